@@ -21,11 +21,15 @@
 
 #include "gui/EventRecorder.h"
 
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/profiler.h"
 #include "common/util.h"
 #include "common/textconsole.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
@@ -37,12 +41,23 @@ namespace Audio {
 #pragma mark -
 
 
+/**
+ * The part of the channel state needed to compute its elapsed time.
+ */
+struct ChannelTiming {
+	uint32 samplesConsumed;
+	uint32 mixerTimeStamp;
+	uint32 pauseStartTime;
+	uint32 pauseTime;
+	uint32 pauseLevel;
+};
+
 /**
  * Channel used by the default Mixer implementation.
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterType converterType);
 	~Channel();
 
 	/**
@@ -54,7 +69,7 @@ public:
 	 *             16 bits, for a total of 40 bytes.
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(int16 *data, uint len);
+	int mix(st_mix_t *data, uint len);
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -121,6 +136,24 @@ public:
 	*/
 	void setRate(uint32 rate);
 
+	/**
+	 * Compute what the rate converter needs to switch to another sample
+	 * rate. Unlike the other methods, this may be called while the channel
+	 * is being mixed on the audio thread.
+	 *
+	 * @param rate	The new sample rate.
+	 * @return The data to pass to setPreparedRate().
+	 */
+	RateConverterData *prepareRate(uint32 rate) const;
+
+	/**
+	 * Set the channel's sample rate, without allocating memory or blocking.
+	 *
+	 * @param rate	The new sample rate.
+	 * @param data	The result of prepareRate() for @p rate.
+	 */
+	void setPreparedRate(uint32 rate, RateConverterData *data);
+
 	/**
 	 * Get the channel's sample rate.
 	 * 
@@ -145,6 +178,17 @@ public:
 	 */
 	Timestamp getElapsedTime();
 
+	/**
+	 * Returns the state getElapsedTime() is computed from.
+	 */
+	ChannelTiming getTiming() const;
+
+	/**
+	 * Computes how long a channel has been playing from a copy
+	 * of its timing state.
+	 */
+	static Timestamp getElapsedTime(const ChannelTiming &timing, uint rate);
+
 	/**
 	 * Replaces the channel's stream with a version that loops indefinitely.
 	 */
@@ -192,28 +236,89 @@ private:
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
+/**
+ * Timing state of the channel in a slot, guarded by a sequence counter
+ * so that the engine thread can read it while the audio callback updates it.
+ */
+struct MixerImpl::ChannelSnapshot {
+	ChannelSnapshot() : sequence(0), handle(0xffffffff), samplesConsumed(0), mixerTimeStamp(0), pauseStartTime(0), pauseTime(0), pauseLevel(0) {}
+
+	volatile uint32 sequence;
+	volatile uint32 handle;
+	volatile uint32 samplesConsumed;
+	volatile uint32 mixerTimeStamp;
+	volatile uint32 pauseStartTime;
+	volatile uint32 pauseTime;
+	volatile uint32 pauseLevel;
+};
+
 #pragma mark -
 #pragma mark --- Mixer ---
 #pragma mark -
 
-MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize)
-	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize, bool lockFree)
+	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _mixBuffer(nullptr), _mixBufferSize(0), _rateConverterType(kRateConverterDefault),
+#ifdef COMMON_HAS_ATOMICS
+	  _lockFree(lockFree),
+#else
+	  _lockFree(false),
+#endif
+	  _snapshots(nullptr), _liveChannels(0), _consumer(kConsumerIdle) {
 
 	assert(sampleRate > 0);
 
+#ifndef COMMON_HAS_ATOMICS
+	if (lockFree)
+		warning("MixerImpl: Lock-free mode is not supported on this platform");
+#endif
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = nullptr;
+
+	if (ConfMan.hasKey("resampler")) {
+		_rateConverterType = parseRateConverterType(ConfMan.get("resampler"));
+		if (_rateConverterType == kRateConverterUnknown) {
+			warning("MixerImpl: Unknown resampler '%s'", ConfMan.get("resampler").c_str());
+			_rateConverterType = kRateConverterDefault;
+		}
+	}
+
+	// Allocate the mix bus up front, so the audio thread does not have to
+	// allocate memory. Most backends do not tell us the size of their
+	// callbacks, so make room for a generous amount of frames.
+	_mixBufferSize = MAX<uint>(_outBufSize, MIN_MIX_BUFFER_FRAMES) * (_stereo ? 2 : 1);
+	_mixBuffer = new st_mix_t[_mixBufferSize];
+
+	// Likewise, the mix kernels must not be detected on the audio thread
+	initMixKernels();
+
+	if (_lockFree)
+		_snapshots = new ChannelSnapshot[NUM_CHANNELS];
 }
 
 MixerImpl::~MixerImpl() {
+	if (_lockFree) {
+		// Channels which were never handed over to the audio callback
+		Command cmd;
+		while (_commands.pop(cmd)) {
+			if (cmd.type == Command::kPlay)
+				delete cmd.channel;
+			else if (cmd.rateData)
+				cmd.rateData->release();
+		}
+		reclaimChannels();
+		delete[] _snapshots;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
+
+	delete[] _mixBuffer;
 }
 
 void MixerImpl::setReady(bool ready) {
-	Common::StackLock lock(_mutex);
-
-	_mixerReady = ready;
+	Common::atomicStore(&_mixerReady, ready);
 }
 
 uint MixerImpl::getOutputRate() const {
@@ -269,12 +374,16 @@ void MixerImpl::playStream(
 	}
 
 
-	assert(_mixerReady);
+	assert(Common::atomicLoad(&_mixerReady));
+
+	if (_lockFree)
+		reclaimChannels();
 
 	// Prevent duplicate sounds
 	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != nullptr && _channels[i]->getId() == id) {
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			const Channel *existing = _lockFree ? _slots[i].channel : _channels[i];
+			if (existing != nullptr && existing->getId() == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -285,6 +394,7 @@ void MixerImpl::playStream(
 					delete stream;
 				return;
 			}
+		}
 	}
 
 #ifdef AUDIO_REVERSE_STEREO
@@ -292,25 +402,50 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, _rateConverterType);
 	chan->setVolume(volume);
 	chan->setBalance(balance);
-	insertChannel(handle, chan);
+	if (_lockFree)
+		insertChannelLockFree(handle, chan);
+	else
+		insertChannel(handle, chan);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
+	PROFILE_ZONE("mixCallback");
 
 	int16 *buf = (int16 *)samples;
 
+	if (_lockFree) {
+		// The engine thread only takes over the command queue when it
+		// overflows, e.g. because audio was suspended. Output silence
+		// rather than waiting for it.
+		if (!Common::atomicCompareExchange<uint32>(&_consumer, kConsumerIdle, kConsumerCallback)) {
+			memset(buf, 0, len);
+			return 0;
+		}
+
+		// Since the mixer callback has been called, the mixer must be ready...
+		Common::atomicStore(&_mixerReady, true);
+
+		processCommands();
+		const int res = mixChannels(buf, len);
+
+		Common::atomicStore<uint32>(&_consumer, kConsumerIdle);
+		return res;
+	}
+
+	Common::StackLock lock(_mutex);
+
 	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
+	Common::atomicStore(&_mixerReady, true);
 
-	//  zero the buf
-	memset(buf, 0, len);
+	return mixChannels(buf, len);
+}
 
+int MixerImpl::mixChannels(int16 *buf, uint len) {
 	// we store 16-bit samples
 	if (_stereo) {
 		assert(len % 4 == 0);
@@ -320,26 +455,72 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 		len >>= 1;
 	}
 
+	// Mix as much as fits into the mix bus at a time
+	const uint channels = _stereo ? 2 : 1;
+	const uint maxFrames = _mixBufferSize / channels;
+	int res = 0;
+	while (len > 0) {
+		const uint frames = MIN(len, maxFrames);
+		res += mixPass(buf, frames);
+		buf += frames * channels;
+		len -= frames;
+	}
+
+	return res;
+}
+
+int MixerImpl::mixPass(int16 *buf, uint len) {
+	const uint numSamples = len * (_stereo ? 2 : 1);
+
+	//  zero the mix bus
+	memset(_mixBuffer, 0, numSamples * sizeof(st_mix_t));
+
 	// mix all channels
 	int res = 0, tmp;
+	bool mixed = false;
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = nullptr;
+				if (_lockFree) {
+					retireChannel(i);
+				} else {
+					delete _channels[i];
+					_channels[i] = nullptr;
+				}
 			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
+				tmp = _channels[i]->mix(_mixBuffer, len);
+				mixed = true;
 
 				if (tmp > res)
 					res = tmp;
+
+				if (_lockFree)
+					publishSnapshot(i);
 			}
 		}
 
+	// clip the result into the output buffer
+	if (mixed)
+		clampMixBuffer(buf, _mixBuffer, numSamples);
+	else
+		memset(buf, 0, numSamples * sizeof(int16));
+
 	return res;
 }
 
 void MixerImpl::stopAll() {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		reclaimChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].channel != nullptr && !_slots[i].channel->isPermanent())
+				freeSlot(_slots[i]);
+		}
+		postCommand(Command::kStopAll);
+		return;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && !_channels[i]->isPermanent()) {
 			delete _channels[i];
@@ -350,6 +531,18 @@ void MixerImpl::stopAll() {
 
 void MixerImpl::stopID(int id) {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		reclaimChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].channel != nullptr && _slots[i].channel->getId() == id) {
+				postCommand(Command::kStop, _slots[i].channel->getHandle()._val);
+				freeSlot(_slots[i]);
+			}
+		}
+		return;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
 			delete _channels[i];
@@ -361,6 +554,15 @@ void MixerImpl::stopID(int id) {
 void MixerImpl::stopHandle(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		ChannelSlot *slot = findSlot(handle);
+		if (slot) {
+			postCommand(Command::kStop, handle._val);
+			freeSlot(*slot);
+		}
+		return;
+	}
+
 	// Simply ignore stop requests for handles of sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
@@ -372,7 +574,13 @@ void MixerImpl::stopHandle(SoundHandle handle) {
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
+	Common::atomicStoreRelaxed(&_soundTypeSettings[type].mute, mute);
+
+	if (_lockFree) {
+		Common::StackLock lock(_mutex);
+		postCommand(Command::kGlobalVolChange, 0, type);
+		return;
+	}
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
@@ -382,12 +590,21 @@ void MixerImpl::muteSoundType(SoundType type, bool mute) {
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	return _soundTypeSettings[type].mute;
+	return Common::atomicLoadRelaxed(&_soundTypeSettings[type].mute);
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		ChannelSlot *slot = findSlot(handle);
+		if (slot) {
+			slot->volume = volume;
+			postCommand(Command::kSetVolume, handle._val, volume);
+		}
+		return;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
@@ -396,6 +613,12 @@ void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
+	if (_lockFree) {
+		Common::StackLock lock(_mutex);
+		const ChannelSlot *slot = findSlot(handle);
+		return slot ? slot->volume : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -406,6 +629,15 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		ChannelSlot *slot = findSlot(handle);
+		if (slot) {
+			slot->balance = balance;
+			postCommand(Command::kSetBalance, handle._val, balance);
+		}
+		return;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
@@ -414,6 +646,12 @@ void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
+	if (_lockFree) {
+		Common::StackLock lock(_mutex);
+		const ChannelSlot *slot = findSlot(handle);
+		return slot ? slot->balance : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -424,6 +662,16 @@ int8 MixerImpl::getChannelBalance(SoundHandle handle) {
 void MixerImpl::setChannelRate(SoundHandle handle, uint32 rate) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		ChannelSlot *slot = findSlot(handle);
+		if (slot) {
+			// Leave the expensive part of a rate change to this thread
+			slot->rate = rate;
+			postCommand(Command::kSetRate, handle._val, rate, nullptr, slot->channel->prepareRate(rate));
+		}
+		return;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
@@ -432,6 +680,12 @@ void MixerImpl::setChannelRate(SoundHandle handle, uint32 rate) {
 }
 
 uint32 MixerImpl::getChannelRate(SoundHandle handle) {
+	if (_lockFree) {
+		Common::StackLock lock(_mutex);
+		const ChannelSlot *slot = findSlot(handle);
+		return slot ? slot->rate : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -442,6 +696,15 @@ uint32 MixerImpl::getChannelRate(SoundHandle handle) {
 void MixerImpl::resetChannelRate(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		ChannelSlot *slot = findSlot(handle);
+		if (slot) {
+			slot->rate = slot->streamRate;
+			postCommand(Command::kSetRate, handle._val, slot->rate, nullptr, slot->channel->prepareRate(slot->rate));
+		}
+		return;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
@@ -456,6 +719,33 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		if (!findSlot(handle))
+			return Timestamp(0, _sampleRate);
+
+		// Retry until we get a copy which was not modified by the audio
+		// callback while we were reading it.
+		const ChannelSnapshot &snapshot = _snapshots[handle._val % NUM_CHANNELS];
+		ChannelTiming timing;
+		uint32 snapshotHandle, sequence;
+		do {
+			sequence = Common::atomicLoad(&snapshot.sequence);
+			snapshotHandle = Common::atomicLoadRelaxed(&snapshot.handle);
+			timing.samplesConsumed = Common::atomicLoadRelaxed(&snapshot.samplesConsumed);
+			timing.mixerTimeStamp = Common::atomicLoadRelaxed(&snapshot.mixerTimeStamp);
+			timing.pauseStartTime = Common::atomicLoadRelaxed(&snapshot.pauseStartTime);
+			timing.pauseTime = Common::atomicLoadRelaxed(&snapshot.pauseTime);
+			timing.pauseLevel = Common::atomicLoadRelaxed(&snapshot.pauseLevel);
+			Common::atomicFence();
+		} while ((sequence & 1) || sequence != Common::atomicLoadRelaxed(&snapshot.sequence));
+
+		// The audio callback did not pick up the channel yet
+		if (snapshotHandle != handle._val)
+			return Timestamp(0, _sampleRate);
+
+		return Channel::getElapsedTime(timing, _sampleRate);
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return Timestamp(0, _sampleRate);
@@ -466,6 +756,12 @@ Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 void MixerImpl::loopChannel(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		if (findSlot(handle))
+			postCommand(Command::kLoop, handle._val);
+		return;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return;
@@ -475,6 +771,12 @@ void MixerImpl::loopChannel(SoundHandle handle) {
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		postCommand(Command::kPauseAll, 0, paused);
+		return;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr) {
 			_channels[i]->pause(paused);
@@ -484,6 +786,18 @@ void MixerImpl::pauseAll(bool paused) {
 
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		reclaimChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_slots[i].channel != nullptr && _slots[i].channel->getId() == id) {
+				postCommand(Command::kPause, _slots[i].channel->getHandle()._val, paused);
+				return;
+			}
+		}
+		return;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++) {
 		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
 			_channels[i]->pause(paused);
@@ -495,6 +809,12 @@ void MixerImpl::pauseID(int id, bool paused) {
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
+	if (_lockFree) {
+		if (findSlot(handle))
+			postCommand(Command::kPause, handle._val, paused);
+		return;
+	}
+
 	// Simply ignore (un)pause requests for sounds that already terminated
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
@@ -510,6 +830,14 @@ bool MixerImpl::isSoundIDActive(int id) {
 	g_eventRec.updateSubsystems();
 #endif
 
+	if (_lockFree) {
+		reclaimChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_slots[i].channel && _slots[i].channel->getId() == id)
+				return true;
+		return false;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getId() == id)
 			return true;
@@ -518,6 +846,12 @@ bool MixerImpl::isSoundIDActive(int id) {
 
 int MixerImpl::getSoundID(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		const ChannelSlot *slot = findSlot(handle);
+		return slot ? slot->channel->getId() : 0;
+	}
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
 		return _channels[index]->getId();
@@ -531,12 +865,24 @@ bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
 	g_eventRec.updateSubsystems();
 #endif
 
+	if (_lockFree)
+		return findSlot(handle) != nullptr;
+
 	const int index = handle._val % NUM_CHANNELS;
 	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
 	Common::StackLock lock(_mutex);
+
+	if (_lockFree) {
+		reclaimChannels();
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_slots[i].channel && _slots[i].channel->getType() == type)
+				return true;
+		return false;
+	}
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		if (_channels[i] && _channels[i]->getType() == type)
 			return true;
@@ -553,7 +899,12 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// scaling? See also Player_V2::setMasterVolume
 
 	Common::StackLock lock(_mutex);
-	_soundTypeSettings[type].volume = volume;
+	Common::atomicStoreRelaxed(&_soundTypeSettings[type].volume, volume);
+
+	if (_lockFree) {
+		postCommand(Command::kGlobalVolChange, 0, type);
+		return;
+	}
 
 	for (int i = 0; i != NUM_CHANNELS; ++i) {
 		if (_channels[i] && _channels[i]->getType() == type)
@@ -564,7 +915,206 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
 
-	return _soundTypeSettings[type].volume;
+	return Common::atomicLoadRelaxed(&_soundTypeSettings[type].volume);
+}
+
+#pragma mark -
+#pragma mark --- Lock-free command queue ---
+#pragma mark -
+
+void MixerImpl::insertChannelLockFree(SoundHandle *handle, Channel *chan) {
+	// Make sure the consumer can always hand back the channels it retires
+	if (_liveChannels >= RETIRE_QUEUE_SIZE)
+		flushCommands();
+
+	int index = -1;
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		if (_slots[i].channel == nullptr) {
+			index = i;
+			break;
+		}
+	}
+	if (index == -1) {
+		warning("MixerImpl::out of mixer slots");
+		delete chan;
+		return;
+	}
+
+	SoundHandle chanHandle;
+	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
+
+	chan->setHandle(chanHandle);
+	_handleSeed++;
+	if (handle)
+		*handle = chanHandle;
+
+	ChannelSlot &slot = _slots[index];
+	slot.channel = chan;
+	slot.volume = chan->getVolume();
+	slot.balance = chan->getBalance();
+	slot.rate = slot.streamRate = chan->getRate();
+
+	_liveChannels++;
+	postCommand(Command::kPlay, chanHandle._val, 0, chan);
+}
+
+MixerImpl::ChannelSlot *MixerImpl::findSlot(SoundHandle handle) {
+	reclaimChannels();
+
+	ChannelSlot &slot = _slots[handle._val % NUM_CHANNELS];
+	if (!slot.channel || slot.channel->getHandle()._val != handle._val)
+		return nullptr;
+
+	return &slot;
+}
+
+void MixerImpl::freeSlot(ChannelSlot &slot) {
+	// The channel itself is deleted once the consumer retired it
+	slot.channel = nullptr;
+}
+
+void MixerImpl::postCommand(Command::Type type, uint32 handle, int value, Channel *chan, RateConverterData *rateData) {
+	Command cmd;
+	cmd.type = type;
+	cmd.handle = handle;
+	cmd.value = value;
+	cmd.channel = chan;
+	cmd.rateData = rateData;
+
+	while (!_commands.push(cmd))
+		flushCommands();
+}
+
+void MixerImpl::flushCommands() {
+	// The audio callback is not keeping up, most likely because audio output
+	// is suspended. Temporarily take over its role as the consumer of the
+	// command queue. It outputs silence until we are done.
+	while (!Common::atomicCompareExchange<uint32>(&_consumer, kConsumerIdle, kConsumerEngine))
+		g_system->delayMillis(1);
+
+	processCommands();
+
+	Common::atomicStore<uint32>(&_consumer, kConsumerIdle);
+
+	reclaimChannels();
+}
+
+void MixerImpl::reclaimChannels() {
+	Channel *chan;
+	while (_retiredChannels.pop(chan)) {
+		ChannelSlot &slot = _slots[chan->getHandle()._val % NUM_CHANNELS];
+		if (slot.channel == chan)
+			slot.channel = nullptr;
+
+		delete chan;
+		_liveChannels--;
+	}
+}
+
+void MixerImpl::processCommands() {
+	Command cmd;
+	while (_commands.pop(cmd)) {
+		const int index = cmd.handle % NUM_CHANNELS;
+		Channel *chan = _channels[index];
+		if (chan && chan->getHandle()._val != cmd.handle)
+			chan = nullptr;
+
+		switch (cmd.type) {
+		case Command::kPlay:
+			assert(!_channels[index]);
+			_channels[index] = cmd.channel;
+			publishSnapshot(index);
+			break;
+
+		case Command::kStop:
+			if (chan)
+				retireChannel(index);
+			break;
+
+		case Command::kStopAll:
+			for (int i = 0; i != NUM_CHANNELS; i++) {
+				if (_channels[i] && !_channels[i]->isPermanent())
+					retireChannel(i);
+			}
+			break;
+
+		case Command::kPause:
+			if (chan) {
+				chan->pause(cmd.value != 0);
+				publishSnapshot(index);
+			}
+			break;
+
+		case Command::kPauseAll:
+			for (int i = 0; i != NUM_CHANNELS; i++) {
+				if (_channels[i]) {
+					_channels[i]->pause(cmd.value != 0);
+					publishSnapshot(i);
+				}
+			}
+			break;
+
+		case Command::kSetVolume:
+			if (chan)
+				chan->setVolume(cmd.value);
+			break;
+
+		case Command::kSetBalance:
+			if (chan)
+				chan->setBalance(cmd.value);
+			break;
+
+		case Command::kSetRate:
+			if (chan)
+				chan->setPreparedRate(cmd.value, cmd.rateData);
+			else if (cmd.rateData)
+				cmd.rateData->release();
+			break;
+
+		case Command::kLoop:
+			if (chan)
+				chan->loop();
+			break;
+
+		case Command::kGlobalVolChange:
+			for (int i = 0; i != NUM_CHANNELS; i++) {
+				if (_channels[i] && _channels[i]->getType() == cmd.value)
+					_channels[i]->notifyGlobalVolChange();
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void MixerImpl::retireChannel(int index) {
+	// This cannot fail, insertChannelLockFree() makes sure there are never
+	// more live channels than fit into the queue.
+	if (!_retiredChannels.push(_channels[index]))
+		error("MixerImpl::retired channel queue overflow");
+
+	_channels[index] = nullptr;
+}
+
+void MixerImpl::publishSnapshot(int index) {
+	ChannelSnapshot &snapshot = _snapshots[index];
+	const ChannelTiming timing = _channels[index]->getTiming();
+	const uint32 sequence = Common::atomicLoadRelaxed(&snapshot.sequence);
+
+	// An odd sequence number tells readers that an update is in progress
+	Common::atomicStoreRelaxed(&snapshot.sequence, sequence + 1);
+	Common::atomicFence();
+
+	Common::atomicStoreRelaxed(&snapshot.handle, _channels[index]->getHandle()._val);
+	Common::atomicStoreRelaxed(&snapshot.samplesConsumed, timing.samplesConsumed);
+	Common::atomicStoreRelaxed(&snapshot.mixerTimeStamp, timing.mixerTimeStamp);
+	Common::atomicStoreRelaxed(&snapshot.pauseStartTime, timing.pauseStartTime);
+	Common::atomicStoreRelaxed(&snapshot.pauseTime, timing.pauseTime);
+	Common::atomicStoreRelaxed(&snapshot.pauseLevel, timing.pauseLevel);
+
+	Common::atomicStore(&snapshot.sequence, sequence + 2);
 }
 
 
@@ -573,7 +1123,7 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
+				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, RateConverterType converterType)
 	: _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
 	  _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
 	  _pauseStartTime(0), _pauseTime(0), _converter(nullptr), _volL(0), _volR(0),
@@ -582,7 +1132,7 @@ Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo, converterType);
 }
 
 Channel::~Channel() {
@@ -612,6 +1162,17 @@ void Channel::setRate(uint32 rate) {
 		_converter->setInputRate(rate);
 }
 
+RateConverterData *Channel::prepareRate(uint32 rate) const {
+	return _converter ? _converter->prepareInputRate(rate) : nullptr;
+}
+
+void Channel::setPreparedRate(uint32 rate, RateConverterData *data) {
+	if (_converter)
+		_converter->setPreparedInputRate(rate, data);
+	else if (data)
+		data->release();
+}
+
 uint32 Channel::getRate() {
 	if (_converter)
 		return _converter->getInputRate();
@@ -671,22 +1232,35 @@ void Channel::pause(bool paused) {
 }
 
 Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
+	return getElapsedTime(getTiming(), _mixer->getOutputRate());
+}
+
+ChannelTiming Channel::getTiming() const {
+	ChannelTiming timing;
+	timing.samplesConsumed = _samplesConsumed;
+	timing.mixerTimeStamp = _mixerTimeStamp;
+	timing.pauseStartTime = _pauseStartTime;
+	timing.pauseTime = _pauseTime;
+	timing.pauseLevel = _pauseLevel;
+	return timing;
+}
+
+Timestamp Channel::getElapsedTime(const ChannelTiming &timing, uint rate) {
 	uint32 delta = 0;
 
 	Audio::Timestamp ts(0, rate);
 
-	if (_mixerTimeStamp == 0)
+	if (timing.mixerTimeStamp == 0)
 		return ts;
 
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
+	if (timing.pauseLevel != 0)
+		delta = timing.pauseStartTime - timing.mixerTimeStamp;
 	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
+		delta = g_system->getMillis(true) - timing.mixerTimeStamp - timing.pauseTime;
 
 	// Convert the number of samples into a time duration.
 
-	ts = ts.addFrames(_samplesConsumed);
+	ts = ts.addFrames(timing.samplesConsumed);
 	ts = ts.addMsecs(delta);
 
 	// In theory it would seem like a good idea to limit the approximation
@@ -707,7 +1281,7 @@ void Channel::loop() {
 	}
 }
 
-int Channel::mix(int16 *data, uint len) {
+int Channel::mix(st_mix_t *data, uint len) {
 	assert(_stream);
 	assert(_converter);
 
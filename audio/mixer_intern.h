@@ -23,8 +23,11 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/atomic.h"
 #include "common/mutex.h"
+#include "common/spsc-queue.h"
 #include "audio/mixer.h"
+#include "audio/rate.h"
 
 namespace Audio {
 
@@ -49,6 +52,15 @@ namespace Audio {
  * 4) Change the mixer into ready mode via setReady(true).
  * 5) Start audio processing (e.g. by resuming the audio thread, if applicable).
  *
+ * By default, every mixer call made by the engine and mixCallback() are
+ * serialized by a single mutex. Backends may instead construct the mixer in
+ * lock-free mode. In that mode, engine-side calls only update a shadow copy of
+ * the channel state and post commands into a lock-free queue, which
+ * mixCallback() drains at the start of each buffer. The audio callback then
+ * never waits for the engine. Note that engines which lock mutex() to
+ * synchronize their own audio streams with the callback are not protected in
+ * this mode, so it has to be explicitly requested.
+ *
  * In the future, we might make it possible for backends to provide
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
@@ -58,7 +70,10 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 32
+		NUM_CHANNELS = 32,
+		COMMAND_QUEUE_SIZE = 256,
+		RETIRE_QUEUE_SIZE = 128,
+		MIN_MIX_BUFFER_FRAMES = 4096
 	};
 
 	Common::Mutex _mutex;
@@ -66,7 +81,7 @@ private:
 	const uint _sampleRate;
 	const bool _stereo;
 	const uint _outBufSize;
-	bool _mixerReady;
+	volatile bool _mixerReady; ///< Set by the lock-free mixer callback, so only accessed atomically
 	uint32 _handleSeed;
 
 	struct SoundTypeSettings {
@@ -79,13 +94,80 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * All channels are mixed into this 32-bit buffer, which is only clipped
+	 * to 16 bits once every channel has been added. Its size never changes,
+	 * larger callbacks are mixed in several passes.
+	 */
+	st_mix_t *_mixBuffer;
+	uint _mixBufferSize;
+
+	/** The resampler used by new channels, from the "resampler" config key */
+	RateConverterType _rateConverterType;
+
+	/** A request from the engine side, applied by mixCallback() in lock-free mode. */
+	struct Command {
+		enum Type {
+			kPlay,
+			kStop,
+			kStopAll,
+			kPause,
+			kPauseAll,
+			kSetVolume,
+			kSetBalance,
+			kSetRate,
+			kLoop,
+			kGlobalVolChange
+		};
+
+		Type type;
+		uint32 handle;
+		int value;
+		Channel *channel;
+
+		/** For kSetRate, what the rate converter prepared for the new rate */
+		RateConverterData *rateData;
+	};
+
+	/**
+	 * Engine side view of a channel slot in lock-free mode. Only the
+	 * immutable properties of the channel (handle, id, type, permanence)
+	 * may be queried through the channel pointer.
+	 */
+	struct ChannelSlot {
+		ChannelSlot() : channel(nullptr), volume(0), balance(0), rate(0), streamRate(0) {}
+
+		Channel *channel;
+		byte volume;
+		int8 balance;
+		uint32 rate;
+		uint32 streamRate;
+	};
+
+	/** Channel timing state, published by the audio callback in lock-free mode. */
+	struct ChannelSnapshot;
+
+	enum {
+		kConsumerIdle = 0,
+		kConsumerCallback = 1,
+		kConsumerEngine = 2
+	};
+
+	const bool _lockFree;
+	Common::SPSCQueue<Command, COMMAND_QUEUE_SIZE> _commands;
+	Common::SPSCQueue<Channel *, RETIRE_QUEUE_SIZE> _retiredChannels;
+	ChannelSlot _slots[NUM_CHANNELS];
+	ChannelSnapshot *_snapshots;
+	uint _liveChannels;
+	volatile uint32 _consumer;
+
 
 public:
 
-	MixerImpl(uint sampleRate, bool stereo = true, uint outBufSize = 0);
+	MixerImpl(uint sampleRate, bool stereo = true, uint outBufSize = 0, bool lockFree = false);
 	~MixerImpl();
 
-	virtual bool isReady() const { Common::StackLock lock(_mutex); return _mixerReady; }
+	virtual bool isReady() const { return Common::atomicLoad(&_mixerReady); }
 
 	virtual Common::Mutex &mutex() { return _mutex; }
 
@@ -139,6 +221,22 @@ public:
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
+	int mixChannels(int16 *buf, uint len);
+	int mixPass(int16 *buf, uint len);
+
+	// Engine side of the lock-free mode, all called with _mutex held.
+	void insertChannelLockFree(SoundHandle *handle, Channel *chan);
+	ChannelSlot *findSlot(SoundHandle handle);
+	void freeSlot(ChannelSlot &slot);
+	void postCommand(Command::Type type, uint32 handle = 0, int value = 0, Channel *chan = nullptr, RateConverterData *rateData = nullptr);
+	void flushCommands();
+	void reclaimChannels();
+
+	// Consumer side of the lock-free mode.
+	void processCommands();
+	void retireChannel(int index);
+	void publishSnapshot(int index);
+
 public:
 	/**
 	 * The mixer callback function, to be called at regular intervals by
@@ -151,6 +249,11 @@ public:
 	 */
 	int mixCallback(byte *samples, uint len);
 
+	/**
+	 * Whether this mixer was created in lock-free mode.
+	 */
+	bool isLockFree() const { return _lockFree; }
+
 	/**
 	 * Set the internal 'is ready' flag of the mixer.
 	 * Backends should invoke Mixer::setReady(true) once initialisation of
@@ -29,7 +29,9 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/mixer.h"
+#include "common/system.h"
 #include "common/util.h"
 
 namespace Audio {
@@ -45,6 +47,12 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+/**
+ * Rate conversion happens in two stages: the input samples are first
+ * resampled into a block of 16-bit frames, and that block is then scaled by
+ * the channel volume and added to the output by a mix kernel. The latter is
+ * where most of the time goes, and it has SIMD implementations.
+ */
 template<bool inStereo, bool outStereo, bool reverseStereo>
 class RateConverter_Impl : public RateConverter {
 private:
@@ -64,6 +72,9 @@ private:
 	/** Size of data currently loaded into the buffer */
 	int _bufferSize;
 
+	/** Resampled frames waiting to be mixed, in the input channel layout */
+	st_sample_t _outBlock[512];
+
 	/** How far output is ahead of input when doing simple conversion */
 	frac_t _outPos;
 
@@ -76,15 +87,33 @@ private:
 	/** Current sample(s) in the input stream (left/right channel) */
 	st_sample_t _inCurL, _inCurR;
 
-	int copyConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
-	int simpleConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
-	int interpolateConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+	/** The kernel used to add frames to a 32-bit mix bus */
+	MixKernels::MixFunc _mixFunc;
+
+	int simpleResample(AudioStream &input, int maxFrames);
+	int interpolateResample(AudioStream &input, int maxFrames);
+
+	template<class T>
+	int copyConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+	template<class T>
+	int simpleConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+	template<class T>
+	int interpolateConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+
+	template<class T>
+	int convertT(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
 
 public:
 	RateConverter_Impl(st_rate_t inputRate, st_rate_t outputRate);
 	virtual ~RateConverter_Impl() {}
 
-	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override;
+	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override {
+		return convertT(input, outBuffer, numSamples, vol_l, vol_r);
+	}
+
+	int convert(AudioStream &input, st_mix_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override {
+		return convertT(input, outBuffer, numSamples, vol_l, vol_r);
+	}
 
 	void setInputRate(st_rate_t inputRate) override { _inRate = inputRate; }
 	void setOutputRate(st_rate_t outputRate) override { _outRate = outputRate; }
@@ -96,8 +125,9 @@ public:
 };
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
-	st_sample_t *outStart, *outEnd;
+template<class T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	T *outStart, *outEnd;
 
 	outStart = outBuffer;
 	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
@@ -112,46 +142,33 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::copyConvert(AudioStr
 				return (outBuffer - outStart) / (outStereo ? 2 : 1);
 		}
 
-		// Mix the data into the output buffer
-		st_sample_t inL, inR;
-		inL = *_bufferPos++;
-		inR = (inStereo ? *_bufferPos++ : inL);
-		_bufferSize -= (inStereo ? 2 : 1);
-
-		st_sample_t outL, outR;
-		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
-
-		if (outStereo) {
-			// Output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
-
-			// Output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+		// Mix the data straight from the input buffer into the output buffer
+		const int frames = MIN<int>(_bufferSize / (inStereo ? 2 : 1), (outEnd - outBuffer) / (outStereo ? 2 : 1));
+		if (frames == 0) {
+			// Drop an incomplete stereo frame at the end of the stream
+			_bufferSize = 0;
+			continue;
+		}
 
-			outBuffer += 2;
-		} else {
-			// Output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
+		mixBlock<inStereo, outStereo, reverseStereo>(outBuffer, _bufferPos, frames, volL, volR, _mixFunc);
 
-			outBuffer += 1;
-		}
+		_bufferPos += frames * (inStereo ? 2 : 1);
+		_bufferSize -= frames * (inStereo ? 2 : 1);
+		outBuffer += frames * (outStereo ? 2 : 1);
 	}
 
 	return (outBuffer - outStart) / (outStereo ? 2 : 1);
 }
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleResample(AudioStream &input, int maxFrames) {
 	// How much to increment _outPos by
 	frac_t outPos_inc = _inRate / _outRate;
 
-	st_sample_t *outStart, *outEnd;
-
-	outStart = outBuffer;
-	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
+	st_sample_t *blockPos = _outBlock;
+	int frames = 0;
 
-	while (outBuffer < outEnd) {
+	while (frames < maxFrames) {
 		// Read enough input samples so that _outPos >= 0
 		do {
 			// Check if we have to refill the buffer
@@ -160,7 +177,7 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioS
 				_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
 
 				if (_bufferSize <= 0)
-					return (outBuffer - outStart) / (outStereo ? 2 : 1);
+					return frames;
 			}
 
 			_bufferSize -= (inStereo ? 2 : 1);
@@ -171,45 +188,49 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioS
 			}
 		} while (_outPos >= 0);
 
-		st_sample_t inL, inR;
-		inL = *_bufferPos++;
-		inR = (inStereo ? *_bufferPos++ : inL);
+		*blockPos++ = *_bufferPos++;
+		if (inStereo)
+			*blockPos++ = *_bufferPos++;
 
 		// Increment output position
 		_outPos += outPos_inc;
+		frames++;
+	}
 
-		st_sample_t outL, outR;
-		outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-		outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+	return frames;
+}
 
-		if (outStereo) {
-			// output left channel
-			clampedAdd(outBuffer[reverseStereo    ], outL);
+template<bool inStereo, bool outStereo, bool reverseStereo>
+template<class T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::simpleConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	T *outStart, *outEnd;
 
-			// output right channel
-			clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+	outStart = outBuffer;
+	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
 
-			outBuffer += 2;
-		} else {
-			// output mono channel
-			clampedAdd(outBuffer[0], (outL + outR) / 2);
+	while (outBuffer < outEnd) {
+		const int wanted = MIN<int>(ARRAYSIZE(_outBlock) / (inStereo ? 2 : 1), (outEnd - outBuffer) / (outStereo ? 2 : 1));
+		const int frames = simpleResample(input, wanted);
 
-			outBuffer += 1;
-		}
+		mixBlock<inStereo, outStereo, reverseStereo>(outBuffer, _outBlock, frames, volL, volR, _mixFunc);
+		outBuffer += frames * (outStereo ? 2 : 1);
+
+		// The input stream ran out of data
+		if (frames < wanted)
+			break;
 	}
 	return (outBuffer - outStart) / (outStereo ? 2 : 1);
 }
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateResample(AudioStream &input, int maxFrames) {
 	// How much to increment _outPosFrac by
 	frac_t outPos_inc = (_inRate << FRAC_BITS_LOW) / _outRate;
 
-	st_sample_t *outStart, *outEnd;
-	outStart = outBuffer;
-	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
+	st_sample_t *blockPos = _outBlock;
+	int frames = 0;
 
-	while (outBuffer < outEnd) {
+	while (frames < maxFrames) {
 		// Read enough input samples so that _outPosFrac < 0
 		while ((frac_t)FRAC_ONE_LOW <= _outPosFrac) {
 			// Check if we have to refill the buffer
@@ -218,7 +239,7 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(A
 				_bufferSize = input.readBuffer(_buffer, ARRAYSIZE(_buffer));
 
 				if (_bufferSize <= 0)
-					return (outBuffer - outStart) / (outStereo ? 2 : 1);
+					return frames;
 			}
 
 			_bufferSize -= (inStereo ? 2 : 1);
@@ -234,37 +255,40 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(A
 		}
 
 		// Loop as long as the _outPos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (_outPosFrac < (frac_t)FRAC_ONE_LOW && outBuffer < outEnd) {
+		// still space in the output block.
+		while (_outPosFrac < (frac_t)FRAC_ONE_LOW && frames < maxFrames) {
 			// Interpolate
-			st_sample_t inL, inR;
-			inL = (st_sample_t)(_inLastL + (((_inCurL - _inLastL) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
-			inR = (inStereo ?
-						(st_sample_t)(_inLastR + (((_inCurR - _inLastR) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW)) :
-						inL);
+			*blockPos++ = (st_sample_t)(_inLastL + (((_inCurL - _inLastL) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+			if (inStereo)
+				*blockPos++ = (st_sample_t)(_inLastR + (((_inCurR - _inLastR) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+
+			// Increment output position
+			_outPosFrac += outPos_inc;
+			frames++;
+		}
+	}
 
-			st_sample_t outL, outR;
-			outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
-			outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+	return frames;
+}
 
-			if (outStereo) {
-				// Output left channel
-				clampedAdd(outBuffer[reverseStereo    ], outL);
+template<bool inStereo, bool outStereo, bool reverseStereo>
+template<class T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	T *outStart, *outEnd;
 
-				// Output right channel
-				clampedAdd(outBuffer[reverseStereo ^ 1], outR);
+	outStart = outBuffer;
+	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
 
-				outBuffer += 2;
-			} else {
-				// Output mono channel
-				clampedAdd(outBuffer[0], (outL + outR) / 2);
+	while (outBuffer < outEnd) {
+		const int wanted = MIN<int>(ARRAYSIZE(_outBlock) / (inStereo ? 2 : 1), (outEnd - outBuffer) / (outStereo ? 2 : 1));
+		const int frames = interpolateResample(input, wanted);
 
-				outBuffer += 1;
-			}
+		mixBlock<inStereo, outStereo, reverseStereo>(outBuffer, _outBlock, frames, volL, volR, _mixFunc);
+		outBuffer += frames * (outStereo ? 2 : 1);
 
-			// Increment output position
-			_outPosFrac += outPos_inc;
-		}
+		// The input stream ran out of data
+		if (frames < wanted)
+			break;
 	}
 	return (outBuffer - outStart) / (outStereo ? 2 : 1);
 }
@@ -280,10 +304,14 @@ RateConverter_Impl<inStereo, outStereo, reverseStereo>::RateConverter_Impl(st_ra
 	_inCurL(0),
 	_inCurR(0),
 	_bufferSize(0),
-	_bufferPos(nullptr) {}
+	_bufferPos(nullptr) {
+
+	_mixFunc = getMixKernels().mix[getMixMode<inStereo, outStereo, reverseStereo>()];
+}
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
-int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+template<class T>
+int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convertT(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
 	assert(input.isStereo() == inStereo);
 
 	if (_inRate == _outRate) {
@@ -297,7 +325,18 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream
 	}
 }
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+RateConverterType parseRateConverterType(const Common::String &str) {
+	if (str.equalsIgnoreCase("default"))
+		return kRateConverterDefault;
+	if (str.equalsIgnoreCase("sinc"))
+		return kRateConverterSinc;
+	return kRateConverterUnknown;
+}
+
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterType type) {
+	if (type == kRateConverterSinc && inRate != outRate)
+		return makeSincRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo);
+
 	if (inStereo) {
 		if (outStereo) {
 			if (reverseStereo)
@@ -314,4 +353,65 @@ RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inSte
 	}
 }
 
+void clampMixBuffer(st_sample_t *outBuffer, const st_mix_t *mixBuffer, st_size_t numSamples) {
+	getMixKernels().clamp(outBuffer, mixBuffer, numSamples);
+}
+
+#pragma mark -
+#pragma mark --- Mix kernels ---
+#pragma mark -
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+static void mixKernelGeneric(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	mixFramesGeneric<st_mix_t, inStereo, outStereo, reverseStereo>(out, in, frames, volL, volR);
+}
+
+void getMixKernelsGeneric(MixKernels &kernels) {
+	kernels.mix[kMixMonoToMono] = mixKernelGeneric<false, false, false>;
+	kernels.mix[kMixMonoToStereo] = mixKernelGeneric<false, true, false>;
+	kernels.mix[kMixStereoToMono] = mixKernelGeneric<true, false, false>;
+	kernels.mix[kMixStereoToStereo] = mixKernelGeneric<true, true, false>;
+	kernels.mix[kMixStereoToStereoReversed] = mixKernelGeneric<true, true, true>;
+	kernels.clamp = clampSamplesGeneric;
+}
+
+static MixKernels s_mixKernels;
+static bool s_mixKernelsInitialized = false;
+
+void initMixKernels() {
+	if (s_mixKernelsInitialized)
+		return;
+
+	getMixKernelsGeneric(s_mixKernels);
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		getMixKernelsNEON(s_mixKernels);
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		getMixKernelsSSE2(s_mixKernels);
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+		getMixKernelsAVX2(s_mixKernels);
+#endif
+#endif
+	s_mixKernelsInitialized = true;
+}
+
+const MixKernels &getMixKernels() {
+	initMixKernels();
+	return s_mixKernels;
+}
+
+void setMixKernels(const MixKernels &kernels) {
+	s_mixKernels = kernels;
+	s_mixKernelsInitialized = true;
+}
+
+void resetMixKernels() {
+	s_mixKernelsInitialized = false;
+}
+
 } // End of namespace Audio
@@ -23,6 +23,7 @@
 #define AUDIO_RATE_H
 
 #include "common/frac.h"
+#include "common/str.h"
 
 namespace Audio {
 /**
@@ -36,6 +37,7 @@ namespace Audio {
 class AudioStream;
 
 typedef int16 st_sample_t;
+typedef int32 st_mix_t;
 typedef uint16 st_volume_t;
 typedef uint32 st_size_t;
 typedef uint32 st_rate_t;
@@ -66,6 +68,50 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * The algorithms available to resample an AudioStream.
+ */
+enum RateConverterType {
+	kRateConverterUnknown = -1,
+
+	/**
+	 * Copy the samples when the rates match, drop samples when the input rate
+	 * is a multiple of the output rate, and use linear interpolation otherwise.
+	 */
+	kRateConverterDefault,
+
+	/**
+	 * Use a band-limited windowed-sinc filter, unless the rates match. This
+	 * gives much less aliasing than linear interpolation, at a higher but
+	 * fixed cost per output sample.
+	 */
+	kRateConverterSinc
+};
+
+/**
+ * Convert a resampler name, as used by the "resampler" configuration key,
+ * into a RateConverterType. Return kRateConverterUnknown for unknown names.
+ */
+RateConverterType parseRateConverterType(const Common::String &str);
+
+/**
+ * Data which a rate converter computes for a particular pair of input and
+ * output rates, such as filter coefficients.
+ *
+ * @see RateConverter::prepareInputRate()
+ */
+class RateConverterData {
+public:
+	virtual ~RateConverterData() {}
+
+	/**
+	 * Drop the reference returned by RateConverter::prepareInputRate(),
+	 * when it is not passed on to RateConverter::setPreparedInputRate().
+	 * This never blocks, so it can be called from the audio thread.
+	 */
+	virtual void release() = 0;
+};
+
 /**
  * Helper class that handles resampling an AudioStream between an input and output
  * sample rate. Its regular use case is upsampling from the native stream rate
@@ -90,9 +136,50 @@ public:
 	 */
 	virtual int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
+	/**
+	 * Convert the provided AudioStream to the target sample rate, and add
+	 * it to a 32-bit mix bus. Unlike the 16-bit variant, this does not clip
+	 * the output, which allows mixing many streams and clipping only once
+	 * using clampMixBuffer().
+	 *
+	 * @param input			The AudioStream to read data from.
+	 * @param outBuffer		The mix bus that the resampled audio will be added to. Must have size of at least @p numSamples.
+	 * @param numSamples	The desired number of samples to be written into the buffer.
+	 * @param vol_l			Volume for left channel.
+	 * @param vol_r			Volume for right channel.
+	 *
+	 * @return Number of sample pairs written into the buffer.
+	 */
+	virtual int convert(AudioStream &input, st_mix_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) = 0;
+
 	virtual void setInputRate(st_rate_t inputRate) = 0;
 	virtual void setOutputRate(st_rate_t outputRate) = 0;
 
+	/**
+	 * Compute what the converter needs to switch to another input rate,
+	 * which can be expensive. Unlike the other methods, this may be called
+	 * from another thread than the one using the converter, as long as the
+	 * output rate is not changed meanwhile.
+	 *
+	 * @return The data to pass to setPreparedInputRate(), or nullptr if
+	 *         the converter does not need any.
+	 */
+	virtual RateConverterData *prepareInputRate(st_rate_t inputRate) const { return nullptr; }
+
+	/**
+	 * Change the input rate, like setInputRate(), using the result of
+	 * prepareInputRate(). This neither allocates memory nor blocks, so the
+	 * audio thread can do it.
+	 *
+	 * @param inputRate	The new input rate.
+	 * @param data		The result of prepareInputRate() for @p inputRate, which the converter takes over.
+	 */
+	virtual void setPreparedInputRate(st_rate_t inputRate, RateConverterData *data) {
+		if (data)
+			data->release();
+		setInputRate(inputRate);
+	}
+
 	virtual st_rate_t getInputRate() const = 0;
 	virtual st_rate_t getOutputRate() const = 0;
 
@@ -104,7 +191,17 @@ public:
 	virtual bool needsDraining() const = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo);
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterType type = kRateConverterDefault);
+
+/**
+ * Clip the samples of a 32-bit mix bus, as filled by RateConverter::convert(),
+ * into 16-bit output samples.
+ *
+ * @param outBuffer  The buffer that the output samples will be written to.
+ * @param mixBuffer  The mix bus to read from.
+ * @param numSamples Number of samples (not sample pairs) to convert.
+ */
+void clampMixBuffer(st_sample_t *outBuffer, const st_mix_t *mixBuffer, st_size_t numSamples);
 
 /** @} */
 } // End of namespace Audio
@@ -0,0 +1,172 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_intern.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Audio {
+
+STATIC_ASSERT(Mixer::kMaxMixerVolume == 256, mix_kernels_assume_a_max_mixer_volume_of_256);
+
+// Divide by kMaxMixerVolume, rounding towards zero like the scalar code does
+static FORCEINLINE __m256i avx2_div256(__m256i x) {
+	return _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(_mm256_srai_epi32(x, 31), 24)), 8);
+}
+
+// Divide by two, rounding towards zero like the scalar code does
+static FORCEINLINE __m256i avx2_div2(__m256i x) {
+	return _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 31)), 1);
+}
+
+// Scale 16 samples by 16 volumes, giving 16 32-bit results in order
+static FORCEINLINE void avx2_scale(__m256i in, __m256i vol, __m256i &first, __m256i &second) {
+	const __m256i prodLo = _mm256_mullo_epi16(in, vol);
+	const __m256i prodHi = _mm256_mulhi_epi16(in, vol);
+
+	// The unpack instructions work on each 128-bit lane separately
+	const __m256i lo = _mm256_unpacklo_epi16(prodLo, prodHi);
+	const __m256i hi = _mm256_unpackhi_epi16(prodLo, prodHi);
+	first = avx2_div256(_mm256_permute2x128_si256(lo, hi, 0x20));
+	second = avx2_div256(_mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+static FORCEINLINE void avx2_accumulate(st_mix_t *out, __m256i val) {
+	_mm256_storeu_si256((__m256i *)out, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)out), val));
+}
+
+static void mixMonoToMonoAVX2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m256i vecVolL = _mm256_set1_epi16(volL);
+	const __m256i vecVolR = _mm256_set1_epi16(volR);
+
+	uint i = 0;
+	for (; i + 16 <= frames; i += 16, in += 16, out += 16) {
+		const __m256i src = _mm256_loadu_si256((const __m256i *)in);
+		__m256i firstL, secondL, firstR, secondR;
+		avx2_scale(src, vecVolL, firstL, secondL);
+		avx2_scale(src, vecVolR, firstR, secondR);
+		avx2_accumulate(out, avx2_div2(_mm256_add_epi32(firstL, firstR)));
+		avx2_accumulate(out + 8, avx2_div2(_mm256_add_epi32(secondL, secondR)));
+	}
+
+	mixFramesGeneric<st_mix_t, false, false, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixMonoToStereoAVX2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m256i vol = _mm256_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL,
+	                                     volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 8, out += 16) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)in);
+		const __m256i dup = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(src, src)), _mm_unpackhi_epi16(src, src), 1);
+
+		__m256i first, second;
+		avx2_scale(dup, vol, first, second);
+		avx2_accumulate(out, first);
+		avx2_accumulate(out + 8, second);
+	}
+
+	mixFramesGeneric<st_mix_t, false, true, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixStereoToMonoAVX2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m256i vol = _mm256_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL,
+	                                     volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 16, out += 8) {
+		__m256i first, second;
+		avx2_scale(_mm256_loadu_si256((const __m256i *)in), vol, first, second);
+
+		// Add the left and right channels of each frame, then restore the
+		// frame order which the per-lane horizontal add mixed up
+		const __m256i sum = _mm256_permute4x64_epi64(_mm256_hadd_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+		avx2_accumulate(out, avx2_div2(sum));
+	}
+
+	mixFramesGeneric<st_mix_t, true, false, false>(out, in, frames - i, volL, volR);
+}
+
+template<bool reverseStereo>
+static void mixStereoToStereoAVX2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	// When reversing, swap the channels of each frame, which moves the
+	// left volume to the right channel as well
+	const __m256i vol = reverseStereo ?
+		_mm256_set_epi16(volL, volR, volL, volR, volL, volR, volL, volR,
+		                 volL, volR, volL, volR, volL, volR, volL, volR) :
+		_mm256_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL,
+		                 volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 16, out += 16) {
+		__m256i src = _mm256_loadu_si256((const __m256i *)in);
+		if (reverseStereo)
+			src = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+		__m256i first, second;
+		avx2_scale(src, vol, first, second);
+		avx2_accumulate(out, first);
+		avx2_accumulate(out + 8, second);
+	}
+
+	mixFramesGeneric<st_mix_t, true, true, reverseStereo>(out, in, frames - i, volL, volR);
+}
+
+static void clampSamplesAVX2(st_sample_t *out, const st_mix_t *in, uint numSamples) {
+	uint i = 0;
+	for (; i + 16 <= numSamples; i += 16, in += 16, out += 16) {
+		const __m256i first = _mm256_loadu_si256((const __m256i *)in);
+		const __m256i second = _mm256_loadu_si256((const __m256i *)(in + 8));
+
+		// The pack instruction works on each 128-bit lane separately
+		const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i *)out, packed);
+	}
+
+	clampSamplesGeneric(out, in, numSamples - i);
+}
+
+void getMixKernelsAVX2(MixKernels &kernels) {
+	kernels.mix[kMixMonoToMono] = mixMonoToMonoAVX2;
+	kernels.mix[kMixMonoToStereo] = mixMonoToStereoAVX2;
+	kernels.mix[kMixStereoToMono] = mixStereoToMonoAVX2;
+	kernels.mix[kMixStereoToStereo] = mixStereoToStereoAVX2<false>;
+	kernels.mix[kMixStereoToStereoReversed] = mixStereoToStereoAVX2<true>;
+	kernels.clamp = clampSamplesAVX2;
+}
+
+} // End of namespace Audio
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
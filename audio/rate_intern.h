@@ -0,0 +1,179 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_RATE_INTERN_H
+#define AUDIO_RATE_INTERN_H
+
+#include "common/util.h"
+
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Channel layouts handled by the mixing kernels. The input is either mono
+ * or interleaved stereo, and so is the output. For reversed stereo, the
+ * left input channel goes to the right output channel and vice versa.
+ */
+enum MixMode {
+	kMixMonoToMono,
+	kMixMonoToStereo,
+	kMixStereoToMono,
+	kMixStereoToStereo,
+	kMixStereoToStereoReversed,
+	kMixModeCount
+};
+
+/**
+ * Kernels used in the last stage of rate conversion, and by the mixer.
+ *
+ * The mix kernels scale a block of 16-bit frames by the channel volume and
+ * accumulate them into the 32-bit mix bus. The clamp kernel converts the mix
+ * bus into 16-bit output samples once all channels have been mixed.
+ *
+ * The SIMD versions must produce exactly the same output as the generic ones.
+ */
+struct MixKernels {
+	typedef void (*MixFunc)(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR);
+	typedef void (*ClampFunc)(st_sample_t *out, const st_mix_t *in, uint numSamples);
+
+	MixFunc mix[kMixModeCount];
+	ClampFunc clamp;
+};
+
+void getMixKernelsGeneric(MixKernels &kernels);
+#ifdef SCUMMVM_SSE2
+void getMixKernelsSSE2(MixKernels &kernels);
+#endif
+#ifdef SCUMMVM_AVX2
+void getMixKernelsAVX2(MixKernels &kernels);
+#endif
+#ifdef SCUMMVM_NEON
+void getMixKernelsNEON(MixKernels &kernels);
+#endif
+
+/**
+ * Select the fastest kernels supported by the CPU, unless this already
+ * happened. The mixer calls this when it is created, so that the detection
+ * never runs on the audio thread.
+ */
+void initMixKernels();
+
+/**
+ * Return the kernels selected by initMixKernels(), selecting them first
+ * if necessary.
+ */
+const MixKernels &getMixKernels();
+
+/**
+ * Override the kernels returned by getMixKernels(), e.g. to test a specific
+ * implementation. Rate converters pick their kernel when they are created.
+ */
+void setMixKernels(const MixKernels &kernels);
+
+/**
+ * Undo setMixKernels(). The next call to initMixKernels() detects the
+ * kernels supported by the CPU again.
+ */
+void resetMixKernels();
+
+/**
+ * Create a rate converter using a windowed-sinc filter.
+ *
+ * @see makeRateConverter()
+ */
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo);
+
+static inline int scaleSample(int sample, int vol) {
+	return (sample * vol) / Mixer::kMaxMixerVolume;
+}
+
+static inline void accumulateSample(st_sample_t &out, int val) {
+	clampedAdd(out, val);
+}
+
+static inline void accumulateSample(st_mix_t &out, int val) {
+	out += val;
+}
+
+/**
+ * Scalar implementation of the mix kernels, for both the 16-bit output used
+ * by RateConverter users which mix themselves, and the 32-bit mix bus. The
+ * SIMD kernels use it for the frames which do not fill a whole vector.
+ */
+template<class T, bool inStereo, bool outStereo, bool reverseStereo>
+static inline void mixFramesGeneric(T *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	for (uint i = 0; i < frames; i++) {
+		const st_sample_t inL = *in++;
+		const st_sample_t inR = (inStereo ? *in++ : inL);
+
+		const st_sample_t outL = scaleSample(inL, volL);
+		const st_sample_t outR = scaleSample(inR, volR);
+
+		if (outStereo) {
+			accumulateSample(out[reverseStereo    ], outL);
+			accumulateSample(out[reverseStereo ^ 1], outR);
+			out += 2;
+		} else {
+			accumulateSample(out[0], (outL + outR) / 2);
+			out += 1;
+		}
+	}
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+static inline MixMode getMixMode() {
+	if (inStereo)
+		return outStereo ? (reverseStereo ? kMixStereoToStereoReversed : kMixStereoToStereo) : kMixStereoToMono;
+	else
+		return outStereo ? kMixMonoToStereo : kMixMonoToMono;
+}
+
+/**
+ * Add a block of resampled frames to the output of a rate converter. The
+ * 16-bit output is saturated after each frame by the scalar code, while the
+ * 32-bit mix bus uses the kernel selected by the converter.
+ */
+template<bool inStereo, bool outStereo, bool reverseStereo>
+static inline void mixBlock(st_sample_t *out, const st_sample_t *in, uint frames, int volL, int volR, MixKernels::MixFunc) {
+	mixFramesGeneric<st_sample_t, inStereo, outStereo, reverseStereo>(out, in, frames, volL, volR);
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+static inline void mixBlock(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR, MixKernels::MixFunc mixFunc) {
+	mixFunc(out, in, frames, volL, volR);
+}
+
+static inline void clampSamplesGeneric(st_sample_t *out, const st_mix_t *in, uint numSamples) {
+	for (uint i = 0; i < numSamples; i++) {
+		const int val = CLIP<st_mix_t>(in[i], ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+#ifdef OUTPUT_UNSIGNED_AUDIO
+		out[i] = ((st_sample_t)val) ^ 0x8000;
+#else
+		out[i] = val;
+#endif
+	}
+}
+
+} // End of namespace Audio
+
+#endif
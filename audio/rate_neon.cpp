@@ -0,0 +1,178 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/rate_intern.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Audio {
+
+STATIC_ASSERT(Mixer::kMaxMixerVolume == 256, mix_kernels_assume_a_max_mixer_volume_of_256);
+
+// Divide by kMaxMixerVolume, rounding towards zero like the scalar code does
+static inline int32x4_t neon_div256(int32x4_t x) {
+	const uint32x4_t bias = vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(x, 31)), 24);
+	return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(bias)), 8);
+}
+
+// Divide by two, rounding towards zero like the scalar code does
+static inline int32x4_t neon_div2(int32x4_t x) {
+	const uint32x4_t bias = vshrq_n_u32(vreinterpretq_u32_s32(x), 31);
+	return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(bias)), 1);
+}
+
+// Scale 8 samples by 8 volumes, giving 8 32-bit results
+static inline void neon_scale(int16x8_t in, int16x8_t vol, int32x4_t &lo, int32x4_t &hi) {
+	lo = neon_div256(vmull_s16(vget_low_s16(in), vget_low_s16(vol)));
+	hi = neon_div256(vmull_s16(vget_high_s16(in), vget_high_s16(vol)));
+}
+
+static inline void neon_accumulate(st_mix_t *out, int32x4_t val) {
+	vst1q_s32((int32_t *)out, vaddq_s32(vld1q_s32((const int32_t *)out), val));
+}
+
+static inline int16x8_t neon_volumePairs(int volL, int volR) {
+	const int16 vols[8] = { (int16)volL, (int16)volR, (int16)volL, (int16)volR, (int16)volL, (int16)volR, (int16)volL, (int16)volR };
+	return vld1q_s16(vols);
+}
+
+static void mixMonoToMonoNEON(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const int16x8_t vecVolL = vdupq_n_s16(volL);
+	const int16x8_t vecVolR = vdupq_n_s16(volR);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 8, out += 8) {
+		const int16x8_t src = vld1q_s16(in);
+		int32x4_t loL, hiL, loR, hiR;
+		neon_scale(src, vecVolL, loL, hiL);
+		neon_scale(src, vecVolR, loR, hiR);
+		neon_accumulate(out, neon_div2(vaddq_s32(loL, loR)));
+		neon_accumulate(out + 4, neon_div2(vaddq_s32(hiL, hiR)));
+	}
+
+	mixFramesGeneric<st_mix_t, false, false, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixMonoToStereoNEON(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const int16x8_t vol = neon_volumePairs(volL, volR);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 8, out += 16) {
+		const int16x8_t src = vld1q_s16(in);
+		const int16x8x2_t dup = vzipq_s16(src, src);
+
+		int32x4_t lo, hi;
+		neon_scale(dup.val[0], vol, lo, hi);
+		neon_accumulate(out, lo);
+		neon_accumulate(out + 4, hi);
+		neon_scale(dup.val[1], vol, lo, hi);
+		neon_accumulate(out + 8, lo);
+		neon_accumulate(out + 12, hi);
+	}
+
+	mixFramesGeneric<st_mix_t, false, true, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixStereoToMonoNEON(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const int16x8_t vecVolL = vdupq_n_s16(volL);
+	const int16x8_t vecVolR = vdupq_n_s16(volR);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 16, out += 8) {
+		// Load the left and right channels into separate registers
+		const int16x8x2_t src = vld2q_s16(in);
+
+		int32x4_t loL, hiL, loR, hiR;
+		neon_scale(src.val[0], vecVolL, loL, hiL);
+		neon_scale(src.val[1], vecVolR, loR, hiR);
+		neon_accumulate(out, neon_div2(vaddq_s32(loL, loR)));
+		neon_accumulate(out + 4, neon_div2(vaddq_s32(hiL, hiR)));
+	}
+
+	mixFramesGeneric<st_mix_t, true, false, false>(out, in, frames - i, volL, volR);
+}
+
+template<bool reverseStereo>
+static void mixStereoToStereoNEON(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	// When reversing, swap the channels of each frame, which moves the
+	// left volume to the right channel as well
+	const int16x8_t vol = reverseStereo ? neon_volumePairs(volR, volL) : neon_volumePairs(volL, volR);
+
+	uint i = 0;
+	for (; i + 4 <= frames; i += 4, in += 8, out += 8) {
+		int16x8_t src = vld1q_s16(in);
+		if (reverseStereo)
+			src = vrev32q_s16(src);
+
+		int32x4_t lo, hi;
+		neon_scale(src, vol, lo, hi);
+		neon_accumulate(out, lo);
+		neon_accumulate(out + 4, hi);
+	}
+
+	mixFramesGeneric<st_mix_t, true, true, reverseStereo>(out, in, frames - i, volL, volR);
+}
+
+static void clampSamplesNEON(st_sample_t *out, const st_mix_t *in, uint numSamples) {
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8, in += 8, out += 8)
+		vst1q_s16(out, vcombine_s16(vqmovn_s32(vld1q_s32((const int32_t *)in)), vqmovn_s32(vld1q_s32((const int32_t *)(in + 4)))));
+
+	clampSamplesGeneric(out, in, numSamples - i);
+}
+
+void getMixKernelsNEON(MixKernels &kernels) {
+	kernels.mix[kMixMonoToMono] = mixMonoToMonoNEON;
+	kernels.mix[kMixMonoToStereo] = mixMonoToStereoNEON;
+	kernels.mix[kMixStereoToMono] = mixStereoToMonoNEON;
+	kernels.mix[kMixStereoToStereo] = mixStereoToStereoNEON<false>;
+	kernels.mix[kMixStereoToStereoReversed] = mixStereoToStereoNEON<true>;
+	kernels.clamp = clampSamplesNEON;
+}
+
+} // End of namespace Audio
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
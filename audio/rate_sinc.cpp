@@ -0,0 +1,478 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * A polyphase windowed-sinc resampler. The filter coefficients are computed
+ * once per ratio between input and output rate, in floating point, and are
+ * shared by all converters using that ratio. The filtering itself only uses
+ * integer arithmetic.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/rate_intern.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/atomic.h"
+#include "common/mutex.h"
+#include "common/singleton.h"
+#include "common/util.h"
+
+#include <math.h>
+
+namespace Audio {
+
+enum {
+	/** Zero crossings of the filter on each side of its center, when upsampling */
+	kSincHalfWidth = 24,
+	/** Upper limit for the half width, which grows with the downsampling ratio */
+	kSincMaxHalfWidth = 128,
+	/** Upper limit for the number of filter phases stored in a table */
+	kSincMaxPhases = 1024,
+	/** Fractional bits of the filter coefficients */
+	kSincCoefBits = 14,
+	/** Size of the input window, in frames */
+	kSincWindowFrames = 2 * kSincMaxHalfWidth + 512
+};
+
+/** Cutoff frequency, relative to the lower of the input and output Nyquist frequencies */
+static const double kSincCutoff = 0.9;
+
+/** Shape of the Kaiser window, which gives about 80dB of stopband attenuation */
+static const double kSincKaiserBeta = 8.0;
+
+/**
+ * Filter coefficients for one ratio between the input and output rate.
+ *
+ * The output frames are spaced decimation / interpolation input frames
+ * apart, so each output frame falls on one of interpolation possible
+ * positions (phases) between two input frames. If there are too many of
+ * them, the nearest of kSincMaxPhases evenly spaced phases is used instead.
+ */
+struct SincTable : public RateConverterData {
+	uint interpolation;
+	uint decimation;
+	uint phases;
+	uint halfWidth;
+	mutable uint32 refCount;
+
+	/**
+	 * (phases + 1) * 2 * halfWidth coefficients, with a sum of
+	 * 1 << kSincCoefBits for each phase. The extra phase is one input frame
+	 * further, so rounding to the nearest phase does not need to wrap around.
+	 */
+	int16 *coefs;
+
+	SincTable() : interpolation(0), decimation(0), phases(0), halfWidth(0), refCount(0), coefs(nullptr) {}
+	~SincTable() override { delete[] coefs; }
+
+	void release() override;
+};
+
+/**
+ * Keeps the coefficient tables shared between converters. Unused tables are
+ * kept until a table for a new ratio is needed, since sounds using the same
+ * rate tend to be played one after another.
+ *
+ * Only acquireTable() takes the lock and allocates memory. Releasing a table
+ * is an atomic decrement where possible, so it can be done on the audio
+ * thread, and unused tables are only deleted by acquireTable().
+ */
+class SincTableCache : public Common::Singleton<SincTableCache> {
+public:
+	~SincTableCache();
+
+	SincTable *acquireTable(st_rate_t inRate, st_rate_t outRate);
+	void releaseTable(const SincTable *table);
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	SincTableCache() {}
+
+	static SincTable *createTable(uint interpolation, uint decimation);
+
+	Common::Mutex _mutex;
+	Common::Array<SincTable *> _tables;
+};
+
+} // End of namespace Audio
+
+namespace Common {
+DECLARE_SINGLETON(Audio::SincTableCache);
+}
+
+namespace Audio {
+
+/** Modified Bessel function of the first kind and order zero, used by the Kaiser window */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; term > sum * 1e-12; k++) {
+		const double factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+	}
+	return sum;
+}
+
+SincTableCache::~SincTableCache() {
+	for (uint i = 0; i < _tables.size(); i++)
+		delete _tables[i];
+}
+
+SincTable *SincTableCache::acquireTable(st_rate_t inRate, st_rate_t outRate) {
+	const st_rate_t divisor = Common::gcd(inRate, outRate);
+	const uint interpolation = outRate / divisor;
+	const uint decimation = inRate / divisor;
+
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _tables.size(); i++) {
+		if (_tables[i]->interpolation == interpolation && _tables[i]->decimation == decimation) {
+			Common::atomicAdd(&_tables[i]->refCount, 1);
+			return _tables[i];
+		}
+	}
+
+	// The reference count cannot go up again without the lock
+	for (uint i = 0; i < _tables.size();) {
+		if (Common::atomicLoad(&_tables[i]->refCount) == 0) {
+			delete _tables[i];
+			_tables.remove_at(i);
+		} else {
+			i++;
+		}
+	}
+
+	SincTable *table = createTable(interpolation, decimation);
+	table->refCount = 1;
+	_tables.push_back(table);
+	return table;
+}
+
+void SincTableCache::releaseTable(const SincTable *table) {
+#ifdef COMMON_HAS_ATOMICS
+	const uint32 refCount = Common::atomicAdd(&table->refCount, (uint32)-1);
+#else
+	Common::StackLock lock(_mutex);
+	const uint32 refCount = --table->refCount;
+#endif
+	assert(refCount != (uint32)-1);
+	(void)refCount;
+}
+
+void SincTable::release() {
+	SincTableCache::instance().releaseTable(this);
+}
+
+SincTable *SincTableCache::createTable(uint interpolation, uint decimation) {
+	SincTable *table = new SincTable();
+	table->interpolation = interpolation;
+	table->decimation = decimation;
+	table->phases = MIN<uint>(interpolation, kSincMaxPhases);
+
+	// When downsampling, the cutoff frequency has to be lowered to the output
+	// Nyquist frequency, and the filter has to be made longer to keep the
+	// same transition band
+	const double ratio = MAX<double>(1.0, (double)decimation / interpolation);
+	const double cutoff = kSincCutoff / ratio;
+	table->halfWidth = MIN<uint>((uint)ceil(kSincHalfWidth * ratio), kSincMaxHalfWidth);
+
+	const uint taps = 2 * table->halfWidth;
+	table->coefs = new int16[(table->phases + 1) * taps];
+
+	const double windowScale = 1.0 / besselI0(kSincKaiserBeta);
+	double values[2 * kSincMaxHalfWidth];
+
+	for (uint phase = 0; phase <= table->phases; phase++) {
+		// Tap k is applied to the input frame at offset k - halfWidth + 1
+		// from the frame at or before the output position
+		const double frac = (double)phase / table->phases;
+		double sum = 0.0;
+
+		for (uint k = 0; k < taps; k++) {
+			const double t = (double)k - table->halfWidth + 1 - frac;
+			const double x = t / table->halfWidth;
+			const double window = besselI0(kSincKaiserBeta * sqrt(MAX<double>(0.0, 1.0 - x * x))) * windowScale;
+			const double sinc = (t == 0.0) ? 1.0 : sin(M_PI * cutoff * t) / (M_PI * cutoff * t);
+
+			values[k] = cutoff * sinc * window;
+			sum += values[k];
+		}
+
+		// Normalize each phase separately, so that a constant input gives a
+		// constant output, and put the rounding error on the largest tap
+		int16 *coefs = table->coefs + phase * taps;
+		int intSum = 0;
+		uint largest = 0;
+		for (uint k = 0; k < taps; k++) {
+			coefs[k] = (int16)floor(values[k] / sum * (1 << kSincCoefBits) + 0.5);
+			intSum += coefs[k];
+			if (coefs[k] > coefs[largest])
+				largest = k;
+		}
+		coefs[largest] += (1 << kSincCoefBits) - intSum;
+	}
+
+	return table;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+class SincRateConverter : public RateConverter {
+private:
+	/** Input and output rates */
+	st_rate_t _inRate, _outRate;
+
+	/** The coefficients for the current rates */
+	const SincTable *_table;
+
+	/**
+	 * The input frames which the filter is applied to. Besides the frames
+	 * still to be filtered, it keeps enough past frames for the longest
+	 * filter, so a rate change never needs frames which were dropped.
+	 */
+	st_sample_t _window[kSincWindowFrames * (inStereo ? 2 : 1)];
+
+	/** Number of frames currently in the window */
+	uint _windowFrames;
+
+	/** Index of the input frame at or before the next output frame */
+	uint _pos;
+
+	/** Position of the next output frame after _pos, in 1 / interpolation frames */
+	uint _phase;
+
+	/** Whether any data was read from the input stream */
+	bool _inputSeen;
+
+	/** Whether the end of the input stream was padded with silence */
+	bool _flushed;
+
+	/** Resampled frames waiting to be mixed, in the input channel layout */
+	st_sample_t _outBlock[512];
+
+	/** The kernel used to add frames to a 32-bit mix bus */
+	MixKernels::MixFunc _mixFunc;
+
+	void setTable(const SincTable *table);
+	bool fillWindow(AudioStream &input);
+	int resample(AudioStream &input, int maxFrames);
+
+	template<class T>
+	int convertT(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r);
+
+public:
+	SincRateConverter(st_rate_t inputRate, st_rate_t outputRate);
+	~SincRateConverter() override;
+
+	int convert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override {
+		return convertT(input, outBuffer, numSamples, vol_l, vol_r);
+	}
+
+	int convert(AudioStream &input, st_mix_t *outBuffer, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r) override {
+		return convertT(input, outBuffer, numSamples, vol_l, vol_r);
+	}
+
+	void setInputRate(st_rate_t inputRate) override {
+		setPreparedInputRate(inputRate, prepareInputRate(inputRate));
+	}
+
+	void setOutputRate(st_rate_t outputRate) override {
+		if (outputRate != _outRate) {
+			setTable(SincTableCache::instance().acquireTable(_inRate, outputRate));
+			_outRate = outputRate;
+		}
+	}
+
+	RateConverterData *prepareInputRate(st_rate_t inputRate) const override {
+		return SincTableCache::instance().acquireTable(inputRate, _outRate);
+	}
+
+	void setPreparedInputRate(st_rate_t inputRate, RateConverterData *data) override {
+		assert(data);
+		setTable(static_cast<const SincTable *>(data));
+		_inRate = inputRate;
+	}
+
+	st_rate_t getInputRate() const override { return _inRate; }
+	st_rate_t getOutputRate() const override { return _outRate; }
+
+	bool needsDraining() const override {
+		// Until the end of the stream is known, the last input frames are
+		// still needed for output frames which have not been produced yet
+		if (!_flushed)
+			return _inputSeen;
+		return _pos + _table->halfWidth < _windowFrames;
+	}
+};
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincRateConverter<inStereo, outStereo, reverseStereo>::SincRateConverter(st_rate_t inputRate, st_rate_t outputRate) :
+	_inRate(inputRate),
+	_outRate(outputRate),
+	_table(nullptr),
+	_windowFrames(kSincMaxHalfWidth - 1),
+	_pos(kSincMaxHalfWidth - 1),
+	_phase(0),
+	_inputSeen(false),
+	_flushed(false) {
+
+	// The first output frame is centered on the first input frame, so the
+	// filter starts with silence on its left side
+	memset(_window, 0, sizeof(_window));
+
+	_table = SincTableCache::instance().acquireTable(_inRate, _outRate);
+	_mixFunc = getMixKernels().mix[getMixMode<inStereo, outStereo, reverseStereo>()];
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+SincRateConverter<inStereo, outStereo, reverseStereo>::~SincRateConverter() {
+	SincTableCache::instance().releaseTable(_table);
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+void SincRateConverter<inStereo, outStereo, reverseStereo>::setTable(const SincTable *table) {
+	// Keep the position between the input frames
+	_phase = (uint)((uint64)_phase * table->interpolation / _table->interpolation);
+
+	SincTableCache::instance().releaseTable(_table);
+	_table = table;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+bool SincRateConverter<inStereo, outStereo, reverseStereo>::fillWindow(AudioStream &input) {
+	const uint channels = inStereo ? 2 : 1;
+
+	// Drop the frames which are too old for any filter
+	if (_pos > kSincMaxHalfWidth - 1) {
+		const uint shift = MIN<uint>(_pos - (kSincMaxHalfWidth - 1), _windowFrames);
+		memmove(_window, _window + shift * channels, (_windowFrames - shift) * channels * sizeof(st_sample_t));
+		_windowFrames -= shift;
+		_pos -= shift;
+	}
+
+	const int samples = input.readBuffer(_window + _windowFrames * channels, (kSincWindowFrames - _windowFrames) * channels);
+	if (samples >= (int)channels) {
+		// An incomplete stereo frame at the end of the stream is dropped
+		_windowFrames += samples / channels;
+		_inputSeen = true;
+		return true;
+	}
+
+	// Once the stream has ended, pad it with silence so the filter reaches
+	// its last frames
+	if (_inputSeen && !_flushed && input.endOfStream()) {
+		const uint padding = MIN<uint>(_table->halfWidth, kSincWindowFrames - _windowFrames);
+		memset(_window + _windowFrames * channels, 0, padding * channels * sizeof(st_sample_t));
+		_windowFrames += padding;
+		_flushed = true;
+		return true;
+	}
+
+	return false;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+int SincRateConverter<inStereo, outStereo, reverseStereo>::resample(AudioStream &input, int maxFrames) {
+	const SincTable &table = *_table;
+	const uint halfWidth = table.halfWidth;
+	const uint taps = 2 * halfWidth;
+	const bool exactPhases = (table.phases == table.interpolation);
+
+	st_sample_t *blockPos = _outBlock;
+	int frames = 0;
+
+	while (frames < maxFrames) {
+		// Make sure the filter has all the frames it needs
+		while (_pos + halfWidth >= _windowFrames) {
+			if (!fillWindow(input))
+				return frames;
+		}
+
+		const uint phase = exactPhases ? _phase : (uint)(((uint64)_phase * table.phases + table.interpolation / 2) / table.interpolation);
+		const int16 *coefs = table.coefs + phase * taps;
+		const st_sample_t *in = _window + (_pos + 1 - halfWidth) * (inStereo ? 2 : 1);
+
+		int32 accL = 0, accR = 0;
+		for (uint k = 0; k < taps; k++) {
+			if (inStereo) {
+				accL += in[2 * k] * coefs[k];
+				accR += in[2 * k + 1] * coefs[k];
+			} else {
+				accL += in[k] * coefs[k];
+			}
+		}
+
+		*blockPos++ = (st_sample_t)CLIP<int32>((accL + (1 << (kSincCoefBits - 1))) >> kSincCoefBits, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+		if (inStereo)
+			*blockPos++ = (st_sample_t)CLIP<int32>((accR + (1 << (kSincCoefBits - 1))) >> kSincCoefBits, ST_SAMPLE_MIN, ST_SAMPLE_MAX);
+
+		// Increment output position
+		_phase += table.decimation;
+		_pos += _phase / table.interpolation;
+		_phase %= table.interpolation;
+		frames++;
+	}
+
+	return frames;
+}
+
+template<bool inStereo, bool outStereo, bool reverseStereo>
+template<class T>
+int SincRateConverter<inStereo, outStereo, reverseStereo>::convertT(AudioStream &input, T *outBuffer, st_size_t numSamples, st_volume_t volL, st_volume_t volR) {
+	assert(input.isStereo() == inStereo);
+
+	T *outStart, *outEnd;
+
+	outStart = outBuffer;
+	outEnd = outBuffer + numSamples * (outStereo ? 2 : 1);
+
+	while (outBuffer < outEnd) {
+		const int wanted = MIN<int>(ARRAYSIZE(_outBlock) / (inStereo ? 2 : 1), (outEnd - outBuffer) / (outStereo ? 2 : 1));
+		const int frames = resample(input, wanted);
+
+		mixBlock<inStereo, outStereo, reverseStereo>(outBuffer, _outBlock, frames, volL, volR, _mixFunc);
+		outBuffer += frames * (outStereo ? 2 : 1);
+
+		// The input stream ran out of data
+		if (frames < wanted)
+			break;
+	}
+	return (outBuffer - outStart) / (outStereo ? 2 : 1);
+}
+
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+	if (inStereo) {
+		if (outStereo) {
+			if (reverseStereo)
+				return new SincRateConverter<true, true, true>(inRate, outRate);
+			else
+				return new SincRateConverter<true, true, false>(inRate, outRate);
+		} else
+			return new SincRateConverter<true, false, false>(inRate, outRate);
+	} else {
+		if (outStereo) {
+			return new SincRateConverter<false, true, false>(inRate, outRate);
+		} else
+			return new SincRateConverter<false, false, false>(inRate, outRate);
+	}
+}
+
+} // End of namespace Audio
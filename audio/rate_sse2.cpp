@@ -0,0 +1,171 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_intern.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+STATIC_ASSERT(Mixer::kMaxMixerVolume == 256, mix_kernels_assume_a_max_mixer_volume_of_256);
+
+// Divide by kMaxMixerVolume, rounding towards zero like the scalar code does
+static FORCEINLINE __m128i sse2_div256(__m128i x) {
+	return _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(_mm_srai_epi32(x, 31), 24)), 8);
+}
+
+// Divide by two, rounding towards zero like the scalar code does
+static FORCEINLINE __m128i sse2_div2(__m128i x) {
+	return _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1);
+}
+
+// Scale 8 samples by 8 volumes, giving 8 32-bit results
+static FORCEINLINE void sse2_scale(__m128i in, __m128i vol, __m128i &lo, __m128i &hi) {
+	const __m128i prodLo = _mm_mullo_epi16(in, vol);
+	const __m128i prodHi = _mm_mulhi_epi16(in, vol);
+	lo = sse2_div256(_mm_unpacklo_epi16(prodLo, prodHi));
+	hi = sse2_div256(_mm_unpackhi_epi16(prodLo, prodHi));
+}
+
+static FORCEINLINE void sse2_accumulate(st_mix_t *out, __m128i val) {
+	_mm_storeu_si128((__m128i *)out, _mm_add_epi32(_mm_loadu_si128((const __m128i *)out), val));
+}
+
+static void mixMonoToMonoSSE2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m128i vecVolL = _mm_set1_epi16(volL);
+	const __m128i vecVolR = _mm_set1_epi16(volR);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 8, out += 8) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)in);
+		__m128i loL, hiL, loR, hiR;
+		sse2_scale(src, vecVolL, loL, hiL);
+		sse2_scale(src, vecVolR, loR, hiR);
+		sse2_accumulate(out, sse2_div2(_mm_add_epi32(loL, loR)));
+		sse2_accumulate(out + 4, sse2_div2(_mm_add_epi32(hiL, hiR)));
+	}
+
+	mixFramesGeneric<st_mix_t, false, false, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixMonoToStereoSSE2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m128i vol = _mm_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8, in += 8, out += 16) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)in);
+		__m128i lo, hi;
+		sse2_scale(_mm_unpacklo_epi16(src, src), vol, lo, hi);
+		sse2_accumulate(out, lo);
+		sse2_accumulate(out + 4, hi);
+		sse2_scale(_mm_unpackhi_epi16(src, src), vol, lo, hi);
+		sse2_accumulate(out + 8, lo);
+		sse2_accumulate(out + 12, hi);
+	}
+
+	mixFramesGeneric<st_mix_t, false, true, false>(out, in, frames - i, volL, volR);
+}
+
+static void mixStereoToMonoSSE2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	const __m128i vol = _mm_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 4 <= frames; i += 4, in += 8, out += 4) {
+		__m128i lo, hi;
+		sse2_scale(_mm_loadu_si128((const __m128i *)in), vol, lo, hi);
+
+		// Separate the left and right channels again
+		const __m128 loF = _mm_castsi128_ps(lo), hiF = _mm_castsi128_ps(hi);
+		const __m128i left = _mm_castps_si128(_mm_shuffle_ps(loF, hiF, _MM_SHUFFLE(2, 0, 2, 0)));
+		const __m128i right = _mm_castps_si128(_mm_shuffle_ps(loF, hiF, _MM_SHUFFLE(3, 1, 3, 1)));
+		sse2_accumulate(out, sse2_div2(_mm_add_epi32(left, right)));
+	}
+
+	mixFramesGeneric<st_mix_t, true, false, false>(out, in, frames - i, volL, volR);
+}
+
+template<bool reverseStereo>
+static void mixStereoToStereoSSE2(st_mix_t *out, const st_sample_t *in, uint frames, int volL, int volR) {
+	// When reversing, swap the channels of each frame, which moves the
+	// left volume to the right channel as well
+	const __m128i vol = reverseStereo ?
+		_mm_set_epi16(volL, volR, volL, volR, volL, volR, volL, volR) :
+		_mm_set_epi16(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 4 <= frames; i += 4, in += 8, out += 8) {
+		__m128i src = _mm_loadu_si128((const __m128i *)in);
+		if (reverseStereo)
+			src = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+
+		__m128i lo, hi;
+		sse2_scale(src, vol, lo, hi);
+		sse2_accumulate(out, lo);
+		sse2_accumulate(out + 4, hi);
+	}
+
+	mixFramesGeneric<st_mix_t, true, true, reverseStereo>(out, in, frames - i, volL, volR);
+}
+
+static void clampSamplesSSE2(st_sample_t *out, const st_mix_t *in, uint numSamples) {
+	uint i = 0;
+	for (; i + 8 <= numSamples; i += 8, in += 8, out += 8) {
+		const __m128i lo = _mm_loadu_si128((const __m128i *)in);
+		const __m128i hi = _mm_loadu_si128((const __m128i *)(in + 4));
+		_mm_storeu_si128((__m128i *)out, _mm_packs_epi32(lo, hi));
+	}
+
+	clampSamplesGeneric(out, in, numSamples - i);
+}
+
+void getMixKernelsSSE2(MixKernels &kernels) {
+	kernels.mix[kMixMonoToMono] = mixMonoToMonoSSE2;
+	kernels.mix[kMixMonoToStereo] = mixMonoToStereoSSE2;
+	kernels.mix[kMixStereoToMono] = mixStereoToMonoSSE2;
+	kernels.mix[kMixStereoToStereo] = mixStereoToStereoSSE2<false>;
+	kernels.mix[kMixStereoToStereoReversed] = mixStereoToStereoSSE2<true>;
+	kernels.clamp = clampSamplesSSE2;
+}
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -172,6 +172,16 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Queries the size and the last modification time of the file referred by
+	 * this node, without opening it. The modification time uses a
+	 * backend-specific unit, and is only meant to be compared with other
+	 * values returned by this method.
+	 *
+	 * @return bool true if the information is available, false otherwise
+	 */
+	virtual bool getFileStats(int64 &size, int64 &modificationTime) const;
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
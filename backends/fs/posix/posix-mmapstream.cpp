@@ -0,0 +1,110 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#ifdef HAS_MMAP
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/vfs.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+
+bool PosixMmapStream::_enabled = false;
+
+// Files on network filesystems may change or go away while they are mapped,
+// which raises SIGBUS on the next access instead of failing a read
+static bool isOnNetworkFilesystem(int fd) {
+#if defined(__linux__)
+	struct statfs fs;
+	if (fstatfs(fd, &fs) == -1)
+		return true;
+
+	switch ((uint32)fs.f_type) {
+	case 0x6969:     // NFS_SUPER_MAGIC
+	case 0x517B:     // SMB_SUPER_MAGIC
+	case 0xFF534D42: // CIFS_MAGIC_NUMBER
+	case 0xFE534D42: // SMB2_MAGIC_NUMBER
+	case 0x65735546: // FUSE_SUPER_MAGIC
+		return true;
+	default:
+		return false;
+	}
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+	struct statfs fs;
+	if (fstatfs(fd, &fs) == -1)
+		return true;
+
+	static const char *const networkTypes[] = { "nfs", "smbfs", "afpfs", "webdav", "macfuse", "osxfuse" };
+	for (uint i = 0; i < ARRAYSIZE(networkTypes); i++) {
+		if (!strcmp(fs.f_fstypename, networkTypes[i]))
+			return true;
+	}
+	// FreeBSD names FUSE filesystems after their driver, like fusefs.sshfs
+	return !strncmp(fs.f_fstypename, "fusefs", 6);
+#else
+	return false;
+#endif
+}
+
+PosixMmapStream *PosixMmapStream::makeFromPath(const Common::String &path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	// Only regular files on local filesystems are mapped, and the size of
+	// the stream is limited to 32 bits
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+	        (uint64)st.st_size > 0xFFFFFFFF || (uint64)st.st_size > (size_t)-1 ||
+	        isOnNetworkFilesystem(fd)) {
+		close(fd);
+		return nullptr;
+	}
+
+	// The mapping stays valid after closing the file
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	return new PosixMmapStream(data, st.st_size);
+}
+
+PosixMmapStream::PosixMmapStream(void *data, uint32 size) :
+		MemoryReadStream((const byte *)data, size), _data(data), _mappedSize(size) {
+}
+
+PosixMmapStream::~PosixMmapStream() {
+	munmap(_data, _mappedSize);
+}
+
+#endif
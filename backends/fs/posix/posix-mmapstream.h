@@ -0,0 +1,68 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+#define BACKENDS_FS_POSIX_POSIXMMAPSTREAM_H
+
+#include "common/scummsys.h"
+
+#ifdef HAS_MMAP
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+/**
+ * A file input stream which maps the whole file into memory, so that
+ * reading it does not copy it into the buffers of stdio first. The data
+ * can be used in place through Common::getMappedSpan().
+ */
+class PosixMmapStream final : public Common::MemoryReadStream {
+public:
+	/**
+	 * Map the file at the given path into memory. Returns nullptr for files
+	 * which cannot be mapped, such as pipes, empty files, files on some
+	 * network filesystems and files too large for the address space, which
+	 * have to be read with PosixIoStream instead.
+	 */
+	static PosixMmapStream *makeFromPath(const Common::String &path);
+
+	/**
+	 * Set whether POSIXFilesystemNode maps files into memory, which is the
+	 * mmap_files option. This is set once by the backend at startup, before
+	 * any other thread opens files.
+	 */
+	static void setEnabled(bool enabled) { _enabled = enabled; }
+	static bool isEnabled() { return _enabled; }
+
+	~PosixMmapStream() override;
+
+private:
+	PosixMmapStream(void *data, uint32 size);
+
+	static bool _enabled;
+
+	void *_data;
+	uint32 _mappedSize;
+};
+
+#endif
+
+#endif
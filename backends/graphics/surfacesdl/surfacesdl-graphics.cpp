@@ -25,6 +25,7 @@
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #include "backends/events/sdl/sdl-events.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
@@ -34,6 +35,8 @@
 #ifdef USE_RGB_COLOR
 #include "common/list.h"
 #endif
+#include "common/profiler.h"
+#include "common/taskpool.h"
 #include "graphics/blit.h"
 #include "graphics/font.h"
 #include "graphics/fontman.h"
@@ -177,7 +180,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_screen(nullptr), _tmpscreen(nullptr),
 	_screenFormat(Graphics::PixelFormat::createFormatCLUT8()),
 	_cursorFormat(Graphics::PixelFormat::createFormatCLUT8()),
-	_useOldSrc(false), _isHwPalette(false),
+	_useOldSrc(false), _scaleInParallel(false), _useFrameDiff(false), _isHwPalette(false),
 	_overlayscreen(nullptr), _tmpscreen2(nullptr),
 	_screenChangeCount(0),
 	_mouseSurface(nullptr), _mouseScaler(nullptr),
@@ -213,6 +216,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_mouseLastRect.x = _mouseLastRect.y = _mouseLastRect.w = _mouseLastRect.h = 0;
 	_mouseNextRect.x = _mouseNextRect.y = _mouseNextRect.w = _mouseNextRect.h = 0;
 
+	if (ConfMan.hasKey("frame_diff"))
+		_useFrameDiff = ConfMan.getBool("frame_diff");
+
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	if (ConfMan.hasKey("use_sdl_debug_focusrect"))
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
@@ -240,6 +246,9 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 }
 
 SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
+	if (_useFrameDiff)
+		debug(1, "Frame diff: %u of %u compared tiles were unchanged", _frameDiff.getSkippedTiles(), _frameDiff.getComparedTiles());
+
 	unloadGFXMode();
 	delete _scaler;
 	delete _mouseScaler;
@@ -787,6 +796,7 @@ void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 	_scaler->setFactor(_videoMode.scaleFactor);
 	_extraPixels = _scalerPlugin->extraPixels();
 	_useOldSrc = _scalerPlugin->useOldSource();
+	_scaleInParallel = _scalerPlugin->canScaleInParallel();
 	if (_useOldSrc) {
 		_scaler->enableSource(true);
 		_scaler->setSource((byte *)_tmpscreen->pixels, _tmpscreen->pitch,
@@ -1067,6 +1077,11 @@ bool SurfaceSdlGraphicsManager::loadGFXMode() {
 	// SDL_SetColors does nothing for non indexed surfaces.
 	SDL_SetColors(_screen, _currentPalette, 0, 256);
 
+	if (_useFrameDiff) {
+		_frameDiff.reset(_videoMode.screenWidth, _videoMode.screenHeight, _screenFormat);
+		_screenChangedRect = Common::Rect();
+	}
+
 	//
 	// Create the surface that contains the scaled graphics in 16 bit mode
 	//
@@ -1157,6 +1172,7 @@ void SurfaceSdlGraphicsManager::unloadGFXMode() {
 		destroySurface(_screen);
 		_screen = nullptr;
 	}
+	_frameDiff.free();
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	deinitializeRenderer();
@@ -1374,6 +1390,9 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		height = _videoMode.screenHeight;
 		oldScaleFactor = scale1 = _videoMode.scaleFactor;
 		_needRestoreAfterOverlay = false;
+
+		if (_useFrameDiff)
+			addFrameDiffRects();
 	} else {
 		origSurf = _overlayscreen;
 		srcSurf = _tmpscreen2;
@@ -1468,6 +1487,12 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		srcPitch = srcSurf->pitch;
 		dstPitch = _hwScreen->pitch;
 
+		// Large rects are scaled in bands on the worker threads, which are
+		// all done before the rect is stretched and shown
+		Common::TaskPool *scalerPool = nullptr;
+		if (_scaleInParallel && g_system->getTaskPool()->getWorkerCount())
+			scalerPool = g_system->getTaskPool();
+
 		for (r = _dirtyRectList; r != lastRect; ++r) {
 			int src_x = r->x;
 			int src_y = r->y;
@@ -1512,8 +1537,12 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 				if (_videoMode.aspectRatioCorrection && !_overlayInGUI)
 					dst_y = real2Aspect(dst_y);
 
-				_scaler->scale((byte *)srcSurf->pixels + (src_x + _maxExtraPixels) * bpp + (src_y + _maxExtraPixels) * srcPitch, srcPitch,
-						(byte *)_hwScreen->pixels + dst_x * bpp + dst_y * dstPitch, dstPitch, dst_w, dst_h, src_x, src_y);
+				if (scalerPool)
+					_scaler->scaleInBands(*scalerPool, _extraPixels, (byte *)srcSurf->pixels + (src_x + _maxExtraPixels) * bpp + (src_y + _maxExtraPixels) * srcPitch, srcPitch,
+							(byte *)_hwScreen->pixels + dst_x * bpp + dst_y * dstPitch, dstPitch, dst_w, dst_h, src_x, src_y);
+				else
+					_scaler->scale((byte *)srcSurf->pixels + (src_x + _maxExtraPixels) * bpp + (src_y + _maxExtraPixels) * srcPitch, srcPitch,
+							(byte *)_hwScreen->pixels + dst_x * bpp + dst_y * dstPitch, dstPitch, dst_w, dst_h, src_x, src_y);
 
 				r->x = dst_x;
 				r->y = dst_y;
@@ -1789,7 +1818,10 @@ void SurfaceSdlGraphicsManager::copyRectToScreen(const void *buf, int pitch, int
 	assert(h > 0 && y + h <= _videoMode.screenHeight);
 	assert(w > 0 && x + w <= _videoMode.screenWidth);
 
-	addDirtyRect(x, y, w, h, false);
+	if (_useFrameDiff)
+		addScreenChange(Common::Rect(x, y, x + w, y + h));
+	else
+		addDirtyRect(x, y, w, h, false);
 
 	// Try to lock the screen surface
 	if (!lockSurface(_screen))
@@ -1841,7 +1873,10 @@ void SurfaceSdlGraphicsManager::unlockScreen() {
 	SDL_UnlockSurface(_screen);
 
 	// Trigger a full screen update
-	_forceRedraw = true;
+	if (_useFrameDiff)
+		addScreenChange(Common::Rect(_videoMode.screenWidth, _videoMode.screenHeight));
+	else
+		_forceRedraw = true;
 
 	// Finally unlock the graphics mutex
 	_graphicsMutex.unlock();
@@ -1930,6 +1965,36 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool in
 	}
 }
 
+void SurfaceSdlGraphicsManager::addScreenChange(const Common::Rect &r) {
+	if (_screenChangedRect.isEmpty())
+		_screenChangedRect = r;
+	else
+		_screenChangedRect.extend(r);
+}
+
+void SurfaceSdlGraphicsManager::addFrameDiffRects() {
+	if (_screenChangedRect.isEmpty())
+		return;
+
+	if (!lockSurface(_screen))
+		error("SDL_LockSurface failed: %s", SDL_GetError());
+
+	Graphics::Surface frame;
+	frame.init(_screen->w, _screen->h, _screen->pitch, _screen->pixels, _screenFormat);
+
+	const uint32 skippedTiles = _frameDiff.getSkippedTiles();
+	_frameDiffRects.clear();
+	_frameDiff.compare(frame, _screenChangedRect, _frameDiffRects);
+	_screenChangedRect = Common::Rect();
+
+	SDL_UnlockSurface(_screen);
+
+	for (const Common::Rect &r : _frameDiffRects)
+		addDirtyRect(r.left, r.top, r.width(), r.height(), false);
+
+	PROFILE_COUNTER("Unchanged screen tiles", _frameDiff.getSkippedTiles() - skippedTiles);
+}
+
 int16 SurfaceSdlGraphicsManager::getHeight() const {
 	return _videoMode.screenHeight;
 }
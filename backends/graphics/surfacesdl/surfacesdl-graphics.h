@@ -24,6 +24,7 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "graphics/framediff.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "graphics/scalerplugin.h"
@@ -228,6 +229,7 @@ protected:
 
 	SDL_Surface *_overlayscreen;
 	bool _useOldSrc;
+	bool _scaleInParallel;
 	Graphics::PixelFormat _overlayFormat;
 	bool _isDoubleBuf, _isHwPalette;
 
@@ -366,6 +368,15 @@ protected:
 	SDL_Rect _prevDirtyRectList[NUM_DIRTY_RECT];
 	int _numPrevDirtyRects;
 
+	// Frame diffing
+	// Instead of marking the rects drawn by the engine as dirty, the changed
+	// area is compared with the previous frame before each update, and only
+	// the tiles which differ are marked dirty.
+	bool _useFrameDiff;
+	Graphics::FrameDiff _frameDiff;
+	Common::Rect _screenChangedRect;
+	Common::Array<Common::Rect> _frameDiffRects;
+
 	struct MousePos {
 		// The size and hotspot of the original cursor image.
 		int16 w, h;
@@ -429,6 +440,8 @@ protected:
 #endif
 
 	virtual void addDirtyRect(int x, int y, int w, int h, bool inOverlay, bool realCoordinates = false);
+	void addScreenChange(const Common::Rect &r);
+	void addFrameDiffRects();
 
 	virtual void drawMouse();
 	virtual void undrawMouse();
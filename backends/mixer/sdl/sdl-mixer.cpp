@@ -142,7 +142,14 @@ void SdlMixerManager::init() {
 	desiredSamples = desired.samples;
 #endif
 
-	_mixer = new Audio::MixerImpl(_obtained.freq, _obtained.channels >= 2, desiredSamples);
+	// Advanced users who experience drop-outs while engines are busy may
+	// let the audio callback run without taking the mixer lock. This is
+	// not exposed in the GUI, as some engines rely on that lock.
+	bool lockFree = false;
+	if (ConfMan.hasKey("mixer_lock_free", Common::ConfigManager::kApplicationDomain))
+		lockFree = ConfMan.getBool("mixer_lock_free", Common::ConfigManager::kApplicationDomain);
+
+	_mixer = new Audio::MixerImpl(_obtained.freq, _obtained.channels >= 2, desiredSamples, lockFree);
 	assert(_mixer);
 	_mixer->setReady(true);
 
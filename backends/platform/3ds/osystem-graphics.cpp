@@ -23,6 +23,7 @@
 
 #include "backends/platform/3ds/osystem.h"
 #include "backends/platform/3ds/shader_shbin.h"
+#include "common/profiler.h"
 #include "common/rect.h"
 #include "graphics/blit.h"
 #include "graphics/fontman.h"
@@ -428,6 +429,9 @@ void OSystem_3DS::unlockScreen() {
 }
 
 void OSystem_3DS::updateScreen() {
+	Common::Profiler::endFrame();
+	PROFILE_ZONE("updateScreen");
+
 	if (sleeping || exiting) {
 		return;
 	}
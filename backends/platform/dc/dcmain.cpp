@@ -56,6 +56,7 @@ OSystem_Dreamcast::OSystem_Dreamcast()
 void OSystem_Dreamcast::initBackend()
 {
   ConfMan.setInt("autosave_period", 0);
+  ConfMan.registerDefault("archive_cache_budget", 512);
   _savefileManager = createSavefileManager();
   _timerManager = new DefaultTimerManager();
 
@@ -24,6 +24,7 @@
 #include "backends/platform/ds/osystem_ds.h"
 #include "backends/platform/ds/gfx/banner.h"
 
+#include "common/profiler.h"
 #include "common/translation.h"
 
 #include "graphics/blit.h"
@@ -514,6 +515,9 @@ void OSystem_DS::copyRectToScreen(const void *buf, int pitch, int x, int y, int
 }
 
 void OSystem_DS::updateScreen() {
+	Common::Profiler::endFrame();
+	PROFILE_ZONE("updateScreen");
+
 	swiWaitForVBlank();
 	bgUpdate();
 
@@ -81,6 +81,7 @@ void OSystem_DS::initBackend() {
 
 	ConfMan.setInt("autosave_period", 0);
 	ConfMan.setBool("FM_medium_quality", true);
+	ConfMan.registerDefault("archive_cache_budget", 256);
 
 	_eventSource = new DSEventSource();
 	_eventManager = new DefaultEventManager(_eventSource);
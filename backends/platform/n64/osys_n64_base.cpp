@@ -32,6 +32,7 @@
 #include "backends/mutex/null/null-mutex.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
+#include "common/profiler.h"
 #include "graphics/blit.h"
 
 typedef unsigned long long uint64;
@@ -477,6 +478,9 @@ void OSystem_N64::copyRectToScreen(const void *buf, int pitch, int x, int y, int
 }
 
 void OSystem_N64::updateScreen() {
+	Common::Profiler::endFrame();
+	PROFILE_ZONE("updateScreen");
+
 #ifdef LIMIT_FPS
 	static uint32 _lastScreenUpdate = 0;
 	if (!_disableFpsLimit) {
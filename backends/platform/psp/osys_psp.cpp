@@ -30,6 +30,7 @@
 
 #include "common/config-manager.h"
 #include "common/events.h"
+#include "common/profiler.h"
 #include "common/scummsys.h"
 
 #include "backends/platform/psp/psppixelformat.h"
@@ -63,6 +64,7 @@ void OSystem_PSP::initBackend() {
 	ConfMan.registerDefault("gfx_mode", "Fit to Screen");
 	ConfMan.registerDefault("kbdmouse_speed", 3);
 	ConfMan.registerDefault("joystick_deadzone", 3);
+	ConfMan.registerDefault("archive_cache_budget", 1024);
 
 	// Instantiate real time clock
 	PspRtc::instance();
@@ -219,6 +221,9 @@ void OSystem_PSP::unlockScreen() {
 
 void OSystem_PSP::updateScreen() {
 	DEBUG_ENTER_FUNC();
+	Common::Profiler::endFrame();
+	PROFILE_ZONE("updateScreen");
+
 	_pendingUpdate = !_displayManager.renderAll();	// if we didn't update, we have a pending update
 }
 
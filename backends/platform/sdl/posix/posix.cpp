@@ -36,6 +36,7 @@
 #include "backends/saves/posix/posix-saves.h"
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-mmapstream.h"
 #include "backends/taskbar/unity/unity-taskbar.h"
 #include "backends/dialogs/gtk/gtk-dialogs.h"
 
@@ -43,6 +44,7 @@
 #include "backends/audiocd/linux/linux-audiocd.h"
 #endif
 
+#include "common/config-manager.h"
 #include "common/textconsole.h"
 
 #include <stdlib.h>
@@ -91,6 +93,12 @@ void OSystem_POSIX::initBackend() {
 	// Invoke parent implementation of this method
 	OSystem_SDL::initBackend();
 
+#ifdef HAS_MMAP
+	// The filesystem nodes may be used by other threads, so they do not
+	// read the option themselves
+	PosixMmapStream::setEnabled(ConfMan.hasKey("mmap_files") && ConfMan.getBool("mmap_files"));
+#endif
+
 #if defined(USE_TASKBAR) && defined(USE_UNITY)
 	// Register the taskbar manager as an event source (this is necessary for the glib event loop to be run)
 	_eventManager->getEventDispatcher()->registerSource((UnityTaskbarManager *)_taskbarManager, false);
@@ -108,6 +108,7 @@ void OSystem_Wii::initBackend() {
 
 	ConfMan.registerDefault("fullscreen", true);
 	ConfMan.registerDefault("aspect_ratio", true);
+	ConfMan.registerDefault("archive_cache_budget", 4096);
 	ConfMan.registerDefault("wii_video_default_underscan_x", 16);
 	ConfMan.registerDefault("wii_video_default_underscan_y", 16);
 	ConfMan.registerDefault("wii_video_ds_underscan_x", 16);
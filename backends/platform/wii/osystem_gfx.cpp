@@ -27,6 +27,7 @@
 #include <gxflux/gfx_con.h>
 
 #include "common/config-manager.h"
+#include "common/profiler.h"
 #include "graphics/blit.h"
 #include "backends/fs/wii/wii-fs-factory.h"
 
@@ -471,6 +472,9 @@ bool OSystem_Wii::needsScreenUpdate() {
 }
 
 void OSystem_Wii::updateScreen() {
+	Common::Profiler::endFrame();
+	PROFILE_ZONE("updateScreen");
+
 	static f32 ar;
 	static gfx_screen_coords_t cc;
 	static f32 csx, csy;
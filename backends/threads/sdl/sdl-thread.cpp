@@ -0,0 +1,115 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/threads/sdl/sdl-thread.h"
+#include "backends/platform/sdl/sdl-sys.h"
+
+/**
+ * SDL thread
+ */
+class SdlThreadInternal final : public Common::ThreadInternal {
+public:
+	SdlThreadInternal(Common::ThreadProc proc, void *data) : _proc(proc), _data(data), _thread(nullptr) {}
+	~SdlThreadInternal() override { assert(!_thread); }
+
+	bool start() {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		_thread = SDL_CreateThread(threadFunc, "ScummVM worker", this);
+#else
+		_thread = SDL_CreateThread(threadFunc, this);
+#endif
+		return _thread != nullptr;
+	}
+
+	void join() override {
+		SDL_WaitThread(_thread, nullptr);
+		_thread = nullptr;
+	}
+
+private:
+	static int SDLCALL threadFunc(void *data) {
+		SdlThreadInternal *thread = (SdlThreadInternal *)data;
+		thread->_proc(thread->_data);
+		return 0;
+	}
+
+	Common::ThreadProc _proc;
+	void *_data;
+	SDL_Thread *_thread;
+};
+
+Common::ThreadInternal *createSdlThreadInternal(Common::ThreadProc proc, void *data) {
+	SdlThreadInternal *thread = new SdlThreadInternal(proc, data);
+	if (!thread->start()) {
+		delete thread;
+		return nullptr;
+	}
+
+	return thread;
+}
+
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+typedef SDL_Semaphore SdlSemaphore;
+#else
+typedef SDL_sem SdlSemaphore;
+#endif
+
+/**
+ * SDL semaphore
+ */
+class SdlSemaphoreInternal final : public Common::SemaphoreInternal {
+public:
+	SdlSemaphoreInternal(SdlSemaphore *semaphore) : _semaphore(semaphore) {}
+	~SdlSemaphoreInternal() override { SDL_DestroySemaphore(_semaphore); }
+
+	void signal() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_SignalSemaphore(_semaphore);
+#else
+		SDL_SemPost(_semaphore);
+#endif
+	}
+
+	void wait() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_WaitSemaphore(_semaphore);
+#else
+		SDL_SemWait(_semaphore);
+#endif
+	}
+
+private:
+	SdlSemaphore *_semaphore;
+};
+
+Common::SemaphoreInternal *createSdlSemaphoreInternal() {
+	SdlSemaphore *semaphore = SDL_CreateSemaphore(0);
+	if (!semaphore)
+		return nullptr;
+
+	return new SdlSemaphoreInternal(semaphore);
+}
+
+#endif
@@ -25,6 +25,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_exit
 
 #include "engines/advancedDetector.h"
+#include "engines/detectionScanner.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
@@ -44,6 +45,7 @@
 #include "gui/ThemeEngine.h"
 
 #include "audio/musicplugin.h"
+#include "audio/rate.h"
 
 #include "graphics/renderer.h"
 
@@ -79,6 +81,7 @@ static const char HELP_STRING1[] =
 	"  --list-all-engines       Display list of all detection engines and exit\n"
 	"  --dump-all-detection-entries Create a DAT file containing MD5s from detection entries of all engines\n"
 	"  --stats                  Display statistics about engines and games and exit\n"
+	"  --detection-cache-stats  Display statistics about the detection cache and exit\n"
 	"  --list-debugflags=engine Display list of engine specified debugflags\n"
 	"                           if engine=global or engine is not specified, then it will list global debugflags\n"
 	"  --list-all-debugflags    Display list of all engine specified debugflags\n"
@@ -175,6 +178,7 @@ static const char HELP_STRING4[] =
 	"  --enable-gs              Enable Roland GS mode for MIDI playback\n"
 	"  --output-channels=CHANNELS Select output channel count (e.g. 2 for stereo)\n"
 	"  --output-rate=RATE       Select output sample rate in Hz (e.g. 22050)\n"
+	"  --resampler=TYPE         Select the audio resampler (default, sinc)\n"
 	"  --opl-driver=DRIVER      Select AdLib (OPL) emulator (db, mame"
 #ifndef DISABLE_NUKED_OPL
 																	 ", nuked"
@@ -188,6 +192,7 @@ static const char HELP_STRING4[] =
 																			  ")\n"
 	"  --show-fps               Set the turn on display FPS info in 3D games\n"
 	"  --no-show-fps            Set the turn off display FPS info in 3D games\n"
+	"  --profile                Record timings to a Chrome trace file in the save path\n"
 	"  --random-seed=SEED       Set the random seed used to initialize entropy\n"
 	"  --renderer=RENDERER      Select 3D renderer (software, opengl, opengl_shaders)\n"
 	"  --antialiasing=SAMPLES   Select the antialiasing level\n"
@@ -199,8 +204,10 @@ static const char HELP_STRING4[] =
 	"                           atari, macintosh, macintoshbw, vgaGray)\n"
 #ifdef ENABLE_EVENTRECORDER
 	"  --record-mode=MODE       Specify record mode for event recorder (record, playback,\n"
-	"                           info, update, passthrough [default])\n"
+	"                           benchmark, info, update, passthrough [default])\n"
 	"  --record-file-name=FILE  Specify record file name\n"
+	"  --benchmark-report=FILE  When benchmarking a recording, write the timings to FILE\n"
+	"                           (default: benchmark.json)\n"
 	"  --disable-display        Disable any gfx output. Used for headless events\n"
 	"                           playback by Event Recorder\n"
 	"  --screenshot-period=NUM  When recording, trigger a screenshot every NUM milliseconds\n"
@@ -305,6 +312,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("scale_factor", -1);
 	ConfMan.registerDefault("shader", Common::Path("default", Common::Path::kNoSeparator));
 	ConfMan.registerDefault("show_fps", false);
+	ConfMan.registerDefault("profile", false);
 	ConfMan.registerDefault("dirtyrects", true);
 	ConfMan.registerDefault("vsync", true);
 
@@ -378,6 +386,8 @@ void registerDefaults() {
 	ConfMan.registerDefault("disable_display", false);
 	ConfMan.registerDefault("record_mode", "none");
 	ConfMan.registerDefault("record_file_name", "record.bin");
+	ConfMan.registerDefault("benchmark_report", "benchmark.json");
+	ConfMan.registerDefault("archive_cache_budget", 0);
 
 	ConfMan.registerDefault("gui_saveload_chooser", "grid");
 	ConfMan.registerDefault("gui_saveload_last_pos", "0");
@@ -699,6 +709,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_COMMAND("stats")
 			END_COMMAND
 
+			DO_LONG_COMMAND("detection-cache-stats")
+			END_COMMAND
+
 			DO_COMMAND('a', "add")
 			END_COMMAND
 
@@ -770,6 +783,11 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_INT("output-rate")
 			END_OPTION
 
+			DO_LONG_OPTION("resampler")
+				if (Audio::parseRateConverterType(option) == Audio::kRateConverterUnknown)
+					usage("Unrecognized resampler '%s'", option);
+			END_OPTION
+
 			DO_OPTION_BOOL('f', "fullscreen")
 			END_OPTION
 
@@ -805,6 +823,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("record-file-name")
 			END_OPTION
 
+			DO_LONG_OPTION("benchmark-report")
+			END_OPTION
+
 			DO_LONG_COMMAND("list-records")
 			END_COMMAND
 
@@ -929,6 +950,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_BOOL("show-fps")
 			END_OPTION
 
+			DO_LONG_OPTION_BOOL("profile")
+			END_OPTION
+
 			DO_LONG_OPTION_PATH("savepath")
 			END_OPTION
 
@@ -1507,17 +1531,13 @@ static void dumpAllDetectionEntries() {
 }
 
 /** Display all games in the given directory, or current directory if empty */
-static DetectedGames getGameList(const Common::FSNode &dir) {
-	Common::FSList files;
-
-	// Collect all files from directory
-	if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-		printf("Path %s does not exist or is not a directory.\n", dir.getPath().toString(Common::Path::kNativeSeparator).c_str());
+static DetectedGames getGameList(const DetectionScanner &scanner) {
+	if (!scanner.isDirectoryReadable()) {
+		printf("Path %s does not exist or is not a directory.\n", scanner.getDirectory().getPath().toString(Common::Path::kNativeSeparator).c_str());
 		return DetectedGames();
 	}
 
-	// detect Games
-	DetectionResults detectionResults = EngineMan.detectGames(files);
+	const DetectionResults &detectionResults = scanner.getResults();
 
 	if (detectionResults.foundUnknownGames()) {
 		Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
@@ -1528,18 +1548,18 @@ static DetectedGames getGameList(const Common::FSNode &dir) {
 }
 
 static DetectedGames recListGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
-	DetectedGames list = getGameList(dir);
-
-	if (recursive) {
-		Common::FSList files;
-		dir.getChildren(files, Common::FSNode::kListDirectoriesOnly);
-		for (const auto &file : files) {
-			DetectedGames rec = recListGames(file, engineId, gameId, recursive);
-			for (auto &game : rec) {
-				if ((game.engineId == engineId && game.gameId == gameId)
-				    || gameId.empty())
-					list.push_back(game);
-			}
+	DetectionScanner scanner(dir, recursive);
+
+	// The games found in the top directory are listed unfiltered
+	scanner.scanNextDirectory();
+	DetectedGames list = getGameList(scanner);
+
+	while (scanner.scanNextDirectory()) {
+		DetectedGames rec = getGameList(scanner);
+		for (auto &game : rec) {
+			if ((game.engineId == engineId && game.gameId == gameId)
+			    || gameId.empty())
+				list.push_back(game);
 		}
 	}
 
@@ -1576,9 +1596,8 @@ static Common::String detectGames(const Common::Path &path, const Common::String
 	return buildQualifiedGameName(candidates[0].engineId, candidates[0].gameId);
 }
 
-static int recAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+static int addGameList(const DetectedGames &list, const Common::String &engineId, const Common::String &gameId) {
 	int count = 0;
-	DetectedGames list = getGameList(dir);
 	for (const auto &v : list) {
 		if ((v.engineId != engineId || v.gameId != gameId)
 		    && !gameId.empty()) {
@@ -1604,13 +1623,14 @@ static int recAddGames(const Common::FSNode &dir, const Common::String &engineId
 		}
 	}
 
-	if (recursive) {
-		Common::FSList files;
-		if (dir.getChildren(files, Common::FSNode::kListDirectoriesOnly)) {
-			for (const auto &file : files) {
-				count += recAddGames(file, engineId, gameId, recursive);
-			}
-		}
+	return count;
+}
+
+static int recAddGames(const Common::FSNode &dir, const Common::String &engineId, const Common::String &gameId, bool recursive) {
+	int count = 0;
+	DetectionScanner scanner(dir, recursive);
+	while (scanner.scanNextDirectory()) {
+		count += addGameList(getGameList(scanner), engineId, gameId);
 	}
 
 	return count;
@@ -1946,6 +1966,9 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	} else if (command == "stats") {
 		printStatistics(settings["engine"]);
 		return cmdDoExit;
+	} else if (command == "detection-cache-stats") {
+		ADCacheMan.printPersistentCacheStats();
+		return cmdDoExit;
 #ifdef ENABLE_EVENTRECORDER
 	} else if (command == "list-records") {
 		err = listRecords(settings["game"]);
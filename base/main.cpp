@@ -43,6 +43,7 @@
 #include "common/events.h"
 #include "gui/EventRecorder.h"
 #include "common/fs.h"
+#include "common/profiler.h"
 #ifdef ENABLE_EVENTRECORDER
 #include "common/recorderfile.h"
 #endif
@@ -556,6 +557,16 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+	// Videos may convert their frames on other threads, which must not ask
+	// the backend for the CPU features
+	YUVToRGBMan.selectConvertRow();
+
+	// The budget of the archive cache, in KiB, which the backend may have
+	// given a default. Archives may be read on other threads later on.
+	const int archiveCacheBudget = ConfMan.getInt("archive_cache_budget");
+	if (archiveCacheBudget > 0)
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(MIN<uint32>(archiveCacheBudget, 0xFFFFFFFF / 1024) * 1024);
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -599,6 +610,9 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// take place after the backend is initiated and the screen has been setup
 	system.getEventManager()->init();
 
+	if (ConfMan.getBool("profile"))
+		Common::Profiler::start();
+
 #ifdef ENABLE_EVENTRECORDER
 	// Directly after initializing the event manager, we will initialize our
 	// event recorder.
@@ -782,6 +796,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 				g_eventRec.init(recordFileName, GUI::EventRecorder::kRecorderUpdate);
 			} else if (recordMode == "playback") {
 				g_eventRec.init(recordFileName, GUI::EventRecorder::kRecorderPlayback);
+			} else if (recordMode == "benchmark") {
+				// There is nobody watching, draw off screen
+				ConfMan.setBool("disable_display", true, Common::ConfigManager::kTransientDomain);
+				g_eventRec.init(recordFileName, GUI::EventRecorder::kRecorderPlayback);
+				g_eventRec.startBenchmark(ConfMan.get("benchmark_report"));
 			} else if ((recordMode == "info") && (!recordFileName.empty())) {
 				Common::PlaybackFile record;
 				record.openRead(recordFileName);
@@ -893,6 +912,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Cloud::CloudManager::destroy();
 #endif
 #endif
+	Common::Profiler::stop();
+
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
 	Common::ConfigManager::destroy();
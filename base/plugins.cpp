@@ -692,6 +692,7 @@ DetectionResults EngineManager::detectGames(const Common::FSList &fslist, uint32
 
 	// Close all archives that were opened during detection
 	ADCacheMan.clearArchives();
+	ADCacheMan.savePersistentCache();
 
 	return DetectionResults(candidates);
 }
@@ -900,6 +901,7 @@ void EngineManager::upgradeTargetForEngineId(const Common::String &target) const
 		// Clear md5 cache before detection starts
 		ADCacheMan.clear();
 		DetectedGames candidates = metaEngine.detectGames(files);
+		ADCacheMan.savePersistentCache();
 		if (candidates.empty()) {
 			warning("No games supported by the engine '%s' were found in path '%s' when upgrading target '%s'",
 			        metaEngine.getName(), path.toString(Common::Path::kNativeSeparator).c_str(), target.c_str());
@@ -20,11 +20,13 @@
  */
 
 #include "common/archive.h"
+#include "common/atomic.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
 #include "common/punycode.h"
 #include "common/debug.h"
 
@@ -230,6 +232,29 @@ void Archive::prepareMaps() const {
 	}
 }
 
+MemcachingCaseInsensitiveArchive::CacheNode *MemcachingCaseInsensitiveArchive::_cacheHead = nullptr;
+MemcachingCaseInsensitiveArchive::CacheNode *MemcachingCaseInsensitiveArchive::_cacheTail = nullptr;
+uint32 MemcachingCaseInsensitiveArchive::_cacheBudget = MemcachingCaseInsensitiveArchive::kDefaultCacheBudget;
+MemcachingCaseInsensitiveArchive::CacheStats MemcachingCaseInsensitiveArchive::_cacheStats = { 0, 0, 0, 0 };
+
+// Guards the caches of all memcaching archives. A mutex needs g_system, so
+// it is only created when the cache is first used, and kept until exit.
+static Mutex *volatile g_cacheMutex = nullptr;
+
+static Mutex &getCacheMutex() {
+	Mutex *mutex = atomicLoad(&g_cacheMutex);
+	if (mutex)
+		return *mutex;
+
+	mutex = new Mutex();
+	if (!atomicCompareExchange(&g_cacheMutex, (Mutex *)nullptr, mutex)) {
+		// Another thread created it first
+		delete mutex;
+		mutex = atomicLoad(&g_cacheMutex);
+	}
+	return *mutex;
+}
+
 SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMember(const Path &path) const {
 	return createReadStreamForMemberImpl(path, false, Common::AltStreamType::Invalid);
 }
@@ -249,50 +274,142 @@ SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMemberI
 	cacheKey.path = translatePath(path);
 	cacheKey.altStreamType = isAltStream ? altStreamType : AltStreamType::Invalid;
 
-	bool isNew = false;
-	if (!_cache.contains(cacheKey)) {
-		SharedArchiveContents readResult = isAltStream ? readContentsForPathAltStream(cacheKey.path, altStreamType) : readContentsForPath(cacheKey.path);
-		if (readResult._bypass)
-			return readResult._bypass;
-		_cache[cacheKey] = readResult;
-		isNew = true;
+	{
+		StackLock lock(getCacheMutex());
+		if (_cache.contains(cacheKey)) {
+			CacheEntry &entry = _cache[cacheKey];
+
+			// Errors and missing files. Just return nullptr,
+			// no need to create stream.
+			if (entry.contents.isFileMissing())
+				return nullptr;
+
+			// Check whether the entry is still valid as WeakPtr might have expired.
+			if (entry.contents.makeStrong())
+				return createReadStreamForEntry(cacheKey, entry, false);
+		}
 	}
 
-	SharedArchiveContents* entry = &_cache[cacheKey];
+	// (Re)create the entry. The member is read without holding the lock, so
+	// that other threads may open members in the meantime.
+	SharedArchiveContents readResult = isAltStream ? readContentsForPathAltStream(cacheKey.path, altStreamType) : readContentsForPath(cacheKey.path);
+	if (readResult._bypass)
+		return readResult._bypass;
 
-	// Errors and missing files. Just return nullptr,
-	// no need to create stream.
-	if (entry->isFileMissing())
-		return nullptr;
+	StackLock lock(getCacheMutex());
+	CacheEntry &entry = _cache[cacheKey];
 
-	// Check whether the entry is still valid as WeakPtr might have expired.
-	if (!entry->makeStrong()) {
-		// If it's expired, recreate the entry.
-		SharedArchiveContents readResult = isAltStream ? readContentsForPathAltStream(cacheKey.path, altStreamType) : readContentsForPath(cacheKey.path);
-		if (readResult._bypass)
-			return readResult._bypass;
-		_cache[cacheKey] = readResult;
-		entry = &_cache[cacheKey];
-		isNew = true;
-	}
+	// Another thread may have read and kept the member meanwhile
+	if (!entry.node)
+		entry.contents = readResult;
 
 	// It's possible that recreation failed in case of e.g. network
 	// share going offline.
-	if (entry->isFileMissing())
+	if (entry.contents.isFileMissing())
 		return nullptr;
 
-	// Now we have a valid contents reference. Make stream for it.
-	Common::MemoryReadStream *memStream = new Common::MemoryReadStream(entry->getContents(), entry->getSize());
+	return createReadStreamForEntry(cacheKey, entry, true);
+}
+
+SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForEntry(const CacheKey &key, CacheEntry &entry, bool isNew) const {
+	if (isNew)
+		_cacheStats.misses++;
+	else
+		_cacheStats.hits++;
 
-	// If the entry was just created and it's too big for strong caching,
-	// mark the copy in cache as weak
-	if (isNew && entry->getSize() > _maxStronglyCachedSize) {
-		entry->makeWeak();
+	// Now we have a valid contents reference. Make stream for it.
+	const uint32 size = entry.contents.getSize();
+	Common::MemoryReadStream *memStream = new Common::MemoryReadStream(entry.contents.getContents(), size);
+
+	if (entry.node) {
+		// Move the member to the front of the cache
+		unlinkCacheNode(entry.node);
+		linkCacheNode(entry.node);
+	} else if (isNew && size > 0 && size <= _cacheBudget &&
+	           (size <= _maxStronglyCachedSize || _cacheBudget != kDefaultCacheBudget)) {
+		// Without a budget, nothing would ever drop the large members
+		CacheNode *node = new CacheNode();
+		node->archive = this;
+		node->key = key;
+		node->size = size;
+		entry.node = node;
+		linkCacheNode(node);
+		_cacheStats.bytesResident += size;
+		evictCacheNodes(_cacheBudget);
+	} else {
+		// Only the streams keep the contents in memory
+		entry.contents.makeWeak();
 	}
 
 	return memStream;
 }
 
+MemcachingCaseInsensitiveArchive::~MemcachingCaseInsensitiveArchive() {
+	// Archives which never cached anything do not need the mutex
+	if (_cache.empty() || !atomicLoad(&g_cacheMutex))
+		return;
+
+	StackLock lock(getCacheMutex());
+	for (auto &entry : _cache) {
+		if (entry._value.node) {
+			_cacheStats.bytesResident -= entry._value.node->size;
+			unlinkCacheNode(entry._value.node);
+			delete entry._value.node;
+		}
+	}
+}
+
+void MemcachingCaseInsensitiveArchive::setCacheBudget(uint32 budget) {
+	StackLock lock(getCacheMutex());
+	_cacheBudget = budget;
+	evictCacheNodes(budget);
+}
+
+uint32 MemcachingCaseInsensitiveArchive::getCacheBudget() {
+	StackLock lock(getCacheMutex());
+	return _cacheBudget;
+}
+
+MemcachingCaseInsensitiveArchive::CacheStats MemcachingCaseInsensitiveArchive::getCacheStats() {
+	StackLock lock(getCacheMutex());
+	return _cacheStats;
+}
+
+void MemcachingCaseInsensitiveArchive::linkCacheNode(CacheNode *node) {
+	node->prev = nullptr;
+	node->next = _cacheHead;
+	if (_cacheHead)
+		_cacheHead->prev = node;
+	else
+		_cacheTail = node;
+	_cacheHead = node;
+}
+
+void MemcachingCaseInsensitiveArchive::unlinkCacheNode(CacheNode *node) {
+	if (node->prev)
+		node->prev->next = node->next;
+	else
+		_cacheHead = node->next;
+	if (node->next)
+		node->next->prev = node->prev;
+	else
+		_cacheTail = node->prev;
+}
+
+void MemcachingCaseInsensitiveArchive::evictCacheNodes(uint32 budget) {
+	while (_cacheStats.bytesResident > budget) {
+		CacheNode *node = _cacheTail;
+		CacheEntry &entry = node->archive->_cache[node->key];
+		entry.contents.makeWeak();
+		entry.node = nullptr;
+
+		_cacheStats.bytesResident -= node->size;
+		_cacheStats.evictions++;
+		unlinkCacheNode(node);
+		delete node;
+	}
+}
+
 SharedArchiveContents MemcachingCaseInsensitiveArchive::readContentsForPathAltStream(const Path &translatedPath, AltStreamType altStreamType) const {
 	return SharedArchiveContents();
 }
@@ -338,6 +455,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	invalidatePathIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -428,6 +546,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidatePathIndex();
 	}
 }
 
@@ -451,6 +570,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	invalidatePathIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -469,10 +589,55 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
+void SearchSet::setPathIndexEnabled(bool enabled) {
+	_pathIndexEnabled = enabled;
+	invalidatePathIndex();
+}
+
+void SearchSet::invalidatePathIndex() {
+	_pathIndex.clear(true);
+	_pathIndexValid = false;
+}
+
+bool SearchSet::lookupPathIndex(const Path &path, Archive *&archive) const {
+	if (!_pathIndexEnabled)
+		return false;
+
+	if (!_pathIndexValid) {
+		// The list is sorted by descending priority, so the first archive
+		// which lists a member is the one a search would find it in
+		for (const auto &node : _list) {
+			ArchiveMemberList members;
+			node._arc->listMembers(members);
+			for (const auto &member : members) {
+				const Path memberPath = member->getPathInArchive();
+				if (!_pathIndex.contains(memberPath))
+					_pathIndex[memberPath] = node._arc;
+			}
+		}
+		_pathIndexValid = true;
+	}
+
+	PathIndex::const_iterator it = _pathIndex.find(path);
+	if (it == _pathIndex.end()) {
+		archive = nullptr;
+		_pathIndexNegativeLookups++;
+	} else {
+		archive = it->_value;
+		_pathIndexHits++;
+	}
+
+	return true;
+}
+
 bool SearchSet::hasFile(const Path &path) const {
 	if (path.empty())
 		return false;
 
+	Archive *indexed;
+	if (lookupPathIndex(path, indexed))
+		return indexed != nullptr;
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path))
 			return true;
@@ -553,6 +718,15 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path, Archive **containe
 	if (path.empty())
 		return ArchiveMemberPtr();
 
+	Archive *indexed;
+	if (lookupPathIndex(path, indexed)) {
+		if (!indexed)
+			return ArchiveMemberPtr();
+		if (container)
+			*container = indexed;
+		return indexed->getMember(path);
+	}
+
 	for (const auto &archive : _list) {
 		if (archive._arc->hasFile(path)) {
 			if (container) {
@@ -573,6 +747,19 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const
 	if (path.empty())
 		return nullptr;
 
+	Archive *indexed;
+	if (lookupPathIndex(path, indexed)) {
+		if (!indexed)
+			return nullptr;
+
+		// Like a search, go on with the next archives if the member
+		// cannot be opened
+		SeekableReadStream *stream = indexed->createReadStreamForMember(path);
+		if (stream)
+			return stream;
+		return createReadStreamForMemberNext(path, indexed);
+	}
+
 	for (const auto &archive : _list) {
 		SeekableReadStream *stream = archive._arc->createReadStreamForMember(path);
 		if (stream)
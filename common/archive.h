@@ -283,10 +283,41 @@ private:
 
 /**
  * An archive that caches the resulting contents.
+ *
+ * The members of all memcaching archives share one cache, which keeps them in
+ * memory after their streams have been deleted. Once the members exceed the
+ * cache budget, the least recently used ones are evicted first. Without a
+ * budget, only members up to maxStronglyCachedSize bytes are kept, and larger
+ * ones are only shared by the streams of them.
+ *
+ * The cache is shared by all threads, and guarded by a mutex.
  */
 class MemcachingCaseInsensitiveArchive : public Archive {
 public:
+	/** Counters of the cache which all memcaching archives share. */
+	struct CacheStats {
+		uint32 hits;          /*!< Members which were still in memory when they were opened. */
+		uint32 misses;        /*!< Members which had to be read from their archives. */
+		uint32 bytesResident; /*!< Bytes of the members which are kept in memory. */
+		uint32 evictions;     /*!< Members which were dropped to stay within the budget. */
+	};
+
+	/** The default budget, which does not limit the cache. */
+	static const uint32 kDefaultCacheBudget = 0xFFFFFFFF;
+
 	MemcachingCaseInsensitiveArchive(uint32 maxStronglyCachedSize = 512) : _maxStronglyCachedSize(maxStronglyCachedSize) {}
+	~MemcachingCaseInsensitiveArchive();
+
+	/**
+	 * Set how many bytes of members all memcaching archives together may keep
+	 * in memory, and evict the members which exceed it right away. This is
+	 * the archive_cache_budget option, which ports with little memory set a
+	 * default for.
+	 */
+	static void setCacheBudget(uint32 budget);
+	static uint32 getCacheBudget();
+	static CacheStats getCacheStats();
+
 	SeekableReadStream *createReadStreamForMember(const Path &path) const;
 	SeekableReadStream *createReadStreamForMemberAltStream(const Path &path, Common::AltStreamType altStreamType) const;
 
@@ -313,10 +344,36 @@ private:
 		uint operator()(const CacheKey &x) const;
 	};
 
+	// A member which is kept in memory. They are linked from the most
+	// recently used one of all archives, which requires the cache mutex.
+	struct CacheNode {
+		CacheNode *prev;
+		CacheNode *next;
+		const MemcachingCaseInsensitiveArchive *archive;
+		CacheKey key;
+		uint32 size;
+	};
+
+	struct CacheEntry {
+		CacheEntry() : node(nullptr) {}
+
+		SharedArchiveContents contents;
+		CacheNode *node;
+	};
+
 	SeekableReadStream *createReadStreamForMemberImpl(const Path &path, bool isAltStream, Common::AltStreamType altStreamType) const;
+	SeekableReadStream *createReadStreamForEntry(const CacheKey &key, CacheEntry &entry, bool isNew) const;
+
+	static void linkCacheNode(CacheNode *node);
+	static void unlinkCacheNode(CacheNode *node);
+	static void evictCacheNodes(uint32 budget);
 
-	mutable HashMap<CacheKey, SharedArchiveContents, CacheKey_Hash, CacheKey_EqualTo> _cache;
+	mutable HashMap<CacheKey, CacheEntry, CacheKey_Hash, CacheKey_EqualTo> _cache;
 	uint32 _maxStronglyCachedSize;
+
+	static CacheNode *_cacheHead, *_cacheTail;
+	static uint32 _cacheBudget;
+	static CacheStats _cacheStats;
 };
 
 /**
@@ -347,8 +404,22 @@ class SearchSet : public Archive {
 
 	bool _ignoreClashes;
 
+	typedef HashMap<Path, Archive *, Path::IgnoreCaseAndMac_Hash, Path::IgnoreCaseAndMac_EqualTo> PathIndex;
+	mutable PathIndex _pathIndex; //!< The archive with the highest priority for each member
+	mutable bool _pathIndexValid;
+	bool _pathIndexEnabled;
+	mutable uint32 _pathIndexHits, _pathIndexNegativeLookups;
+
+	/**
+	 * Look up the archive which contains @p path in the path index, building
+	 * the index first if needed. Returns false if the index is disabled, in
+	 * which case the archives have to be searched one by one.
+	 */
+	bool lookupPathIndex(const Path &path, Archive *&archive) const;
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
+	SearchSet() : _ignoreClashes(false), _pathIndexValid(false), _pathIndexEnabled(false),
+		_pathIndexHits(0), _pathIndexNegativeLookups(0) { }
 	virtual ~SearchSet() { clear(); }
 
 	char getPathSeparator() const override { return '/'; }
@@ -476,6 +547,29 @@ public:
 	 */
 	void setIgnoreClashes(bool ignoreClashes) { _ignoreClashes = ignoreClashes; }
 
+	/**
+	 * Resolve hasFile, getMember and createReadStreamForMember with an index
+	 * of the members of all archives, which is built from their listMembers
+	 * on the first lookup, instead of asking each archive in turn.
+	 *
+	 * This is only correct if listMembers lists every file the archives
+	 * contain. The index is rebuilt when archives are added or removed, or
+	 * their priority changes; if the contents of an archive change otherwise,
+	 * call invalidatePathIndex.
+	 */
+	void setPathIndexEnabled(bool enabled);
+
+	/**
+	 * Drop the path index, so that it is rebuilt on the next lookup.
+	 */
+	void invalidatePathIndex();
+
+	/** Number of lookups which the path index resolved to an archive. */
+	uint32 getPathIndexHits() const { return _pathIndexHits; }
+
+	/** Number of lookups which the path index found in none of the archives. */
+	uint32 getPathIndexNegativeLookups() const { return _pathIndexNegativeLookups; }
+
 	bool getChildren(const Common::Path &path, Common::Array<Common::String> &list, ListMode mode = kListDirectoriesOnly, bool hidden = true) const override;
 };
 
@@ -0,0 +1,214 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_atomic Atomic operations
+ * @ingroup common
+ *
+ * @brief Minimal set of atomic operations on 32-bit integers and pointers.
+ *
+ * These are intended for the few places where a lock cannot be used, such as
+ * communication with a real-time audio callback. Where the compiler does not
+ * provide native atomics for the target, COMMON_HAS_ATOMICS is left undefined
+ * and the functions degrade to plain (non-atomic) memory accesses. Code which
+ * relies on real atomicity must check COMMON_HAS_ATOMICS and fall back to a
+ * mutex otherwise.
+ * @{
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
+#define COMMON_HAS_ATOMICS
+
+/** Load a value, with acquire semantics. */
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+/** Load a value, without any ordering guarantees. */
+template<class T>
+inline T atomicLoadRelaxed(const volatile T *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+}
+
+/** Store a value, with release semantics. */
+template<class T>
+inline void atomicStore(volatile T *ptr, T val) {
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+/** Store a value, without any ordering guarantees. */
+template<class T>
+inline void atomicStoreRelaxed(volatile T *ptr, T val) {
+	__atomic_store_n(ptr, val, __ATOMIC_RELAXED);
+}
+
+/** Add @p val to the value at @p ptr and return the new value. */
+inline int32 atomicAdd(volatile int32 *ptr, int32 val) {
+	return __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+/** Add @p val to the value at @p ptr and return the new value. */
+inline uint32 atomicAdd(volatile uint32 *ptr, uint32 val) {
+	return __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Replace the value at @p ptr by @p desired if it currently equals @p expected.
+ *
+ * @return true if the exchange took place.
+ */
+template<class T>
+inline bool atomicCompareExchange(volatile T *ptr, T expected, T desired) {
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/** Full memory barrier. */
+inline void atomicFence() {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#elif defined(_MSC_VER)
+
+#define COMMON_HAS_ATOMICS
+
+// Accesses to aligned volatile variables are atomic, and have acquire/release
+// semantics with the default /volatile:ms setting on x86 and x64. On ARM they
+// need an explicit barrier.
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	T val = *ptr;
+#if defined(_M_ARM) || defined(_M_ARM64)
+	__dmb(0xB); // ISH
+#else
+	_ReadWriteBarrier();
+#endif
+	return val;
+}
+
+template<class T>
+inline T atomicLoadRelaxed(const volatile T *ptr) {
+	return *ptr;
+}
+
+template<class T>
+inline void atomicStore(volatile T *ptr, T val) {
+#if defined(_M_ARM) || defined(_M_ARM64)
+	__dmb(0xB); // ISH
+#else
+	_ReadWriteBarrier();
+#endif
+	*ptr = val;
+}
+
+template<class T>
+inline void atomicStoreRelaxed(volatile T *ptr, T val) {
+	*ptr = val;
+}
+
+inline int32 atomicAdd(volatile int32 *ptr, int32 val) {
+	return _InterlockedExchangeAdd((volatile long *)ptr, val) + val;
+}
+
+inline uint32 atomicAdd(volatile uint32 *ptr, uint32 val) {
+	return (uint32)_InterlockedExchangeAdd((volatile long *)ptr, (long)val) + val;
+}
+
+template<class T>
+inline bool atomicCompareExchange(volatile T *ptr, T expected, T desired) {
+	STATIC_ASSERT(sizeof(T) == sizeof(long), atomic_compare_exchange_requires_32_bit_value);
+	return _InterlockedCompareExchange((volatile long *)ptr, (long)desired, (long)expected) == (long)expected;
+}
+
+template<class T>
+inline bool atomicCompareExchange(T *volatile *ptr, T *expected, T *desired) {
+	return _InterlockedCompareExchangePointer((void *volatile *)ptr, desired, expected) == expected;
+}
+
+inline void atomicFence() {
+#if defined(_M_ARM) || defined(_M_ARM64)
+	__dmb(0xB); // ISH
+#else
+	_mm_mfence();
+#endif
+}
+
+#else
+
+// No native atomics on this target: single-threaded fallback.
+template<class T>
+inline T atomicLoad(const volatile T *ptr) {
+	return *ptr;
+}
+
+template<class T>
+inline T atomicLoadRelaxed(const volatile T *ptr) {
+	return *ptr;
+}
+
+template<class T>
+inline void atomicStore(volatile T *ptr, T val) {
+	*ptr = val;
+}
+
+template<class T>
+inline void atomicStoreRelaxed(volatile T *ptr, T val) {
+	*ptr = val;
+}
+
+inline int32 atomicAdd(volatile int32 *ptr, int32 val) {
+	return *ptr += val;
+}
+
+inline uint32 atomicAdd(volatile uint32 *ptr, uint32 val) {
+	return *ptr += val;
+}
+
+template<class T>
+inline bool atomicCompareExchange(volatile T *ptr, T expected, T desired) {
+	if (*ptr != expected)
+		return false;
+	*ptr = desired;
+	return true;
+}
+
+inline void atomicFence() {
+}
+
+#endif
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
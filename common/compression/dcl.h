@@ -47,9 +47,12 @@ class SeekableReadStream;
 /**
  * Decompress a PKWARE DCL compressed stream.
  *
+ * @param quiet	If set, broken data is not reported with warnings, and no
+ *              debug output is printed, so that this can be used from
+ *              other threads than the main thread.
  * @return Returns true if successful.
  */
-bool decompressDCL(ReadStream *sourceStream, byte *dest, uint32 packedSize, uint32 unpackedSize);
+bool decompressDCL(ReadStream *sourceStream, byte *dest, uint32 packedSize, uint32 unpackedSize, bool quiet = false);
 
 /**
  * @overload
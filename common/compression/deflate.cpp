@@ -0,0 +1,199 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "common/compression/deflate.h"
+
+#include "common/crc.h"
+#include "common/endian.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+static const uint32 kSeekIndexVersion = 1;
+
+DeflateSeekIndex::~DeflateSeekIndex() {
+	clearCheckpoints();
+}
+
+void DeflateSeekIndex::clearCheckpoints() {
+	for (uint i = 0; i < _checkpoints.size(); i++)
+		delete[] _checkpoints[i].window;
+	_checkpoints.clear();
+}
+
+bool DeflateSeekIndex::wantCheckpoint(uint64 outPos) const {
+	// The window has to be full, since it is restored as a whole
+	if (!_interval || outPos < kWindowSize)
+		return false;
+
+	if (_checkpoints.empty())
+		return outPos >= _interval;
+
+	return outPos >= _checkpoints.back().outPos + _interval;
+}
+
+byte *DeflateSeekIndex::addCheckpoint(uint64 outPos, uint64 inPos, byte bits, byte bitValue) {
+	Checkpoint checkpoint;
+	checkpoint.outPos = outPos;
+	checkpoint.inPos = inPos;
+	checkpoint.bits = bits;
+	checkpoint.bitValue = bitValue;
+	checkpoint.window = new byte[kWindowSize];
+	_checkpoints.push_back(checkpoint);
+	return checkpoint.window;
+}
+
+const DeflateSeekIndex::Checkpoint *DeflateSeekIndex::findCheckpoint(uint64 outPos) const {
+	// The checkpoints are sorted, since they are only added further on
+	uint first = 0, last = _checkpoints.size();
+	while (first < last) {
+		const uint middle = (first + last) / 2;
+		if (_checkpoints[middle].outPos <= outPos)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return first ? &_checkpoints[first - 1] : nullptr;
+}
+
+bool DeflateSeekIndex::saveSeekIndex(WriteStream &out) const {
+	out.writeUint32BE(MKTAG('D', 'F', 'S', 'I'));
+	out.writeUint32LE(kSeekIndexVersion);
+	out.writeUint64LE(getCompressedSize());
+	out.writeUint32LE(_checkpoints.size());
+
+	for (const Checkpoint &checkpoint : _checkpoints) {
+		out.writeUint64LE(checkpoint.outPos);
+		out.writeUint64LE(checkpoint.inPos);
+		out.writeByte(checkpoint.bits);
+		out.writeByte(checkpoint.bitValue);
+		out.write(checkpoint.window, kWindowSize);
+	}
+
+	return !out.err();
+}
+
+bool DeflateSeekIndex::loadSeekIndex(SeekableReadStream &in) {
+	if (in.readUint32BE() != MKTAG('D', 'F', 'S', 'I') || in.readUint32LE() != kSeekIndexVersion)
+		return false;
+	if (in.readUint64LE() != getCompressedSize())
+		return false;
+
+	const uint32 count = in.readUint32LE();
+	if (in.err() || in.eos() || in.size() - in.pos() < (int64)count * (18 + kWindowSize))
+		return false;
+
+	Array<Checkpoint> checkpoints;
+	checkpoints.reserve(count);
+	for (uint32 i = 0; i < count; i++) {
+		Checkpoint checkpoint;
+		checkpoint.outPos = in.readUint64LE();
+		checkpoint.inPos = in.readUint64LE();
+		checkpoint.bits = in.readByte();
+		checkpoint.bitValue = in.readByte();
+		checkpoint.window = new byte[kWindowSize];
+		in.read(checkpoint.window, kWindowSize);
+		checkpoints.push_back(checkpoint);
+
+		if ((i > 0 && checkpoint.outPos <= checkpoints[i - 1].outPos) || checkpoint.bits > 7 ||
+		    checkpoint.outPos < kWindowSize || in.err()) {
+			for (Checkpoint &loaded : checkpoints)
+				delete[] loaded.window;
+			return false;
+		}
+	}
+
+	clearCheckpoints();
+	_checkpoints.swap(checkpoints);
+	return true;
+}
+
+/**
+ * A stream which computes the CRC-32 of the data read from its parent, for
+ * as long as it is read without gaps from the start.
+ */
+class Crc32CheckingReadStream : public SeekableReadStream {
+public:
+	Crc32CheckingReadStream(SeekableReadStream *parent, uint32 crc, DisposeAfterUse::Flag disposeParent) :
+		_parent(parent, disposeParent), _expected(crc), _checkedSize(0), _mismatch(false) {
+		_remainder = _crc.getInitRemainder();
+	}
+
+	SeekableReadStream *getParent() const { return _parent.get(); }
+
+	bool err() const override { return _mismatch || _parent->err(); }
+	void clearErr() override { _parent->clearErr(); }
+
+	bool eos() const override { return _parent->eos(); }
+
+	uint32 read(void *dataPtr, uint32 dataSize) override {
+		const int64 startPos = _parent->pos();
+		const uint32 actual = _parent->read(dataPtr, dataSize);
+		if (startPos <= _checkedSize && _checkedSize < startPos + actual)
+			check((const byte *)dataPtr + (_checkedSize - startPos), startPos + actual - _checkedSize);
+		return actual;
+	}
+
+	int64 pos() const override { return _parent->pos(); }
+	int64 size() const override { return _parent->size(); }
+	bool seek(int64 offset, int whence = SEEK_SET) override { return _parent->seek(offset, whence); }
+
+private:
+	void check(const byte *data, uint32 size) {
+		for (uint32 i = 0; i < size; i++)
+			_remainder = _crc.processByte(data[i], _remainder);
+		_checkedSize += size;
+
+		if (_checkedSize == _parent->size()) {
+			const uint32 crc = _crc.finalize(_remainder);
+			if (crc != _expected) {
+				warning("CRC32 mismatch: %08x, %08x", crc, _expected);
+				_mismatch = true;
+			}
+		}
+	}
+
+	DisposablePtr<SeekableReadStream> _parent;
+	CRC32 _crc;
+	uint32 _expected;
+	uint32 _remainder;
+	int64 _checkedSize;
+	bool _mismatch;
+};
+
+SeekableReadStream *wrapCrc32CheckingReadStream(SeekableReadStream *toBeWrapped, uint32 crc, DisposeAfterUse::Flag disposeParent) {
+	if (!toBeWrapped)
+		return nullptr;
+	return new Crc32CheckingReadStream(toBeWrapped, crc, disposeParent);
+}
+
+DeflateSeekIndex *getDeflateSeekIndex(SeekableReadStream *stream) {
+	Crc32CheckingReadStream *checking = dynamic_cast<Crc32CheckingReadStream *>(stream);
+	if (checking)
+		stream = checking->getParent();
+	return dynamic_cast<DeflateSeekIndex *>(stream);
+}
+
+} // End of namespace Common
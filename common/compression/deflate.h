@@ -23,6 +23,7 @@
 #define COMMON_ZLIB_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/types.h"
 
 namespace Common {
@@ -180,6 +181,100 @@ SeekableReadStream *wrapClickteamReadStream(SeekableReadStream *toBeWrapped,
  */
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped);
 
+/**
+ * Take an arbitrary SeekableReadStream and wrap it in a custom stream which
+ * checks the CRC-32 of the data, as it is read in order from the start. Once
+ * all of the data has been read, err() is set if its CRC-32 is not @p crc.
+ * Data which is skipped by seeking past it is not checked.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped	the stream to be wrapped, which has to know its size
+ * @param crc		the CRC-32 which the data is expected to have
+ */
+SeekableReadStream *wrapCrc32CheckingReadStream(SeekableReadStream *toBeWrapped, uint32 crc,
+		DisposeAfterUse::Flag disposeParent = DisposeAfterUse::YES);
+
+/**
+ * Checkpoints which let a stream of deflate data resume decompressing in the
+ * middle, so that seeking backward does not have to start over from the
+ * beginning of the data. They are recorded at the start of deflate blocks
+ * while the data is decompressed for the first time, and hold the 32 KiB of
+ * data before them, which the following blocks may refer to.
+ *
+ * The streams returned by wrapCompressedReadStream, wrapDeflateReadStream
+ * and wrapClickteamReadStream keep such an index, see getDeflateSeekIndex.
+ */
+class DeflateSeekIndex {
+public:
+	static const uint32 kWindowSize = 32768;
+	static const uint32 kDefaultInterval = 1024 * 1024;
+
+	DeflateSeekIndex() : _interval(kDefaultInterval) {}
+	virtual ~DeflateSeekIndex();
+
+	/**
+	 * Set how many bytes of decompressed data there are at least between
+	 * two checkpoints, or 0 to record no more of them. Each checkpoint takes
+	 * about 32 KiB of memory.
+	 */
+	void setCheckpointInterval(uint32 interval) { _interval = interval; }
+
+	uint getCheckpointCount() const { return _checkpoints.size(); }
+
+	/**
+	 * Write the checkpoints recorded so far, for example to a file next to
+	 * the compressed one.
+	 */
+	bool saveSeekIndex(WriteStream &out) const;
+
+	/**
+	 * Replace the checkpoints with those written by saveSeekIndex, so that
+	 * seeking does not have to decompress up to them first. Fails if they
+	 * were written for compressed data of a different size.
+	 */
+	bool loadSeekIndex(SeekableReadStream &in);
+
+protected:
+	struct Checkpoint {
+		uint64 outPos;  ///< Position in the decompressed data
+		uint64 inPos;   ///< Offset of the next byte of compressed data
+		byte bits;      ///< Number of bits of the byte before inPos which are not decoded yet
+		byte bitValue;  ///< Those bits, in the low bits
+		byte *window;   ///< The kWindowSize bytes of decompressed data before outPos
+	};
+
+	/** The size of the compressed data, which the offsets are relative to. */
+	virtual uint64 getCompressedSize() const = 0;
+
+	/** Whether a checkpoint should be recorded at the given position. */
+	bool wantCheckpoint(uint64 outPos) const;
+
+	/**
+	 * Record a checkpoint, and return the buffer which the caller has to
+	 * fill with its window.
+	 */
+	byte *addCheckpoint(uint64 outPos, uint64 inPos, byte bits, byte bitValue);
+
+	/** Find the last checkpoint at or before the given position, if any. */
+	const Checkpoint *findCheckpoint(uint64 outPos) const;
+
+private:
+	void clearCheckpoints();
+
+	Array<Checkpoint> _checkpoints;
+	uint32 _interval;
+};
+
+/**
+ * Return the seek index of a stream created by one of the functions above,
+ * or nullptr if it does not keep one, for example because the data is not
+ * compressed. The index of a stream which is wrapped by
+ * wrapCrc32CheckingReadStream is returned as well.
+ */
+DeflateSeekIndex *getDeflateSeekIndex(SeekableReadStream *stream);
+
 /** @} */
 
 } // End of namespace Common
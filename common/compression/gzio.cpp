@@ -213,7 +213,7 @@ static const ush mask_bits[] =
 #define DUMPBITS(n) do {b>>=(n);k-=(n);} while (0)
 
 /* The state stored in filesystem-specific data.  */
-class GzioReadStream : public Common::SeekableReadStream
+class GzioReadStream : public Common::SeekableReadStream, public DeflateSeekIndex
 {
 public:
 	enum class Mode { ZLIB, CLICKTEAM } _mode;
@@ -224,7 +224,8 @@ public:
 		_inflateD(0), _bb(0), _bk(0), _wp(0), _tl(nullptr),
 		_td(nullptr), _bl(0),
 		_bd(0), _savedOffset(0), _err(false), _mode(mode), _input(parent, disposeParent),
-		_inbufD(0), _inbufSize(0), _uncompressedSize(uncompressedSize), _streamPos(0), _eos(false) {
+		_inbufD(0), _inbufSize(0), _uncompressedSize(uncompressedSize), _streamPos(0), _eos(false),
+		_startOffset(parent->pos()), _resumeWindow(false) {
 
 		if (dict && dict_size) {
 			dict_size = MIN<uint32>(dict_size, sizeof(_slide));
@@ -301,6 +302,14 @@ private:
 	uint64 _uncompressedSize;
 	uint64 _streamPos;
 	bool _eos;
+	/* The offset at which the compressed stream, including its header, starts.  */
+	int64 _startOffset;
+	/* The slide was restored from a checkpoint, and is filled up to _wp.  */
+	bool _resumeWindow;
+
+	uint64 getCompressedSize() const override { return _input->size() - _startOffset; }
+	void recordCheckpoint();
+	void restoreCheckpoint(const Checkpoint &checkpoint);
 
 	void inflate_window();
 	void get_new_block();
@@ -1020,8 +1029,11 @@ GzioReadStream::get_new_block()
 void
 GzioReadStream::inflate_window ()
 {
-  /* initialize window */
-  _wp = 0;
+  /* initialize window, unless a checkpoint filled part of it */
+  if (_resumeWindow)
+    _resumeWindow = false;
+  else
+    _wp = 0;
 
   /*
    *  Main decompression loop.
@@ -1041,6 +1053,9 @@ GzioReadStream::inflate_window ()
 	      break;
 	    }
 
+	  if (wantCheckpoint (_savedOffset + _wp))
+	    recordCheckpoint ();
+
 	  get_new_block ();
 	}
 
@@ -1102,6 +1117,7 @@ GzioReadStream::initialize_tables()
   /* Reset partial decompression code.  */
   _lastBlock = 0;
   _blockLen = 0;
+  _resumeWindow = false;
 
   /* Reset memory allocation stuff.  */
   huft_free (_tl);
@@ -1241,9 +1257,19 @@ GzioReadStream::readAtOffset (int64 offset, byte *buf, uint32 len)
 {
   int32 ret = 0;
 
-  /* Do we reset decompression to the beginning of the file?  */
+  /* Do we reset decompression to the beginning of the file, or to a
+     checkpoint if there is one before the offset?  Checkpoints after the
+     data which has been decompressed already save inflating up to them. */
+  const Checkpoint *checkpoint = findCheckpoint (offset);
   if (_savedOffset > offset + WSIZE)
-    initialize_tables();
+    {
+      if (checkpoint)
+	restoreCheckpoint (*checkpoint);
+      else
+	initialize_tables();
+    }
+  else if (checkpoint && checkpoint->outPos > (uint64) _savedOffset)
+    restoreCheckpoint (*checkpoint);
 
   /*
    *  This loop operates upon uncompressed data only.  The only
@@ -1285,6 +1311,33 @@ GzioReadStream::readAtOffset (int64 offset, byte *buf, uint32 len)
   return ret;
 }
 
+void GzioReadStream::recordCheckpoint() {
+	// Whole bytes in the bit buffer are read again after a restore
+	const int64 inPos = _input->pos() - (_inbufSize - _inbufD) - (_bk >> 3) - _startOffset;
+	const unsigned bits = _bk & 7;
+	const uint64 outPos = _savedOffset + _wp;
+
+	// The window starts with the oldest data, which follows _wp in the slide
+	byte *window = addCheckpoint(outPos, inPos, bits, _bb & mask_bits[bits]);
+	memcpy(window, _slide + _wp, WSIZE - _wp);
+	memcpy(window + WSIZE - _wp, _slide, _wp);
+}
+
+void GzioReadStream::restoreCheckpoint(const Checkpoint &checkpoint) {
+	initialize_tables();
+	parentSeek(_startOffset + checkpoint.inPos);
+	_bb = checkpoint.bitValue;
+	_bk = checkpoint.bits;
+	_codeState = 0;
+
+	// Continue filling the window which the checkpoint is in
+	_wp = checkpoint.outPos & (WSIZE - 1);
+	_savedOffset = checkpoint.outPos - _wp;
+	memcpy(_slide + _wp, checkpoint.window, WSIZE - _wp);
+	memcpy(_slide, checkpoint.window + WSIZE - _wp, _wp);
+	_resumeWindow = true;
+}
+
 uint32 GzioReadStream::read(void *dataPtr, uint32 dataSize) {
 	int32 actualRead = readAtOffset(_streamPos, (byte *)dataPtr, dataSize);
 	if (actualRead < 0) {
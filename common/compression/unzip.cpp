@@ -95,6 +95,9 @@ typedef Byte Bytef;
 #include "common/compression/deflate.h"
 #include "common/compression/unzip.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
+#include "common/ptr.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -237,6 +240,15 @@ Common::SharedArchiveContents unzOpenCurrentFile(unzFile file
   If there is no error, the return value is UNZ_OK.
 */
 
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file);
+/*
+  Open the current file in the zipfile for reading straight from the zipfile,
+  instead of holding all of it in memory. Deflated files are inflated while
+  they are read. The CRC is checked once all of the file has been read in
+  order, and err() is set if it is not good.
+  Return nullptr if there is an error.
+*/
+
 int unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
@@ -325,6 +337,8 @@ typedef Common::HashMap<Common::Path, cached_file_in_zip, Common::Path::IgnoreCa
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;	/* owns _stream, shared with streamed files */
+	Common::SharedPtr<Common::Mutex> _mutex;		/* guards _stream against streamed files */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -459,6 +473,8 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 	int err = UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef = Common::SharedPtr<Common::SeekableReadStream>(stream);
+	us->_mutex = Common::SharedPtr<Common::Mutex>(new Common::Mutex());
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos == 0)
@@ -489,7 +505,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_ERRNO;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -516,7 +531,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -606,7 +620,6 @@ int unzClose(unzFile file) {
 		return UNZ_PARAMERROR;
 	s = (unz_s *)file;
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1024,11 +1037,71 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	return Common::SharedArchiveContents(uncompressedBuffer, s->cur_file_info.uncompressed_size);
 }
 
+/*
+  A file which is read straight from the zipfile. It keeps the zipfile open,
+  so that it may outlive the archive.
+*/
+class ZipFileReadStream : public Common::SafeMutexedSeekableSubReadStream {
+public:
+	ZipFileReadStream(const unz_s *s, uint32 begin, uint32 end) :
+		Common::SafeMutexedSeekableSubReadStream(s->_stream, begin, end, DisposeAfterUse::NO, *s->_mutex),
+		_streamRef(s->_streamRef), _mutexRef(s->_mutex) {
+	}
+
+	bool seek(int64 offset, int whence = SEEK_SET) override {
+		Common::StackLock lock(_mutex);
+		return Common::SafeMutexedSeekableSubReadStream::seek(offset, whence);
+	}
+
+private:
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef;
+	Common::SharedPtr<Common::Mutex> _mutexRef;
+};
+
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file) {
+	uInt iSizeVar;
+	unz_s *s;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file == nullptr)
+		return nullptr;
+	s = (unz_s *)file;
+	if (!s->current_file_ok)
+		return nullptr;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar,
+				&offset_local_extrafield, &size_local_extrafield) != UNZ_OK)
+		return nullptr;
+
+	uint32 begin = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + iSizeVar;
+	Common::SeekableReadStream *stream = new ZipFileReadStream(s, begin, begin + s->cur_file_info.compressed_size);
+
+	switch (s->cur_file_info.compression_method) {
+	case 0: // Store
+		break;
+	case Z_DEFLATED:
+		stream = Common::wrapDeflateReadStream(stream, DisposeAfterUse::YES, s->cur_file_info.uncompressed_size);
+		break;
+	default:
+		warning("Unknown compression algoritthm %d", (int)s->cur_file_info.compression_method);
+		delete stream;
+		return nullptr;
+	}
+
+	// The data is checked as it is read, instead of all at once
+	return Common::wrapCrc32CheckingReadStream(stream, s->cur_file_info.crc);
+}
+
 
 namespace Common {
 
 
 class ZipArchive : public MemcachingCaseInsensitiveArchive {
+	enum {
+		kStreamingThreshold = 1024 * 1024
+	};
+
 	unzFile _zipFile;
 #ifndef USE_ZLIB
 	Common::CRC32 _crc;
@@ -1114,6 +1187,19 @@ const ArchiveMemberPtr ZipArchive::getMember(const Path &path) const {
 Common::SharedArchiveContents ZipArchive::readContentsForPath(const Common::Path &path) const {
 	if (unzLocateFile(_zipFile, path, 2) != UNZ_OK)
 		return Common::SharedArchiveContents();
+
+	// Files may be streamed from the zipfile while others are opened
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	Common::StackLock lock(*archive->_mutex);
+
+	// Large files are not cached, but read from the zipfile as needed
+	if (archive->cur_file_info.uncompressed_size >= kStreamingThreshold) {
+		Common::SeekableReadStream *stream = unzOpenCurrentFileStream(_zipFile);
+		if (!stream)
+			return Common::SharedArchiveContents();
+		return Common::SharedArchiveContents::bypass(stream);
+	}
+
 #ifndef USE_ZLIB
 	return unzOpenCurrentFile(_zipFile, _crc);
 #else
@@ -31,6 +31,12 @@
 #error Version 1.2.0.4 or newer of zlib is required for this code
 #endif
 
+// inflateGetDictionary, which seek checkpoints take the window from, was
+// added in zlib 1.2.7.1
+#if ZLIB_VERNUM >= 0x1271
+#define ZLIB_SEEK_CHECKPOINTS
+#endif
+
 #include "common/compression/deflate.h"
 
 #include "common/ptr.h"
@@ -94,7 +100,7 @@ static bool _shownBackwardSeekingWarning = false;
  * other SeekableReadStream and will then provide on-the-fly decompression support.
  * Assumes the compressed data to be in gzip format.
  */
-class GZipReadStream : public SeekableReadStream {
+class GZipReadStream : public SeekableReadStream, public DeflateSeekIndex {
 protected:
 	enum {
 		BUFSIZE = 16384		// 1 << MAX_WBITS
@@ -109,6 +115,50 @@ protected:
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
+	int _windowBits;
+
+	uint64 getCompressedSize() const override {
+		return _wrapped->size() - _parentPos;
+	}
+
+	void recordCheckpoint() {
+#ifdef ZLIB_SEEK_CHECKPOINTS
+		// The bits which are left of the last byte that was read are only
+		// known while it is in the buffer
+		const uint bits = _stream.data_type & 7;
+		if (bits && _stream.next_in == _buf)
+			return;
+
+		uInt windowSize = 0;
+		if (inflateGetDictionary(&_stream, nullptr, &windowSize) != Z_OK || windowSize != kWindowSize)
+			return;
+
+		const uint64 inPos = _wrapped->pos() - _stream.avail_in - _parentPos;
+		byte *window = addCheckpoint(_pos, inPos, bits, bits ? _stream.next_in[-1] >> (8 - bits) : 0);
+		inflateGetDictionary(&_stream, window, &windowSize);
+#endif
+	}
+
+	bool restoreCheckpoint(const Checkpoint &checkpoint) {
+#ifdef ZLIB_SEEK_CHECKPOINTS
+		// Continue with the raw deflate data of the next block
+		_zlibErr = inflateReset2(&_stream, -MAX_WBITS);
+		if (_zlibErr == Z_OK && checkpoint.bits)
+			_zlibErr = inflatePrime(&_stream, checkpoint.bits, checkpoint.bitValue);
+		if (_zlibErr == Z_OK)
+			_zlibErr = inflateSetDictionary(&_stream, checkpoint.window, kWindowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_wrapped->seek(_parentPos + checkpoint.inPos, SEEK_SET);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		_pos = checkpoint.outPos;
+		return true;
+#else
+		return false;
+#endif
+	}
 
 public:
 
@@ -139,7 +189,8 @@ public:
 		// the compressed file. This feature was added in zlib 1.2.0.4,
 		// released 10 August 2003.
 		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		_windowBits = MAX_WBITS + 32;
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -159,7 +210,8 @@ public:
 		_pos = 0;
 		_eos = false;
 
-		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		_windowBits = -MAX_WBITS;
+		_zlibErr = inflateInit2(&_stream, _windowBits);
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -190,17 +242,21 @@ public:
 		_stream.avail_out = dataSize;
 
 		// Keep going while we get no error
+		const uint32 startPos = _pos;
 		while (_zlibErr == Z_OK && _stream.avail_out) {
 			if (_stream.avail_in == 0 && !_wrapped->eos()) {
 				// If we are out of input data: Read more data, if available.
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
-		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+			// Stop at the end of each block, where checkpoints can be taken
+			_zlibErr = inflate(&_stream, Z_BLOCK);
+
+			_pos = startPos + dataSize - _stream.avail_out;
+			if (_zlibErr == Z_OK && (_stream.data_type & 192) == 128 && wantCheckpoint(_pos))
+				recordCheckpoint();
+		}
 
 		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
 			_eos = true;
@@ -236,7 +292,14 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
+		// Resume from the last checkpoint before the position, if that is
+		// closer than where decompressing is now
+		const Checkpoint *checkpoint = findCheckpoint(newPos);
+		bool restored = false;
+		if (checkpoint && (checkpoint->outPos > _pos || (uint32)newPos < _pos))
+			restored = restoreCheckpoint(*checkpoint);
+
+		if (!restored && (uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
 			// to avoid it. :/
@@ -253,7 +316,12 @@ public:
 
 			_pos = 0;
 			_wrapped->seek(_parentPos, SEEK_SET);
+#ifdef ZLIB_SEEK_CHECKPOINTS
+			// A checkpoint may have switched to raw deflate data
+			_zlibErr = inflateReset2(&_stream, _windowBits);
+#else
 			_zlibErr = inflateReset(&_stream);
+#endif
 			if (_zlibErr != Z_OK)
 				return false; // FIXME: STREAM REWRITE
 			_stream.next_in = _buf;
@@ -267,7 +335,12 @@ public:
 		// bytes, so this should be fine.
 		byte tmpBuf[1024];
 		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int64)sizeof(tmpBuf), offset));
+			const uint32 skipped = read(tmpBuf, MIN((int64)sizeof(tmpBuf), offset));
+			// Corrupt data, for example because of a stale seek index,
+			// may end before the position
+			if (!skipped)
+				break;
+			offset -= skipped;
 		}
 
 		_eos = false;
@@ -0,0 +1,716 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The hash map implementation in this file is modelled after the
+// "Swiss table" design of the Abseil library.
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/endian.h"
+#include "common/hashmap.h"
+#include "common/intrinsics.h"
+
+// The group probing is part of a template, so it can only use the SIMD
+// instructions which the whole build may rely on, without any runtime check.
+#if defined(SCUMMVM_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FLAT_HASHMAP_SSE2
+#include <emmintrin.h>
+#elif defined(SCUMMVM_NEON) && defined(__ARM_NEON) && defined(SCUMM_LITTLE_ENDIAN)
+#define FLAT_HASHMAP_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flat_hashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on a hash table storing its elements inline.
+ *
+ * @{
+ */
+
+/**
+ * A group of control bytes of a FlatHashMap, which is probed at once.
+ *
+ * Each slot of the map has a control byte, which is either kEmpty,
+ * kDeleted, or the lowest 7 bits of the hash of the key stored in the slot.
+ * The match functions return a bit mask with one bit set for each matching
+ * slot of the group, use lowestSlot() to walk through it.
+ */
+struct FlatHashMapGroup {
+	enum {
+		kEmpty = -128,
+		kDeleted = -2
+	};
+
+#if defined(FLAT_HASHMAP_SSE2)
+	enum {
+		kWidth = 16,
+		kMaskShift = 0
+	};
+
+	typedef uint32 Mask;
+
+	static Mask match(const int8 *ctrl, int8 h2) {
+		const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+	}
+
+	static Mask matchEmpty(const int8 *ctrl) {
+		return match(ctrl, kEmpty);
+	}
+
+	/** Match the slots which are either empty or deleted. */
+	static Mask matchFree(const int8 *ctrl) {
+		return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+	}
+#else
+	enum {
+		kWidth = 8,
+		kMaskShift = 3
+	};
+
+	// Each matching slot sets the highest bit of its byte
+	typedef uint64 Mask;
+
+	static Mask load(const int8 *ctrl) {
+#if defined(FLAT_HASHMAP_NEON)
+		return vget_lane_u64(vreinterpret_u64_u8(vld1_u8((const uint8 *)ctrl)), 0);
+#else
+		return READ_LE_UINT64(ctrl);
+#endif
+	}
+
+	static Mask match(const int8 *ctrl, int8 h2) {
+#if defined(FLAT_HASHMAP_NEON)
+		const uint8x8_t eq = vceq_u8(vld1_u8((const uint8 *)ctrl), vdup_n_u8((uint8)h2));
+		return vget_lane_u64(vreinterpret_u64_u8(eq), 0) & kHighBits;
+#else
+		// This may also report a slot following a true match, which only
+		// costs an extra key comparison
+		const uint64 x = load(ctrl) ^ (kLowBits * (uint8)h2);
+		return (x - kLowBits) & ~x & kHighBits;
+#endif
+	}
+
+	static Mask matchEmpty(const int8 *ctrl) {
+		// kEmpty is the only control byte with the highest bit set and the
+		// second lowest bit cleared
+		const uint64 x = load(ctrl);
+		return x & ~(x << 6) & kHighBits;
+	}
+
+	/** Match the slots which are either empty or deleted. */
+	static Mask matchFree(const int8 *ctrl) {
+		return load(ctrl) & kHighBits;
+	}
+
+	static const uint64 kLowBits = 0x0101010101010101ULL;
+	static const uint64 kHighBits = 0x8080808080808080ULL;
+#endif
+
+	/** Return the index in the group of the lowest slot set in @p mask, which must not be empty. */
+	static uint lowestSlot(Mask mask) {
+		const uint32 low = (uint32)mask;
+		if (low)
+			return intLog2(low & (0 - low)) >> kMaskShift;
+
+		const uint32 high = (uint32)((uint64)mask >> 32);
+		return (32 + intLog2(high & (0 - high))) >> kMaskShift;
+	}
+};
+
+/**
+ * FlatHashMap<Key,Val> is a drop-in replacement for HashMap<Key,Val>, which
+ * stores the keys and values in one array instead of allocating a node for
+ * each of them. Next to that array, one control byte per slot holds a part
+ * of the hash of the key, so that a lookup compares a whole group of slots
+ * at once, using SSE2 or NEON when the build allows it, and only compares
+ * the keys whose hash matches.
+ *
+ * This makes lookups cheaper, as they usually touch a single cache line of
+ * control bytes and then the element itself. The price is that, unlike with
+ * HashMap, inserting an element may move the other elements around, which
+ * invalidates any pointer or reference to them as well as any iterator.
+ * Erasing an element does not move the others.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		Val _value;
+		const Key _key;
+		explicit Node(const Key &key) : _value(), _key(key) {}
+		Node(const Node &node) : _value(node._value), _key(node._key) {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+	typedef FlatHashMapGroup Group;
+
+	enum {
+		HASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage of the hashmap may fill up before being
+		// increased automatically. Deleted elements are also counted.
+		HASHMAP_LOADFACTOR_NUMERATOR = 7,
+		HASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	int8 *_ctrl;    ///< One control byte per slot.
+	Node *_slots;   ///< The elements, only constructed in the slots used.
+	size_type _mask;    ///< Capacity of the HashMap minus one; the capacity must be a power of two
+	size_type _size;
+	size_type _deleted; ///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/**
+	 * Mix the bits of the hash, since the hash functions of the integer
+	 * types are simply the identity.
+	 */
+	static size_type mixHash(size_type hash) {
+		const uint32 h = (uint32)hash * 0x9E3779B1;
+		return h ^ (h >> 16);
+	}
+
+	static int8 h2(size_type hash) { return (int8)(hash & 0x7F); }
+	size_type firstGroup(size_type hash) const { return ((hash >> 7) * Group::kWidth) & _mask; }
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const HM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type lookup(const Key &key, size_type hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	size_type findFreeSlot(size_type hash) const;
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type ctr);
+
+	/** The slot index returned by the lookup functions when a key is not found. */
+	size_type notFound() const { return _mask + 1; }
+
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->_ctrl[_idx] >= 0);
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsedSlot(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Return the index of the first used slot from @p ctr on, or (size_type)-1 if there is none. */
+	size_type nextUsedSlot(size_type ctr) const {
+		for (; ctr <= _mask; ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				return ctr;
+		}
+		return (size_type)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const HM_t &map);
+	~FlatHashMap();
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getOrCreateVal(const Key &key);
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getValOrDefault(const Key &key) const;
+	const Val &getValOrDefault(const Key &key, const Val &defaultVal) const;
+	bool tryGetVal(const Key &key, Val &out) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		return iterator(nextUsedSlot(0), this);
+	}
+	iterator	end() {
+		return iterator((size_type)-1, this);
+	}
+
+	const_iterator	begin() const {
+		return const_iterator(nextUsedSlot(0), this);
+	}
+	const_iterator	end() const {
+		return const_iterator((size_type)-1, this);
+	}
+
+	iterator	find(const Key &key) {
+		size_type ctr = lookup(key);
+		if (ctr != notFound())
+			return iterator(ctr, this);
+		return end();
+	}
+
+	const_iterator	find(const Key &key) const {
+		size_type ctr = lookup(key);
+		if (ctr != notFound())
+			return const_iterator(ctr, this);
+		return end();
+	}
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(HASHMAP_MIN_CAPACITY);
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const HM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method for allocating empty storage.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= HASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_mask = capacity - 1;
+	_ctrl = new int8[capacity];
+	memset(_ctrl, Group::kEmpty, capacity);
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	if (!_slots)
+		::error("Common::FlatHashMap: failure to allocate %u bytes", capacity * (size_type)sizeof(Node));
+
+	_size = 0;
+	_deleted = 0;
+}
+
+/**
+ * Internal method for destroying all elements and freeing the storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			_slots[ctr].~Node();
+	}
+
+	delete[] _ctrl;
+	free(_slots);
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Both maps use the same hash function, so the elements can simply be
+	// copied to the same slots.
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(HASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			_slots[ctr].~Node();
+	}
+
+	memset(_ctrl, Group::kEmpty, _mask + 1);
+	_size = 0;
+	_deleted = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	assert(newCapacity > _size);
+
+#ifndef RELEASE_BUILD
+	const size_type old_size = _size;
+#endif
+	const size_type old_mask = _mask;
+	int8 *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	// Move all the old elements over. Since we know that no key exists
+	// twice in the old table, we don't have to call _equal().
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] < 0)
+			continue;
+
+		const size_type hash = mixHash(_hash(old_slots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+		_ctrl[idx] = h2(hash);
+		new ((void *)&_slots[idx]) Node(old_slots[ctr]);
+		old_slots[ctr].~Node();
+		_size++;
+	}
+
+#ifndef RELEASE_BUILD
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+#endif
+
+	delete[] old_ctrl;
+	free(old_slots);
+}
+
+/**
+ * Return the first slot which is empty or deleted in the probe sequence of
+ * @p hash. There must be one.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(size_type hash) const {
+	size_type group = firstGroup(hash);
+	for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+		const Group::Mask mask = Group::matchFree(_ctrl + group);
+		if (mask)
+			return group + Group::lowestSlot(mask);
+
+		// Triangular probing visits every group when their number is a
+		// power of two
+		group = (group + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	return lookup(key, mixHash(_hash(key)));
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key, size_type hash) const {
+	const int8 tag = h2(hash);
+	size_type group = firstGroup(hash);
+	for (size_type step = Group::kWidth; step <= _mask + 1; step += Group::kWidth) {
+		const int8 *ctrl = _ctrl + group;
+		for (Group::Mask mask = Group::match(ctrl, tag); mask; mask &= mask - 1) {
+			const size_type ctr = group + Group::lowestSlot(mask);
+			if (_ctrl[ctr] == tag && _equal(_slots[ctr]._key, key))
+				return ctr;
+		}
+
+		// The probe sequence of a key never goes past a group with an
+		// empty slot
+		if (Group::matchEmpty(ctrl))
+			break;
+
+		group = (group + step) & _mask;
+	}
+
+	return notFound();
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const size_type hash = mixHash(_hash(key));
+	size_type ctr = lookup(key, hash);
+	if (ctr != notFound())
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted slots are also
+	// counted, but when they make up a good part of the storage, it is
+	// enough to rehash it at the same size to get rid of them.
+	const size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * HASHMAP_LOADFACTOR_DENOMINATOR > capacity * HASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 * HASHMAP_LOADFACTOR_DENOMINATOR > capacity * HASHMAP_LOADFACTOR_NUMERATOR)
+			rehash(capacity * 2);
+		else
+			rehash(capacity);
+	}
+
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == Group::kDeleted)
+		_deleted--;
+	_ctrl[ctr] = h2(hash);
+	new ((void *)&_slots[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type ctr) {
+	assert(ctr <= _mask);
+	assert(_ctrl[ctr] >= 0);
+
+	_slots[ctr].~Node();
+	_size--;
+
+	// If the group still has an empty slot, no probe sequence ever went past
+	// it, so the slot can become empty again. Otherwise, it has to be
+	// marked as deleted so that lookups go on with the next group.
+	if (Group::matchEmpty(_ctrl + (ctr & ~(size_type)(Group::kWidth - 1)))) {
+		_ctrl[ctr] = Group::kEmpty;
+	} else {
+		_ctrl[ctr] = Group::kDeleted;
+		_deleted++;
+	}
+}
+
+/**
+ * Check whether the hashmap contains the given key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != notFound();
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getOrCreateVal(key);
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+/**
+ * Get a value from the hashmap, creating it if the key is not present.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getOrCreateVal(const Key &key) {
+	// The storage may move while creating the element
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+/**
+ * Get a value from the hashmap. The key must be present.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != notFound())
+		return _slots[ctr]._value;
+	else
+		// See the comment in HashMap::getVal()
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	size_type ctr = lookup(key);
+	if (ctr != notFound())
+		return _slots[ctr]._value;
+	else
+		// See the comment in HashMap::getVal()
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key) const {
+	return getValOrDefault(key, _defaultVal);
+}
+
+/**
+ * Get a value from the hashmap. If the key is not present, then return @p defaultVal.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr != notFound())
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+/**
+ * Get a value from the hashmap into @p out. Return false if the key is not present.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::tryGetVal(const Key &key, Val &out) const {
+	size_type ctr = lookup(key);
+	if (ctr != notFound()) {
+		out = _slots[ctr]._value;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+/**
+ * Assign an element specified by @p key to a value @p val.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	const size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	eraseSlot(entry._idx);
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != notFound())
+		eraseSlot(ctr);
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -252,6 +252,19 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Get the size and the last modification time of the file referred by
+	 * this node, without opening it. This is much cheaper than opening the
+	 * file on most file systems, and allows checking whether a file changed.
+	 *
+	 * The modification time uses a backend-specific unit, and should only be
+	 * compared with other values returned by this method.
+	 *
+	 * @return True if the information is available, false if the node does
+	 *         not refer to a file or if the backend does not support it.
+	 */
+	bool getFileStats(int64 &size, int64 &modificationTime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
@@ -19,7 +19,17 @@
  *
  */
 
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(POSIX)
+#include <sched.h>
+#endif
+
 #include "common/memorypool.h"
+#include "common/algorithm.h"
+#include "common/atomic.h"
+#include "common/textconsole.h"
 #include "common/util.h"
 
 namespace Common {
@@ -174,4 +184,511 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+//-------------------------------------------------------
+// SizeClassPool
+
+// The thread caches need atomics for the shared lists, and thread-local
+// storage, which is not available with the toolchains of all ports. Without
+// them, every operation goes to the shared lists.
+#if defined(COMMON_HAS_ATOMICS) && (defined(POSIX) || defined(WIN32))
+#define USE_POOL_THREAD_CACHE
+#endif
+
+namespace {
+
+enum {
+	// Class 0 holds the blocks of up to 8 bytes, the other classes are
+	// 16 bytes apart so that their blocks are suitably aligned for any type
+	NUM_SIZE_CLASSES = 1 + SizeClassPool::kMaxChunkSize / 16,
+
+	// Pages start small, so that the classes which are barely used do not
+	// waste memory, and grow up to this size
+	MAX_PAGE_SIZE = 16 * 1024,
+	MIN_CHUNKS_PER_PAGE = 16,
+
+	// Every page starts with a header, padded so that the blocks which
+	// follow it stay aligned
+	PAGE_HEADER_SIZE = 16,
+
+	// Number of bytes exchanged at once between a thread cache and the
+	// shared lists, a thread cache holds up to twice as much
+	BATCH_BYTES = 2048,
+
+	// Number of times a thread checks a busy lock before it lets the other
+	// threads run
+	MAX_LOCK_SPINS = 64
+};
+
+struct FreeChunk {
+	FreeChunk *next;
+};
+
+struct PageHeader {
+	PageHeader *next;
+	size_t size;
+};
+
+STATIC_ASSERT(sizeof(PageHeader) <= PAGE_HEADER_SIZE, page_header_fits_in_its_padding);
+
+/**
+ * The part of a size class shared by all threads. This is plain data, so
+ * that the pool works from static constructors and destructors.
+ *
+ * The blocks given back by the threads are pushed on a separate list with
+ * atomic operations only, so that freeing never waits for the lock. They
+ * are moved over to the free list, under the lock, once it runs short.
+ */
+struct SharedClass {
+	volatile int32 lock;
+	FreeChunk *freeList;
+	uint32 numFree;
+	FreeChunk *volatile returned;
+	volatile int32 numReturned;
+	PageHeader *pages;  ///< All pages, the one blocks are carved from first
+	byte *pageCur;      ///< Start of the part of the first page not handed out yet
+	byte *pageEnd;
+	size_t nextPageSize;
+	uint32 numPages;
+	size_t bytesHeld;
+	uint32 numCarved;   ///< Number of blocks handed out from the pages so far
+	uint32 numReclaimed; ///< Number of blocks given back since the pages were last checked
+};
+
+SharedClass g_sharedClasses[NUM_SIZE_CLASSES];
+
+inline uint getSizeClass(size_t size) {
+	return size <= 8 ? 0 : (uint)((size + 15) >> 4);
+}
+
+inline size_t getClassChunkSize(uint sizeClass) {
+	return sizeClass ? (size_t)sizeClass << 4 : 8;
+}
+
+inline uint32 getBatchSize(uint sizeClass) {
+	return CLIP<uint32>(BATCH_BYTES / getClassChunkSize(sizeClass), 8, 64);
+}
+
+/** Let the other threads run, such as one which was preempted while holding a lock. */
+void yieldThread() {
+#if defined(WIN32)
+	SwitchToThread();
+#elif defined(POSIX)
+	sched_yield();
+#endif
+}
+
+void lockSpin(volatile int32 *lock) {
+	uint spins = 0;
+	while (!atomicCompareExchange(lock, (int32)0, (int32)1)) {
+		while (atomicLoadRelaxed(lock)) {
+			// The locks are only held briefly, unless the holder was
+			// preempted, which spinning would only make worse
+			if (++spins == MAX_LOCK_SPINS) {
+				yieldThread();
+				spins = 0;
+			}
+		}
+	}
+}
+
+void unlockSpin(volatile int32 *lock) {
+	atomicStore(lock, (int32)0);
+}
+
+/**
+ * Move the blocks given back by the threads to the free list of @p shared,
+ * with the lock held.
+ */
+void collectReturned(SharedClass &shared) {
+	// Taking the whole list does not depend on its contents, so unlike
+	// popping single blocks, this is safe from blocks being reused meanwhile
+	FreeChunk *head;
+	do {
+		head = atomicLoad(&shared.returned);
+	} while (head && !atomicCompareExchange(&shared.returned, head, (FreeChunk *)nullptr));
+
+	if (!head)
+		return;
+
+	uint32 count = 1;
+	FreeChunk *tail = head;
+	for (; tail->next; tail = tail->next)
+		count++;
+
+	tail->next = shared.freeList;
+	shared.freeList = head;
+	shared.numFree += count;
+	shared.numReclaimed += count;
+	atomicAdd(&shared.numReturned, -(int32)count);
+}
+
+/**
+ * Take up to @p count blocks from the shared lists of @p sizeClass, with
+ * the lock held. Return the number of blocks taken, which is only lower
+ * than @p count when the list is empty and a new page is needed.
+ */
+uint32 takeShared(uint sizeClass, FreeChunk *&head, uint32 count) {
+	SharedClass &shared = g_sharedClasses[sizeClass];
+	uint32 taken = 0;
+
+	if (shared.numFree < count)
+		collectReturned(shared);
+
+	head = nullptr;
+	while (taken < count && shared.freeList) {
+		FreeChunk *chunk = shared.freeList;
+		shared.freeList = chunk->next;
+		chunk->next = head;
+		head = chunk;
+		taken++;
+	}
+	shared.numFree -= taken;
+
+	const size_t chunkSize = getClassChunkSize(sizeClass);
+	for (; taken < count; taken++) {
+		if ((size_t)(shared.pageEnd - shared.pageCur) < chunkSize) {
+			if (taken)
+				break;
+
+			if (!shared.nextPageSize)
+				shared.nextPageSize = PAGE_HEADER_SIZE + chunkSize * MIN_CHUNKS_PER_PAGE;
+
+			byte *page = (byte *)::malloc(shared.nextPageSize);
+			if (!page)
+				::error("Common::SizeClassPool: failure to allocate %u bytes", (uint)shared.nextPageSize);
+
+			PageHeader *header = (PageHeader *)page;
+			header->next = shared.pages;
+			header->size = shared.nextPageSize;
+			shared.pages = header;
+
+			shared.pageCur = page + PAGE_HEADER_SIZE;
+			shared.pageEnd = page + shared.nextPageSize;
+			shared.numPages++;
+			shared.bytesHeld += shared.nextPageSize;
+			shared.nextPageSize = MIN<size_t>(shared.nextPageSize * 2, MAX_PAGE_SIZE);
+		}
+
+		FreeChunk *chunk = (FreeChunk *)shared.pageCur;
+		shared.pageCur += chunkSize;
+		shared.numCarved++;
+		chunk->next = head;
+		head = chunk;
+	}
+
+	return taken;
+}
+
+/**
+ * Return the list of @p count blocks from @p head to @p tail to the shared
+ * lists of @p sizeClass. This does not need the lock, and may be called
+ * while another thread holds it.
+ */
+void returnShared(uint sizeClass, FreeChunk *head, FreeChunk *tail, uint32 count) {
+	SharedClass &shared = g_sharedClasses[sizeClass];
+	FreeChunk *returned;
+	do {
+		returned = atomicLoad(&shared.returned);
+		tail->next = returned;
+	} while (!atomicCompareExchange(&shared.returned, returned, head));
+
+	atomicAdd(&shared.numReturned, (int32)count);
+}
+
+/** The part of a page with the blocks handed out so far */
+struct PageRange {
+	byte *start;
+	byte *end;
+	uint32 numFree;
+
+	bool operator<(const PageRange &other) const { return start < other.start; }
+
+	bool isUnused(size_t chunkSize) const { return numFree == (uint32)((end - start) / chunkSize); }
+};
+
+/** Return the range from @p ranges, sorted by address, in which @p ptr lies. */
+PageRange *findPageRange(PageRange *ranges, uint32 count, const void *ptr) {
+	uint32 low = 0, high = count;
+	while (high - low > 1) {
+		const uint32 mid = (low + high) / 2;
+		if (ranges[mid].start <= (const byte *)ptr)
+			low = mid;
+		else
+			high = mid;
+	}
+	return &ranges[low];
+}
+
+/** Release the pages of @p sizeClass of which no block is in use, with the lock held. */
+void releasePages(uint sizeClass) {
+	SharedClass &shared = g_sharedClasses[sizeClass];
+	const size_t chunkSize = getClassChunkSize(sizeClass);
+
+	PageRange *ranges = (PageRange *)::malloc(shared.numPages * sizeof(PageRange));
+	if (!ranges)
+		return;
+
+	uint32 numRanges = 0;
+	for (PageHeader *page = shared.pages; page; page = page->next) {
+		PageRange &range = ranges[numRanges++];
+		range.start = (byte *)page + PAGE_HEADER_SIZE;
+		if (page == shared.pages && shared.pageCur)
+			range.end = shared.pageCur;
+		else
+			range.end = range.start + (page->size - PAGE_HEADER_SIZE) / chunkSize * chunkSize;
+		range.numFree = 0;
+	}
+	sort(ranges, ranges + numRanges);
+
+	for (FreeChunk *chunk = shared.freeList; chunk; chunk = chunk->next)
+		findPageRange(ranges, numRanges, chunk)->numFree++;
+
+	for (FreeChunk **iter = &shared.freeList; *iter;) {
+		if (findPageRange(ranges, numRanges, *iter)->isUnused(chunkSize)) {
+			*iter = (*iter)->next;
+			shared.numFree--;
+		} else {
+			iter = &(*iter)->next;
+		}
+	}
+
+	for (PageHeader **iter = &shared.pages; *iter;) {
+		PageHeader *page = *iter;
+		const PageRange *range = findPageRange(ranges, numRanges, (byte *)page + PAGE_HEADER_SIZE);
+		if (!range->isUnused(chunkSize)) {
+			iter = &page->next;
+			continue;
+		}
+
+		if (page == shared.pages && shared.pageCur) {
+			shared.pageCur = nullptr;
+			shared.pageEnd = nullptr;
+		}
+
+		*iter = page->next;
+		shared.numPages--;
+		shared.bytesHeld -= page->size;
+		shared.numCarved -= range->numFree;
+		::free(page);
+	}
+
+	::free(ranges);
+}
+
+#ifdef USE_POOL_THREAD_CACHE
+
+struct ThreadCache {
+	FreeChunk *freeList[NUM_SIZE_CLASSES];
+	volatile uint32 numFree[NUM_SIZE_CLASSES]; ///< Also read by getStats() from other threads
+	ThreadCache *next;
+};
+
+/** All thread caches, for the statistics */
+ThreadCache *g_threadCaches = nullptr;
+volatile int32 g_threadCachesLock = 0;
+
+thread_local ThreadCache *t_threadCache = nullptr;
+thread_local bool t_threadExiting = false;
+
+void flushCache(ThreadCache *cache) {
+	for (uint sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++) {
+		FreeChunk *head = cache->freeList[sizeClass];
+		if (!head)
+			continue;
+
+		FreeChunk *tail = head;
+		while (tail->next)
+			tail = tail->next;
+
+		returnShared(sizeClass, head, tail, cache->numFree[sizeClass]);
+
+		cache->freeList[sizeClass] = nullptr;
+		atomicStoreRelaxed(&cache->numFree[sizeClass], (uint32)0);
+	}
+}
+
+/** Give the blocks of a thread back when it exits */
+struct ThreadCacheReaper {
+	~ThreadCacheReaper() {
+		ThreadCache *cache = t_threadCache;
+		t_threadCache = nullptr;
+		t_threadExiting = true;
+		if (!cache)
+			return;
+
+		flushCache(cache);
+
+		lockSpin(&g_threadCachesLock);
+		for (ThreadCache **iter = &g_threadCaches; *iter; iter = &(*iter)->next) {
+			if (*iter == cache) {
+				*iter = cache->next;
+				break;
+			}
+		}
+		unlockSpin(&g_threadCachesLock);
+
+		::free(cache);
+	}
+};
+
+/** Return the cache of the calling thread, or nullptr once it is exiting. */
+inline ThreadCache *getThreadCache() {
+	ThreadCache *cache = t_threadCache;
+	if (cache || t_threadExiting)
+		return cache;
+
+	// Make sure that the cache is flushed when the thread exits
+	thread_local ThreadCacheReaper reaper;
+	(void)reaper;
+
+	cache = (ThreadCache *)::calloc(1, sizeof(ThreadCache));
+	if (!cache)
+		return nullptr;
+
+	lockSpin(&g_threadCachesLock);
+	cache->next = g_threadCaches;
+	g_threadCaches = cache;
+	unlockSpin(&g_threadCachesLock);
+
+	t_threadCache = cache;
+	return cache;
+}
+
+#endif
+
+} // End of anonymous namespace
+
+void *SizeClassPool::allocChunk(size_t size) {
+	if (size > kMaxChunkSize) {
+		void *ptr = ::malloc(size);
+		if (!ptr)
+			::error("Common::SizeClassPool: failure to allocate %u bytes", (uint)size);
+		return ptr;
+	}
+
+	const uint sizeClass = getSizeClass(size);
+	FreeChunk *chunk;
+
+#ifdef USE_POOL_THREAD_CACHE
+	ThreadCache *cache = getThreadCache();
+	if (cache) {
+		chunk = cache->freeList[sizeClass];
+		uint32 numFree = cache->numFree[sizeClass];
+		if (!chunk) {
+			SharedClass &shared = g_sharedClasses[sizeClass];
+			lockSpin(&shared.lock);
+			numFree = takeShared(sizeClass, chunk, getBatchSize(sizeClass));
+			unlockSpin(&shared.lock);
+		}
+
+		cache->freeList[sizeClass] = chunk->next;
+		atomicStoreRelaxed(&cache->numFree[sizeClass], numFree - 1);
+		return chunk;
+	}
+#endif
+
+	SharedClass &shared = g_sharedClasses[sizeClass];
+	lockSpin(&shared.lock);
+	takeShared(sizeClass, chunk, 1);
+	unlockSpin(&shared.lock);
+	return chunk;
+}
+
+void SizeClassPool::freeChunk(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	if (size > kMaxChunkSize) {
+		::free(ptr);
+		return;
+	}
+
+	const uint sizeClass = getSizeClass(size);
+	FreeChunk *chunk = (FreeChunk *)ptr;
+
+#ifdef USE_POOL_THREAD_CACHE
+	ThreadCache *cache = getThreadCache();
+	if (cache) {
+		chunk->next = cache->freeList[sizeClass];
+		cache->freeList[sizeClass] = chunk;
+
+		uint32 numFree = cache->numFree[sizeClass] + 1;
+		const uint32 batchSize = getBatchSize(sizeClass);
+		if (numFree > batchSize * 2) {
+			// Give the most recently freed blocks back, the others are
+			// less likely to still be in the cache of the CPU
+			FreeChunk *tail = chunk;
+			for (uint32 i = 1; i < batchSize; i++)
+				tail = tail->next;
+			cache->freeList[sizeClass] = tail->next;
+
+			returnShared(sizeClass, chunk, tail, batchSize);
+
+			numFree -= batchSize;
+		}
+
+		atomicStoreRelaxed(&cache->numFree[sizeClass], numFree);
+		return;
+	}
+#endif
+
+	returnShared(sizeClass, chunk, chunk, 1);
+}
+
+void SizeClassPool::flushThreadCache() {
+#ifdef USE_POOL_THREAD_CACHE
+	ThreadCache *cache = t_threadCache;
+	if (cache)
+		flushCache(cache);
+#endif
+}
+
+void SizeClassPool::freeUnusedPages() {
+	for (uint sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++) {
+		SharedClass &shared = g_sharedClasses[sizeClass];
+		lockSpin(&shared.lock);
+		collectReturned(shared);
+
+		// Only look at the pages again once enough blocks were given back
+		// to fill one, so that frequent calls stay cheap
+		if (shared.numReclaimed * getClassChunkSize(sizeClass) >= MAX_PAGE_SIZE) {
+			releasePages(sizeClass);
+			shared.numReclaimed = 0;
+		}
+		unlockSpin(&shared.lock);
+	}
+}
+
+void SizeClassPool::getStats(Stats &stats) {
+	stats.pages = 0;
+	stats.bytesHeld = 0;
+	stats.bytesInUse = 0;
+	stats.bytesCached = 0;
+
+	size_t bytesFree = 0;
+	for (uint sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++) {
+		SharedClass &shared = g_sharedClasses[sizeClass];
+		const size_t chunkSize = getClassChunkSize(sizeClass);
+
+		lockSpin(&shared.lock);
+		stats.pages += shared.numPages;
+		stats.bytesHeld += shared.bytesHeld;
+		stats.bytesInUse += shared.numCarved * chunkSize;
+		bytesFree += (shared.numFree + MAX<int32>(atomicLoadRelaxed(&shared.numReturned), 0)) * chunkSize;
+		unlockSpin(&shared.lock);
+	}
+
+#ifdef USE_POOL_THREAD_CACHE
+	lockSpin(&g_threadCachesLock);
+	for (ThreadCache *cache = g_threadCaches; cache; cache = cache->next) {
+		for (uint sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++)
+			stats.bytesCached += atomicLoadRelaxed(&cache->numFree[sizeClass]) * getClassChunkSize(sizeClass);
+	}
+	unlockSpin(&g_threadCachesLock);
+#endif
+
+	bytesFree += stats.bytesCached;
+	stats.bytesInUse = stats.bytesInUse > bytesFree ? stats.bytesInUse - bytesFree : 0;
+}
+
 } // End of namespace Common
@@ -148,6 +148,75 @@ public:
 	}
 };
 
+/**
+ * A process-wide pool for small memory blocks of any size, which may be
+ * used from any thread.
+ *
+ * Blocks are grouped in size classes, each with its own pages. Every
+ * thread keeps a few free blocks of each class for itself, so most
+ * allocations and frees do not need any synchronization. A block may be
+ * freed by another thread than the one which allocated it, it then simply
+ * goes to the cache of the freeing thread. Only when a cache runs empty or
+ * grows too large does the thread exchange a batch of blocks with the
+ * shared lists. Giving blocks back never waits for another thread, taking
+ * them needs a short spin lock.
+ *
+ * The blocks freed are reused for later allocations of the same size
+ * class, and the pages are only released by freeUnusedPages(). Blocks
+ * bigger than kMaxChunkSize are passed on to malloc() and free().
+ *
+ * Common::String uses this pool for its reference counts and
+ * Common::HashMap for its nodes.
+ */
+class SizeClassPool {
+public:
+	enum {
+		kMaxChunkSize = 256
+	};
+
+	struct Stats {
+		uint32 pages;       ///< Number of pages held by the pool
+		size_t bytesHeld;   ///< Size of those pages
+		size_t bytesInUse;  ///< Size of the blocks currently allocated from them
+		size_t bytesCached; ///< Size of the free blocks kept by the threads
+
+		/** Part of the memory held by the pool which is not in use, from 0 to 1. */
+		double getFragmentation() const { return bytesHeld ? (double)(bytesHeld - bytesInUse) / bytesHeld : 0.0; }
+	};
+
+	/**
+	 * Allocate a block of @p size bytes. It must be returned with
+	 * freeChunk() and the same size.
+	 */
+	static void *allocChunk(size_t size);
+
+	/**
+	 * Return a block obtained from allocChunk() with the same @p size. This
+	 * may be called from another thread than the allocation.
+	 */
+	static void freeChunk(void *ptr, size_t size);
+
+	/**
+	 * Return the free blocks kept by the calling thread to the shared lists.
+	 * This is done automatically when a thread exits.
+	 */
+	static void flushThreadCache();
+
+	/**
+	 * Release the pages of which no block is in use, nor kept by a thread.
+	 * A size class is only checked once a page worth of blocks came back
+	 * to the shared lists since the last time, so this is cheap enough to
+	 * be called often.
+	 */
+	static void freeUnusedPages();
+
+	/**
+	 * Get statistics about the pool. The numbers are only approximate
+	 * while other threads use the pool.
+	 */
+	static void getStats(Stats &stats);
+};
+
 /** @} */
 
 } // End of namespace Common
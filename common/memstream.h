@@ -93,6 +93,9 @@ public:
 	int64 size() const { return _size; }
 
 	bool seek(int64 offs, int whence = SEEK_SET);
+
+	/** Return the whole data of the stream, which can be used without reading it. */
+	const byte *getData() const { return _ptrOrig.get(); }
 };
 
 
@@ -0,0 +1,322 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "common/profiler.h"
+#include "common/atomic.h"
+#include "common/savefile.h"
+#include "common/str.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+// The buffers of the threads are only written by their thread, and read by
+// the main thread, which needs atomic operations and thread local storage
+#if defined(COMMON_HAS_ATOMICS) && (defined(POSIX) || defined(WIN32))
+#define USE_PROFILER
+#endif
+
+namespace Common {
+
+volatile bool Profiler::_running = false;
+
+#ifdef USE_PROFILER
+
+namespace {
+
+enum {
+	kBufferSize = 8192 // events, a power of two
+};
+
+enum EventType {
+	kEventZone,
+	kEventCounter,
+	kEventThreadName
+};
+
+struct Event {
+	const char *name;
+	uint64 time;
+	int64 value; ///< Duration of a zone, or value of a counter
+	uint32 thread;
+	uint32 type;
+};
+
+/**
+ * A single producer, single consumer ring of events. Once a thread exits,
+ * its buffer may be taken over by another thread.
+ */
+struct Buffer {
+	Event events[kBufferSize];
+	volatile uint32 writePos; ///< Only changed by the owner
+	volatile uint32 readPos;  ///< Only changed by the main thread
+	volatile uint32 dropped;  ///< Only changed by the owner
+	volatile int32 owned;
+	Buffer *next;
+};
+
+// Buffers are never freed, so that threads still writing while the profiler
+// is stopped are safe
+Buffer *volatile g_buffers = nullptr;
+volatile uint32 g_nextThreadId = 0;
+
+WriteStream *g_stream = nullptr;
+bool g_firstEvent;
+uint64 g_startTime;
+uint64 g_frameStart;
+
+thread_local Buffer *t_buffer = nullptr;
+thread_local uint32 t_threadId = 0;
+
+struct BufferReleaser {
+	~BufferReleaser() {
+		if (t_buffer)
+			atomicStore(&t_buffer->owned, (int32)0);
+	}
+};
+
+Buffer *getThreadBuffer() {
+	if (t_buffer)
+		return t_buffer;
+
+	// Release the buffer when the thread exits
+	thread_local BufferReleaser releaser;
+	(void)releaser;
+
+	Buffer *buffer;
+	for (buffer = atomicLoad(&g_buffers); buffer; buffer = buffer->next) {
+		if (atomicCompareExchange(&buffer->owned, (int32)0, (int32)1))
+			break;
+	}
+
+	if (!buffer) {
+		buffer = new Buffer;
+		buffer->writePos = 0;
+		buffer->readPos = 0;
+		buffer->dropped = 0;
+		buffer->owned = 1;
+
+		Buffer *head;
+		do {
+			head = atomicLoad(&g_buffers);
+			buffer->next = head;
+		} while (!atomicCompareExchange(&g_buffers, head, buffer));
+	}
+
+	t_buffer = buffer;
+	t_threadId = atomicAdd(&g_nextThreadId, 1);
+	return buffer;
+}
+
+void addEvent(EventType type, const char *name, uint64 time, int64 value) {
+	Buffer *buffer = getThreadBuffer();
+
+	const uint32 writePos = buffer->writePos;
+	if (writePos - atomicLoad(&buffer->readPos) >= kBufferSize) {
+		buffer->dropped++;
+		return;
+	}
+
+	Event &event = buffer->events[writePos & (kBufferSize - 1)];
+	event.name = name;
+	event.time = time;
+	event.value = value;
+	event.thread = t_threadId;
+	event.type = type;
+
+	atomicStore(&buffer->writePos, writePos + 1);
+}
+
+void writeEvent(const Event &event) {
+	const unsigned long long time = event.time > g_startTime ? event.time - g_startTime : 0;
+
+	String json;
+	switch (event.type) {
+	case kEventZone:
+		json = String::format("{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%lld,\"pid\":1,\"tid\":%u}",
+		                      event.name, time, (long long)event.value, event.thread);
+		break;
+	case kEventCounter:
+		json = String::format("{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+		                      event.name, time, event.thread, (long long)event.value);
+		break;
+	case kEventThreadName:
+		json = String::format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+		                      event.thread, event.name);
+		break;
+	default:
+		return;
+	}
+
+	if (!g_firstEvent)
+		g_stream->writeString(",\n");
+	g_firstEvent = false;
+	g_stream->writeString(json);
+}
+
+void writeEvents() {
+	for (Buffer *buffer = atomicLoad(&g_buffers); buffer; buffer = buffer->next) {
+		const uint32 writePos = atomicLoad(&buffer->writePos);
+		for (uint32 pos = buffer->readPos; pos != writePos; pos++)
+			writeEvent(buffer->events[pos & (kBufferSize - 1)]);
+		atomicStore(&buffer->readPos, writePos);
+	}
+}
+
+} // End of anonymous namespace
+
+bool Profiler::start() {
+	TimeDate td;
+	g_system->getTimeAndDate(td);
+	const String fileName = String::format("profile-%04d%02d%02d-%02d%02d%02d.json",
+	                                       td.tm_year + 1900, td.tm_mon + 1, td.tm_mday,
+	                                       td.tm_hour, td.tm_min, td.tm_sec);
+
+	WriteStream *stream = g_system->getSavefileManager()->openForSaving(fileName, false);
+	if (!stream) {
+		warning("Profiler: Could not create '%s'", fileName.c_str());
+		return false;
+	}
+
+	return start(stream);
+}
+
+bool Profiler::start(WriteStream *stream) {
+	if (_running)
+		stop();
+
+	g_stream = stream;
+	g_firstEvent = true;
+	g_startTime = getMicros();
+	g_frameStart = g_startTime;
+
+	// Skip what was left over from a previous run
+	for (Buffer *buffer = atomicLoad(&g_buffers); buffer; buffer = buffer->next) {
+		atomicStore(&buffer->readPos, atomicLoad(&buffer->writePos));
+		buffer->dropped = 0;
+	}
+
+	g_stream->writeString("{\"traceEvents\":[\n");
+	_running = true;
+
+	setThreadName("main");
+	return true;
+}
+
+void Profiler::stop() {
+	if (!_running)
+		return;
+
+	_running = false;
+	writeEvents();
+
+	uint32 dropped = 0;
+	for (Buffer *buffer = atomicLoad(&g_buffers); buffer; buffer = buffer->next)
+		dropped += buffer->dropped;
+	if (dropped)
+		warning("Profiler: %u events were dropped", dropped);
+
+	g_stream->writeString("\n],\"displayTimeUnit\":\"ms\"}\n");
+	g_stream->finalize();
+	delete g_stream;
+	g_stream = nullptr;
+}
+
+void Profiler::writeFrame() {
+	const uint64 now = getMicros();
+	addZone("Frame", g_frameStart, now);
+	g_frameStart = now;
+
+	writeEvents();
+}
+
+void Profiler::setThreadName(const char *name) {
+	if (_running)
+		addEvent(kEventThreadName, name, 0, 0);
+}
+
+void Profiler::addZone(const char *name, uint64 start, uint64 end) {
+	addEvent(kEventZone, name, start, end - start);
+}
+
+void Profiler::addCounter(const char *name, int64 value) {
+	addEvent(kEventCounter, name, getMicros(), value);
+}
+
+uint64 Profiler::getMicros() {
+#if defined(WIN32)
+	static LARGE_INTEGER frequency = { { 0, 0 } };
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+	       (uint64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+#else
+
+bool Profiler::start() {
+	warning("Profiler: Not supported on this platform");
+	return false;
+}
+
+bool Profiler::start(WriteStream *stream) {
+	delete stream;
+	return false;
+}
+
+void Profiler::stop() {
+}
+
+void Profiler::writeFrame() {
+}
+
+void Profiler::setThreadName(const char *name) {
+}
+
+void Profiler::addZone(const char *name, uint64 start, uint64 end) {
+}
+
+void Profiler::addCounter(const char *name, int64 value) {
+}
+
+uint64 Profiler::getMicros() {
+	return (uint64)g_system->getMillis() * 1000;
+}
+
+#endif
+
+} // End of namespace Common
@@ -0,0 +1,140 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_PROFILER_H
+#define COMMON_PROFILER_H
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+class WriteStream;
+
+/**
+ * @defgroup common_profiler Profiler
+ * @ingroup common
+ *
+ * @brief Timing instrumentation, written as a Chrome trace.
+ * @{
+ */
+
+/**
+ * Records the time spent in zones of code and the values of counters, and
+ * writes them in the Chrome trace event format, which can be viewed with
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Every thread writes its events to a ring buffer of its own, without any
+ * locking. The main thread moves them to the file at the end of each frame,
+ * which the backends mark in updateScreen(). Events which do not fit in the
+ * buffer until then are dropped.
+ *
+ * While the profiler is not running, a zone only costs the test of a flag.
+ * The names of zones and counters are not copied, they must be string
+ * literals.
+ */
+class Profiler {
+public:
+	/** Return whether events are being recorded. */
+	static bool isRunning() { return _running; }
+
+	/**
+	 * Start recording to a new file in the save path, named after the
+	 * current date and time.
+	 *
+	 * @return false if the profiler is not supported on this platform, or
+	 *         the file could not be created.
+	 */
+	static bool start();
+
+	/**
+	 * Start recording to the given stream, which is deleted by stop().
+	 */
+	static bool start(WriteStream *stream);
+
+	/** Stop recording, and finish the file. */
+	static void stop();
+
+	/**
+	 * Mark the end of a frame, and write the events recorded since the
+	 * previous one. This must be called on the main thread.
+	 */
+	static void endFrame() {
+		if (_running)
+			writeFrame();
+	}
+
+	/** Name the calling thread in the trace. */
+	static void setThreadName(const char *name);
+
+	/** Record a zone of the calling thread, see ProfilerZone. */
+	static void addZone(const char *name, uint64 start, uint64 end);
+
+	/** Record the value of a counter, see PROFILE_COUNTER. */
+	static void addCounter(const char *name, int64 value);
+
+	/** Return the time in microseconds, from an arbitrary start. */
+	static uint64 getMicros();
+
+private:
+	static volatile bool _running;
+
+	static void writeFrame();
+};
+
+/**
+ * Records the time from its construction to its destruction as a zone of
+ * the calling thread.
+ */
+class ProfilerZone {
+public:
+	explicit ProfilerZone(const char *name) :
+		_name(name), _running(Profiler::isRunning()), _start(_running ? Profiler::getMicros() : 0) {}
+
+	~ProfilerZone() {
+		if (_running)
+			Profiler::addZone(_name, _start, Profiler::getMicros());
+	}
+
+private:
+	const char *_name;
+	bool _running;
+	uint64 _start;
+};
+
+// The variable is named after the line, so that a scope may hold several zones
+#define PROFILE_ZONE_VARIABLE2(line) profilerZone##line
+#define PROFILE_ZONE_VARIABLE(line) PROFILE_ZONE_VARIABLE2(line)
+
+/** Record the rest of the current scope as a zone named @p name. */
+#define PROFILE_ZONE(name) Common::ProfilerZone PROFILE_ZONE_VARIABLE(__LINE__)(name)
+
+/** Record @p value as the current value of the counter named @p name. */
+#define PROFILE_COUNTER(name, value) \
+	do { \
+		if (Common::Profiler::isRunning()) \
+			Common::Profiler::addCounter(name, value); \
+	} while (0)
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -995,6 +995,19 @@ public:
 	inline reference operator[](const index_type index) { return _span[index]; }
 };
 
+/**
+ * Return the whole data of a stream which holds it in memory, such as a
+ * memory stream or a memory mapped file, so that it can be used in place.
+ * Returns an empty span for other streams, which have to be read.
+ */
+inline Span<const byte> getMappedSpan(SeekableReadStream &stream) {
+	const MemoryReadStream *memoryStream = dynamic_cast<const MemoryReadStream *>(&stream);
+	if (!memoryStream)
+		return Span<const byte>();
+
+	return Span<const byte>(memoryStream->getData(), memoryStream->size());
+}
+
 } // End of namespace Common
 
 #endif
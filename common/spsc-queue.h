@@ -0,0 +1,119 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_SPSC_QUEUE_H
+#define COMMON_SPSC_QUEUE_H
+
+#include "common/scummsys.h"
+#include "common/atomic.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_spsc_queue SPSC queue
+ * @ingroup common
+ *
+ * @brief Fixed size lock-free single-producer/single-consumer queue.
+ * @{
+ */
+
+/**
+ * Fixed size ring buffer which one thread may push to while another thread
+ * pops from it, without either of them ever blocking.
+ *
+ * push() must only ever be called from one thread at a time, and the same
+ * goes for pop(). Callers with several producers (or consumers) need to
+ * serialize them themselves.
+ *
+ * @tparam T        Element type. Elements are copied in and out, so this
+ *                  should be a small POD type such as a pointer or a
+ *                  command struct.
+ * @tparam CAPACITY Maximum number of queued elements, must be a power of two.
+ */
+template<class T, uint CAPACITY>
+class SPSCQueue : NonCopyable {
+	STATIC_ASSERT(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, SPSCQueue_capacity_must_be_a_power_of_two);
+
+public:
+	SPSCQueue() : _head(0), _tail(0) {}
+
+	/**
+	 * Append an element. Must only be called from the producer thread.
+	 *
+	 * @return false if the queue is full, in which case nothing is added.
+	 */
+	bool push(const T &val) {
+		const uint32 tail = atomicLoadRelaxed(&_tail);
+		if (tail - atomicLoad(&_head) == CAPACITY)
+			return false;
+
+		_items[tail & (CAPACITY - 1)] = val;
+		atomicStore(&_tail, tail + 1);
+		return true;
+	}
+
+	/**
+	 * Remove the oldest element. Must only be called from the consumer thread.
+	 *
+	 * @return false if the queue is empty, in which case @p val is untouched.
+	 */
+	bool pop(T &val) {
+		const uint32 head = atomicLoadRelaxed(&_head);
+		if (head == atomicLoad(&_tail))
+			return false;
+
+		val = _items[head & (CAPACITY - 1)];
+		atomicStore(&_head, head + 1);
+		return true;
+	}
+
+	/**
+	 * Return the number of queued elements. When called from a thread which
+	 * is neither the producer nor the consumer, this is only a snapshot.
+	 */
+	uint size() const {
+		return atomicLoad(&_tail) - atomicLoad(&_head);
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	bool full() const {
+		return size() == CAPACITY;
+	}
+
+	static uint capacity() {
+		return CAPACITY;
+	}
+
+private:
+	T _items[CAPACITY];
+	volatile uint32 _head; ///< Index of the next element to pop, only written by the consumer.
+	volatile uint32 _tail; ///< Index of the next free slot, only written by the producer.
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
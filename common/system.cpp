@@ -28,6 +28,7 @@
 #include "common/savefile.h"
 #include "common/str.h"
 #include "common/taskbar.h"
+#include "common/taskpool.h"
 #include "common/updates.h"
 #include "common/dialogs.h"
 #include "common/rotationmode.h"
@@ -60,9 +61,13 @@ OSystem::OSystem() {
 	_fsFactory = nullptr;
 	_dlcStore = nullptr;
 	_backendInitialized = false;
+	_taskPool = nullptr;
 }
 
 OSystem::~OSystem() {
+	delete _taskPool;
+	_taskPool = nullptr;
+
 	delete _audiocdManager;
 	_audiocdManager = nullptr;
 
@@ -121,12 +126,24 @@ void OSystem::initBackend() {
 }
 
 void OSystem::destroy() {
+	// The worker threads are stopped before the backend shuts down
+	delete _taskPool;
+	_taskPool = nullptr;
+
 	_backendInitialized = false;
-	Common::String::releaseMemoryPoolMutex();
 	Common::releaseCJKTables();
 	delete this;
 }
 
+Common::TaskPool *OSystem::getTaskPool() {
+	if (!_taskPool) {
+		// The calling thread takes part in the work as well
+		_taskPool = new Common::TaskPool(MAX<uint>(getCPUCount(), 1) - 1);
+	}
+
+	return _taskPool;
+}
+
 void OSystem::updateStartSettings(const Common::String &executable, Common::String &command, Common::StringMap &settings, Common::StringArray& additionalArgs) {
 	// If a command was explicitly passed on the command line, do not override it
 	if (!command.empty())
@@ -55,6 +55,9 @@ class Store;
 namespace Common {
 class EventManager;
 class MutexInternal;
+class SemaphoreInternal;
+class TaskPool;
+class ThreadInternal;
 struct Rect;
 class SaveFileManager;
 class SearchSet;
@@ -79,6 +82,9 @@ class KeymapperDefaultBindings;
 enum RotationMode : int;
 
 typedef Array<Keymap *> KeymapArray;
+
+/** Function run by a thread, see OSystem::createThread(). */
+typedef void (*ThreadProc)(void *data);
 }
 
 /**
@@ -286,6 +292,11 @@ private:
 	 */
 	bool _backendInitialized;
 
+	/**
+	 * Created on first use by getTaskPool(), and deleted by destroy().
+	 */
+	Common::TaskPool *_taskPool;
+
 	//@}
 
 public:
@@ -1625,6 +1636,10 @@ public:
 	 *
 	 * Hence, backends that do not use threads to implement the timers can simply
 	 * use dummy implementations for these methods.
+	 *
+	 * Backends with thread support may additionally implement createThread(),
+	 * which common code uses to spread work over several cores. Such code
+	 * always has a fallback running on the calling thread, so this is optional.
 	 */
 
 	/**
@@ -1634,6 +1649,43 @@ public:
 	 */
 	virtual Common::MutexInternal *createMutex() = 0;
 
+	/**
+	 * Start a new thread running the given function.
+	 *
+	 * Backends which implement this must also provide real mutexes with
+	 * createMutex(). The thread must not call any other OSystem method
+	 * than createMutex() and getFilesystemFactory().
+	 *
+	 * @return The new thread, which must be joined before it is deleted,
+	 *         or nullptr if threads are not supported.
+	 */
+	virtual Common::ThreadInternal *createThread(Common::ThreadProc proc, void *data) { return nullptr; }
+
+	/**
+	 * Create a new semaphore, with a count of zero.
+	 *
+	 * Backends which implement createThread() must implement this as well.
+	 * Unlike the other methods, the semaphore may be used on any thread.
+	 *
+	 * @return The new semaphore, or nullptr if threads are not supported.
+	 */
+	virtual Common::SemaphoreInternal *createSemaphore() { return nullptr; }
+
+	/**
+	 * Return the number of logical processors, as a hint of how many threads
+	 * common code may use.
+	 */
+	virtual uint getCPUCount() { return 1; }
+
+	/**
+	 * Return the task pool shared by the engines and common code, which
+	 * runs tasks on worker threads. On backends without threads, the pool
+	 * runs them on the calling thread.
+	 *
+	 * For more information, see @ref Common::TaskPool.
+	 */
+	Common::TaskPool *getTaskPool();
+
 	/** @} */
 
 
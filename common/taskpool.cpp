@@ -0,0 +1,271 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/taskpool.h"
+#include "common/system.h"
+#include "common/thread.h"
+#include "common/util.h"
+
+namespace Common {
+
+TaskPool::Future::Future() :
+	_pool(nullptr), _proc(nullptr), _data(nullptr), _state(kFutureIdle), _next(nullptr) {
+}
+
+TaskPool::Future::~Future() {
+	wait();
+}
+
+bool TaskPool::Future::isDone() const {
+	if (!_pool)
+		return _state != kFutureQueued && _state != kFutureRunning;
+
+	StackLock lock(_pool->_mutex);
+	return _state != kFutureQueued && _state != kFutureRunning;
+}
+
+void TaskPool::Future::wait() {
+	if (_pool)
+		_pool->wait(*this);
+}
+
+TaskPool::TaskPool(uint numWorkers) :
+	_workSemaphore(nullptr), _doneSemaphore(nullptr),
+	_queueFirst(nullptr), _queueLast(nullptr), _queueSize(0),
+	_waiting(0), _stopping(false) {
+
+	numWorkers = MIN<uint>(numWorkers, kMaxWorkers);
+	if (!numWorkers)
+		return;
+
+	_workSemaphore = g_system->createSemaphore();
+	_doneSemaphore = g_system->createSemaphore();
+	if (!_workSemaphore || !_doneSemaphore)
+		return;
+
+	for (uint i = 0; i < numWorkers; i++) {
+		ThreadInternal *thread = g_system->createThread(workerProc, this);
+		if (!thread)
+			break;
+		_workers.push_back(thread);
+	}
+}
+
+TaskPool::~TaskPool() {
+	{
+		StackLock lock(_mutex);
+		_stopping = true;
+	}
+
+	// The workers run what is left in the queue before they exit
+	for (uint i = 0; i < _workers.size(); i++)
+		_workSemaphore->signal();
+
+	for (uint i = 0; i < _workers.size(); i++) {
+		_workers[i]->join();
+		delete _workers[i];
+	}
+
+	delete _workSemaphore;
+	delete _doneSemaphore;
+}
+
+void TaskPool::submit(Future &future, TaskProc proc, void *data) {
+	future.wait();
+
+	future._pool = this;
+	future._proc = proc;
+	future._data = data;
+	future._next = nullptr;
+
+	if (_workers.empty()) {
+		future._state = kFutureRunning;
+		run(future);
+		return;
+	}
+
+	bool queued;
+	{
+		StackLock lock(_mutex);
+		queued = (_queueSize < kMaxQueuedTasks);
+		if (queued) {
+			future._state = kFutureQueued;
+			if (_queueLast)
+				_queueLast->_next = &future;
+			else
+				_queueFirst = &future;
+			_queueLast = &future;
+			_queueSize++;
+		} else {
+			future._state = kFutureRunning;
+		}
+	}
+
+	if (queued)
+		_workSemaphore->signal();
+	else
+		run(future);
+}
+
+void TaskPool::run(Future &future) {
+	future._proc(future._data);
+
+	if (_workers.empty()) {
+		future._state = kFutureDone;
+		return;
+	}
+
+	StackLock lock(_mutex);
+	finish(future);
+}
+
+void TaskPool::finish(Future &future) {
+	// The mutex must be held
+	future._state = kFutureDone;
+
+	for (; _waiting; _waiting--)
+		_doneSemaphore->signal();
+}
+
+void TaskPool::wait(Future &future) {
+	if (_workers.empty())
+		return;
+
+	_mutex.lock();
+	for (;;) {
+		if (future._state == kFutureIdle || future._state == kFutureDone)
+			break;
+
+		if (future._state == kFutureQueued) {
+			// Take it out of the queue, it is faster to run it here than to
+			// wait for the tasks before it
+			Future *prev = nullptr;
+			for (Future *it = _queueFirst; it != &future; it = it->_next)
+				prev = it;
+
+			if (prev)
+				prev->_next = future._next;
+			else
+				_queueFirst = future._next;
+			if (_queueLast == &future)
+				_queueLast = prev;
+			_queueSize--;
+
+			future._state = kFutureRunning;
+			_mutex.unlock();
+			future._proc(future._data);
+			_mutex.lock();
+			finish(future);
+			break;
+		}
+
+		// A worker is running it
+		_waiting++;
+		_mutex.unlock();
+		_doneSemaphore->wait();
+		_mutex.lock();
+	}
+	_mutex.unlock();
+}
+
+void TaskPool::workerProc(void *data) {
+	TaskPool *pool = (TaskPool *)data;
+
+	for (;;) {
+		pool->_workSemaphore->wait();
+
+		Future *future;
+		{
+			StackLock lock(pool->_mutex);
+			future = pool->_queueFirst;
+			if (!future) {
+				if (pool->_stopping)
+					return;
+
+				// The task was run by a thread waiting for it
+				continue;
+			}
+
+			pool->_queueFirst = future->_next;
+			if (!pool->_queueFirst)
+				pool->_queueLast = nullptr;
+			pool->_queueSize--;
+			future->_state = kFutureRunning;
+		}
+
+		pool->run(*future);
+	}
+}
+
+void TaskPool::parallelFor(uint begin, uint end, uint grain, RangeProc proc, void *data) {
+	if (begin >= end)
+		return;
+
+	const uint count = end - begin;
+	grain = MAX<uint>(grain, 1);
+	uint numChunks = (count + grain - 1) / grain;
+	if (_workers.empty() || numChunks == 1) {
+		proc(begin, end, data);
+		return;
+	}
+
+	// A few chunks per thread even out chunks which take longer than others
+	numChunks = MIN<uint>(numChunks, (_workers.size() + 1) * 4);
+
+	RangeJob job;
+	job.pool = this;
+	job.proc = proc;
+	job.data = data;
+	job.begin = begin;
+	job.count = count;
+	job.numChunks = numChunks;
+	job.nextChunk = 0;
+
+	Future futures[kMaxWorkers];
+	const uint numHelpers = MIN<uint>(numChunks - 1, _workers.size());
+	for (uint i = 0; i < numHelpers; i++)
+		submit(futures[i], rangeJobProc, &job);
+
+	rangeJobProc(&job);
+
+	for (uint i = 0; i < numHelpers; i++)
+		wait(futures[i]);
+}
+
+void TaskPool::rangeJobProc(void *data) {
+	RangeJob *job = (RangeJob *)data;
+
+	for (;;) {
+		uint chunk;
+		{
+			StackLock lock(job->pool->_mutex);
+			if (job->nextChunk == job->numChunks)
+				return;
+			chunk = job->nextChunk++;
+		}
+
+		const uint chunkBegin = job->begin + (uint)((uint64)job->count * chunk / job->numChunks);
+		const uint chunkEnd = job->begin + (uint)((uint64)job->count * (chunk + 1) / job->numChunks);
+		job->proc(chunkBegin, chunkEnd, job->data);
+	}
+}
+
+} // End of namespace Common
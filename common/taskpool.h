@@ -0,0 +1,181 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_TASKPOOL_H
+#define COMMON_TASKPOOL_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+class SemaphoreInternal;
+class ThreadInternal;
+
+/**
+ * @defgroup common_taskpool Task pool
+ * @ingroup common
+ *
+ * @brief API for running tasks on worker threads.
+ * @{
+ */
+
+/**
+ * A fixed set of worker threads, which run the tasks submitted to them in
+ * the order of submission. The shared pool is returned by
+ * OSystem::getTaskPool().
+ *
+ * If the backend does not support threads, or the pool has no workers, the
+ * tasks are run on the calling thread, before submit() returns. Code using
+ * the pool must therefore not rely on tasks running concurrently with it.
+ *
+ * Tasks must follow the rules of OSystem::createThread(): they must not
+ * call any OSystem method other than createMutex() and
+ * getFilesystemFactory(). They may submit tasks of their own to the pool.
+ */
+class TaskPool : NonCopyable {
+public:
+	typedef void (*TaskProc)(void *data);
+	typedef void (*RangeProc)(uint begin, uint end, void *data);
+
+	enum {
+		/** The number of tasks which may wait for a worker. */
+		kMaxQueuedTasks = 256,
+		kMaxWorkers = 32
+	};
+
+	/**
+	 * The state of a submitted task, which the caller waits for to get its
+	 * result.
+	 *
+	 * The future is owned by the caller, so submitting a task does not
+	 * allocate any memory. It must stay alive until the task is done, which
+	 * its destructor waits for.
+	 */
+	class Future : NonCopyable {
+	public:
+		Future();
+		~Future();
+
+		/** Return whether the task has run. */
+		bool isDone() const;
+
+		/**
+		 * Wait until the task has run. A task which has not been started
+		 * yet is run on the calling thread.
+		 */
+		void wait();
+
+	private:
+		friend class TaskPool;
+
+		TaskPool *_pool;
+		TaskProc _proc;
+		void *_data;
+		int _state;
+		Future *_next;
+	};
+
+	/**
+	 * Create a pool.
+	 *
+	 * @param numWorkers The number of worker threads to start, which is
+	 *                   lowered if the backend cannot start them.
+	 */
+	explicit TaskPool(uint numWorkers);
+	~TaskPool();
+
+	/** Return the number of worker threads, not counting the caller. */
+	uint getWorkerCount() const { return _workers.size(); }
+
+	/**
+	 * Run proc(data) on a worker thread.
+	 *
+	 * If kMaxQueuedTasks are already waiting, the task is run on the
+	 * calling thread instead, which keeps producers from running ahead.
+	 */
+	void submit(Future &future, TaskProc proc, void *data);
+
+	/**
+	 * Split the range [begin, end) into chunks of at least @p grain
+	 * elements, and call proc(chunkBegin, chunkEnd, data) on each of them.
+	 * The calling thread works on the chunks as well, and this returns once
+	 * all of them are done.
+	 */
+	void parallelFor(uint begin, uint end, uint grain, RangeProc proc, void *data);
+
+	/**
+	 * Same as above, calling func(chunkBegin, chunkEnd) on each chunk,
+	 * where @p func is a function object such as a lambda.
+	 */
+	template<class Func>
+	void parallelFor(uint begin, uint end, uint grain, const Func &func) {
+		parallelFor(begin, end, grain, &callRange<Func>, const_cast<Func *>(&func));
+	}
+
+private:
+	enum FutureState {
+		kFutureIdle,
+		kFutureQueued,
+		kFutureRunning,
+		kFutureDone
+	};
+
+	struct RangeJob {
+		TaskPool *pool;
+		RangeProc proc;
+		void *data;
+		uint begin;
+		uint count;
+		uint numChunks;
+		uint nextChunk;
+	};
+
+	template<class Func>
+	static void callRange(uint begin, uint end, void *data) {
+		(*(const Func *)data)(begin, end);
+	}
+
+	static void workerProc(void *data);
+	static void rangeJobProc(void *data);
+
+	void run(Future &future);
+	void wait(Future &future);
+	void finish(Future &future);
+
+	Mutex _mutex;
+	Array<ThreadInternal *> _workers;
+	SemaphoreInternal *_workSemaphore; ///< Signalled once per queued task
+	SemaphoreInternal *_doneSemaphore; ///< Signalled for each waiting thread
+	Future *_queueFirst;
+	Future *_queueLast;
+	uint _queueSize;
+	uint _waiting;
+	bool _stopping;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -0,0 +1,73 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_THREAD_H
+#define COMMON_THREAD_H
+
+#include "common/scummsys.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_thread Threads
+ * @ingroup common
+ *
+ * @brief API for running work on worker threads.
+ *
+ * Threads are optional: common code only uses them to spread work which
+ * can also be done on the calling thread, and must keep working when
+ * OSystem::createThread() returns nullptr.
+ * @{
+ */
+
+class ThreadInternal {
+public:
+	virtual ~ThreadInternal() {}
+
+	/**
+	 * Wait until the thread function returned.
+	 *
+	 * This must be called exactly once before deleting the thread.
+	 */
+	virtual void join() = 0;
+};
+
+/**
+ * A counting semaphore, which lets worker threads sleep until there is
+ * something to do. See OSystem::createSemaphore().
+ */
+class SemaphoreInternal {
+public:
+	virtual ~SemaphoreInternal() {}
+
+	/** Increment the count, and wake up one waiting thread, if any. */
+	virtual void signal() = 0;
+
+	/** Wait until the count is not zero, and decrement it. */
+	virtual void wait() = 0;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
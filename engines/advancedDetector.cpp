@@ -407,6 +407,7 @@ Common::Error AdvancedMetaEngineDetectionBase::identifyGame(DetectedGame &game,
 
 	// Detection is done, no need to keep archives in memory anymore
 	ADCacheMan.clearArchives();
+	ADCacheMan.savePersistentCache();
 
 	if (!agdDesc.desc)
 		return Common::kNoGameDataFoundError;
@@ -462,13 +463,6 @@ void AdvancedMetaEngineDetectionBase::composeFileHashMap(FileMap &allFiles, cons
 	}
 }
 
-/* Singleton Cache Storage for MD5 */
-
-namespace Common {
-	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
-}
-
-
 static MD5Properties gameFileToMD5Props(const ADGameFileDescription *fileEntry, uint32 gameFlags) {
 	MD5Properties ret = kMD5Head;
 	if (fileEntry && fileEntry->md5 && strchr(fileEntry->md5, ':')) {
@@ -528,6 +522,78 @@ Common::String md5PropToGameFile(MD5Properties flags) {
 
 static bool getFilePropertiesIntern(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps);
 
+/**
+ * Build the key under which the properties of a file are stored in the
+ * persistent and prefetch caches. Unlike the keys of the MD5 cache, it
+ * contains the absolute path of the file.
+ *
+ * If requested, also build the signature of the files on disk the
+ * properties are computed from. It lists the size and the modification time
+ * of each candidate file, so that any change invalidates the entry. It is
+ * left empty if the file system does not provide that information.
+ *
+ * @return False if none of the files exist.
+ */
+static bool getFileCacheKey(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, Common::String &key, Common::String *signature) {
+	Common::Array<Common::Path> sources;
+	Common::String member;
+
+	if (md5prop & kMD5Archive) {
+		Common::StringTokenizer tok(fname.toString(), ":");
+		Common::String archiveType = tok.nextToken();
+		sources.push_back(Common::Path(tok.nextToken()));
+		member = archiveType + ':' + tok.nextToken();
+	} else if (md5prop & (kMD5MacResFork | kMD5MacDataFork)) {
+		// The forks may be stored in any of these files, see MacResManager
+		const Common::Path appleDouble = fname.getParent().appendComponent("._" + fname.baseName());
+		sources.push_back(fname);
+		sources.push_back(fname.append(".rsrc"));
+		sources.push_back(fname.append(".bin"));
+		sources.push_back(appleDouble);
+		sources.push_back(Common::Path("__MACOSX").join(appleDouble));
+	} else {
+		sources.push_back(fname);
+	}
+
+	Common::String path, stats;
+	bool haveStats = true;
+	for (const auto &source : sources) {
+		if (!stats.empty())
+			stats += ',';
+
+		if (!allFiles.contains(source)) {
+			stats += '-';
+			continue;
+		}
+
+		const Common::FSNode &node = allFiles[source];
+		if (path.empty())
+			path = node.getPath().toString(Common::Path::kNativeSeparator);
+
+		if (!signature || !haveStats)
+			continue;
+
+		int64 size, modificationTime;
+		if (node.getFileStats(size, modificationTime))
+			stats += Common::String::format("%lld:%lld", (long long)size, (long long)modificationTime);
+		else
+			haveStats = false;
+	}
+
+	// None of the files exist
+	if (path.empty())
+		return false;
+
+	if (signature)
+		*signature = haveStats ? stats : Common::String();
+
+	key = Common::String::format("%s:%u:", md5PropToCachePrefix(md5prop).c_str(), md5Bytes) + path;
+	if (!member.empty())
+		key += ':' + member;
+
+	return true;
+}
+
 bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
 	Common::String hashname = md5PropToCachePrefix(md5prop);
 		hashname += ':';
@@ -541,16 +607,78 @@ bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles,
 		return true;
 	}
 
-	bool res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
+	// Then check the persistent cache, which remembers files between runs
+	Common::String cacheKey, signature;
+	bool persistent = ADCacheMan.isPersistentCacheEnabled();
+	const bool haveKey = getFileCacheKey(_md5Bytes, allFiles, md5prop, fname, cacheKey, persistent ? &signature : nullptr);
+	persistent = haveKey && !signature.empty();
+
+	if (persistent && ADCacheMan.getPersistentProperties(cacheKey, signature, fileProps)) {
+		ADCacheMan.setMD5(hashname, fileProps.md5);
+		ADCacheMan.setSize(hashname, fileProps.size);
+		return true;
+	}
+
+	// The properties may have been computed by a worker thread ahead of time
+	bool res = haveKey && ADCacheMan.getPrefetchedProperties(cacheKey, fileProps);
+	if (!res)
+		res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
 
 	if (res) {
 		ADCacheMan.setMD5(hashname, fileProps.md5);
 		ADCacheMan.setSize(hashname, fileProps.size);
+
+		if (persistent)
+			ADCacheMan.setPersistentProperties(cacheKey, signature, fileProps);
 	}
 
 	return res;
 }
 
+void AdvancedMetaEngineDetectionBase::prefetchFileProperties(const Common::FSList &fslist) const {
+	if (fslist.empty())
+		return;
+
+	FileMap allFiles;
+	composeFileHashMap(allFiles, fslist, (_maxScanDepth == 0 ? 1 : _maxScanDepth));
+
+	const bool persistent = ADCacheMan.isPersistentCacheEnabled();
+	Common::HashMap<Common::String, bool> checked;
+
+	// Compute the same properties as detectGame() does, and put them in the
+	// prefetch cache unless they can be found in the persistent cache
+	for (const byte *descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			MD5Properties md5prop = gameFileToMD5Props(fileDesc, g->flags);
+
+			// Files in archives are read through the archives kept by the
+			// cache manager, which may only be used on the main thread
+			if (md5prop & kMD5Archive)
+				continue;
+
+			Common::Path fname(fileDesc->fileName);
+			Common::String key, signature;
+			if (!getFileCacheKey(_md5Bytes, allFiles, md5prop, fname, key, persistent ? &signature : nullptr))
+				continue;
+
+			if (checked.contains(key))
+				continue;
+			checked.setVal(key, true);
+
+			if (ADCacheMan.hasPrefetchedProperties(key))
+				continue;
+			if (!signature.empty() && ADCacheMan.hasPersistentProperties(key, signature))
+				continue;
+
+			FileProperties fileProps;
+			if (getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps))
+				ADCacheMan.setPrefetchedProperties(key, fileProps);
+		}
+	}
+}
+
 bool AdvancedMetaEngineBase::getFilePropertiesExtern(uint md5Bytes, const FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, FileProperties &fileProps) const {
 	return getFilePropertiesIntern(md5Bytes, allFiles, md5prop, fname, fileProps);
 }
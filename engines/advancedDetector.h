@@ -26,6 +26,7 @@
 #include "engines/engine.h"
 
 #include "common/hash-str.h"
+#include "common/mutex.h"
 
 #include "common/gui_options.h" // Keep it here, so detection tables can refer to them
 
@@ -514,6 +515,10 @@ public:
 	 */
 	DetectedGames detectGames(const Common::FSList &fslist, uint32 skipADFlags, bool skipIncomplete) override;
 
+	void preparePrefetch() override final { preprocessDescriptions(); }
+
+	void prefetchFileProperties(const Common::FSList &fslist) const override final;
+
 	uint getMD5Bytes() const override final { return _md5Bytes; }
 
 	int getGameVariantCount() const override final {
@@ -732,6 +737,9 @@ private:
 
 /**
  * Singleton Cache Storage for Computed MD5s and Open Archives
+ *
+ * Only the persistent and prefetch caches may be used from worker threads,
+ * everything else is reserved to the main thread.
  */
 class AdvancedDetectorCacheManager : public Common::Singleton<AdvancedDetectorCacheManager> {
 public:
@@ -772,7 +780,91 @@ public:
 		return archiveHashMap.getValOrDefault(node.getPath(), nullptr);
 	}
 
-	AdvancedDetectorCacheManager() {
+	/**
+	 * Look up the properties of a file in the persistent cache.
+	 *
+	 * Unlike the MD5 cache above, the persistent cache is stored beside
+	 * the configuration file and is kept between detections and between
+	 * runs. An entry is only returned when the signature, which describes
+	 * the size and the modification time of the files it was computed from,
+	 * did not change in the meantime.
+	 *
+	 * @param key        Identifies the file, the MD5 mode and the number of hashed bytes.
+	 * @param signature  Current signature of the file.
+	 * @param fileProps  Receives the cached properties.
+	 *
+	 * @return True on a cache hit.
+	 */
+	bool getPersistentProperties(const Common::String &key, const Common::String &signature, FileProperties &fileProps);
+
+	/**
+	 * Store the properties of a file in the persistent cache.
+	 *
+	 * The cache is only written to disk by savePersistentCache().
+	 */
+	void setPersistentProperties(const Common::String &key, const Common::String &signature, const FileProperties &fileProps);
+
+	/**
+	 * Check whether the persistent cache holds up-to-date properties for
+	 * a file, without counting it as a cache lookup.
+	 */
+	bool hasPersistentProperties(const Common::String &key, const Common::String &signature);
+
+	/**
+	 * Whether the persistent cache is enabled with the "detection_cache"
+	 * configuration key.
+	 */
+	bool isPersistentCacheEnabled() const;
+
+	/**
+	 * Write the persistent cache to disk if entries were added, invalidated
+	 * or expired. Entries which were not used for a long time are dropped
+	 * at this point.
+	 *
+	 * This does nothing while a scan is running, see beginScan().
+	 */
+	void savePersistentCache();
+
+	/**
+	 * Use another file for the persistent cache, e.g. for testing. The
+	 * cache is reloaded from that file when it is next used. An empty path
+	 * selects the default file, beside the configuration file.
+	 */
+	void setPersistentCacheFile(const Common::Path &path);
+
+	/**
+	 * Start a scan of several directories, during which worker threads may
+	 * prefetch file properties. Must be called on the main thread, before
+	 * starting the workers.
+	 */
+	void beginScan();
+
+	/**
+	 * End a scan. The prefetched properties are dropped and the persistent
+	 * cache is saved. Must be called on the main thread, after stopping the
+	 * workers.
+	 */
+	void endScan();
+
+	/**
+	 * Look up properties computed ahead of time by a worker thread. The key
+	 * is the same as for the persistent cache.
+	 */
+	bool getPrefetchedProperties(const Common::String &key, FileProperties &fileProps);
+
+	/** Check whether a worker thread already computed the properties of a file. */
+	bool hasPrefetchedProperties(const Common::String &key);
+
+	/** Store properties computed ahead of time. */
+	void setPrefetchedProperties(const Common::String &key, const FileProperties &fileProps);
+
+	/**
+	 * Print statistics about the persistent cache to the standard output.
+	 */
+	void printPersistentCacheStats();
+
+	AdvancedDetectorCacheManager() : _persistentLoaded(false), _persistentDirty(false), _persistentEnabled(true), _today(0),
+		_sessionHits(0), _sessionMisses(0), _lastHits(0), _lastMisses(0), _totalHits(0), _totalMisses(0), _scanDepth(0) {
 		clear();
 	}
 
@@ -798,6 +890,36 @@ private:
 	FileHashMap md5HashMap;
 	SizeHashMap sizeHashMap;
 	ArchiveHashMap archiveHashMap;
+
+	struct PersistentEntry {
+		Common::String signature;
+		Common::String md5;
+		int64 size;
+		MD5Properties md5prop;
+		uint32 lastUsed; ///< Day on which the entry was last used
+	};
+
+	typedef Common::HashMap<Common::String, PersistentEntry> PersistentHashMap;
+	PersistentHashMap _persistentHashMap;
+	bool _persistentLoaded;
+	bool _persistentDirty;
+	bool _persistentEnabled; ///< Cached value of isPersistentCacheEnabled() while scanning
+	Common::Path _persistentPath; ///< Set by setPersistentCacheFile()
+	uint32 _today;
+
+	uint32 _sessionHits, _sessionMisses; ///< Lookups since the cache was loaded
+	uint32 _lastHits, _lastMisses;       ///< Lookups during the last run which saved the cache
+	uint32 _totalHits, _totalMisses;     ///< Lookups over the lifetime of the cache, excluding this session
+
+	typedef Common::HashMap<Common::String, FileProperties> PrefetchHashMap;
+	PrefetchHashMap _prefetchHashMap;
+	int _scanDepth;
+
+	/** Protects the persistent and the prefetch caches */
+	Common::Mutex _mutex;
+
+	Common::FSNode getPersistentCacheFile() const;
+	void loadPersistentCache();
 };
 
 /** Convenience shortcut for accessing the MD5CacheManager. */
@@ -0,0 +1,320 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_printf
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/stream.h"
+#include "common/system.h"
+#include "common/tokenizer.h"
+#include "engines/advancedDetector.h"
+
+/* Singleton Cache Storage for MD5 */
+
+namespace Common {
+	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
+}
+
+/* Persistent cache of file properties */
+
+#define DETECTION_CACHE_FILENAME "detection.cache"
+#define DETECTION_CACHE_VERSION 1
+
+// Entries which were not used for that many days are dropped
+#define DETECTION_CACHE_MAX_AGE 90
+
+static uint32 getCurrentDay() {
+	TimeDate td;
+	g_system->getTimeAndDate(td, true);
+
+	// Count the days since 1 March of year 0 in the proleptic Gregorian
+	// calendar. Starting the year in March puts the leap day at its end.
+	int year = td.tm_year + 1900;
+	int month = td.tm_mon + 1;
+	if (month <= 2) {
+		year--;
+		month += 12;
+	}
+
+	return 365 * year + year / 4 - year / 100 + year / 400 + (153 * (month - 3) + 2) / 5 + td.tm_mday - 1;
+}
+
+bool AdvancedDetectorCacheManager::isPersistentCacheEnabled() const {
+	// Worker threads must not access the configuration
+	if (_scanDepth > 0)
+		return _persistentEnabled;
+
+	return !ConfMan.hasKey("detection_cache") || ConfMan.getBool("detection_cache");
+}
+
+Common::FSNode AdvancedDetectorCacheManager::getPersistentCacheFile() const {
+	if (!_persistentPath.empty())
+		return Common::FSNode(_persistentPath);
+
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+
+	return Common::FSNode(configFile.getParent().appendComponent(DETECTION_CACHE_FILENAME));
+}
+
+void AdvancedDetectorCacheManager::loadPersistentCache() {
+	if (_persistentLoaded)
+		return;
+
+	_persistentLoaded = true;
+	_today = getCurrentDay();
+
+	Common::FSNode file = getPersistentCacheFile();
+	if (!file.exists())
+		return;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(file.createReadStream());
+	if (!stream)
+		return;
+
+	// The first lines hold the version and the statistics, followed by one
+	// line per entry. The key is last since it may contain any character.
+	int version = 0;
+	if (sscanf(stream->readLine().c_str(), "version %d", &version) != 1 || version != DETECTION_CACHE_VERSION) {
+		debugC(2, kDebugGlobalDetection, "Discarding detection cache with unsupported version %d", version);
+		_persistentDirty = true;
+		return;
+	}
+
+	if (sscanf(stream->readLine().c_str(), "stats %u %u %u %u", &_lastHits, &_lastMisses, &_totalHits, &_totalMisses) != 4) {
+		_lastHits = _lastMisses = _totalHits = _totalMisses = 0;
+	}
+
+	while (!stream->eos() && !stream->err()) {
+		Common::String line = stream->readLine();
+		if (line.empty())
+			continue;
+
+		Common::StringTokenizer tok(line, "\t");
+		PersistentEntry entry;
+		uint32 lastUsed = strtoul(tok.nextToken().c_str(), nullptr, 10);
+		entry.size = strtoll(tok.nextToken().c_str(), nullptr, 10);
+		entry.md5prop = (MD5Properties)strtol(tok.nextToken().c_str(), nullptr, 10);
+		entry.md5 = tok.nextToken();
+		entry.signature = tok.nextToken();
+		Common::String key = tok.nextToken();
+		entry.lastUsed = lastUsed;
+
+		if (key.empty() || entry.md5.empty() || entry.signature.empty()) {
+			_persistentDirty = true;
+			continue;
+		}
+
+		// Expired entries are dropped the next time the cache is saved
+		if (entry.lastUsed + DETECTION_CACHE_MAX_AGE < _today)
+			_persistentDirty = true;
+
+		_persistentHashMap.setVal(key, entry);
+	}
+
+	debugC(2, kDebugGlobalDetection, "Loaded %u entries from detection cache '%s'", _persistentHashMap.size(), file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+}
+
+bool AdvancedDetectorCacheManager::getPersistentProperties(const Common::String &key, const Common::String &signature, FileProperties &fileProps) {
+	Common::StackLock lock(_mutex);
+	loadPersistentCache();
+
+	PersistentHashMap::iterator it = _persistentHashMap.find(key);
+	if (it == _persistentHashMap.end()) {
+		_sessionMisses++;
+		return false;
+	}
+
+	// The file changed since the entry was made
+	if (it->_value.signature != signature) {
+		_persistentHashMap.erase(it);
+		_persistentDirty = true;
+		_sessionMisses++;
+		return false;
+	}
+
+	fileProps.md5 = it->_value.md5;
+	fileProps.size = it->_value.size;
+	fileProps.md5prop = it->_value.md5prop;
+
+	if (it->_value.lastUsed != _today) {
+		it->_value.lastUsed = _today;
+		_persistentDirty = true;
+	}
+
+	_sessionHits++;
+	return true;
+}
+
+void AdvancedDetectorCacheManager::setPersistentProperties(const Common::String &key, const Common::String &signature, const FileProperties &fileProps) {
+	// Tabs and line breaks would break the file format
+	if (key.contains('\t') || key.contains('\n') || key.contains('\r'))
+		return;
+
+	Common::StackLock lock(_mutex);
+	loadPersistentCache();
+
+	PersistentEntry entry;
+	entry.signature = signature;
+	entry.md5 = fileProps.md5;
+	entry.size = fileProps.size;
+	entry.md5prop = fileProps.md5prop;
+	entry.lastUsed = _today;
+	_persistentHashMap.setVal(key, entry);
+	_persistentDirty = true;
+}
+
+bool AdvancedDetectorCacheManager::hasPersistentProperties(const Common::String &key, const Common::String &signature) {
+	Common::StackLock lock(_mutex);
+	loadPersistentCache();
+
+	PersistentHashMap::const_iterator it = _persistentHashMap.find(key);
+	return it != _persistentHashMap.end() && it->_value.signature == signature;
+}
+
+void AdvancedDetectorCacheManager::savePersistentCache() {
+	// The statistics alone are not worth rewriting the file after every
+	// detection, they are only updated along with the entries
+	if (_scanDepth > 0 || !_persistentLoaded || !_persistentDirty)
+		return;
+
+	Common::FSNode file = getPersistentCacheFile();
+	Common::ScopedPtr<Common::SeekableWriteStream> stream(file.createWriteStream());
+	if (!stream) {
+		debugC(2, kDebugGlobalDetection, "Could not write detection cache '%s'", file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	// Fold the lookups of this session into the statistics
+	_lastHits = _sessionHits;
+	_lastMisses = _sessionMisses;
+	_totalHits += _sessionHits;
+	_totalMisses += _sessionMisses;
+	_sessionHits = _sessionMisses = 0;
+
+	stream->writeString(Common::String::format("version %d\n", DETECTION_CACHE_VERSION));
+	stream->writeString(Common::String::format("stats %u %u %u %u\n", _lastHits, _lastMisses, _totalHits, _totalMisses));
+
+	Common::Array<Common::String> expired;
+	for (const auto &entry : _persistentHashMap) {
+		if (entry._value.lastUsed + DETECTION_CACHE_MAX_AGE < _today) {
+			expired.push_back(entry._key);
+			continue;
+		}
+
+		stream->writeString(Common::String::format("%u\t%lld\t%d\t%s\t%s\t%s\n",
+			entry._value.lastUsed, (long long)entry._value.size, (int)entry._value.md5prop,
+			entry._value.md5.c_str(), entry._value.signature.c_str(), entry._key.c_str()));
+	}
+
+	for (const auto &key : expired)
+		_persistentHashMap.erase(key);
+
+	stream->finalize();
+	if (stream->err()) {
+		debugC(2, kDebugGlobalDetection, "Failed to write detection cache '%s'", file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	_persistentDirty = false;
+}
+
+void AdvancedDetectorCacheManager::setPersistentCacheFile(const Common::Path &path) {
+	Common::StackLock lock(_mutex);
+
+	_persistentPath = path;
+	_persistentHashMap.clear();
+	_persistentLoaded = false;
+	_persistentDirty = false;
+	_sessionHits = _sessionMisses = 0;
+	_lastHits = _lastMisses = _totalHits = _totalMisses = 0;
+}
+
+void AdvancedDetectorCacheManager::beginScan() {
+	if (_scanDepth == 0) {
+		_persistentEnabled = isPersistentCacheEnabled();
+		loadPersistentCache();
+	}
+
+	_scanDepth++;
+}
+
+void AdvancedDetectorCacheManager::endScan() {
+	assert(_scanDepth > 0);
+	if (--_scanDepth > 0)
+		return;
+
+	_prefetchHashMap.clear(true);
+	savePersistentCache();
+}
+
+bool AdvancedDetectorCacheManager::getPrefetchedProperties(const Common::String &key, FileProperties &fileProps) {
+	Common::StackLock lock(_mutex);
+
+	PrefetchHashMap::const_iterator it = _prefetchHashMap.find(key);
+	if (it == _prefetchHashMap.end())
+		return false;
+
+	fileProps = it->_value;
+	return true;
+}
+
+bool AdvancedDetectorCacheManager::hasPrefetchedProperties(const Common::String &key) {
+	Common::StackLock lock(_mutex);
+	return _prefetchHashMap.contains(key);
+}
+
+void AdvancedDetectorCacheManager::setPrefetchedProperties(const Common::String &key, const FileProperties &fileProps) {
+	// The reference counts of strings are not thread-safe, so store deep
+	// copies which the calling worker thread does not share
+	FileProperties props;
+	props.size = fileProps.size;
+	props.md5 = Common::String(fileProps.md5.c_str());
+	props.md5prop = fileProps.md5prop;
+
+	Common::StackLock lock(_mutex);
+	_prefetchHashMap.setVal(Common::String(key.c_str()), props);
+}
+
+void AdvancedDetectorCacheManager::printPersistentCacheStats() {
+	loadPersistentCache();
+
+	const uint32 totalHits = _totalHits + _sessionHits;
+	const uint32 totalMisses = _totalMisses + _sessionMisses;
+
+	uint32 stale = 0;
+	for (const auto &entry : _persistentHashMap) {
+		if (entry._value.lastUsed + DETECTION_CACHE_MAX_AGE < _today)
+			stale++;
+	}
+
+	printf("Detection cache: %s (%s)\n", getPersistentCacheFile().getPath().toString(Common::Path::kNativeSeparator).c_str(),
+	       isPersistentCacheEnabled() ? "enabled" : "disabled");
+	printf("Entries: %u, of which %u expired\n\n", _persistentHashMap.size(), stale);
+	printf("Lookups         Hits          Misses        Hit rate\n"
+	       "--------------- ------------- ------------- -------------\n");
+	printf("%-15s %13u %13u %12.1f%%\n", "Last run", _lastHits, _lastMisses,
+	       _lastHits + _lastMisses ? 100.0 * _lastHits / (_lastHits + _lastMisses) : 0.0);
+	printf("%-15s %13u %13u %12.1f%%\n", "Total", totalHits, totalMisses,
+	       totalHits + totalMisses ? 100.0 * totalHits / (totalHits + totalMisses) : 0.0);
+}
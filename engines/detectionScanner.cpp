@@ -0,0 +1,262 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "engines/detectionScanner.h"
+#include "engines/advancedDetector.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/system.h"
+#include "common/thread.h"
+
+// Detection is mostly bound by the latency of the file system, so this is
+// not related to the number of cores
+#define DEFAULT_DETECTION_THREADS 4
+
+DetectionScanner::DetectionScanner(const Common::FSNode &dir, bool recursive, Detector *detector) :
+	_recursive(recursive), _detector(detector),
+	_maxWorkers(DEFAULT_DETECTION_THREADS), _stopping(false),
+	_currentReadable(false), _results(DetectedGames()), _scannedCount(0) {
+
+	if (ConfMan.hasKey("detection_threads"))
+		_maxWorkers = MAX(ConfMan.getInt("detection_threads"), 0);
+
+	// The detection trace of the higher debug levels, including the one of
+	// MacResManager, would be printed from the worker threads, which may not
+	// call into the backend
+	if (gDebugLevel >= 7)
+		_maxWorkers = 0;
+
+	ADCacheMan.beginScan();
+
+	Directory *root = addDirectory(dir);
+	_order.push_back(root);
+	_pending.push_back(root);
+}
+
+DetectionScanner::~DetectionScanner() {
+	stopWorkers();
+
+	for (auto &dir : _directories)
+		delete dir;
+
+	ADCacheMan.endScan();
+}
+
+uint DetectionScanner::getDirectoryCount() {
+	Common::StackLock lock(_mutex);
+	return _directories.size();
+}
+
+DetectionScanner::Directory *DetectionScanner::addDirectory(const Common::FSNode &node) {
+	Directory *dir = new Directory(node);
+	_directories.push_back(dir);
+	return dir;
+}
+
+void DetectionScanner::readDirectory(Directory *dir, bool prefetch) {
+	Common::Array<Directory *> children;
+
+	dir->readable = dir->node.getChildren(dir->files, Common::FSNode::kListAll);
+
+	if (_recursive && dir->readable) {
+		for (const auto &file : dir->files) {
+			if (!file.isDirectory())
+				continue;
+
+			// The subdirectory is read by another thread, while this list of
+			// files may be used on the main thread. Nodes and strings are
+			// reference counted without any locking, so the subdirectory
+			// gets a node of its own, which shares nothing with this one.
+			Common::String path(file.getPath().toString(Common::Path::kNativeSeparator).c_str());
+			children.push_back(new Directory(Common::FSNode(Common::Path(path, Common::Path::kNativeSeparator))));
+		}
+	}
+
+	{
+		Common::StackLock lock(_mutex);
+		for (auto &child : children)
+			_directories.push_back(child);
+
+		// Queue the subdirectories so that the first one is read first
+		for (uint i = children.size(); i > 0; i--)
+			_pending.push_back(children[i - 1]);
+	}
+
+	dir->children = children;
+
+	if (prefetch && dir->readable)
+		_detector->prefetch(dir->files);
+
+	Common::StackLock lock(_mutex);
+	dir->ready = true;
+}
+
+void DetectionScanner::workerProc(void *data) {
+	Worker *worker = (Worker *)data;
+	DetectionScanner *scanner = worker->scanner;
+
+	for (;;) {
+		Directory *dir;
+
+		{
+			Common::StackLock lock(scanner->_mutex);
+			if (scanner->_pending.empty() || scanner->_stopping) {
+				// Idle workers exit, the main thread starts new ones when
+				// more directories are found
+				worker->finished = true;
+				return;
+			}
+
+			dir = scanner->_pending.back();
+			scanner->_pending.pop_back();
+		}
+
+		scanner->readDirectory(dir, true);
+	}
+}
+
+bool DetectionScanner::takePendingDirectory(Directory *dir) {
+	Common::StackLock lock(_mutex);
+
+	for (uint i = 0; i < _pending.size(); i++) {
+		if (_pending[i] == dir) {
+			_pending.remove_at(i);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void DetectionScanner::updateWorkers() {
+	Common::Array<Worker *> finished;
+	uint pending;
+
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i < _workers.size();) {
+			if (_workers[i]->finished) {
+				finished.push_back(_workers[i]);
+				_workers.remove_at(i);
+			} else {
+				i++;
+			}
+		}
+
+		pending = _pending.size();
+	}
+
+	for (auto &worker : finished) {
+		worker->thread->join();
+		delete worker->thread;
+		delete worker;
+	}
+
+	while (_workers.size() < _maxWorkers && _workers.size() < pending) {
+		Worker *worker = new Worker;
+		worker->scanner = this;
+		worker->finished = false;
+
+		// The worker may finish at once, so it has to be registered first
+		{
+			Common::StackLock lock(_mutex);
+			_workers.push_back(worker);
+		}
+
+		worker->thread = g_system->createThread(workerProc, worker);
+		if (!worker->thread) {
+			// Threads are not supported, read everything on this thread
+			Common::StackLock lock(_mutex);
+			_workers.pop_back();
+			delete worker;
+			_maxWorkers = 0;
+			break;
+		}
+	}
+}
+
+void DetectionScanner::stopWorkers() {
+	{
+		Common::StackLock lock(_mutex);
+		_stopping = true;
+	}
+
+	for (auto &worker : _workers) {
+		worker->thread->join();
+		delete worker->thread;
+		delete worker;
+	}
+
+	_workers.clear();
+}
+
+bool DetectionScanner::scanNextDirectory(bool wait) {
+	if (_order.empty())
+		return false;
+
+	Directory *dir = _order.back();
+
+	for (;;) {
+		updateWorkers();
+
+		bool ready;
+		{
+			Common::StackLock lock(_mutex);
+			ready = dir->ready;
+		}
+
+		if (ready)
+			break;
+
+		if (_workers.empty()) {
+			// Nobody is going to read the directory, do it here. There is no
+			// point in prefetching the file properties on this thread.
+			if (takePendingDirectory(dir)) {
+				readDirectory(dir, false);
+				break;
+			}
+		}
+
+		if (!wait)
+			return false;
+
+		g_system->delayMillis(1);
+	}
+
+	_order.pop_back();
+	for (uint i = dir->children.size(); i > 0; i--)
+		_order.push_back(dir->children[i - 1]);
+
+	_current = dir->node;
+	_currentReadable = dir->readable;
+	_scannedCount++;
+
+	if (dir->readable)
+		_results = _detector->detect(dir->files);
+	else
+		_results = DetectionResults(DetectedGames());
+
+	// The list of files is not needed anymore
+	dir->files.clear();
+
+	return true;
+}
@@ -0,0 +1,175 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONSCANNER_H
+#define ENGINES_DETECTIONSCANNER_H
+
+#include "engines/game.h"
+
+#include "common/array.h"
+#include "common/fs.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/ptr.h"
+
+namespace Common {
+class ThreadInternal;
+}
+
+/**
+ * @addtogroup engines_game
+ * @{
+ */
+
+/**
+ * Detects the games in a directory and, optionally, in all its
+ * subdirectories.
+ *
+ * When the backend supports threads, worker threads read the directories
+ * and compute the MD5 hashes of the game files ahead of time, while the
+ * engines run their detection on the calling thread. The directories are
+ * reported in the same order as a serial depth-first scan would report
+ * them, whatever the number of workers. Without threads, everything is done
+ * on the calling thread.
+ *
+ * The number of workers is set with the "detection_threads" configuration
+ * key.
+ */
+class DetectionScanner : Common::NonCopyable {
+public:
+	/**
+	 * Runs the detection in each directory. The default one asks all the
+	 * engines known to the EngineManager.
+	 */
+	class Detector {
+	public:
+		virtual ~Detector() {}
+
+		/**
+		 * Compute what the detection needs ahead of time, such as the MD5
+		 * hashes of the files. This is called on the worker threads, which
+		 * must not call into the backend or print anything.
+		 */
+		virtual void prefetch(const Common::FSList &files) = 0;
+
+		/** Detect the games in a directory, on the thread which runs the scan. */
+		virtual DetectionResults detect(const Common::FSList &files) = 0;
+	};
+
+	/**
+	 * @param dir             Directory to scan.
+	 * @param recursive       Whether to scan the subdirectories as well.
+	 * @param skipADFlags     Passed to EngineManager::detectGames().
+	 * @param skipIncomplete  Passed to EngineManager::detectGames().
+	 */
+	DetectionScanner(const Common::FSNode &dir, bool recursive, uint32 skipADFlags = 0, bool skipIncomplete = false);
+
+	/**
+	 * @param dir        Directory to scan.
+	 * @param recursive  Whether to scan the subdirectories as well.
+	 * @param detector   The detection to run, which the scanner takes over.
+	 */
+	DetectionScanner(const Common::FSNode &dir, bool recursive, Detector *detector);
+	~DetectionScanner();
+
+	/**
+	 * Run the detection in the next directory.
+	 *
+	 * @param wait  Whether to wait for the workers if they did not read the
+	 *              next directory yet. When false, this may return without
+	 *              scanning anything, so that a GUI can stay responsive.
+	 *
+	 * @return True if a directory was scanned. Its results are then available
+	 *         through getDirectory(), isDirectoryReadable() and getResults().
+	 */
+	bool scanNextDirectory(bool wait = true);
+
+	/** Whether all directories were scanned. */
+	bool isDone() const { return _order.empty(); }
+
+	/** The directory scanned by the last call to scanNextDirectory(). */
+	const Common::FSNode &getDirectory() const { return _current; }
+
+	/** Whether the last scanned directory could be read. */
+	bool isDirectoryReadable() const { return _currentReadable; }
+
+	/** The detection results for the last scanned directory. */
+	const DetectionResults &getResults() const { return _results; }
+
+	/** The number of directories scanned so far. */
+	uint getScannedCount() const { return _scannedCount; }
+
+	/** The number of directories found so far. */
+	uint getDirectoryCount();
+
+private:
+	struct Directory {
+		Common::FSNode node;
+		Common::FSList files;
+		Common::Array<Directory *> children;
+		bool readable;
+		bool ready;
+
+		Directory(const Common::FSNode &n) : node(n), readable(false), ready(false) {}
+	};
+
+	struct Worker {
+		DetectionScanner *scanner;
+		Common::ThreadInternal *thread;
+		bool finished;
+	};
+
+	static void workerProc(void *data);
+
+	Directory *addDirectory(const Common::FSNode &node);
+	void readDirectory(Directory *dir, bool prefetch);
+	bool takePendingDirectory(Directory *dir);
+	void updateWorkers();
+	void stopWorkers();
+
+	bool _recursive;
+	Common::ScopedPtr<Detector> _detector;
+
+	/** All directories found so far, owned by the scanner */
+	Common::Array<Directory *> _directories;
+
+	/** Directories which still have to be read, the next one is at the back */
+	Common::Array<Directory *> _pending;
+
+	/** Directories which still have to be scanned, the next one is at the back */
+	Common::Array<Directory *> _order;
+
+	Common::Array<Worker *> _workers;
+	uint _maxWorkers;
+	bool _stopping;
+
+	/** Protects the directories and the worker states */
+	Common::Mutex _mutex;
+
+	Common::FSNode _current;
+	bool _currentReadable;
+	DetectionResults _results;
+	uint _scannedCount;
+};
+
+/** @} */
+
+#endif
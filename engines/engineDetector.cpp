@@ -0,0 +1,57 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "engines/detectionScanner.h"
+#include "engines/metaengine.h"
+
+/**
+ * The detector used by default, which asks all the engines. This lives
+ * apart from the rest of the scanner, which does not depend on the plugins.
+ */
+class EngineDetector : public DetectionScanner::Detector {
+public:
+	EngineDetector(uint32 skipADFlags, bool skipIncomplete) : _skipADFlags(skipADFlags), _skipIncomplete(skipIncomplete) {
+		const PluginList &plugins = EngineMan.getPlugins(PLUGIN_TYPE_ENGINE_DETECTION);
+		for (const auto &plugin : plugins) {
+			MetaEngineDetection &metaEngine = plugin->get<MetaEngineDetection>();
+			metaEngine.preparePrefetch();
+			_engines.push_back(&metaEngine);
+		}
+	}
+
+	void prefetch(const Common::FSList &files) override {
+		for (const auto &engine : _engines)
+			engine->prefetchFileProperties(files);
+	}
+
+	DetectionResults detect(const Common::FSList &files) override {
+		return EngineMan.detectGames(files, _skipADFlags, _skipIncomplete);
+	}
+
+private:
+	uint32 _skipADFlags;
+	bool _skipIncomplete;
+	Common::Array<MetaEngineDetection *> _engines;
+};
+
+DetectionScanner::DetectionScanner(const Common::FSNode &dir, bool recursive, uint32 skipADFlags, bool skipIncomplete) :
+	DetectionScanner(dir, recursive, new EngineDetector(skipADFlags, skipIncomplete)) {
+}
@@ -164,6 +164,26 @@ public:
 	 */
 	virtual DetectedGames detectGames(const Common::FSList &fslist, uint32 skipADFlags = 0, bool skipIncomplete = false) = 0;
 
+	/**
+	 * Prepare the engine for calls to prefetchFileProperties().
+	 *
+	 * This is called on the main thread before scanning directories.
+	 */
+	virtual void preparePrefetch() {}
+
+	/**
+	 * Compute ahead of time the properties of the files, such as their MD5
+	 * hashes, which detectGames() is going to check in the given list of
+	 * files. They are stored in the detection cache, where detectGames()
+	 * picks them up later.
+	 *
+	 * Unlike the other methods, this may be called from worker threads,
+	 * concurrently for different lists of files. Implementations must not
+	 * touch any global state besides the detection cache, and must not call
+	 * debug() and friends.
+	 */
+	virtual void prefetchFileProperties(const Common::FSList &fslist) const {}
+
 	/** Returns the number of bytes used for MD5-based detection, or 0 if not supported. */
 	virtual uint getMD5Bytes() const = 0;
 
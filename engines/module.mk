@@ -3,8 +3,11 @@ MODULE := engines
 MODULE_OBJS := \
 	achievements.o \
 	advancedDetector.o \
+	advancedDetectorCache.o \
+	detectionScanner.o \
 	dialogs.o \
 	engine.o \
+	engineDetector.o \
 	game.o \
 	metaengine.o \
 	obsolete.o \
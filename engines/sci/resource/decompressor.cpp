@@ -24,6 +24,7 @@
 #include "common/compression/dcl.h"
 #include "common/util.h"
 #include "common/endian.h"
+#include "common/str.h"
 #include "common/stream.h"
 #include "common/textconsole.h"
 
@@ -32,6 +33,20 @@
 #include "sci/resource/resource.h"
 
 namespace Sci {
+void Decompressor::warnBroken(const char *format, ...) {
+	if (_quiet) {
+		_broken = true;
+		return;
+	}
+
+	va_list va;
+	va_start(va, format);
+	const Common::String message = Common::String::vformat(format, va);
+	va_end(va);
+
+	warning("%s", message.c_str());
+}
+
 int Decompressor::unpack(Common::ReadStream *src, byte *dest, uint32 nPacked, uint32 nUnpacked) {
 	while (nPacked && !(src->eos() || src->err())) {
 		uint32 chunk = MIN<uint32>(1024, nPacked);
@@ -187,7 +202,7 @@ int DecompressorLZW::unpackLZW(Common::ReadStream *src, byte *dest, uint32 nPack
 		              getBitsMSB(codeBitLength);
 
 		if (code >= tableSize) {
-			warning("LZW code %x exceeds table size %x", code, tableSize);
+			warnBroken("LZW code %x exceeds table size %x", code, tableSize);
 			break;
 		}
 
@@ -462,7 +477,7 @@ void DecompressorLZW::reorderView(byte *src, byte *dest) {
 	for (l = 0; l < loopheaders; l++) {
 		if (lh_mask & lb) { /* The loop is _not_ present */
 			if (lh_last == -1) {
-				warning("Error: While reordering view: Loop not present, but can't re-use last loop");
+				warnBroken("Error: While reordering view: Loop not present, but can't re-use last loop");
 				lh_last = 0;
 			}
 			WRITE_LE_UINT16(lh_ptr, lh_last);
@@ -496,7 +511,7 @@ void DecompressorLZW::reorderView(byte *src, byte *dest) {
 	}
 
 	if (celindex < cel_total) {
-		warning("View decompression generated too few (%d / %d) headers", celindex, cel_total);
+		warnBroken("View decompression generated too few (%d / %d) headers", celindex, cel_total);
 		free(cc_pos);
 		free(cc_lengths);
 		return;
@@ -532,7 +547,7 @@ void DecompressorLZW::reorderView(byte *src, byte *dest) {
 
 int DecompressorDCL::unpack(Common::ReadStream *src, byte *dest, uint32 nPacked,
 							uint32 nUnpacked) {
-	return Common::decompressDCL(src, dest, nPacked, nUnpacked) ? 0 : SCI_ERROR_DECOMPRESSION_ERROR;
+	return Common::decompressDCL(src, dest, nPacked, nUnpacked, _quiet) ? 0 : SCI_ERROR_DECOMPRESSION_ERROR;
 }
 
 #ifdef ENABLE_SCI32
@@ -557,14 +572,14 @@ int DecompressorLZS::unpackLZS() {
 				if (!offs) // This is the end marker - a 7 bit offset of zero
 					break;
 				if (!(clen = getCompLen())) {
-					warning("lzsDecomp: length mismatch");
+					warnBroken("lzsDecomp: length mismatch");
 					return SCI_ERROR_DECOMPRESSION_ERROR;
 				}
 				copyComp(offs, clen);
 			} else { // Eleven bit offset follows
 				offs = getBitsMSB(11);
 				if (!(clen = getCompLen())) {
-					warning("lzsDecomp: length mismatch");
+					warnBroken("lzsDecomp: length mismatch");
 					return SCI_ERROR_DECOMPRESSION_ERROR;
 				}
 				copyComp(offs, clen);
@@ -58,7 +58,9 @@ public:
 		_dwRead(0),
 		_dwWrote(0),
 		_src(nullptr),
-		_dest(nullptr)
+		_dest(nullptr),
+		_quiet(false),
+		_broken(false)
 	{}
 
 	virtual ~Decompressor() {}
@@ -66,7 +68,19 @@ public:
 
 	virtual int unpack(Common::ReadStream *src, byte *dest, uint32 nPacked, uint32 nUnpacked);
 
+	/**
+	 * Do not print warnings about broken data, only remember them, so that
+	 * resources can be unpacked outside the main thread.
+	 */
+	void setQuiet(bool quiet) { _quiet = quiet; }
+
+	/** Returns true if broken data was found while quiet. */
+	bool isBroken() const { return _broken; }
+
 protected:
+	/** Prints a warning about broken data, or only remembers it when quiet. */
+	void warnBroken(const char *format, ...) GCC_PRINTF(2, 3);
+
 	/**
 	 * Initialize decompressor.
 	 * @param src		source stream to read from
@@ -126,6 +140,8 @@ protected:
 	uint32 _dwWrote;	///< number of bytes written to _dest
 	Common::ReadStream *_src;
 	byte *_dest;
+	bool _quiet;
+	bool _broken;
 };
 
 /**
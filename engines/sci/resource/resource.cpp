@@ -210,6 +210,10 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : SciSpan<const byte>
 	_source = nullptr;
 	_header = nullptr;
 	_headerSize = 0;
+	_lruPrev = nullptr;
+	_lruNext = nullptr;
+	_prefetch = nullptr;
+	_prefetched = false;
 }
 
 Resource::~Resource() {
@@ -599,26 +603,30 @@ Common::SeekableReadStream *ResourceSource::getVolumeFile(ResourceManager *resMa
 	return fileStream;
 }
 
-void ResourceSource::loadResource(ResourceManager *resMan, Resource *res) {
-	Common::SeekableReadStream *fileStream = getVolumeFile(resMan, res);
-	if (!fileStream)
-		return;
-
-	fileStream->seek(0, SEEK_SET);
-	ResourceType type = resMan->convertResType(fileStream->readByte());
-	ResVersion volVersion = resMan->getVolVersion();
+int Resource::loadFromVolume(Common::SeekableReadStream *file, bool koreanText, bool quiet) {
+	file->seek(0, SEEK_SET);
+	ResourceType type = _resMan->convertResType(file->readByte());
+	ResVersion volVersion = _resMan->getVolVersion();
 
 	// FIXME: if resource.msg has different version from SCI, this has to be modified.
 	if (
 		(
-			(type == kResourceTypeMessage && res->getType() == kResourceTypeMessage) ||
-			(type == kResourceTypeText && res->getType() == kResourceTypeText)
+			(type == kResourceTypeMessage && getType() == kResourceTypeMessage) ||
+			(type == kResourceTypeText && getType() == kResourceTypeText)
 		) &&
-		g_sci && g_sci->getLanguage() == Common::KO_KOR)
+		koreanText)
 		volVersion = kResVersionSci11;
-	fileStream->seek(res->_fileOffset, SEEK_SET);
+	file->seek(_fileOffset, SEEK_SET);
+
+	return decompress(volVersion, file, quiet);
+}
 
-	int error = res->decompress(volVersion, fileStream);
+void ResourceSource::loadResource(ResourceManager *resMan, Resource *res) {
+	Common::SeekableReadStream *fileStream = getVolumeFile(resMan, res);
+	if (!fileStream)
+		return;
+
+	int error = res->loadFromVolume(fileStream, g_sci && g_sci->getLanguage() == Common::KO_KOR);
 	if (error) {
 		warning("Error %d occurred while reading %s from resource file %s: %s",
 				error, res->_id.toString().c_str(), res->getResourceLocation().toString().c_str(),
@@ -1002,13 +1010,15 @@ void ResourceManager::freeResourceSources() {
 }
 
 ResourceManager::ResourceManager(const bool detectionMode) :
-	_detectionMode(detectionMode) {}
+	_detectionMode(detectionMode), _prefetcher(nullptr) {}
 
 void ResourceManager::init() {
 	_maxMemoryLRU = 256 * 1024; // 256KiB
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	_lruFirst = nullptr;
+	_lruLast = nullptr;
+	resetCacheStats();
 	_resMap.clear();
 	_audioMapSCI1 = nullptr;
 #ifdef ENABLE_SCI32
@@ -1082,6 +1092,9 @@ void ResourceManager::init() {
 		_maxMemoryLRU = 4096 * 1024; // 4MiB
 	}
 
+	if (!_detectionMode)
+		_prefetcher = new ResourcePrefetcher();
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -1108,6 +1121,9 @@ void ResourceManager::init() {
 }
 
 ResourceManager::~ResourceManager() {
+	// The prefetch thread may still be loading resources
+	delete _prefetcher;
+
 	// freeing resources
 	ResourceMap::iterator itr = _resMap.begin();
 	while (itr != _resMap.end()) {
@@ -1128,7 +1144,15 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+	if (res->_lruPrev)
+		res->_lruPrev->_lruNext = res->_lruNext;
+	else
+		_lruFirst = res->_lruNext;
+	if (res->_lruNext)
+		res->_lruNext->_lruPrev = res->_lruPrev;
+	else
+		_lruLast = res->_lruPrev;
+	res->_lruPrev = res->_lruNext = nullptr;
 	_memoryLRU -= res->size();
 	res->_status = kResStatusAllocated;
 }
@@ -1138,7 +1162,13 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+	res->_lruPrev = nullptr;
+	res->_lruNext = _lruFirst;
+	if (_lruFirst)
+		_lruFirst->_lruPrev = res;
+	else
+		_lruLast = res;
+	_lruFirst = res;
 	_memoryLRU += res->size();
 #ifdef SCI_VERBOSE_RESMAN
 	debug("Adding %s (%d bytes) to lru control: %d bytes total",
@@ -1150,8 +1180,8 @@ void ResourceManager::addToLRU(Resource *res) {
 
 void ResourceManager::freeOldResources() {
 	while (_maxMemoryLRU < _memoryLRU) {
-		assert(!_LRU.empty());
-		Resource *goner = _LRU.back();
+		assert(_lruLast);
+		Resource *goner = _lruLast;
 		removeFromLRU(goner);
 		goner->unalloc();
 #ifdef SCI_VERBOSE_RESMAN
@@ -1160,6 +1190,86 @@ void ResourceManager::freeOldResources() {
 	}
 }
 
+void ResourceManager::resetCacheStats() {
+	_cacheStats.hits = 0;
+	_cacheStats.misses = 0;
+	_cacheStats.prefetched = 0;
+	_cacheStats.prefetchHits = 0;
+}
+
+bool ResourceManager::canPrefetch(const Resource *res) const {
+	// Only plain volumes are read in the background. The other sources share
+	// state with the main thread, and digital audio may need to be fixed up
+	// with warnings.
+	return res->_source && res->_source->getSourceType() == kSourceVolume &&
+		res->getType() != kResourceTypeAudio;
+}
+
+void ResourceManager::prefetchResource(ResourceId id) {
+	if (!_prefetcher)
+		return;
+
+	adoptPrefetchedResources();
+
+	Resource *res = testResource(id);
+	if (!res || res->_status != kResStatusNoMalloc || res->_prefetch || !canPrefetch(res))
+		return;
+
+	_prefetcher->request(res, g_sci && g_sci->getLanguage() == Common::KO_KOR);
+
+	if (!_prefetcher->isAvailable()) {
+		delete _prefetcher;
+		_prefetcher = nullptr;
+	}
+}
+
+void ResourceManager::prefetchRoom(uint16 roomNumber) {
+	// Rooms usually draw the picture with their own number first, and SCI1.1
+	// and later pictures may use the palette of the same number
+	prefetchResource(ResourceId(kResourceTypePic, roomNumber));
+	prefetchResource(ResourceId(kResourceTypePalette, roomNumber));
+}
+
+void ResourceManager::adoptPrefetchedResources() {
+	Common::Array<PrefetchRequest *> finished;
+	_prefetcher->takeFinished(finished);
+
+	for (uint i = 0; i < finished.size(); i++) {
+		Resource *res = finished[i]->resource;
+		Resource *loaded = finished[i]->loaded;
+
+		// Problems with the resource are reported when it is loaded on the
+		// main thread
+		if (finished[i]->error)
+			debugC(2, kDebugLevelResMan, "[resMan] Prefetching %s failed with error %d", res->_id.toString().c_str(), finished[i]->error);
+
+		// The resource may have been patched meanwhile
+		if (finished[i]->state == kPrefetchDone && res->_status == kResStatusNoMalloc && res->_source == loaded->_source) {
+			res->_id = loaded->_id;
+			res->_data = loaded->_data;
+			res->_size = loaded->_size;
+			res->_header = loaded->_header;
+			res->_headerSize = loaded->_headerSize;
+			res->_status = kResStatusAllocated;
+			loaded->_data = nullptr;
+			loaded->_header = nullptr;
+
+			if (_patcher)
+				_patcher->applyPatch(*res);
+
+			addToLRU(res);
+			res->_prefetched = true;
+			_cacheStats.prefetched++;
+		}
+
+		delete loaded;
+		delete finished[i];
+	}
+
+	if (!finished.empty())
+		freeOldResources();
+}
+
 Common::List<ResourceId> ResourceManager::listResources(ResourceType type, int mapNumber) {
 	Common::List<ResourceId> resources;
 
@@ -1196,6 +1306,21 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return nullptr;
 
+	if (_prefetcher) {
+		if (retval->_prefetch)
+			_prefetcher->finish(retval->_prefetch);
+		adoptPrefetchedResources();
+	}
+
+	if (retval->_status == kResStatusNoMalloc) {
+		_cacheStats.misses++;
+	} else {
+		_cacheStats.hits++;
+		if (retval->_prefetched)
+			_cacheStats.prefetchHits++;
+	}
+	retval->_prefetched = false;
+
 	if (retval->_status == kResStatusNoMalloc)
 		loadResource(retval);
 	else if (retval->_status == kResStatusEnqueued)
@@ -2363,7 +2488,7 @@ int Resource::readResourceInfo(ResVersion volVersion, Common::SeekableReadStream
 	return (compression == kCompUnknown) ? SCI_ERROR_UNKNOWN_COMPRESSION : SCI_ERROR_NONE;
 }
 
-int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file) {
+int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file, bool quiet) {
 	int errorNum;
 	uint32 szPacked = 0;
 	ResourceCompression compression = kCompUnknown;
@@ -2397,33 +2522,47 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 		break;
 #endif
 	default:
-		error("Resource %s: Compression method %d not supported", _id.toString().c_str(), compression);
+		if (!quiet)
+			error("Resource %s: Compression method %d not supported", _id.toString().c_str(), compression);
 		return SCI_ERROR_UNKNOWN_COMPRESSION;
 	}
 
+	// When quiet, anything which would be reported fails the loading
+	// instead, and is reported when the resource is loaded again
+	dec->setQuiet(quiet);
+
 	byte *ptr = new byte[_size];
 	_data = ptr;
 	_status = kResStatusAllocated;
 	errorNum = ptr ? dec->unpack(file, ptr, szPacked, _size) : SCI_ERROR_RESOURCE_TOO_BIG;
-	if (errorNum) {
-		unalloc();
-	} else {
-		// At least Lighthouse puts sound effects in RESSCI.00n/RESSCI.PAT
-		// instead of using a RESOURCE.SFX
-		if (getType() == kResourceTypeAudio) {
-			const uint8 headerSize = ptr[1];
-			if (headerSize < 11) {
+	if (!errorNum && dec->isBroken())
+		errorNum = SCI_ERROR_DECOMPRESSION_ERROR;
+
+	// At least Lighthouse puts sound effects in RESSCI.00n/RESSCI.PAT
+	// instead of using a RESOURCE.SFX
+	if (!errorNum && getType() == kResourceTypeAudio) {
+		const uint8 headerSize = ptr[1];
+		if (headerSize < 11) {
+			if (!quiet)
 				error("Unexpected audio header size for %s: should be >= 11, but got %d", _id.toString().c_str(), headerSize);
-			}
+			errorNum = SCI_ERROR_DECOMPRESSION_ERROR;
+		} else {
 			const uint32 audioSize = READ_LE_UINT32(ptr + 9);
 			const uint32 calculatedTotalSize = audioSize + headerSize + kResourceHeaderSize;
 			if (calculatedTotalSize != _size) {
-				warning("Unexpected audio file size: the size of %s in %s is %d, but the volume says it should be %d", _id.toString().c_str(), _source->getLocationName().toString().c_str(), calculatedTotalSize, _size);
+				if (quiet)
+					errorNum = SCI_ERROR_DECOMPRESSION_ERROR;
+				else
+					warning("Unexpected audio file size: the size of %s in %s is %d, but the volume says it should be %d", _id.toString().c_str(), _source->getLocationName().toString().c_str(), calculatedTotalSize, _size);
 			}
-			_size = MIN(_size - kResourceHeaderSize, headerSize + audioSize);
+			if (!errorNum)
+				_size = MIN(_size - kResourceHeaderSize, headerSize + audioSize);
 		}
 	}
 
+	if (errorNum)
+		unalloc();
+
 	delete dec;
 	return errorNum;
 }
@@ -157,6 +157,7 @@ const char *getSciVersionDesc(SciVersion version);
 class ResourceManager;
 class ResourceSource;
 class ResourcePatcher;
+struct PrefetchRequest;
 
 class ResourceId {
 	static inline ResourceType fixupType(ResourceType type) {
@@ -264,6 +265,7 @@ class Resource : public SciSpan<const byte> {
 	friend class WaveResourceSource;
 	friend class AudioVolumeResourceSource;
 	friend class MacResourceForkResourceSource;
+	friend class ResourcePrefetcher;
 #ifdef ENABLE_SCI32
 	friend class ChunkResourceSource;
 #endif
@@ -312,18 +314,25 @@ protected:
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
+	Resource *_lruPrev; ///< Next more recently used resource in the LRU queue
+	Resource *_lruNext; ///< Next less recently used resource in the LRU queue
+	PrefetchRequest *_prefetch; ///< Pending request to load the resource in the background
+	bool _prefetched; ///< Loaded in the background, and not looked up since
+
 	bool loadPatch(Common::SeekableReadStream *file);
 	bool loadFromPatchFile();
 	bool loadFromWaveFile(Common::SeekableReadStream *file);
 	bool loadFromAudioVolumeSCI1(Common::SeekableReadStream *file);
 	bool loadFromAudioVolumeSCI11(Common::SeekableReadStream *file);
-	int decompress(ResVersion volVersion, Common::SeekableReadStream *file);
+	int loadFromVolume(Common::SeekableReadStream *file, bool koreanText, bool quiet = false);
+	int decompress(ResVersion volVersion, Common::SeekableReadStream *file, bool quiet = false);
 	int readResourceInfo(ResVersion volVersion, Common::SeekableReadStream *file, uint32 &szPacked, ResourceCompression &compression);
 };
 
 typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
 class IntMapResourceSource;
+class ResourcePrefetcher;
 class ResourceManager {
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
 	// ease transition to the ResourceSource class system.
@@ -380,6 +389,36 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	/**
+	 * Hints that a resource is going to be used soon.
+	 * When threads are available, the resource is loaded and decompressed in
+	 * the background, and put in the LRU queue once it is ready. Otherwise,
+	 * this does nothing and the resource is loaded by findResource() as usual.
+	 * @param id	The resource to load
+	 */
+	void prefetchResource(ResourceId id);
+
+	/**
+	 * Hints that a room is going to be entered, so that its picture and
+	 * palette are loaded in the background.
+	 * @param roomNumber	The number of the room script
+	 */
+	void prefetchRoom(uint16 roomNumber);
+
+	/** Statistics of the resource cache, shown by the debugger */
+	struct CacheStats {
+		uint32 hits;         ///< Lookups of resources which were in memory
+		uint32 misses;       ///< Lookups which had to load the resource
+		uint32 prefetched;   ///< Resources loaded in the background
+		uint32 prefetchHits; ///< Lookups of resources loaded in the background
+	};
+
+	const CacheStats &getCacheStats() const { return _cacheStats; }
+	void resetCacheStats();
+	int getMemoryLRU() const { return _memoryLRU; }
+	int getMaxMemoryLRU() const { return _maxMemoryLRU; }
+	int getMemoryLocked() const { return _memoryLocked; }
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -501,7 +540,10 @@ protected:
 	SourcesList _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	Resource *_lruFirst; ///< Most recently used resource of the LRU queue
+	Resource *_lruLast;  ///< Least recently used resource of the LRU queue
+	CacheStats _cacheStats;
+	ResourcePrefetcher *_prefetcher; ///< Background loader, or NULL if threads are not available
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -647,6 +689,9 @@ protected:
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
 
+	bool canPrefetch(const Resource *res) const;
+	void adoptPrefetchedResources();
+
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
 	bool hasSci0Voc999();
@@ -22,10 +22,13 @@
 #ifndef SCI_RESOURCE_RESOURCE_INTERN_H
 #define SCI_RESOURCE_RESOURCE_INTERN_H
 
+#include "common/mutex.h"
+
 #include "sci/resource/resource.h"
 
 namespace Common {
 class MacResManager;
+class ThreadInternal;
 }
 
 namespace Sci {
@@ -237,6 +240,82 @@ protected:
 
 #endif
 
+enum PrefetchState {
+	kPrefetchQueued,
+	kPrefetchLoading,
+	kPrefetchDone,
+	kPrefetchFailed
+};
+
+struct PrefetchRequest {
+	Resource *resource; ///< The resource of the resource map
+	Resource *loaded;   ///< Copy of the resource, loaded by the prefetch thread
+	Common::SeekableReadStream *stream; ///< Volume file, only used by the prefetch thread
+	bool koreanText;
+	PrefetchState state;
+	int error;          ///< Error of the prefetch thread, the resource is then loaded on the main thread
+};
+
+/**
+ * Loads resources from volume files on a background thread.
+ *
+ * The thread decompresses each resource into a copy of its own, and only
+ * touches the volume files it opened itself. The resource manager then
+ * moves the data of the finished requests into the actual resources on
+ * the main thread.
+ *
+ * The thread never prints warnings or errors: a resource with broken data
+ * is dropped, and loaded again by the main thread, which reports them.
+ */
+class ResourcePrefetcher {
+public:
+	enum {
+		kMaxQueuedRequests = 32
+	};
+
+	ResourcePrefetcher();
+	~ResourcePrefetcher();
+
+	/**
+	 * Returns false once it turned out that the backend does not support
+	 * threads. Nothing is loaded in the background then.
+	 */
+	bool isAvailable() const { return _available; }
+
+	/** Queues loading a resource from a volume. */
+	void request(Resource *res, bool koreanText);
+
+	/**
+	 * Makes sure that the request of a resource is finished: cancels it if
+	 * the thread did not start it, or waits until it is loaded.
+	 */
+	void finish(PrefetchRequest *request);
+
+	/** Gets the requests finished since the last call. */
+	void takeFinished(Common::Array<PrefetchRequest *> &finished);
+
+private:
+	Common::Mutex _mutex;
+	Common::List<PrefetchRequest *> _queue;
+	Common::Array<PrefetchRequest *> _finished;
+	Common::ThreadInternal *_thread;
+	Common::SemaphoreInternal *_loadedSemaphore; ///< Signalled once the waiting request is loaded
+	PrefetchRequest *_waitingFor; ///< The request which finish() waits for, if any
+	bool _threadFinished;
+	bool _available;
+
+	struct VolumeFile {
+		ResourceSource *source;
+		Common::SeekableReadStream *stream;
+	};
+	Common::Array<VolumeFile> _volumeFiles;
+
+	Common::SeekableReadStream *getVolumeFile(ResourceSource *source);
+	void startThread();
+	void joinThread();
+	static void threadProc(void *data);
+};
+
 } // End of namespace Sci
 
 #endif // SCI_RESOURCE_RESOURCE_INTERN_H
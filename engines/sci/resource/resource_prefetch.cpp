@@ -0,0 +1,225 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/file.h"
+#include "common/fs.h"
+#include "common/system.h"
+#include "common/thread.h"
+
+#include "sci/resource/resource.h"
+#include "sci/resource/resource_intern.h"
+
+namespace Sci {
+
+ResourcePrefetcher::ResourcePrefetcher() :
+	_thread(nullptr), _loadedSemaphore(nullptr), _waitingFor(nullptr),
+	_threadFinished(false), _available(true) {
+}
+
+ResourcePrefetcher::~ResourcePrefetcher() {
+	{
+		Common::StackLock lock(_mutex);
+		for (Common::List<PrefetchRequest *>::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+			(*it)->state = kPrefetchFailed;
+			_finished.push_back(*it);
+		}
+		_queue.clear();
+	}
+
+	joinThread();
+	delete _loadedSemaphore;
+
+	for (uint i = 0; i < _finished.size(); i++) {
+		_finished[i]->resource->_prefetch = nullptr;
+		delete _finished[i]->loaded;
+		delete _finished[i];
+	}
+
+	for (uint i = 0; i < _volumeFiles.size(); i++)
+		delete _volumeFiles[i].stream;
+}
+
+Common::SeekableReadStream *ResourcePrefetcher::getVolumeFile(ResourceSource *source) {
+	for (uint i = 0; i < _volumeFiles.size(); i++) {
+		if (_volumeFiles[i].source == source)
+			return _volumeFiles[i].stream;
+	}
+
+	// The thread gets a stream of its own for each volume, as the streams
+	// cached by the resource manager are used on the main thread
+	Common::SeekableReadStream *stream;
+	if (source->_resourceFile) {
+		stream = source->_resourceFile->createReadStream();
+	} else {
+		Common::File *file = new Common::File;
+		if (!file->open(source->getLocationName())) {
+			delete file;
+			file = nullptr;
+		}
+		stream = file;
+	}
+
+	if (stream) {
+		VolumeFile volumeFile = { source, stream };
+		_volumeFiles.push_back(volumeFile);
+	}
+
+	return stream;
+}
+
+void ResourcePrefetcher::request(Resource *res, bool koreanText) {
+	Common::SeekableReadStream *stream = getVolumeFile(res->_source);
+	if (!stream)
+		return;
+
+	PrefetchRequest *request = new PrefetchRequest;
+	request->resource = res;
+	request->loaded = new Resource(res->_resMan, res->_id);
+	request->loaded->_source = res->_source;
+	request->loaded->_fileOffset = res->_fileOffset;
+	request->stream = stream;
+	request->koreanText = koreanText;
+	request->state = kPrefetchQueued;
+	request->error = SCI_ERROR_NONE;
+
+	{
+		Common::StackLock lock(_mutex);
+		if (_queue.size() >= kMaxQueuedRequests) {
+			// Hints are only worth something if they are loaded in time
+			delete request->loaded;
+			delete request;
+			return;
+		}
+
+		_queue.push_back(request);
+	}
+
+	res->_prefetch = request;
+	startThread();
+}
+
+void ResourcePrefetcher::finish(PrefetchRequest *request) {
+	{
+		Common::StackLock lock(_mutex);
+		if (request->state == kPrefetchQueued) {
+			// Loading it on the main thread is not slower than waiting
+			// for the requests before it
+			_queue.remove(request);
+			request->state = kPrefetchFailed;
+			_finished.push_back(request);
+			return;
+		}
+
+		if (request->state != kPrefetchLoading)
+			return;
+
+		_waitingFor = request;
+	}
+
+	// The thread signals once it is done with the request
+	_loadedSemaphore->wait();
+}
+
+void ResourcePrefetcher::takeFinished(Common::Array<PrefetchRequest *> &finished) {
+	finished.clear();
+
+	{
+		Common::StackLock lock(_mutex);
+		if (_finished.empty())
+			return;
+
+		SWAP(finished, _finished);
+	}
+
+	for (uint i = 0; i < finished.size(); i++)
+		finished[i]->resource->_prefetch = nullptr;
+}
+
+void ResourcePrefetcher::startThread() {
+	if (_thread) {
+		{
+			Common::StackLock lock(_mutex);
+			if (!_threadFinished)
+				return;
+		}
+
+		joinThread();
+	}
+
+	_threadFinished = false;
+	if (!_loadedSemaphore)
+		_loadedSemaphore = g_system->createSemaphore();
+	_thread = _loadedSemaphore ? g_system->createThread(threadProc, this) : nullptr;
+	if (!_thread) {
+		// Threads are not supported, the resources are loaded on demand
+		_available = false;
+
+		Common::StackLock lock(_mutex);
+		for (Common::List<PrefetchRequest *>::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+			(*it)->state = kPrefetchFailed;
+			_finished.push_back(*it);
+		}
+		_queue.clear();
+	}
+}
+
+void ResourcePrefetcher::joinThread() {
+	if (!_thread)
+		return;
+
+	_thread->join();
+	delete _thread;
+	_thread = nullptr;
+}
+
+void ResourcePrefetcher::threadProc(void *data) {
+	ResourcePrefetcher *prefetcher = (ResourcePrefetcher *)data;
+
+	for (;;) {
+		PrefetchRequest *request;
+
+		{
+			Common::StackLock lock(prefetcher->_mutex);
+			if (prefetcher->_queue.empty()) {
+				// The main thread starts a new thread for the next requests
+				prefetcher->_threadFinished = true;
+				return;
+			}
+
+			request = prefetcher->_queue.front();
+			prefetcher->_queue.pop_front();
+			request->state = kPrefetchLoading;
+		}
+
+		const int error = request->loaded->loadFromVolume(request->stream, request->koreanText, true);
+
+		Common::StackLock lock(prefetcher->_mutex);
+		request->error = error;
+		request->state = (error || !request->loaded->data()) ? kPrefetchFailed : kPrefetchDone;
+		prefetcher->_finished.push_back(request);
+		if (prefetcher->_waitingFor == request) {
+			prefetcher->_waitingFor = nullptr;
+			prefetcher->_loadedSemaphore->signal();
+		}
+	}
+}
+
+} // End of namespace Sci
@@ -30,6 +30,7 @@ struct Point;
 }
 
 class BlendBlitUnfilteredTestSuite;
+class KeyMaskBlitTestSuite;
 
 namespace Graphics {
 
@@ -250,6 +251,53 @@ bool setAlpha(byte *dst, const byte *src,
               const Graphics::PixelFormat &format,
               const bool skipTransparent, const uint8 alpha);
 
+// This is a class so that we can declare certain things as private
+class KeyMaskBlit {
+public:
+	/** Blits the pixels of a row which differ from the color key. */
+	typedef void (*KeyRowFunc)(byte *dst, const byte *src, uint w, uint32 key);
+	/** Blits the pixels of a row whose mask value is non-zero. */
+	typedef void (*MaskRowFunc)(byte *dst, const byte *src, const byte *mask, uint w);
+	/**
+	 * Blits the pixels of a CLUT8 row through a map, skipping those whose
+	 * mask value is zero, or which equal the color key if there is no mask.
+	 * The row is blitted from right to left, so that it can be converted in
+	 * place.
+	 */
+	typedef void (*MapRowFunc)(byte *dst, const byte *src, const byte *mask, uint w, const uint32 *map, uint32 key);
+
+	/**
+	 * The row functions for 1, 2 and 4 bytes per pixel, indexed by
+	 * bytesPerPixel >> 1. Color keys have to fit in a pixel.
+	 */
+	struct RowFuncs {
+		KeyRowFunc keyRow[3];
+		MaskRowFunc maskRow[3];
+		MapRowFunc mapRow[3];
+	};
+
+	/**
+	 * Returns the vectorized row functions supported by the CPU, or nullptr
+	 * if there are none, in which case the pixels are blitted one by one.
+	 */
+	static const RowFuncs *getRowFuncs();
+
+private:
+#ifdef SCUMMVM_NEON
+	static const RowFuncs rowFuncsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	static const RowFuncs rowFuncsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+	static const RowFuncs rowFuncsAVX2;
+#endif
+
+	static const RowFuncs *rowFuncs;
+	static bool rowFuncsSelected;
+	friend class ::KeyMaskBlitTestSuite;
+};
+
 // This is a class so that we can declare certain things as private
 class BlendBlit {
 private:
@@ -321,6 +321,161 @@ void BlendBlit::blitAVX2(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_AVX2>(args, blendMode, alphaType);
 }
 
+namespace {
+
+template<int Size>
+inline __m256i compareKey(__m256i src, __m256i key) {
+	if (Size == 1)
+		return _mm256_cmpeq_epi8(src, key);
+	else if (Size == 2)
+		return _mm256_cmpeq_epi16(src, key);
+	else
+		return _mm256_cmpeq_epi32(src, key);
+}
+
+template<typename Color>
+void keyRow(byte *dst, const byte *src, uint w, uint32 key) {
+	const int Size = sizeof(Color);
+	const __m256i keyVec = Size == 1 ? _mm256_set1_epi8((char)key) :
+	                       Size == 2 ? _mm256_set1_epi16((short)key) : _mm256_set1_epi32((int)key);
+	uint x = 0;
+
+	for (; x + 32 / Size <= w; x += 32 / Size) {
+		const __m256i srcVec = _mm256_loadu_si256((const __m256i *)src);
+		const __m256i transparent = compareKey<Size>(srcVec, keyVec);
+		const int bits = _mm256_movemask_epi8(transparent);
+		if (bits == 0)
+			_mm256_storeu_si256((__m256i *)dst, srcVec);
+		else if (bits != -1)
+			_mm256_storeu_si256((__m256i *)dst, _mm256_blendv_epi8(srcVec, _mm256_loadu_si256((const __m256i *)dst), transparent));
+		src += 32;
+		dst += 32;
+	}
+
+	for (; x < w; ++x) {
+		const Color color = *(const Color *)src;
+		if (color != key)
+			*(Color *)dst = color;
+		src += Size;
+		dst += Size;
+	}
+}
+
+/**
+ * Blits the pixels in src, keeping the destination where the bytes of
+ * transparent are set. That is 32 pixels for CLUT8, and 16 pixels otherwise,
+ * in which case only the lower half of transparent is used.
+ */
+template<int Size>
+inline void blendPixels(byte *dst, const byte *src, __m256i transparent) {
+	if (Size == 1) {
+		_mm256_storeu_si256((__m256i *)dst, _mm256_blendv_epi8(_mm256_loadu_si256((const __m256i *)src),
+		                                                        _mm256_loadu_si256((const __m256i *)dst), transparent));
+	} else if (Size == 2) {
+		const __m256i t = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(transparent));
+		_mm256_storeu_si256((__m256i *)dst, _mm256_blendv_epi8(_mm256_loadu_si256((const __m256i *)src),
+		                                                        _mm256_loadu_si256((const __m256i *)dst), t));
+	} else {
+		const __m128i lo = _mm256_castsi256_si128(transparent);
+		const __m256i t[2] = { _mm256_cvtepi8_epi32(lo), _mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8)) };
+		for (int i = 0; i < 2; ++i)
+			_mm256_storeu_si256((__m256i *)dst + i, _mm256_blendv_epi8(_mm256_loadu_si256((const __m256i *)src + i),
+			                                                            _mm256_loadu_si256((const __m256i *)dst + i), t[i]));
+	}
+}
+
+/** Loads which of the next 32 or 16 pixels are transparent, as in blendPixels(). */
+template<int Size>
+inline __m256i loadTransparent(const byte *src, const byte *mask, __m256i key) {
+	if (Size == 1) {
+		if (mask)
+			return _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)mask), _mm256_setzero_si256());
+		return _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)src), key);
+	}
+
+	const __m128i t = mask ? _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)mask), _mm_setzero_si128())
+	                       : _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)src), _mm256_castsi256_si128(key));
+	return _mm256_castsi128_si256(t);
+}
+
+template<typename Color>
+void maskRow(byte *dst, const byte *src, const byte *mask, uint w) {
+	const int Size = sizeof(Color);
+	const int Chunk = Size == 1 ? 32 : 16;
+	const int allBits = Size == 1 ? -1 : 0xFFFF;
+	uint x = 0;
+
+	for (; x + Chunk <= w; x += Chunk) {
+		const __m256i transparent = loadTransparent<Size>(src, mask, _mm256_setzero_si256());
+		const int bits = _mm256_movemask_epi8(transparent) & allBits;
+		if (bits == 0)
+			memcpy(dst, src, Chunk * Size);
+		else if (bits != allBits)
+			blendPixels<Size>(dst, src, transparent);
+		src  += Chunk * Size;
+		dst  += Chunk * Size;
+		mask += Chunk;
+	}
+
+	for (; x < w; ++x) {
+		if (*mask)
+			*(Color *)dst = *(const Color *)src;
+		src  += Size;
+		dst  += Size;
+		mask += 1;
+	}
+}
+
+template<typename Color>
+void mapRow(byte *dst, const byte *src, const byte *mask, uint w, const uint32 *map, uint32 key) {
+	const int Size = sizeof(Color);
+	const int Chunk = Size == 1 ? 32 : 16;
+	const int allBits = Size == 1 ? -1 : 0xFFFF;
+	const __m256i keyVec = _mm256_set1_epi8((char)key);
+	Color colors[Chunk];
+	uint x = w;
+
+	// The source and the mask are read before anything is written, so
+	// that the row can be converted in place
+	while (x >= (uint)Chunk) {
+		x -= Chunk;
+		const __m256i transparent = loadTransparent<Size>(src + x, mask ? mask + x : nullptr, keyVec);
+		const int bits = _mm256_movemask_epi8(transparent) & allBits;
+		if (bits == allBits)
+			continue;
+
+		if (Size == 4) {
+			// Gather the colors straight from the map
+			const __m128i indices = _mm_loadu_si128((const __m128i *)(src + x));
+			const __m256i lo = _mm256_i32gather_epi32((const int *)map, _mm256_cvtepu8_epi32(indices), 4);
+			const __m256i hi = _mm256_i32gather_epi32((const int *)map, _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8)), 4);
+			_mm256_storeu_si256((__m256i *)colors, lo);
+			_mm256_storeu_si256((__m256i *)colors + 1, hi);
+		} else {
+			for (int i = 0; i < Chunk; ++i)
+				colors[i] = map[src[x + i]];
+		}
+
+		if (bits == 0)
+			memcpy(dst + x * Size, colors, Chunk * Size);
+		else
+			blendPixels<Size>(dst + x * Size, (const byte *)colors, transparent);
+	}
+
+	while (x-- > 0) {
+		if (mask ? mask[x] != 0 : src[x] != key)
+			*(Color *)(dst + x * Size) = map[src[x]];
+	}
+}
+
+} // End of anonymous namespace
+
+const KeyMaskBlit::RowFuncs KeyMaskBlit::rowFuncsAVX2 = {
+	{ keyRow<uint8>, keyRow<uint16>, keyRow<uint32> },
+	{ maskRow<uint8>, maskRow<uint16>, maskRow<uint32> },
+	{ mapRow<uint8>, mapRow<uint16>, mapRow<uint32> }
+};
+
 } // End of namespace Graphics
 
 #if defined(__clang__)
@@ -324,6 +324,146 @@ void BlendBlit::blitNEON(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_NEON>(args, blendMode, alphaType);
 }
 
+namespace {
+
+inline bool allZero(uint8x16_t v) {
+	const uint64x2_t v64 = vreinterpretq_u64_u8(v);
+	return (vgetq_lane_u64(v64, 0) | vgetq_lane_u64(v64, 1)) == 0;
+}
+
+inline bool allOnes(uint8x16_t v) {
+	const uint64x2_t v64 = vreinterpretq_u64_u8(v);
+	return (vgetq_lane_u64(v64, 0) & vgetq_lane_u64(v64, 1)) == ~(uint64)0;
+}
+
+template<int Size>
+inline uint8x16_t compareKey(uint8x16_t src, uint32 key) {
+	if (Size == 1)
+		return vceqq_u8(src, vdupq_n_u8(key));
+	else if (Size == 2)
+		return vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(src), vdupq_n_u16(key)));
+	else
+		return vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(src), vdupq_n_u32(key)));
+}
+
+template<typename Color>
+void keyRow(byte *dst, const byte *src, uint w, uint32 key) {
+	const int Size = sizeof(Color);
+	uint x = 0;
+
+	for (; x + 16 / Size <= w; x += 16 / Size) {
+		const uint8x16_t srcVec = vld1q_u8(src);
+		const uint8x16_t transparent = compareKey<Size>(srcVec, key);
+		if (allZero(transparent))
+			vst1q_u8(dst, srcVec);
+		else if (!allOnes(transparent))
+			vst1q_u8(dst, vbslq_u8(transparent, vld1q_u8(dst), srcVec));
+		src += 16;
+		dst += 16;
+	}
+
+	for (; x < w; ++x) {
+		const Color color = *(const Color *)src;
+		if (color != key)
+			*(Color *)dst = color;
+		src += Size;
+		dst += Size;
+	}
+}
+
+/**
+ * Blits 16 pixels from the source pixels in src, keeping the destination
+ * where the bytes of transparent are set.
+ */
+template<int Size>
+inline void blendPixels16(byte *dst, const byte *src, uint8x16_t transparent) {
+	if (Size == 1) {
+		vst1q_u8(dst, vbslq_u8(transparent, vld1q_u8(dst), vld1q_u8(src)));
+		return;
+	}
+
+	const int8x16_t t = vreinterpretq_s8_u8(transparent);
+	const int16x8_t t16[2] = { vmovl_s8(vget_low_s8(t)), vmovl_s8(vget_high_s8(t)) };
+	for (int i = 0; i < 2; ++i) {
+		if (Size == 2) {
+			const uint8x16_t m = vreinterpretq_u8_s16(t16[i]);
+			vst1q_u8(dst + i * 16, vbslq_u8(m, vld1q_u8(dst + i * 16), vld1q_u8(src + i * 16)));
+		} else {
+			const uint8x16_t m[2] = {
+				vreinterpretq_u8_s32(vmovl_s16(vget_low_s16(t16[i]))),
+				vreinterpretq_u8_s32(vmovl_s16(vget_high_s16(t16[i])))
+			};
+			for (int j = 0; j < 2; ++j) {
+				const int offset = (i * 2 + j) * 16;
+				vst1q_u8(dst + offset, vbslq_u8(m[j], vld1q_u8(dst + offset), vld1q_u8(src + offset)));
+			}
+		}
+	}
+}
+
+template<typename Color>
+void maskRow(byte *dst, const byte *src, const byte *mask, uint w) {
+	const int Size = sizeof(Color);
+	uint x = 0;
+
+	for (; x + 16 <= w; x += 16) {
+		const uint8x16_t transparent = vceqq_u8(vld1q_u8(mask), vdupq_n_u8(0));
+		if (allZero(transparent))
+			memcpy(dst, src, 16 * Size);
+		else if (!allOnes(transparent))
+			blendPixels16<Size>(dst, src, transparent);
+		src  += 16 * Size;
+		dst  += 16 * Size;
+		mask += 16;
+	}
+
+	for (; x < w; ++x) {
+		if (*mask)
+			*(Color *)dst = *(const Color *)src;
+		src  += Size;
+		dst  += Size;
+		mask += 1;
+	}
+}
+
+template<typename Color>
+void mapRow(byte *dst, const byte *src, const byte *mask, uint w, const uint32 *map, uint32 key) {
+	const int Size = sizeof(Color);
+	Color colors[16];
+	uint x = w;
+
+	// The source and the mask are read before anything is written, so
+	// that the row can be converted in place
+	while (x >= 16) {
+		x -= 16;
+		const uint8x16_t transparent = mask ? vceqq_u8(vld1q_u8(mask + x), vdupq_n_u8(0))
+		                                    : vceqq_u8(vld1q_u8(src + x), vdupq_n_u8(key));
+		if (allOnes(transparent))
+			continue;
+
+		for (int i = 0; i < 16; ++i)
+			colors[i] = map[src[x + i]];
+
+		if (allZero(transparent))
+			memcpy(dst + x * Size, colors, 16 * Size);
+		else
+			blendPixels16<Size>(dst + x * Size, (const byte *)colors, transparent);
+	}
+
+	while (x-- > 0) {
+		if (mask ? mask[x] != 0 : src[x] != key)
+			*(Color *)(dst + x * Size) = map[src[x]];
+	}
+}
+
+} // end of anonymous namespace
+
+const KeyMaskBlit::RowFuncs KeyMaskBlit::rowFuncsNEON = {
+	{ keyRow<uint8>, keyRow<uint16>, keyRow<uint32> },
+	{ maskRow<uint8>, maskRow<uint16>, maskRow<uint32> },
+	{ mapRow<uint8>, mapRow<uint16>, mapRow<uint32> }
+};
+
 } // end of namespace Graphics
 
 #if !defined(__aarch64__) && !defined(__ARM_NEON)
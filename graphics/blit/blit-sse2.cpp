@@ -326,6 +326,153 @@ void BlendBlit::blitSSE2(Args &args, const TSpriteBlendMode &blendMode, const Al
 	blitT<BlendBlitImpl_SSE2>(args, blendMode, alphaType);
 }
 
+namespace {
+
+/**
+ * Keeps the destination where the bytes of transparent are set, and takes
+ * the source everywhere else.
+ */
+inline __m128i blendTransparent(__m128i transparent, __m128i dst, __m128i src) {
+	return _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, src));
+}
+
+template<int Size>
+inline __m128i compareKey(__m128i src, __m128i key) {
+	if (Size == 1)
+		return _mm_cmpeq_epi8(src, key);
+	else if (Size == 2)
+		return _mm_cmpeq_epi16(src, key);
+	else
+		return _mm_cmpeq_epi32(src, key);
+}
+
+template<typename Color>
+void keyRow(byte *dst, const byte *src, uint w, uint32 key) {
+	const int Size = sizeof(Color);
+	const __m128i keyVec = Size == 1 ? _mm_set1_epi8((char)key) :
+	                       Size == 2 ? _mm_set1_epi16((short)key) : _mm_set1_epi32((int)key);
+	uint x = 0;
+
+	for (; x + 16 / Size <= w; x += 16 / Size) {
+		const __m128i srcVec = _mm_loadu_si128((const __m128i *)src);
+		const __m128i transparent = compareKey<Size>(srcVec, keyVec);
+		const int bits = _mm_movemask_epi8(transparent);
+		if (bits == 0)
+			_mm_storeu_si128((__m128i *)dst, srcVec);
+		else if (bits != 0xFFFF)
+			_mm_storeu_si128((__m128i *)dst, blendTransparent(transparent, _mm_loadu_si128((const __m128i *)dst), srcVec));
+		src += 16;
+		dst += 16;
+	}
+
+	for (; x < w; ++x) {
+		const Color color = *(const Color *)src;
+		if (color != key)
+			*(Color *)dst = color;
+		src += Size;
+		dst += Size;
+	}
+}
+
+/**
+ * Blits 16 pixels from the source pixels in src, keeping the destination
+ * where the bytes of transparent are set.
+ */
+template<int Size>
+inline void blendPixels16(byte *dst, const byte *src, __m128i transparent) {
+	if (Size == 1) {
+		const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+		_mm_storeu_si128((__m128i *)dst, blendTransparent(transparent, d, _mm_loadu_si128((const __m128i *)src)));
+		return;
+	}
+
+	const __m128i lo = _mm_unpacklo_epi8(transparent, transparent);
+	const __m128i hi = _mm_unpackhi_epi8(transparent, transparent);
+	if (Size == 2) {
+		_mm_storeu_si128((__m128i *)dst, blendTransparent(lo, _mm_loadu_si128((const __m128i *)dst),
+		                                                  _mm_loadu_si128((const __m128i *)src)));
+		_mm_storeu_si128((__m128i *)dst + 1, blendTransparent(hi, _mm_loadu_si128((const __m128i *)dst + 1),
+		                                                      _mm_loadu_si128((const __m128i *)src + 1)));
+	} else {
+		const __m128i t[4] = {
+			_mm_unpacklo_epi16(lo, lo), _mm_unpackhi_epi16(lo, lo),
+			_mm_unpacklo_epi16(hi, hi), _mm_unpackhi_epi16(hi, hi)
+		};
+		for (int i = 0; i < 4; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, blendTransparent(t[i], _mm_loadu_si128((const __m128i *)dst + i),
+			                                                      _mm_loadu_si128((const __m128i *)src + i)));
+	}
+}
+
+template<typename Color>
+void maskRow(byte *dst, const byte *src, const byte *mask, uint w) {
+	const int Size = sizeof(Color);
+	const __m128i zero = _mm_setzero_si128();
+	uint x = 0;
+
+	for (; x + 16 <= w; x += 16) {
+		const __m128i transparent = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)mask), zero);
+		const int bits = _mm_movemask_epi8(transparent);
+		if (bits == 0)
+			memcpy(dst, src, 16 * Size);
+		else if (bits != 0xFFFF)
+			blendPixels16<Size>(dst, src, transparent);
+		src  += 16 * Size;
+		dst  += 16 * Size;
+		mask += 16;
+	}
+
+	for (; x < w; ++x) {
+		if (*mask)
+			*(Color *)dst = *(const Color *)src;
+		src  += Size;
+		dst  += Size;
+		mask += 1;
+	}
+}
+
+template<typename Color>
+void mapRow(byte *dst, const byte *src, const byte *mask, uint w, const uint32 *map, uint32 key) {
+	const int Size = sizeof(Color);
+	const __m128i keyVec = _mm_set1_epi8((char)key);
+	const __m128i zero = _mm_setzero_si128();
+	Color colors[16];
+	uint x = w;
+
+	// The source and the mask are read before anything is written, so
+	// that the row can be converted in place
+	while (x >= 16) {
+		x -= 16;
+		const __m128i srcVec = _mm_loadu_si128((const __m128i *)(src + x));
+		const __m128i transparent = mask ? _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(mask + x)), zero)
+		                                 : _mm_cmpeq_epi8(srcVec, keyVec);
+		const int bits = _mm_movemask_epi8(transparent);
+		if (bits == 0xFFFF)
+			continue;
+
+		for (int i = 0; i < 16; ++i)
+			colors[i] = map[src[x + i]];
+
+		if (bits == 0)
+			memcpy(dst + x * Size, colors, 16 * Size);
+		else
+			blendPixels16<Size>(dst + x * Size, (const byte *)colors, transparent);
+	}
+
+	while (x-- > 0) {
+		if (mask ? mask[x] != 0 : src[x] != key)
+			*(Color *)(dst + x * Size) = map[src[x]];
+	}
+}
+
+} // End of anonymous namespace
+
+const KeyMaskBlit::RowFuncs KeyMaskBlit::rowFuncsSSE2 = {
+	{ keyRow<uint8>, keyRow<uint16>, keyRow<uint32> },
+	{ maskRow<uint8>, maskRow<uint16>, maskRow<uint32> },
+	{ mapRow<uint8>, mapRow<uint16>, mapRow<uint32> }
+};
+
 } // End of namespace Graphics
 
 #if !defined(__x86_64__)
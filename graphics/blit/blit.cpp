@@ -22,9 +22,31 @@
 #include "graphics/blit.h"
 #include "graphics/pixelformat.h"
 #include "common/endian.h"
+#include "common/system.h"
 
 namespace Graphics {
 
+const KeyMaskBlit::RowFuncs *KeyMaskBlit::rowFuncs = nullptr;
+bool KeyMaskBlit::rowFuncsSelected = false;
+
+const KeyMaskBlit::RowFuncs *KeyMaskBlit::getRowFuncs() {
+	// Detect the CPU features the first time, like BlendBlit::blit() does
+	if (!rowFuncsSelected) {
+#ifdef SCUMMVM_NEON
+		if (g_system->hasFeature(OSystem::kFeatureCpuNEON)) rowFuncs = &rowFuncsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+		if (g_system->hasFeature(OSystem::kFeatureCpuSSE2)) rowFuncs = &rowFuncsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+		if (g_system->hasFeature(OSystem::kFeatureCpuAVX2)) rowFuncs = &rowFuncsAVX2;
+#endif
+		rowFuncsSelected = true;
+	}
+
+	return rowFuncs;
+}
+
 // see graphics/blit/blit-atari.cpp
 #ifndef ATARI
 // Function to blit a rect
@@ -88,6 +110,21 @@ bool keyBlit(byte *dst, const byte *src,
 	if (dst == src)
 		return true;
 
+	// The vectorized rows compare whole pixels, so the key has to fit in one
+	const KeyMaskBlit::RowFuncs *rowFuncs = nullptr;
+	if (bytesPerPixel == 4 || ((bytesPerPixel == 1 || bytesPerPixel == 2) && !(key >> (bytesPerPixel * 8))))
+		rowFuncs = KeyMaskBlit::getRowFuncs();
+
+	if (rowFuncs) {
+		const KeyMaskBlit::KeyRowFunc keyRow = rowFuncs->keyRow[bytesPerPixel >> 1];
+		for (uint y = 0; y < h; ++y) {
+			keyRow(dst, src, w, key);
+			src += srcPitch;
+			dst += dstPitch;
+		}
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * bytesPerPixel);
@@ -143,6 +180,21 @@ bool maskBlit(byte *dst, const byte *src, const byte *mask,
 	if (dst == src)
 		return true;
 
+	const KeyMaskBlit::RowFuncs *rowFuncs = nullptr;
+	if (bytesPerPixel == 1 || bytesPerPixel == 2 || bytesPerPixel == 4)
+		rowFuncs = KeyMaskBlit::getRowFuncs();
+
+	if (rowFuncs) {
+		const KeyMaskBlit::MaskRowFunc maskRow = rowFuncs->maskRow[bytesPerPixel >> 1];
+		for (uint y = 0; y < h; ++y) {
+			maskRow(dst, src, mask, w);
+			src  += srcPitch;
+			dst  += dstPitch;
+			mask += maskPitch;
+		}
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta  = (srcPitch  - w * bytesPerPixel);
 	const uint dstDelta  = (dstPitch  - w * bytesPerPixel);
@@ -394,6 +446,28 @@ inline bool crossBlitMapHelperLogic(byte *dst, const byte *src, const byte *mask
 						   const uint bytesPerPixel, const uint32 *map,
 						   const uint srcPitch, const uint dstPitch, const uint maskPitch,
 						   const uint32 key) {
+	// The vectorized rows handle either a color key or a mask, with keys
+	// which fit in a CLUT8 pixel
+	const KeyMaskBlit::RowFuncs *rowFuncs = nullptr;
+	if ((hasKey != hasMask) && (!hasKey || key <= 0xFF) &&
+	    (bytesPerPixel == 1 || bytesPerPixel == 2 || bytesPerPixel == 4))
+		rowFuncs = KeyMaskBlit::getRowFuncs();
+
+	if (rowFuncs) {
+		const KeyMaskBlit::MapRowFunc mapRow = rowFuncs->mapRow[bytesPerPixel >> 1];
+
+		// Each row is blitted from right to left, and from the bottom row
+		// up when the pixels grow, for the same reason as below
+		if (bytesPerPixel == 1) {
+			for (uint y = 0; y < h; ++y)
+				mapRow(dst + y * dstPitch, src + y * srcPitch, hasMask ? mask + y * maskPitch : nullptr, w, map, key);
+		} else {
+			for (uint y = h; y-- > 0; )
+				mapRow(dst + y * dstPitch, src + y * srcPitch, hasMask ? mask + y * maskPitch : nullptr, w, map, key);
+		}
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta  = (srcPitch  - w);
 	const uint dstDelta  = (dstPitch  - w * bytesPerPixel);
@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/framediff.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+void FrameDiff::diffRowNEON(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty) {
+	// A tile is a multiple of 16 bytes wide, except for the last one
+	const uint fullBytes = rowBytes - rowBytes % tileBytes;
+
+	uint offset = 0;
+	for (; offset < fullBytes; offset += tileBytes, dirty++) {
+		if (*dirty)
+			continue;
+
+		uint8x16_t diff = vdupq_n_u8(0);
+		for (uint i = 0; i < tileBytes; i += 16)
+			diff = vorrq_u8(diff, veorq_u8(vld1q_u8(frame + offset + i), vld1q_u8(previous + offset + i)));
+
+		const uint64x2_t diff64 = vreinterpretq_u64_u8(diff);
+		if (vgetq_lane_u64(diff64, 0) | vgetq_lane_u64(diff64, 1))
+			*dirty = 1;
+	}
+
+	if (offset < rowBytes && !*dirty && memcmp(frame + offset, previous + offset, rowBytes - offset) != 0)
+		*dirty = 1;
+}
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
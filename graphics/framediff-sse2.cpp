@@ -0,0 +1,75 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/framediff.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+void FrameDiff::diffRowSSE2(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty) {
+	// A tile is a multiple of 16 bytes wide, except for the last one
+	const uint fullBytes = rowBytes - rowBytes % tileBytes;
+
+	uint offset = 0;
+	for (; offset < fullBytes; offset += tileBytes, dirty++) {
+		if (*dirty)
+			continue;
+
+		__m128i diff = _mm_setzero_si128();
+		for (uint i = 0; i < tileBytes; i += 16) {
+			const __m128i a = _mm_loadu_si128((const __m128i *)(frame + offset + i));
+			const __m128i b = _mm_loadu_si128((const __m128i *)(previous + offset + i));
+			diff = _mm_or_si128(diff, _mm_xor_si128(a, b));
+		}
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF)
+			*dirty = 1;
+	}
+
+	if (offset < rowBytes && !*dirty && memcmp(frame + offset, previous + offset, rowBytes - offset) != 0)
+		*dirty = 1;
+}
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,142 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphics/framediff.h"
+#include "common/system.h"
+
+namespace Graphics {
+
+FrameDiff::FrameDiff() : _diffRow(nullptr), _hasPrevious(false), _comparedTiles(0), _skippedTiles(0) {
+}
+
+FrameDiff::~FrameDiff() {
+	free();
+}
+
+void FrameDiff::reset(int width, int height, const PixelFormat &format) {
+	if (!_diffRow) {
+		_diffRow = diffRowGeneric;
+#ifdef SCUMMVM_NEON
+		if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+			_diffRow = diffRowNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+		if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+			_diffRow = diffRowSSE2;
+#endif
+	}
+
+	_previous.create(width, height, format);
+	_hasPrevious = false;
+
+	const uint numColumns = (width + kTileSize - 1) / kTileSize;
+	_dirty.resize(numColumns);
+	_openRects.resize(numColumns);
+	_nextOpenRects.resize(numColumns);
+}
+
+void FrameDiff::free() {
+	_previous.free();
+	_hasPrevious = false;
+}
+
+void FrameDiff::compare(const Surface &frame, const Common::Rect &area, Common::Array<Common::Rect> &rects) {
+	assert(frame.w == _previous.w && frame.h == _previous.h && frame.format == _previous.format);
+
+	if (!_hasPrevious) {
+		const Common::Rect all(frame.w, frame.h);
+		copyToPrevious(frame, all);
+		rects.push_back(all);
+		_hasPrevious = true;
+		return;
+	}
+
+	Common::Rect clipped(area);
+	clipped.clip(Common::Rect(frame.w, frame.h));
+	if (clipped.isEmpty())
+		return;
+
+	const uint tileBytes = kTileSize * frame.format.bytesPerPixel;
+	const int firstColumn = clipped.left / kTileSize;
+	const uint numColumns = (clipped.right - 1) / kTileSize - firstColumn + 1;
+	const int left = firstColumn * kTileSize;
+	const int right = MIN<int>(left + numColumns * kTileSize, frame.w);
+	const uint rowBytes = (right - left) * frame.format.bytesPerPixel;
+
+	// The rect of the previous tile row which starts at each column, so that
+	// runs of tiles with the same columns are merged into one rect
+	for (uint column = 0; column < numColumns; column++)
+		_openRects[column] = -1;
+
+	for (int top = clipped.top - clipped.top % kTileSize; top < clipped.bottom; top += kTileSize) {
+		const int bottom = MIN<int>(top + kTileSize, frame.h);
+
+		memset(_dirty.data(), 0, numColumns);
+		for (int y = top; y < bottom; y++)
+			_diffRow((const byte *)frame.getBasePtr(left, y), (const byte *)_previous.getBasePtr(left, y), tileBytes, rowBytes, _dirty.data());
+
+		for (uint column = 0; column < numColumns; column++)
+			_nextOpenRects[column] = -1;
+
+		_comparedTiles += numColumns;
+		uint column = 0;
+		while (column < numColumns) {
+			if (!_dirty[column]) {
+				_skippedTiles++;
+				column++;
+				continue;
+			}
+
+			uint end = column + 1;
+			while (end < numColumns && _dirty[end])
+				end++;
+
+			const Common::Rect run(left + column * kTileSize, top, MIN<int>(left + end * kTileSize, right), bottom);
+			copyToPrevious(frame, run);
+
+			int index = _openRects[column];
+			if (index >= 0 && rects[index].right == run.right) {
+				rects[index].bottom = run.bottom;
+			} else {
+				index = rects.size();
+				rects.push_back(run);
+			}
+			_nextOpenRects[column] = index;
+
+			column = end;
+		}
+
+		_openRects.swap(_nextOpenRects);
+	}
+}
+
+void FrameDiff::copyToPrevious(const Surface &frame, const Common::Rect &rect) {
+	_previous.copyRectToSurface(frame, rect.left, rect.top, rect);
+}
+
+void FrameDiff::diffRowGeneric(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty) {
+	for (uint offset = 0; offset < rowBytes; offset += tileBytes, dirty++) {
+		if (!*dirty && memcmp(frame + offset, previous + offset, MIN(tileBytes, rowBytes - offset)) != 0)
+			*dirty = 1;
+	}
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,109 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_FRAMEDIFF_H
+#define GRAPHICS_FRAMEDIFF_H
+
+#include "common/array.h"
+#include "common/rect.h"
+#include "graphics/surface.h"
+
+class FrameDiffTestSuite;
+
+namespace Graphics {
+
+/**
+ * Finds the parts of a frame which changed since the previous one.
+ *
+ * The frame is compared with a copy of the previous one in tiles of
+ * kTileSize x kTileSize pixels, and the changed tiles are merged into as few
+ * rects as is cheap to find. This lets backends skip the scaling and upload
+ * of screen areas which engines redraw with the same pixels every frame.
+ */
+class FrameDiff {
+public:
+	enum {
+		kTileSize = 16
+	};
+
+	FrameDiff();
+	~FrameDiff();
+
+	/**
+	 * Set the size and format of the frames. The previous frame is
+	 * forgotten, so all of the next one is reported as changed.
+	 */
+	void reset(int width, int height, const PixelFormat &format);
+
+	/** Free the copy of the previous frame. */
+	void free();
+
+	/**
+	 * Compare a frame with the previous one, and keep it for the next call.
+	 *
+	 * @param frame The frame, with the size and format given to reset().
+	 * @param area  The part of the frame which may have changed. Only the
+	 *              tiles it touches are compared.
+	 * @param rects The changed parts of the frame are appended to this, as
+	 *              rects made of whole tiles, clipped to the frame.
+	 */
+	void compare(const Surface &frame, const Common::Rect &area, Common::Array<Common::Rect> &rects);
+
+	/** Return the number of tiles which were compared. */
+	uint32 getComparedTiles() const { return _comparedTiles; }
+
+	/** Return the number of compared tiles which were unchanged. */
+	uint32 getSkippedTiles() const { return _skippedTiles; }
+
+	/**
+	 * Compare the rows of a run of tiles, and set dirty[i] for each tile
+	 * whose bytes differ. Tiles for which dirty[i] is already set are
+	 * skipped. The last tile may be shorter than @p tileBytes.
+	 */
+	typedef void (*DiffRowProc)(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty);
+
+private:
+	friend class ::FrameDiffTestSuite;
+
+	static void diffRowGeneric(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty);
+#ifdef SCUMMVM_NEON
+	static void diffRowNEON(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void diffRowSSE2(const byte *frame, const byte *previous, uint tileBytes, uint rowBytes, byte *dirty);
+#endif
+
+	void copyToPrevious(const Surface &frame, const Common::Rect &rect);
+
+	DiffRowProc _diffRow;
+	Surface _previous;
+	bool _hasPrevious;
+
+	Common::Array<byte> _dirty;
+	Common::Array<int> _openRects, _nextOpenRects;
+
+	uint32 _comparedTiles;
+	uint32 _skippedTiles;
+};
+
+} // End of namespace Graphics
+
+#endif
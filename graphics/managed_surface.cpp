@@ -863,6 +863,74 @@ void transBlit(const Surface &src, const Common::Rect &srcRect, ManagedSurface &
 	delete[] lookup;
 }
 
+/**
+ * Handles the unscaled blits which only skip the pixels of the transparent
+ * color, and otherwise copy or map them, with the color key blitters.
+ * Returns false for anything the generic transBlit() has to handle.
+ */
+static bool transBlitKeyed(const Surface &src, const Common::Rect &srcRect, ManagedSurface &dest, const Common::Rect &destRect,
+		uint32 transColor, bool flipped, uint32 srcAlpha, const Palette *srcPalette, const Palette *dstPalette) {
+	if (flipped || srcRect.width() != destRect.width() || srcRect.height() != destRect.height())
+		return false;
+
+	const PixelFormat &srcFormat = src.format;
+	const PixelFormat &destFormat = dest.format;
+	uint32 map[256];
+	bool useMap = false;
+
+	if (srcFormat.isCLUT8() && destFormat.isCLUT8()) {
+		if (srcAlpha == 0)
+			return false;
+
+		if (srcPalette && dstPalette) {
+			byte *lookup = createPaletteLookup(srcPalette, dstPalette);
+			if (lookup) {
+				for (uint i = 0; i < 256; i++)
+					map[i] = i < srcPalette->size() ? lookup[i] : i;
+				useMap = true;
+				delete[] lookup;
+			}
+		}
+	} else if (srcFormat.isCLUT8()) {
+		if (srcAlpha != 0xff || !srcPalette || (destFormat.bytesPerPixel != 2 && destFormat.bytesPerPixel != 4))
+			return false;
+
+		// Opaque palette colors, as transBlitPixel() would write them
+		memset(map, 0, sizeof(map));
+		convertPaletteToMap(map, srcPalette->data(), MIN<uint>(srcPalette->size(), 256), destFormat);
+		useMap = true;
+	} else {
+		// Without an alpha channel or unused bits, the decoded pixels are
+		// written back unchanged
+		if (srcAlpha != 0xff || srcFormat != destFormat || srcFormat.aBits() != 0 ||
+		    srcFormat.rBits() + srcFormat.gBits() + srcFormat.bBits() != srcFormat.bytesPerPixel * 8)
+			return false;
+	}
+
+	// Clip to the destination, which transBlit() does pixel by pixel
+	Common::Rect clipped = destRect;
+	clipped.clip(Common::Rect(dest.w, dest.h));
+	if (clipped.isEmpty())
+		return true;
+
+	const byte *srcPixels = (const byte *)src.getBasePtr(srcRect.left + clipped.left - destRect.left,
+	                                                     srcRect.top + clipped.top - destRect.top);
+	byte *destPixels = (byte *)dest.getBasePtr(clipped.left, clipped.top);
+
+	if (useMap) {
+		crossKeyBlitMap(destPixels, srcPixels, dest.pitch, src.pitch, clipped.width(), clipped.height(),
+		                destFormat.bytesPerPixel, map, (byte)transColor);
+	} else {
+		// The transparent color is compared with pixels of the source size
+		const uint32 key = srcFormat.bytesPerPixel == 4 ? transColor :
+		                   transColor & ((1 << (srcFormat.bytesPerPixel * 8)) - 1);
+		keyBlit(destPixels, srcPixels, dest.pitch, src.pitch, clipped.width(), clipped.height(),
+		        srcFormat.bytesPerPixel, key);
+	}
+
+	return true;
+}
+
 #define HANDLE_BLIT(SRC_BYTES, DEST_BYTES, SRC_TYPE, DEST_TYPE) \
 	if (src.format.bytesPerPixel == SRC_BYTES && format.bytesPerPixel == DEST_BYTES) \
 		transBlit<SRC_TYPE, DEST_TYPE>(src, srcRect, *this, destRect, transColor, flipped, srcAlpha, srcPalette, dstPalette); \
@@ -874,6 +942,11 @@ void ManagedSurface::transBlitFromInner(const Surface &src, const Common::Rect &
 	if (src.w == 0 || src.h == 0 || destRect.width() == 0 || destRect.height() == 0)
 		return;
 
+	if (transBlitKeyed(src, srcRect, *this, destRect, transColor, flipped, srcAlpha, srcPalette, dstPalette)) {
+		addDirtyRect(destRect);
+		return;
+	}
+
 	HANDLE_BLIT(1, 1, uint8,  uint8)
 	HANDLE_BLIT(1, 2, uint8,  uint16)
 	HANDLE_BLIT(1, 4, uint8,  uint32)
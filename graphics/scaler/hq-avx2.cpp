@@ -0,0 +1,72 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/scaler/hq.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+// Return bit for the pixels whose neighbour differs by more than the
+// thresholds of diffYUV(), which are 0x30 for Y, 7 for U and 6 for V
+static FORCEINLINE __m256i diffYUV_AVX2(__m256i yuv5, const uint32 *neighbours, __m256i bit) {
+	const __m256i threshold = _mm256_set1_epi32(0x00300706);
+	const __m256i yuv = _mm256_loadu_si256((const __m256i *)neighbours);
+	const __m256i diff = _mm256_or_si256(_mm256_subs_epu8(yuv5, yuv), _mm256_subs_epu8(yuv, yuv5));
+	const __m256i over = _mm256_subs_epu8(diff, threshold);
+	return _mm256_andnot_si256(_mm256_cmpeq_epi32(over, _mm256_setzero_si256()), bit);
+}
+
+void HQScaler::patternsAVX2(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width) {
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const __m256i yuv5 = _mm256_loadu_si256((const __m256i *)(yuv + x));
+
+		__m256i pattern = diffYUV_AVX2(yuv5, yuvAbove + x - 1, _mm256_set1_epi32(0x01));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuvAbove + x, _mm256_set1_epi32(0x02)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuvAbove + x + 1, _mm256_set1_epi32(0x04)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuv + x - 1, _mm256_set1_epi32(0x08)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuv + x + 1, _mm256_set1_epi32(0x10)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuvBelow + x - 1, _mm256_set1_epi32(0x20)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuvBelow + x, _mm256_set1_epi32(0x40)));
+		pattern = _mm256_or_si256(pattern, diffYUV_AVX2(yuv5, yuvBelow + x + 1, _mm256_set1_epi32(0x80)));
+
+		// The 256-bit packs work within each 128-bit half, so pack the halves
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(pattern), _mm256_extracti128_si256(pattern, 1));
+		packed = _mm_packus_epi16(packed, packed);
+		_mm_storel_epi64((__m128i *)(patterns + x), packed);
+	}
+
+	patternsGeneric(yuvAbove + x, yuv + x, yuvBelow + x, patterns + x, width - x);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,83 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/scaler/hq.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+// Return bit for the pixels whose neighbour differs by more than the
+// thresholds of diffYUV(), which are 0x30 for Y, 7 for U and 6 for V
+static inline uint32x4_t diffYUV_NEON(uint8x16_t yuv5, const uint32 *neighbours, uint32 bit) {
+	const uint8x16_t threshold = vreinterpretq_u8_u32(vdupq_n_u32(0x00300706));
+	const uint8x16_t yuv = vreinterpretq_u8_u32(vld1q_u32(neighbours));
+	const uint8x16_t over = vqsubq_u8(vabdq_u8(yuv5, yuv), threshold);
+	return vbicq_u32(vdupq_n_u32(bit), vceqq_u32(vreinterpretq_u32_u8(over), vdupq_n_u32(0)));
+}
+
+void HQScaler::patternsNEON(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width) {
+	int x = 0;
+	for (; x + 4 <= width; x += 4) {
+		const uint8x16_t yuv5 = vreinterpretq_u8_u32(vld1q_u32(yuv + x));
+
+		uint32x4_t pattern = diffYUV_NEON(yuv5, yuvAbove + x - 1, 0x01);
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuvAbove + x, 0x02));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuvAbove + x + 1, 0x04));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuv + x - 1, 0x08));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuv + x + 1, 0x10));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuvBelow + x - 1, 0x20));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuvBelow + x, 0x40));
+		pattern = vorrq_u32(pattern, diffYUV_NEON(yuv5, yuvBelow + x + 1, 0x80));
+
+		const uint16x4_t narrow = vmovn_u32(pattern);
+		uint8 bytes[8];
+		vst1_u8(bytes, vmovn_u16(vcombine_u16(narrow, narrow)));
+		memcpy(patterns + x, bytes, 4);
+	}
+
+	patternsGeneric(yuvAbove + x, yuv + x, yuvBelow + x, patterns + x, width - x);
+}
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,80 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+#include "common/endian.h"
+
+#include "graphics/scaler/hq.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+// Return bit for the pixels whose neighbour differs by more than the
+// thresholds of diffYUV(), which are 0x30 for Y, 7 for U and 6 for V
+static FORCEINLINE __m128i diffYUV_SSE2(__m128i yuv5, const uint32 *neighbours, __m128i bit) {
+	const __m128i threshold = _mm_set1_epi32(0x00300706);
+	const __m128i yuv = _mm_loadu_si128((const __m128i *)neighbours);
+	const __m128i diff = _mm_or_si128(_mm_subs_epu8(yuv5, yuv), _mm_subs_epu8(yuv, yuv5));
+	const __m128i over = _mm_subs_epu8(diff, threshold);
+	return _mm_andnot_si128(_mm_cmpeq_epi32(over, _mm_setzero_si128()), bit);
+}
+
+void HQScaler::patternsSSE2(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width) {
+	int x = 0;
+	for (; x + 4 <= width; x += 4) {
+		const __m128i yuv5 = _mm_loadu_si128((const __m128i *)(yuv + x));
+
+		__m128i pattern = diffYUV_SSE2(yuv5, yuvAbove + x - 1, _mm_set1_epi32(0x01));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuvAbove + x, _mm_set1_epi32(0x02)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuvAbove + x + 1, _mm_set1_epi32(0x04)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuv + x - 1, _mm_set1_epi32(0x08)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuv + x + 1, _mm_set1_epi32(0x10)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuvBelow + x - 1, _mm_set1_epi32(0x20)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuvBelow + x, _mm_set1_epi32(0x40)));
+		pattern = _mm_or_si128(pattern, diffYUV_SSE2(yuv5, yuvBelow + x + 1, _mm_set1_epi32(0x80)));
+
+		pattern = _mm_packs_epi32(pattern, pattern);
+		pattern = _mm_packus_epi16(pattern, pattern);
+		WRITE_UINT32(patterns + x, _mm_cvtsi128_si32(pattern));
+	}
+
+	patternsGeneric(yuvAbove + x, yuv + x, yuvBelow + x, patterns + x, width - x);
+}
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -21,6 +21,7 @@
 #include "graphics/scaler/hq.h"
 #include "graphics/scaler.h"
 #include "graphics/scaler/intern.h"
+#include "common/system.h"
 
 // RGB-to-YUV lookup table
 
@@ -173,7 +174,17 @@ void HQScaler::initLUT(Graphics::PixelFormat format) {
 #define PIXEL11_90	*(q+1+nextlineDst) = interpolate_2_3_3(w5, w6, w8);
 #define PIXEL11_100	*(q+1+nextlineDst) = interpolate_14_1_1(w5, w6, w8);
 
-#define YUV(x)	(sizeof(Pixel) == 2 ? RGBtoYUV[w ## x] : ConvertYUV<ColorMask>(w ## x, RGBtoYUV))
+// The YUV values of w1 to w9, from the rows computed by convertRowYUV()
+#define YUV(x)	YUV_ ## x
+#define YUV_1	yuvAbove[-1]
+#define YUV_2	yuvAbove[0]
+#define YUV_3	yuvAbove[1]
+#define YUV_4	yuvRow[-1]
+#define YUV_5	yuvRow[0]
+#define YUV_6	yuvRow[1]
+#define YUV_7	yuvBelow[-1]
+#define YUV_8	yuvBelow[0]
+#define YUV_9	yuvBelow[1]
 
 /**
  * Convert 32 bit RGB values to Yuv
@@ -193,13 +204,42 @@ static inline uint32 ConvertYUV(uint32 x, const uint32 *RGBtoYUV) {
 	return RGBtoYUV[r | g | b];
 }
 
+/**
+ * Convert a row of pixels to YUV, including the pixels left and right of it.
+ */
+template<typename ColorMask>
+static void convertRowYUV(const typename ColorMask::PixelType *p, uint32 *yuv, int width, const uint32 *RGBtoYUV) {
+	for (int x = -1; x <= width; x++) {
+		if (sizeof(typename ColorMask::PixelType) == 2)
+			yuv[x] = RGBtoYUV[p[x]];
+		else
+			yuv[x] = ConvertYUV<ColorMask>(p[x], RGBtoYUV);
+	}
+}
+
+void HQScaler::patternsGeneric(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width) {
+	for (int x = 0; x < width; x++) {
+		const uint32 yuv5 = yuv[x];
+		uint8 pattern = 0;
+		if (diffYUV(yuv5, yuvAbove[x - 1])) pattern |= 0x0001;
+		if (diffYUV(yuv5, yuvAbove[x])) pattern |= 0x0002;
+		if (diffYUV(yuv5, yuvAbove[x + 1])) pattern |= 0x0004;
+		if (diffYUV(yuv5, yuv[x - 1])) pattern |= 0x0008;
+		if (diffYUV(yuv5, yuv[x + 1])) pattern |= 0x0010;
+		if (diffYUV(yuv5, yuvBelow[x - 1])) pattern |= 0x0020;
+		if (diffYUV(yuv5, yuvBelow[x])) pattern |= 0x0040;
+		if (diffYUV(yuv5, yuvBelow[x + 1])) pattern |= 0x0080;
+		patterns[x] = pattern;
+	}
+}
+
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (https://web.archive.org/web/20090204033742/http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, HQScaler::PatternProc patternProc) {
 	typedef typename ColorMask::PixelType Pixel;
 
 	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
@@ -221,7 +261,28 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	// The YUV values of the rows above, at and below the current one, with
+	// room for the pixels left and right of them. The pattern of differing
+	// neighbours is found for a whole row at a time, so that patternProc can
+	// compare several pixels at once.
+	uint32 *yuvRows = new uint32[3 * (width + 2)];
+	uint32 *yuvAboveRow = yuvRows + 1;
+	uint32 *yuvCurrentRow = yuvAboveRow + width + 2;
+	uint32 *yuvBelowRow = yuvCurrentRow + width + 2;
+	uint8 *patterns = new uint8[width];
+
+	convertRowYUV<ColorMask>(p - nextlineSrc, yuvAboveRow, width, RGBtoYUV);
+	convertRowYUV<ColorMask>(p, yuvCurrentRow, width, RGBtoYUV);
+
 	while (height--) {
+		convertRowYUV<ColorMask>(p + nextlineSrc, yuvBelowRow, width, RGBtoYUV);
+		patternProc(yuvAboveRow, yuvCurrentRow, yuvBelowRow, patterns, width);
+
+		const uint32 *yuvAbove = yuvAboveRow;
+		const uint32 *yuvRow = yuvCurrentRow;
+		const uint32 *yuvBelow = yuvBelowRow;
+		const uint8 *pattern = patterns;
+
 		w1 = *(p - 1 - nextlineSrc);
 		w4 = *(p - 1);
 		w7 = *(p - 1 + nextlineSrc);
@@ -238,18 +299,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
-
-			switch (pattern) {
+			switch (*pattern++) {
 			case 0:
 			case 1:
 			case 4:
@@ -2049,11 +2099,22 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w5 = w6;
 			w8 = w9;
 
+			yuvAbove++;
+			yuvRow++;
+			yuvBelow++;
 			q += 2;
 		}
 		p += nextlineSrc - width;
 		q += (nextlineDst - width) * 2;
+
+		uint32 *yuvFree = yuvAboveRow;
+		yuvAboveRow = yuvCurrentRow;
+		yuvCurrentRow = yuvBelowRow;
+		yuvBelowRow = yuvFree;
 	}
+
+	delete[] yuvRows;
+	delete[] patterns;
 }
 
 #define PIXEL00_1M  *(q) = interpolate_3_1(w5, w1);
@@ -2116,7 +2177,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, HQScaler::PatternProc patternProc) {
 	typedef typename ColorMask::PixelType Pixel;
 
 	int  w1, w2, w3, w4, w5, w6, w7, w8, w9;
@@ -2139,7 +2200,28 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	// The YUV values of the rows above, at and below the current one, with
+	// room for the pixels left and right of them. The pattern of differing
+	// neighbours is found for a whole row at a time, so that patternProc can
+	// compare several pixels at once.
+	uint32 *yuvRows = new uint32[3 * (width + 2)];
+	uint32 *yuvAboveRow = yuvRows + 1;
+	uint32 *yuvCurrentRow = yuvAboveRow + width + 2;
+	uint32 *yuvBelowRow = yuvCurrentRow + width + 2;
+	uint8 *patterns = new uint8[width];
+
+	convertRowYUV<ColorMask>(p - nextlineSrc, yuvAboveRow, width, RGBtoYUV);
+	convertRowYUV<ColorMask>(p, yuvCurrentRow, width, RGBtoYUV);
+
 	while (height--) {
+		convertRowYUV<ColorMask>(p + nextlineSrc, yuvBelowRow, width, RGBtoYUV);
+		patternProc(yuvAboveRow, yuvCurrentRow, yuvBelowRow, patterns, width);
+
+		const uint32 *yuvAbove = yuvAboveRow;
+		const uint32 *yuvRow = yuvCurrentRow;
+		const uint32 *yuvBelow = yuvBelowRow;
+		const uint8 *pattern = patterns;
+
 		w1 = *(p - 1 - nextlineSrc);
 		w4 = *(p - 1);
 		w7 = *(p - 1 + nextlineSrc);
@@ -2156,18 +2238,7 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
-
-			switch (pattern) {
+			switch (*pattern++) {
 			case 0:
 			case 1:
 			case 4:
@@ -4940,18 +5011,29 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w5 = w6;
 			w8 = w9;
 
+			yuvAbove++;
+			yuvRow++;
+			yuvBelow++;
 			q += 3;
 		}
 		p += nextlineSrc - width;
 		q += (nextlineDst - width) * 3;
+
+		uint32 *yuvFree = yuvAboveRow;
+		yuvAboveRow = yuvCurrentRow;
+		yuvCurrentRow = yuvBelowRow;
+		yuvBelowRow = yuvFree;
 	}
+
+	delete[] yuvRows;
+	delete[] patterns;
 }
 
 HQScaler::HQScaler(const Graphics::PixelFormat &format) : Scaler(format),
 #ifdef USE_NASM
 	_hqx_params(nullptr),
 #endif
-	_RGBtoYUV(nullptr) {
+	_RGBtoYUV(nullptr), _patternProc(nullptr) {
 	_factor = 2;
 
 	if (format.bytesPerPixel == 2) {
@@ -4987,19 +5069,19 @@ void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 void HQScaler::HQ2x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 	else
 		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 }
 
 void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ3x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 	else
 		HQ3x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 }
 #endif
 
@@ -5007,15 +5089,15 @@ void HQScaler::HQ2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ2x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternProc);
 		} else {
 			HQ2x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternProc);
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ2x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 	}
 }
 
@@ -5023,20 +5105,37 @@ void HQScaler::HQ3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ3x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternProc);
 		} else {
 			HQ3x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _patternProc);
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ3x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _patternProc);
 	}
 }
 
 void HQScaler::scaleIntern(const uint8 *srcPtr, uint32 srcPitch,
 							uint8 *dstPtr, uint32 dstPitch, int width, int height, int x, int y) {
+	// If no function has been selected yet, detect and select
+	if (!_patternProc) {
+		_patternProc = patternsGeneric;
+#ifdef SCUMMVM_NEON
+		if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+			_patternProc = patternsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+		if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+			_patternProc = patternsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+		if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+			_patternProc = patternsAVX2;
+#endif
+	}
+
 	if (_format.bytesPerPixel == 2) {
 		switch (_factor) {
 		case 2:
@@ -5079,6 +5178,7 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 1; }
+	bool canScaleInParallel() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
@@ -27,16 +27,39 @@
 struct hqx_parameters;
 #endif
 
+class ScalerTestSuite;
+
 class HQScaler : public Scaler {
 public:
 	HQScaler(const Graphics::PixelFormat &format);
 	~HQScaler();
 	uint increaseFactor() override;
 	uint decreaseFactor() override;
+
+	/**
+	 * Compute which of the 8 neighbours of each pixel in a row differ from
+	 * it, from the YUV values of the row and of the rows above and below it.
+	 * Element -1 and @p width of each YUV row must be valid.
+	 */
+	typedef void (*PatternProc)(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width);
+
 protected:
+	friend class ::ScalerTestSuite;
+
 	virtual void scaleIntern(const uint8 *srcPtr, uint32 srcPitch,
 							uint8 *dstPtr, uint32 dstPitch, int width, int height, int x, int y) override;
 
+	static void patternsGeneric(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width);
+#ifdef SCUMMVM_NEON
+	static void patternsNEON(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void patternsSSE2(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width);
+#endif
+#ifdef SCUMMVM_AVX2
+	static void patternsAVX2(const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, uint8 *patterns, int width);
+#endif
+
 	void initLUT(Graphics::PixelFormat format);
 	inline void HQ2x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height);
 	inline void HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height);
@@ -44,6 +67,7 @@ protected:
 	inline void HQ3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height);
 
 	uint32 *_RGBtoYUV;
+	PatternProc _patternProc;
 #ifdef USE_NASM
 	hqx_parameters *_hqx_params;
 #endif
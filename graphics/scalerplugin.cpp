@@ -20,6 +20,8 @@
 
 #include "graphics/scalerplugin.h"
 
+#include "common/taskpool.h"
+
 namespace {
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
@@ -57,6 +59,29 @@ void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	}
 }
 
+void Scaler::scaleInBands(Common::TaskPool &pool, uint extraPixels,
+                          const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+                          uint32 dstPitch, int width, int height, int x, int y) {
+	if (width <= 0 || height <= 0)
+		return;
+
+	// Each band reads extraPixels rows above and below it a second time, so
+	// they are kept high enough for this to not matter. Narrow rects are
+	// split into fewer bands, as each one costs a task switch.
+	enum {
+		kMinBandHeight = 16,
+		kMinBandPixels = 8192
+	};
+	uint grain = MAX<uint>(kMinBandHeight, extraPixels * 4);
+	grain = MAX<uint>(grain, kMinBandPixels / width);
+
+	pool.parallelFor(0, height, grain, [this, srcPtr, srcPitch, dstPtr, dstPitch, width, x, y](uint begin, uint end) {
+		scale(srcPtr + begin * srcPitch, srcPitch,
+		      dstPtr + begin * _factor * dstPitch, dstPitch,
+		      width, end - begin, x, y + begin);
+	});
+}
+
 SourceScaler::SourceScaler(const Graphics::PixelFormat &format) : Scaler(format), _width(0), _height(0), _oldSrc(NULL), _enable(false) {
 }
 
@@ -25,6 +25,10 @@
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
+namespace Common {
+class TaskPool;
+}
+
 class Scaler {
 public:
 	Scaler(const Graphics::PixelFormat &format) : _format(format) {}
@@ -45,6 +49,20 @@ public:
 	void scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	           uint32 dstPitch, int width, int height, int x, int y);
 
+	/**
+	 * Scale a rect like scale(), splitting it into horizontal bands which are
+	 * scaled on the worker threads of @p pool. This must only be used if the
+	 * plugin returns true for ScalerPluginObject::canScaleInParallel().
+	 *
+	 * Each band reads @p extraPixels rows above and below it from the
+	 * source, so this must be the value returned by
+	 * ScalerPluginObject::extraPixels(). Rects which are too small to be
+	 * worth splitting are scaled on the calling thread.
+	 */
+	void scaleInBands(Common::TaskPool &pool, uint extraPixels,
+	                  const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	                  uint32 dstPitch, int width, int height, int x, int y);
+
 	/**
 	 * Increase the factor of scaling.
 	 * @return The new factor
@@ -199,6 +217,14 @@ public:
 	 */
 	virtual bool useOldSource() const { return false; }
 
+	/**
+	 * Whether the scaler may be run on several parts of the same surface
+	 * at the same time, using Scaler::scaleInBands(). This requires the
+	 * output rows to depend only on the source, within extraPixels() rows,
+	 * and scaling to not change the state of the scaler.
+	 */
+	virtual bool canScaleInParallel() const { return false; }
+
 protected:
 	Common::Array<uint> _factors;
 };
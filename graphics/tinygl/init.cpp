@@ -27,6 +27,9 @@
 
 #include "common/singleton.h"
 #include "common/array.h"
+#include "common/config-manager.h"
+#include "common/system.h"
+#include "common/taskpool.h"
 
 #include "graphics/tinygl/tinygl.h"
 #include "graphics/tinygl/zgl.h"
@@ -363,6 +366,11 @@ void GLContext::init(int screenW, int screenH, Graphics::PixelFormat pixelFormat
 	_drawCallAllocator[1].initialize(drawCallMemorySize);
 	_debugRectsEnabled = false;
 	_profilingEnabled = false;
+
+	_tileRenderer = nullptr;
+	Common::TaskPool *pool = g_system->getTaskPool();
+	if (ConfMan.hasKey("tinygl_tiles") && ConfMan.getBool("tinygl_tiles") && pool->getWorkerCount())
+		_tileRenderer = new TileRenderer(this, pool);
 }
 
 void GLContext::deinit() {
@@ -375,6 +383,7 @@ void GLContext::deinit() {
 	free_texture(default_texture);
 	endSharedState();
 	gl_free(vertex);
+	delete _tileRenderer;
 	delete fb;
 }
 
@@ -42,6 +42,8 @@ TexelBuffer::TexelBuffer(uint width, uint height, uint textureSize) {
 	_fracTextureMask = _fracTextureUnit - 1;
 	_widthRatio = (float) width / textureSize;
 	_heightRatio = (float) height / textureSize;
+	_spanLayout = kSpanLayoutNone;
+	_spanTexels = nullptr;
 }
 
 static inline uint wrap(uint wrap_mode, int coord, uint _fracTextureUnit, uint _fracTextureMask) {
@@ -103,7 +105,12 @@ template<uint Format, uint Type>
 class NearestTexelBuffer final : public BaseNearestTexelBuffer {
 public:
 	NearestTexelBuffer(const byte *buf, const Graphics::PixelFormat &format, uint width, uint height, uint textureSize)
-	  : BaseNearestTexelBuffer(buf, format, width, height, textureSize) {}
+	  : BaseNearestTexelBuffer(buf, format, width, height, textureSize) {
+		if (Format == TGL_RGBA && Type == TGL_UNSIGNED_BYTE) {
+			_spanLayout = kSpanLayoutRGBA8888;
+			_spanTexels = (const uint32 *)_buf;
+		}
+	}
 
 protected:
 	void getARGBAt(
@@ -261,6 +268,9 @@ BilinearTexelBuffer::BilinearTexelBuffer(byte *buf, const Graphics::PixelFormat
 			pixel00_offset++;
 		}
 	}
+
+	_spanLayout = kSpanLayoutBilinear;
+	_spanTexels = _texels;
 }
 
 BilinearTexelBuffer::~BilinearTexelBuffer() {
@@ -38,6 +38,15 @@ public:
 	) const;
 
 protected:
+	friend struct FrameBuffer;
+
+	// How the span procs of the frame buffer can fetch the texels themselves
+	enum SpanLayout {
+		kSpanLayoutNone,
+		kSpanLayoutRGBA8888, // A TGL_RGBA and TGL_UNSIGNED_BYTE pixel per texel
+		kSpanLayoutBilinear  // The 4 pixels to interpolate per texel, see BilinearTexelBuffer
+	};
+
 	virtual void getARGBAt(
 		uint pixel,
 		uint ds, uint dt,
@@ -45,6 +54,8 @@ protected:
 	) const = 0;
 	uint _width, _height, _fracTextureUnit, _fracTextureMask;
 	float _widthRatio, _heightRatio;
+	SpanLayout _spanLayout;
+	const uint32 *_spanTexels;
 };
 
 TexelBuffer *createNearestTexelBuffer(const byte *buf, const Graphics::PixelFormat &pf, uint format, uint type, uint width, uint height, uint textureSize);
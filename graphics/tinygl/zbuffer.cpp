@@ -30,6 +30,7 @@
 #include "common/scummsys.h"
 #include "common/endian.h"
 #include "common/memory.h"
+#include "common/system.h"
 
 #include "graphics/tinygl/zbuffer.h"
 #include "graphics/tinygl/zgl.h"
@@ -50,6 +51,12 @@ FrameBuffer::FrameBuffer(int width, int height, const Graphics::PixelFormat &for
 	else
 		_sbuf = nullptr;
 
+	_ownsBuffers = true;
+
+	if (!_spanProcsSelected)
+		selectSpanProcs();
+	_spanFormat = _pbufBpp == 4 && _pbufFormat.rLoss == 0 && _pbufFormat.gLoss == 0 && _pbufFormat.bLoss == 0;
+
 	_offscreenBuffer.pbuf = _pbuf;
 	_offscreenBuffer.zbuf = _zbuf;
 
@@ -58,13 +65,48 @@ FrameBuffer::FrameBuffer(int width, int height, const Graphics::PixelFormat &for
 	_clippingEnabled = false;
 }
 
+FrameBuffer::FrameBuffer(const FrameBuffer *parent) {
+	shareBuffers(parent);
+}
+
 FrameBuffer::~FrameBuffer() {
+	if (!_ownsBuffers)
+		return;
+
 	gl_free(_pbuf);
 	gl_free(_zbuf);
 	if (_sbuf)
 		gl_free(_sbuf);
 }
 
+void FrameBuffer::shareBuffers(const FrameBuffer *parent) {
+	*this = *parent;
+	_ownsBuffers = false;
+}
+
+FrameBuffer::SpanProc FrameBuffer::_fillSpan = nullptr;
+FrameBuffer::SpanProc FrameBuffer::_fillDepthSpan = nullptr;
+FrameBuffer::TextureSpanProc FrameBuffer::_fillTextureSpan = nullptr;
+bool FrameBuffer::_spanProcsSelected = false;
+
+void FrameBuffer::selectSpanProcs() {
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON)) {
+		_fillSpan = fillSpanNEON;
+		_fillDepthSpan = fillDepthSpanNEON;
+		_fillTextureSpan = fillTextureSpanNEON;
+	}
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2)) {
+		_fillSpan = fillSpanSSE2;
+		_fillDepthSpan = fillDepthSpanSSE2;
+		_fillTextureSpan = fillTextureSpanSSE2;
+	}
+#endif
+	_spanProcsSelected = true;
+}
+
 Buffer *FrameBuffer::genOffscreenBuffer() {
 	Buffer *buf = (Buffer *)gl_malloc(sizeof(Buffer));
 	buf->pbuf = (byte *)gl_zalloc(_pbufHeight * _pbufPitch);
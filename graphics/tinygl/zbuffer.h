@@ -35,6 +35,8 @@
 #include "common/rect.h"
 #include "common/textconsole.h"
 
+class TinyGLTestSuite;
+
 namespace TinyGL {
 
 // Z buffer
@@ -105,8 +107,20 @@ struct ZBufferPoint {
 
 struct FrameBuffer {
 	FrameBuffer(int width, int height, const Graphics::PixelFormat &format, bool enableStencilBuffer);
+	/**
+	 * Create a frame buffer which draws into the buffers of @p parent with a
+	 * drawing state of its own, so that separate parts of the buffers can be
+	 * drawn by several threads at once. The buffers stay owned by @p parent.
+	 */
+	explicit FrameBuffer(const FrameBuffer *parent);
 	~FrameBuffer();
 
+	/**
+	 * Draw into the current buffers of @p parent, see above. This also copies
+	 * the drawing state of @p parent.
+	 */
+	void shareBuffers(const FrameBuffer *parent);
+
 	Graphics::PixelFormat getPixelFormat() {
 		return _pbufFormat;
 	}
@@ -145,7 +159,71 @@ struct FrameBuffer {
 		surface.init(_pbufWidth, _pbufHeight, _pbufPitch, _pbuf, _pbufFormat);
 	}
 
+	/**
+	 * A run of pixels of a triangle without texture, fog, alpha test, stencil
+	 * or stipple, in a 32 bpp pixel format with 8 bit colour channels.
+	 */
+	struct Span {
+		uint32 *pixels;
+		uint *zbuf;
+		int count; // A multiple of 4
+		uint z, r, g, b, a;
+		int dzdx, drdx, dgdx, dbdx, dadx;
+		int depthFunc;
+		bool depthTest;
+		bool depthWrite;
+		bool blending; // TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA
+		byte rShift, gShift, bShift, aShift, aLoss;
+	};
+
+	/**
+	 * Draw a span several pixels at a time, with the same results as
+	 * putPixelNoTexture() or putPixelDepth().
+	 */
+	typedef void (*SpanProc)(const Span &span);
+
+	/**
+	 * A run of pixels of a textured triangle, with the same restrictions as
+	 * Span. The texture coordinates are stepped linearly, as they are over
+	 * each NB_INTERP pixels of a perspective correct triangle.
+	 */
+	struct TextureSpan : Span {
+		const uint32 *texels;
+		int s, t, dsdx, dtdx;
+		uint wrapS, wrapT;
+		uint texWidth, fracUnit, fracMask;
+		float widthRatio, heightRatio;
+		bool bilinear; // Otherwise a TGL_RGBA and TGL_UNSIGNED_BYTE pixel per texel
+		bool lighting; // Whether the texels are modulated by the colour
+		byte texRShift, texGShift, texBShift, texAShift;
+	};
+
+	/**
+	 * Draw a textured span several pixels at a time, with the same results
+	 * as putPixelTexture().
+	 */
+	typedef void (*TextureSpanProc)(const TextureSpan &span);
+
 private:
+	friend class ::TinyGLTestSuite;
+
+	static void selectSpanProcs();
+#ifdef SCUMMVM_NEON
+	static void fillSpanNEON(const Span &span);
+	static void fillDepthSpanNEON(const Span &span);
+	static void fillTextureSpanNEON(const TextureSpan &span);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void fillSpanSSE2(const Span &span);
+	static void fillDepthSpanSSE2(const Span &span);
+	static void fillTextureSpanSSE2(const TextureSpan &span);
+#endif
+
+	// The span procs for this CPU, or nullptr if there are none
+	static SpanProc _fillSpan;
+	static SpanProc _fillDepthSpan;
+	static TextureSpanProc _fillTextureSpan;
+	static bool _spanProcsSelected;
 
 	FORCEINLINE void setPixelAt(int pixel, uint32 value) {
 		switch (_pbufBpp) {
@@ -373,6 +451,16 @@ private:
 	template <bool kDepthWrite, bool kEnableScissor, bool kStencilEnabled, bool StippleEnabled, bool kDepthTestEnabled>
 	void putPixelDepth(uint *pz, byte *ps, int _a, int x, int y, uint &z, int &dzdx);
 
+	template <bool kInterpRGB, bool kSmoothMode, bool kDepthWrite, bool kEnableScissor, bool kEnableBlending, bool kDepthTestEnabled>
+	void fillSpan(int &pp, uint *&pz, int &x, int &n, uint &z, uint &r, uint &g, uint &b, uint &a,
+	              int dzdx, int drdx, int dgdx, int dbdx, uint dadx);
+
+	template <bool kLightsMode, bool kSmoothMode, bool kDepthWrite, bool kEnableBlending, bool kDepthTestEnabled>
+	bool initTextureSpan(TextureSpan &span, const TexelBuffer *texture, int dzdx, int drdx, int dgdx, int dbdx, uint dadx);
+
+	template <bool kSmoothMode, bool kDepthWrite, bool kEnableScissor>
+	bool fillTextureSpan(TextureSpan &span, int pp, uint *pz, int x, uint &z, int s, int t, uint &r, uint &g, uint &b, uint &a,
+	                     int dzdx, int dsdx, int dtdx, int drdx, int dgdx, int dbdx, uint dadx);
 
 	template <bool kEnableAlphaTest>
 	FORCEINLINE void writePixel(int pixel, int value) {
@@ -783,6 +871,8 @@ private:
 
 	uint *_zbuf;
 	byte *_sbuf;
+	bool _ownsBuffers;
+	bool _spanFormat; // Whether the span procs can draw into the pixel buffer
 
 	bool _enableStencil;
 	int _textureSize;
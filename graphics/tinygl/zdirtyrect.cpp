@@ -191,12 +191,20 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 		}
 
 		// Execute draw calls.
-		for (auto &drawCall : _drawCallsQueue) {
-			Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+		if (canUseTileRenderer()) {
+			Common::Array<Common::Rect> dirtyRects;
 			for (auto &rect : rectangles) {
-				Common::Rect dirtyRegion = rect.rectangle;
-				if (dirtyRegion.intersects(drawCallRegion)) {
-					drawCall->execute(true, &dirtyRegion);
+				dirtyRects.push_back(rect.rectangle);
+			}
+			_tileRenderer->execute(_drawCallsQueue, &dirtyRects);
+		} else {
+			for (auto &drawCall : _drawCallsQueue) {
+				Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+				for (auto &rect : rectangles) {
+					Common::Rect dirtyRegion = rect.rectangle;
+					if (dirtyRegion.intersects(drawCallRegion)) {
+						drawCall->execute(true, &dirtyRegion);
+					}
 				}
 			}
 		}
@@ -236,8 +244,15 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
 	dirtyAreas.push_back(Common::Rect(fb->getPixelBufferWidth(), fb->getPixelBufferHeight()));
 
+	if (canUseTileRenderer()) {
+		_tileRenderer->execute(_drawCallsQueue, nullptr);
+	} else {
+		for (const auto &drawCall : _drawCallsQueue) {
+			drawCall->execute(true);
+		}
+	}
+
 	for (const auto &drawCall : _drawCallsQueue) {
-		drawCall->execute(true);
 		delete drawCall;
 	}
 
@@ -248,6 +263,11 @@ void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
 	_drawCallAllocator[_currentAllocatorIndex].reset();
 }
 
+bool GLContext::canUseTileRenderer() const {
+	// The tiles neither count the drawn triangles nor select
+	return _tileRenderer && !_profilingEnabled && render_mode != TGL_SELECT;
+}
+
 void presentBuffer(Common::List<Common::Rect> &dirtyAreas) {
 	GLContext *c = gl_get_context();
 	if (c->_enableDirtyRectangles) {
@@ -290,7 +310,7 @@ RasterizationDrawCall::RasterizationDrawCall() : DrawCall(DrawCall_Rasterization
 	_drawTriangleFront = c->draw_triangle_front;
 	_drawTriangleBack = c->draw_triangle_back;
 	memcpy(_vertex, c->vertex, sizeof(GLVertex) * _vertexCount);
-	_state = captureState();
+	_state = captureState(c);
 	if (c->_enableDirtyRectangles) {
 		computeDirtyRegion();
 	}
@@ -329,19 +349,73 @@ void RasterizationDrawCall::computeDirtyRegion() {
 	}
 }
 
+bool RasterizationDrawCall::canExecuteOnOtherContext() const {
+	// Quad strips use the vertex count of the current context, selection
+	// writes to its selection buffer, and quads change the edge flags of the
+	// vertices, which is only visible when the edges are drawn.
+	if (_state.beginType == TGL_QUAD_STRIP)
+		return false;
+	if (_drawTriangleFront == (gl_draw_triangle_func_ptr)GLContext::gl_draw_triangle_select)
+		return false;
+	if (_state.beginType == TGL_QUADS && (_state.polygonModeFront != TGL_FILL || _state.polygonModeBack != TGL_FILL))
+		return false;
+	return true;
+}
+
+void RasterizationDrawCall::getRows(int height, int &top, int &bottom) const {
+	top = height;
+	bottom = 0;
+	for (int i = 0; i < _vertexCount; i++) {
+		const GLVertex *v = &_vertex[i];
+		int y;
+		if (!v->clip_code) {
+			y = v->zp.y;
+		} else if (v->pc.W > 0) {
+			// Clipping only adds vertices in between the others
+			float fy = v->pc.Y / v->pc.W * _state.viewportScaling[1] + _state.viewportTranslation[1];
+			y = (int)CLIP<float>(fy, 0, height - 1);
+		} else {
+			top = 0;
+			bottom = height;
+			return;
+		}
+		top = MIN(top, y);
+		bottom = MAX(bottom, y + 1);
+	}
+	// The vertices added by clipping are rounded on their own
+	top = MAX(top - 1, 0);
+	bottom = MIN(bottom + 1, height);
+}
+
+void RasterizationDrawCall::updateVertices() const {
+	if (_state.beginType == TGL_QUADS) {
+		for (int i = 0; i < _vertexCount; i += 4) {
+			_vertex[i + 2].edge_flag = 1;
+			_vertex[i + 0].edge_flag = 0;
+		}
+	}
+}
+
 void RasterizationDrawCall::execute(bool restoreState, const Common::Rect *clippingRectangle) const {
-	GLContext *c = gl_get_context();
+	executeWith(gl_get_context(), _vertex, restoreState, clippingRectangle);
+}
 
+void RasterizationDrawCall::execute(GLContext *c, GLVertex *vertex, const Common::Rect *clippingRectangle) const {
+	memcpy(vertex, _vertex, sizeof(GLVertex) * _vertexCount);
+	executeWith(c, vertex, false, clippingRectangle);
+}
+
+void RasterizationDrawCall::executeWith(GLContext *c, GLVertex *vertex, bool restoreState, const Common::Rect *clippingRectangle) const {
 	RasterizationDrawCall::RasterizationState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_state, clippingRectangle);
+	applyState(c, _state, clippingRectangle);
 
 	GLVertex *prevVertex = c->vertex;
 	int prevVertexCount = c->vertex_cnt;
 
-	c->vertex = _vertex;
+	c->vertex = vertex;
 	c->vertex_cnt = _vertexCount;
 	c->draw_triangle_front = (gl_draw_triangle_func)_drawTriangleFront;
 	c->draw_triangle_back = (gl_draw_triangle_func)_drawTriangleBack;
@@ -425,13 +499,12 @@ void RasterizationDrawCall::execute(bool restoreState, const Common::Rect *clipp
 	c->vertex_cnt = prevVertexCount;
 
 	if (restoreState) {
-		applyState(backupState, nullptr);
+		applyState(c, backupState, nullptr);
 	}
 }
 
-RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState() const {
+RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState(GLContext *c) const {
 	RasterizationState state;
-	GLContext *c = gl_get_context();
 	state.enableScissor = c->scissor_test_enabled;
 	state.enableBlending = c->blending_enabled;
 	state.sfactor = c->source_blending_factor;
@@ -484,8 +557,7 @@ RasterizationDrawCall::RasterizationState RasterizationDrawCall::captureState()
 	return state;
 }
 
-void RasterizationDrawCall::applyState(const RasterizationDrawCall::RasterizationState &state, const Common::Rect *clippingRectangle) const {
-	GLContext *c = gl_get_context();
+void RasterizationDrawCall::applyState(GLContext *c, const RasterizationDrawCall::RasterizationState &state, const Common::Rect *clippingRectangle) const {
 	c->fb->setupScissor(state.enableScissor, state.scissor, clippingRectangle);
 	c->fb->enableBlending(state.enableBlending);
 	c->fb->setBlendingFactors(state.sfactor, state.dfactor);
@@ -688,38 +760,42 @@ ClearBufferDrawCall::ClearBufferDrawCall(bool clearZBuffer, int zValue,
 	: _clearZBuffer(clearZBuffer), _clearColorBuffer(clearColorBuffer), _zValue(zValue),
 	  _rValue(rValue), _gValue(gValue), _bValue(bValue), _clearStencilBuffer(clearStencilBuffer),
 	  _stencilValue(stencilValue), DrawCall(DrawCall_Clear) {
-	_clearState = captureState();
 	TinyGL::GLContext *c = gl_get_context();
+	_clearState = captureState(c);
 	if (c->_enableDirtyRectangles) {
 		_dirtyRegion = c->renderRect;
 	}
 }
 
 void ClearBufferDrawCall::execute(bool restoreState, const Common::Rect *clippingRectangle) const {
+	TinyGL::GLContext *c = gl_get_context();
+
 	ClearBufferState backupState;
 	if (restoreState) {
-		backupState = captureState();
+		backupState = captureState(c);
 	}
-	applyState(_clearState, clippingRectangle);
+	applyState(c, _clearState, clippingRectangle);
 
-	TinyGL::GLContext *c = gl_get_context();
 	c->fb->clear(_clearZBuffer, _zValue, _clearColorBuffer, _rValue, _gValue, _bValue, _clearStencilBuffer, _stencilValue);
 
 	if (restoreState) {
-		applyState(backupState, nullptr);
+		applyState(c, backupState, nullptr);
 	}
 }
 
-ClearBufferDrawCall::ClearBufferState ClearBufferDrawCall::captureState() const {
+void ClearBufferDrawCall::execute(TinyGL::GLContext *c, const Common::Rect *clippingRectangle) const {
+	applyState(c, _clearState, clippingRectangle);
+	c->fb->clear(_clearZBuffer, _zValue, _clearColorBuffer, _rValue, _gValue, _bValue, _clearStencilBuffer, _stencilValue);
+}
+
+ClearBufferDrawCall::ClearBufferState ClearBufferDrawCall::captureState(TinyGL::GLContext *c) const {
 	ClearBufferState state;
-	TinyGL::GLContext *c = gl_get_context();
 	state.enableScissor = c->scissor_test_enabled;
 	memcpy(state.scissor, c->scissor, sizeof(state.scissor));
 	return state;
 }
 
-void ClearBufferDrawCall::applyState(const ClearBufferState &state, const Common::Rect *clippingRectangle) const {
-	TinyGL::GLContext *c = gl_get_context();
+void ClearBufferDrawCall::applyState(TinyGL::GLContext *c, const ClearBufferState &state, const Common::Rect *clippingRectangle) const {
 	c->fb->setupScissor(state.enableScissor, state.scissor, clippingRectangle);
 
 	c->scissor_test_enabled = state.enableScissor;
@@ -68,6 +68,8 @@ public:
 	virtual ~ClearBufferDrawCall() { }
 	bool operator==(const ClearBufferDrawCall &other) const;
 	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
+	// Execute the call with another context than the current one, without restoring its state.
+	void execute(GLContext *c, const Common::Rect *clippingRectangle) const;
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -91,8 +93,8 @@ private:
 		}
 	};
 
-	ClearBufferState captureState() const;
-	void applyState(const ClearBufferState &state, const Common::Rect *clippingRectangle) const;
+	ClearBufferState captureState(GLContext *c) const;
+	void applyState(GLContext *c, const ClearBufferState &state, const Common::Rect *clippingRectangle) const;
 
 	ClearBufferState _clearState;
 };
@@ -104,6 +106,16 @@ public:
 	virtual ~RasterizationDrawCall() { }
 	bool operator==(const RasterizationDrawCall &other) const;
 	virtual void execute(bool restoreState, const Common::Rect *clippingRectangle = nullptr) const;
+	// Execute the call with another context than the current one, without restoring its state.
+	// The vertices are copied to vertex first, which must have room for getVertexCount() of them.
+	void execute(GLContext *c, GLVertex *vertex, const Common::Rect *clippingRectangle) const;
+	int getVertexCount() const { return _vertexCount; }
+	// Whether executing the call on a context of its own gives the same pixels as on the current one.
+	bool canExecuteOnOtherContext() const;
+	// Find the rows of the frame buffer which the call may draw to.
+	void getRows(int height, int &top, int &bottom) const;
+	// Change the vertices as executing the call on the current context does.
+	void updateVertices() const;
 
 	void *operator new(size_t size) {
 		return Internal::allocateFrame(size);
@@ -169,8 +181,9 @@ private:
 
 	RasterizationState _state;
 
-	RasterizationState captureState() const;
-	void applyState(const RasterizationState &state, const Common::Rect *clippingRectangle) const;
+	RasterizationState captureState(GLContext *c) const;
+	void applyState(GLContext *c, const RasterizationState &state, const Common::Rect *clippingRectangle) const;
+	void executeWith(GLContext *c, GLVertex *vertex, bool restoreState, const Common::Rect *clippingRectangle) const;
 };
 
 // Encapsulate a blit call: it might execute either a color buffer or z buffer blit.
@@ -41,6 +41,7 @@
 #include "graphics/tinygl/zmath.h"
 #include "graphics/tinygl/zblit.h"
 #include "graphics/tinygl/zdirtyrect.h"
+#include "graphics/tinygl/ztiles.h"
 #include "graphics/tinygl/texelbuffer.h"
 
 namespace TinyGL {
@@ -469,6 +470,9 @@ struct GLContext {
 	bool _debugRectsEnabled;
 	bool _profilingEnabled;
 
+	// Executes the draw calls on the task pool, if enabled
+	TileRenderer *_tileRenderer;
+
 	void gl_vertex_transform(GLVertex *v);
 	void gl_calc_fog_factor(GLVertex *v);
 
@@ -525,6 +529,7 @@ public:
 
 	void presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas);
 	void presentBufferSimple(Common::List<Common::Rect> &dirtyAreas);
+	bool canUseTileRenderer() const;
 
 	void debugDrawRectangle(Common::Rect rect, int r, int g, int b);
 
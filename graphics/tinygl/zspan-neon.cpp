@@ -0,0 +1,318 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/tinygl/zbuffer.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace TinyGL {
+
+// The values of 4 pixels from the start of a span
+static FORCEINLINE uint32x4_t spanSteps(uint value, int delta) {
+	const uint32 values[4] = { value, value + delta, value + 2 * (uint)delta, value + 3 * (uint)delta };
+	return vld1q_u32(values);
+}
+
+static FORCEINLINE uint32x4_t spanCompareDepth(uint32x4_t zSrc, uint32x4_t zDst, int depthFunc) {
+	switch (depthFunc) {
+	case TGL_LESS:
+		return vcltq_u32(zDst, zSrc);
+	case TGL_EQUAL:
+		return vceqq_u32(zDst, zSrc);
+	case TGL_LEQUAL:
+		return vcleq_u32(zDst, zSrc);
+	case TGL_GREATER:
+		return vcgtq_u32(zDst, zSrc);
+	case TGL_NOTEQUAL:
+		return vmvnq_u32(vceqq_u32(zDst, zSrc));
+	case TGL_GEQUAL:
+		return vcgeq_u32(zDst, zSrc);
+	case TGL_ALWAYS:
+		return vdupq_n_u32(0xFFFFFFFF);
+	default:
+		return vdupq_n_u32(0);
+	}
+}
+
+static FORCEINLINE bool spanAny(uint32x4_t mask) {
+	const uint32x2_t bits = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return vget_lane_u32(vpmax_u32(bits, bits), 0) != 0;
+}
+
+// The shifts of the pixel format of a span
+struct SpanFormat {
+	int32x4_t rShift, gShift, bShift, aShift;
+	int32x4_t rShiftRight, gShiftRight, bShiftRight, aLossRight;
+	uint32x4_t opaque;
+
+	explicit SpanFormat(const FrameBuffer::Span &span) :
+		rShift(vdupq_n_s32(span.rShift)), gShift(vdupq_n_s32(span.gShift)),
+		bShift(vdupq_n_s32(span.bShift)), aShift(vdupq_n_s32(span.aShift)),
+		rShiftRight(vdupq_n_s32(-span.rShift)), gShiftRight(vdupq_n_s32(-span.gShift)),
+		bShiftRight(vdupq_n_s32(-span.bShift)), aLossRight(vdupq_n_s32(-span.aLoss)),
+		opaque(vdupq_n_u32((0xFF >> span.aLoss) << span.aShift)) {
+	}
+};
+
+// The colours of 4 pixels from their 8 bit channels, blended with the pixels
+// in the frame buffer if the span is blended
+static FORCEINLINE uint32x4_t spanColor(const FrameBuffer::Span &span, const SpanFormat &format, uint32x4_t dst,
+                                        uint32x4_t aSrc, uint32x4_t rSrc, uint32x4_t gSrc, uint32x4_t bSrc) {
+	const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+	uint32x4_t color;
+	if (!span.blending) {
+		color = vshlq_u32(vshlq_u32(aSrc, format.aLossRight), format.aShift);
+		color = vorrq_u32(color, vshlq_u32(rSrc, format.rShift));
+		color = vorrq_u32(color, vshlq_u32(gSrc, format.gShift));
+		color = vorrq_u32(color, vshlq_u32(bSrc, format.bShift));
+	} else {
+		// The sums can't overflow a channel
+		const uint32x4_t aInv = vsubq_u32(byteMask, aSrc);
+		const uint32x4_t rDst = vandq_u32(vshlq_u32(dst, format.rShiftRight), byteMask);
+		const uint32x4_t gDst = vandq_u32(vshlq_u32(dst, format.gShiftRight), byteMask);
+		const uint32x4_t bDst = vandq_u32(vshlq_u32(dst, format.bShiftRight), byteMask);
+		const uint32x4_t rOut = vaddq_u32(vshrq_n_u32(vmulq_u32(rSrc, aSrc), 8), vshrq_n_u32(vmulq_u32(rDst, aInv), 8));
+		const uint32x4_t gOut = vaddq_u32(vshrq_n_u32(vmulq_u32(gSrc, aSrc), 8), vshrq_n_u32(vmulq_u32(gDst, aInv), 8));
+		const uint32x4_t bOut = vaddq_u32(vshrq_n_u32(vmulq_u32(bSrc, aSrc), 8), vshrq_n_u32(vmulq_u32(bDst, aInv), 8));
+		color = vorrq_u32(format.opaque, vshlq_u32(rOut, format.rShift));
+		color = vorrq_u32(color, vshlq_u32(gOut, format.gShift));
+		color = vorrq_u32(color, vshlq_u32(bOut, format.bShift));
+	}
+	return color;
+}
+
+// The depth test of 4 pixels, which also writes their depths if enabled
+static FORCEINLINE uint32x4_t spanDepth(const FrameBuffer::Span &span, int depthFunc, uint32 *zbuf, uint32x4_t z) {
+	const uint32x4_t zDst = vld1q_u32(zbuf);
+	const uint32x4_t mask = spanCompareDepth(z, zDst, depthFunc);
+	if (span.depthWrite && spanAny(mask)) {
+		// writePixel() writes the depth through a float
+		vst1q_u32(zbuf, vbslq_u32(mask, vcvtq_u32_f32(vcvtq_f32_u32(z)), zDst));
+	}
+	return mask;
+}
+
+void FrameBuffer::fillSpanNEON(const Span &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+	const SpanFormat format(span);
+
+	uint32x4_t z = spanSteps(span.z, span.dzdx);
+	uint32x4_t r = spanSteps(span.r, span.drdx);
+	uint32x4_t g = spanSteps(span.g, span.dgdx);
+	uint32x4_t b = spanSteps(span.b, span.dbdx);
+	uint32x4_t a = spanSteps(span.a, span.dadx);
+	const uint32x4_t dz = vdupq_n_u32(4 * (uint)span.dzdx);
+	const uint32x4_t dr = vdupq_n_u32(4 * (uint)span.drdx);
+	const uint32x4_t dg = vdupq_n_u32(4 * (uint)span.dgdx);
+	const uint32x4_t db = vdupq_n_u32(4 * (uint)span.dbdx);
+	const uint32x4_t da = vdupq_n_u32(4 * (uint)span.dadx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		uint32 *pixels = span.pixels + i;
+
+		const uint32x4_t mask = spanDepth(span, depthFunc, span.zbuf + i, z);
+		if (spanAny(mask)) {
+			const uint32x4_t rSrc = vandq_u32(vshrq_n_u32(r, ZB_POINT_RED_BITS - 8), byteMask);
+			const uint32x4_t gSrc = vandq_u32(vshrq_n_u32(g, ZB_POINT_GREEN_BITS - 8), byteMask);
+			const uint32x4_t bSrc = vandq_u32(vshrq_n_u32(b, ZB_POINT_BLUE_BITS - 8), byteMask);
+			const uint32x4_t aSrc = vandq_u32(vshrq_n_u32(a, ZB_POINT_ALPHA_BITS - 8), byteMask);
+			const uint32x4_t dst = vld1q_u32(pixels);
+			vst1q_u32(pixels, vbslq_u32(mask, spanColor(span, format, dst, aSrc, rSrc, gSrc, bSrc), dst));
+		}
+
+		z = vaddq_u32(z, dz);
+		r = vaddq_u32(r, dr);
+		g = vaddq_u32(g, dg);
+		b = vaddq_u32(b, db);
+		a = vaddq_u32(a, da);
+	}
+}
+
+// Texture coordinates wrapped as TexelBuffer::getARGBAt() does
+static FORCEINLINE uint32x4_t spanWrap(uint32x4_t coord, uint wrapMode, uint32x4_t fracUnit, uint32x4_t fracMask) {
+	switch (wrapMode) {
+	case TGL_MIRRORED_REPEAT: {
+		const uint32x4_t inside = vandq_u32(coord, fracMask);
+		return vbslq_u32(vtstq_u32(coord, fracUnit), vsubq_u32(fracMask, inside), inside);
+	}
+	case TGL_CLAMP_TO_EDGE: {
+		const int32x4_t clamped = vmaxq_s32(vreinterpretq_s32_u32(coord), vdupq_n_s32(0));
+		return vreinterpretq_u32_s32(vminq_s32(clamped, vreinterpretq_s32_u32(fracMask)));
+	}
+	default:
+		return vandq_u32(coord, fracMask);
+	}
+}
+
+// A channel of 4 bilinear texels, from lanes which hold it for the 4 pixels
+// of each texel, as BilinearTexelBuffer::getARGBAt() interpolates it
+static FORCEINLINE uint32x4_t spanInterpolate(uint32x4_t pixels, uint32x4_t mirrored, int32x4_t xFrac, int32x4_t yFrac) {
+	const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+	pixels = vbslq_u32(mirrored, vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(pixels))), pixels);
+	const int32x4_t p00 = vreinterpretq_s32_u32(vandq_u32(pixels, byteMask));
+	const int32x4_t p01 = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(pixels, 8), byteMask));
+	const int32x4_t p10 = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(pixels, 16), byteMask));
+	const int32x4_t sum = vmlaq_s32(vmulq_s32(vsubq_s32(p01, p00), xFrac), vsubq_s32(p10, p00), yFrac);
+	return vreinterpretq_u32_s32(vaddq_s32(p00, vshrq_n_s32(sum, ZB_POINT_ST_FRAC_BITS)));
+}
+
+// A channel of the texels, modulated by the colour
+template <int kColorBits>
+static FORCEINLINE uint32x4_t spanModulate(uint32x4_t texel, uint32x4_t color) {
+	const uint32x4_t product = vmulq_u32(texel, vshrq_n_u32(color, kColorBits - 8));
+	return vandq_u32(vshrq_n_u32(product, kColorBits - 8), vdupq_n_u32(0xFF));
+}
+
+void FrameBuffer::fillTextureSpanNEON(const TextureSpan &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	const uint32x4_t byteMask = vdupq_n_u32(0xFF);
+	const uint32x4_t fracBits = vdupq_n_u32((1 << ZB_POINT_ST_FRAC_BITS) - 1);
+	const uint32x4_t fracUnit = vdupq_n_u32(span.fracUnit);
+	const uint32x4_t fracMask = vdupq_n_u32(span.fracMask);
+	const uint32x4_t texWidth = vdupq_n_u32(span.texWidth);
+	const float32x4_t widthRatio = vdupq_n_f32(span.widthRatio);
+	const float32x4_t heightRatio = vdupq_n_f32(span.heightRatio);
+	const int32x4_t texRShiftRight = vdupq_n_s32(-span.texRShift);
+	const int32x4_t texGShiftRight = vdupq_n_s32(-span.texGShift);
+	const int32x4_t texBShiftRight = vdupq_n_s32(-span.texBShift);
+	const int32x4_t texAShiftRight = vdupq_n_s32(-span.texAShift);
+	const SpanFormat format(span);
+
+	uint32x4_t z = spanSteps(span.z, span.dzdx);
+	uint32x4_t s = spanSteps(span.s, span.dsdx);
+	uint32x4_t t = spanSteps(span.t, span.dtdx);
+	uint32x4_t r = spanSteps(span.r, span.drdx);
+	uint32x4_t g = spanSteps(span.g, span.dgdx);
+	uint32x4_t b = spanSteps(span.b, span.dbdx);
+	uint32x4_t a = spanSteps(span.a, span.dadx);
+	const uint32x4_t dz = vdupq_n_u32(4 * (uint)span.dzdx);
+	const uint32x4_t ds = vdupq_n_u32(4 * (uint)span.dsdx);
+	const uint32x4_t dt = vdupq_n_u32(4 * (uint)span.dtdx);
+	const uint32x4_t dr = vdupq_n_u32(4 * (uint)span.drdx);
+	const uint32x4_t dg = vdupq_n_u32(4 * (uint)span.dgdx);
+	const uint32x4_t db = vdupq_n_u32(4 * (uint)span.dbdx);
+	const uint32x4_t da = vdupq_n_u32(4 * (uint)span.dadx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		uint32 *pixels = span.pixels + i;
+
+		const uint32x4_t mask = spanDepth(span, depthFunc, span.zbuf + i, z);
+		if (spanAny(mask)) {
+			// The coordinates are scaled to the texture through floats
+			const uint32x4_t x = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(spanWrap(s, span.wrapS, fracUnit, fracMask)), widthRatio));
+			const uint32x4_t y = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(spanWrap(t, span.wrapT, fracUnit, fracMask)), heightRatio));
+			uint32 texels[4];
+			vst1q_u32(texels, vmlaq_u32(vshrq_n_u32(x, ZB_POINT_ST_FRAC_BITS), vshrq_n_u32(y, ZB_POINT_ST_FRAC_BITS), texWidth));
+
+			uint32x4_t aSrc, rSrc, gSrc, bSrc;
+			if (!span.bilinear) {
+				const uint32 gathered[4] = { span.texels[texels[0]], span.texels[texels[1]], span.texels[texels[2]], span.texels[texels[3]] };
+				const uint32x4_t texel = vld1q_u32(gathered);
+				aSrc = vandq_u32(vshlq_u32(texel, texAShiftRight), byteMask);
+				rSrc = vandq_u32(vshlq_u32(texel, texRShiftRight), byteMask);
+				gSrc = vandq_u32(vshlq_u32(texel, texGShiftRight), byteMask);
+				bSrc = vandq_u32(vshlq_u32(texel, texBShiftRight), byteMask);
+			} else {
+				// Each texel holds a row of the 4 pixels to interpolate for
+				// each channel, which are transposed into a row per channel
+				const uint32x4x2_t texels01 = vtrnq_u32(vld1q_u32(span.texels + 4 * texels[0]), vld1q_u32(span.texels + 4 * texels[1]));
+				const uint32x4x2_t texels23 = vtrnq_u32(vld1q_u32(span.texels + 4 * texels[2]), vld1q_u32(span.texels + 4 * texels[3]));
+
+				// Past the diagonal, the pixel on the other side of it is
+				// interpolated from, which swaps the pixels of the rows
+				const uint32x4_t unit = vdupq_n_u32(1 << ZB_POINT_ST_FRAC_BITS);
+				uint32x4_t xFrac = vandq_u32(x, fracBits);
+				uint32x4_t yFrac = vandq_u32(y, fracBits);
+				const uint32x4_t mirrored = vcgtq_u32(vaddq_u32(xFrac, yFrac), unit);
+				xFrac = vbslq_u32(mirrored, vsubq_u32(unit, xFrac), xFrac);
+				yFrac = vbslq_u32(mirrored, vsubq_u32(unit, yFrac), yFrac);
+				const int32x4_t xWeight = vreinterpretq_s32_u32(xFrac);
+				const int32x4_t yWeight = vreinterpretq_s32_u32(yFrac);
+
+				aSrc = spanInterpolate(vcombine_u32(vget_low_u32(texels01.val[0]), vget_low_u32(texels23.val[0])), mirrored, xWeight, yWeight);
+				rSrc = spanInterpolate(vcombine_u32(vget_low_u32(texels01.val[1]), vget_low_u32(texels23.val[1])), mirrored, xWeight, yWeight);
+				gSrc = spanInterpolate(vcombine_u32(vget_high_u32(texels01.val[0]), vget_high_u32(texels23.val[0])), mirrored, xWeight, yWeight);
+				bSrc = spanInterpolate(vcombine_u32(vget_high_u32(texels01.val[1]), vget_high_u32(texels23.val[1])), mirrored, xWeight, yWeight);
+			}
+
+			if (span.lighting) {
+				aSrc = spanModulate<ZB_POINT_ALPHA_BITS>(aSrc, a);
+				rSrc = spanModulate<ZB_POINT_RED_BITS>(rSrc, r);
+				gSrc = spanModulate<ZB_POINT_GREEN_BITS>(gSrc, g);
+				bSrc = spanModulate<ZB_POINT_BLUE_BITS>(bSrc, b);
+			}
+
+			const uint32x4_t dst = vld1q_u32(pixels);
+			vst1q_u32(pixels, vbslq_u32(mask, spanColor(span, format, dst, aSrc, rSrc, gSrc, bSrc), dst));
+		}
+
+		z = vaddq_u32(z, dz);
+		s = vaddq_u32(s, ds);
+		t = vaddq_u32(t, dt);
+		r = vaddq_u32(r, dr);
+		g = vaddq_u32(g, dg);
+		b = vaddq_u32(b, db);
+		a = vaddq_u32(a, da);
+	}
+}
+
+void FrameBuffer::fillDepthSpanNEON(const Span &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	uint32x4_t z = spanSteps(span.z, span.dzdx);
+	const uint32x4_t dz = vdupq_n_u32(4 * (uint)span.dzdx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		uint32 *zbuf = span.zbuf + i;
+		const uint32x4_t zDst = vld1q_u32(zbuf);
+		vst1q_u32(zbuf, vbslq_u32(spanCompareDepth(z, zDst, depthFunc), z, zDst));
+		z = vaddq_u32(z, dz);
+	}
+}
+
+} // end of namespace TinyGL
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,329 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/tinygl/zbuffer.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace TinyGL {
+
+// The values of 4 pixels from the start of a span
+static FORCEINLINE __m128i spanSteps(uint value, int delta) {
+	return _mm_setr_epi32(value, value + delta, value + 2 * (uint)delta, value + 3 * (uint)delta);
+}
+
+static FORCEINLINE __m128i spanSelect(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// The unsigned comparisons of compareDepth(), as signed ones of the values with
+// their top bit flipped
+static FORCEINLINE __m128i spanCompareDepth(__m128i zSrc, __m128i zDst, int depthFunc) {
+	const __m128i topBit = _mm_set1_epi32((int)0x80000000);
+	const __m128i allBits = _mm_set1_epi32(-1);
+	zSrc = _mm_xor_si128(zSrc, topBit);
+	zDst = _mm_xor_si128(zDst, topBit);
+
+	switch (depthFunc) {
+	case TGL_LESS:
+		return _mm_cmplt_epi32(zDst, zSrc);
+	case TGL_EQUAL:
+		return _mm_cmpeq_epi32(zDst, zSrc);
+	case TGL_LEQUAL:
+		return _mm_xor_si128(_mm_cmpgt_epi32(zDst, zSrc), allBits);
+	case TGL_GREATER:
+		return _mm_cmpgt_epi32(zDst, zSrc);
+	case TGL_NOTEQUAL:
+		return _mm_xor_si128(_mm_cmpeq_epi32(zDst, zSrc), allBits);
+	case TGL_GEQUAL:
+		return _mm_xor_si128(_mm_cmplt_epi32(zDst, zSrc), allBits);
+	case TGL_ALWAYS:
+		return allBits;
+	default:
+		return _mm_setzero_si128();
+	}
+}
+
+// The shifts of the pixel format of a span
+struct SpanFormat {
+	__m128i rShift, gShift, bShift, aShift, aLoss, opaque;
+
+	explicit SpanFormat(const FrameBuffer::Span &span) :
+		rShift(_mm_cvtsi32_si128(span.rShift)), gShift(_mm_cvtsi32_si128(span.gShift)),
+		bShift(_mm_cvtsi32_si128(span.bShift)), aShift(_mm_cvtsi32_si128(span.aShift)),
+		aLoss(_mm_cvtsi32_si128(span.aLoss)), opaque(_mm_set1_epi32((0xFF >> span.aLoss) << span.aShift)) {
+	}
+};
+
+// The colours of 4 pixels from their 8 bit channels, blended with the pixels
+// in the frame buffer if the span is blended
+static FORCEINLINE __m128i spanColor(const FrameBuffer::Span &span, const SpanFormat &format, __m128i dst,
+                                     __m128i aSrc, __m128i rSrc, __m128i gSrc, __m128i bSrc) {
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	__m128i color;
+	if (!span.blending) {
+		color = _mm_sll_epi32(_mm_srl_epi32(aSrc, format.aLoss), format.aShift);
+		color = _mm_or_si128(color, _mm_sll_epi32(rSrc, format.rShift));
+		color = _mm_or_si128(color, _mm_sll_epi32(gSrc, format.gShift));
+		color = _mm_or_si128(color, _mm_sll_epi32(bSrc, format.bShift));
+	} else {
+		// The channels are below 256, so their products fit in the low
+		// halves of the lanes. The sums can't overflow a channel.
+		const __m128i aInv = _mm_sub_epi32(byteMask, aSrc);
+		const __m128i rDst = _mm_and_si128(_mm_srl_epi32(dst, format.rShift), byteMask);
+		const __m128i gDst = _mm_and_si128(_mm_srl_epi32(dst, format.gShift), byteMask);
+		const __m128i bDst = _mm_and_si128(_mm_srl_epi32(dst, format.bShift), byteMask);
+		const __m128i rOut = _mm_add_epi32(_mm_srli_epi32(_mm_mullo_epi16(rSrc, aSrc), 8), _mm_srli_epi32(_mm_mullo_epi16(rDst, aInv), 8));
+		const __m128i gOut = _mm_add_epi32(_mm_srli_epi32(_mm_mullo_epi16(gSrc, aSrc), 8), _mm_srli_epi32(_mm_mullo_epi16(gDst, aInv), 8));
+		const __m128i bOut = _mm_add_epi32(_mm_srli_epi32(_mm_mullo_epi16(bSrc, aSrc), 8), _mm_srli_epi32(_mm_mullo_epi16(bDst, aInv), 8));
+		color = _mm_or_si128(format.opaque, _mm_sll_epi32(rOut, format.rShift));
+		color = _mm_or_si128(color, _mm_sll_epi32(gOut, format.gShift));
+		color = _mm_or_si128(color, _mm_sll_epi32(bOut, format.bShift));
+	}
+	return color;
+}
+
+// The depth test of 4 pixels, which also writes their depths if enabled
+static FORCEINLINE __m128i spanDepth(const FrameBuffer::Span &span, int depthFunc, __m128i *zbuf, __m128i z) {
+	const __m128i zDst = _mm_loadu_si128(zbuf);
+	const __m128i mask = spanCompareDepth(z, zDst, depthFunc);
+	if (span.depthWrite && _mm_movemask_epi8(mask)) {
+		// writePixel() writes the depth through a float
+		_mm_storeu_si128(zbuf, spanSelect(mask, _mm_cvttps_epi32(_mm_cvtepi32_ps(z)), zDst));
+	}
+	return mask;
+}
+
+void FrameBuffer::fillSpanSSE2(const Span &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	const SpanFormat format(span);
+
+	__m128i z = spanSteps(span.z, span.dzdx);
+	__m128i r = spanSteps(span.r, span.drdx);
+	__m128i g = spanSteps(span.g, span.dgdx);
+	__m128i b = spanSteps(span.b, span.dbdx);
+	__m128i a = spanSteps(span.a, span.dadx);
+	const __m128i dz = _mm_set1_epi32(4 * (uint)span.dzdx);
+	const __m128i dr = _mm_set1_epi32(4 * (uint)span.drdx);
+	const __m128i dg = _mm_set1_epi32(4 * (uint)span.dgdx);
+	const __m128i db = _mm_set1_epi32(4 * (uint)span.dbdx);
+	const __m128i da = _mm_set1_epi32(4 * (uint)span.dadx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		__m128i *pixels = (__m128i *)(span.pixels + i);
+
+		const __m128i mask = spanDepth(span, depthFunc, (__m128i *)(span.zbuf + i), z);
+		if (_mm_movemask_epi8(mask)) {
+			const __m128i rSrc = _mm_and_si128(_mm_srli_epi32(r, ZB_POINT_RED_BITS - 8), byteMask);
+			const __m128i gSrc = _mm_and_si128(_mm_srli_epi32(g, ZB_POINT_GREEN_BITS - 8), byteMask);
+			const __m128i bSrc = _mm_and_si128(_mm_srli_epi32(b, ZB_POINT_BLUE_BITS - 8), byteMask);
+			const __m128i aSrc = _mm_and_si128(_mm_srli_epi32(a, ZB_POINT_ALPHA_BITS - 8), byteMask);
+			const __m128i dst = _mm_loadu_si128(pixels);
+			_mm_storeu_si128(pixels, spanSelect(mask, spanColor(span, format, dst, aSrc, rSrc, gSrc, bSrc), dst));
+		}
+
+		z = _mm_add_epi32(z, dz);
+		r = _mm_add_epi32(r, dr);
+		g = _mm_add_epi32(g, dg);
+		b = _mm_add_epi32(b, db);
+		a = _mm_add_epi32(a, da);
+	}
+}
+
+// Texture coordinates wrapped as TexelBuffer::getARGBAt() does
+static FORCEINLINE __m128i spanWrap(__m128i coord, uint wrapMode, __m128i fracUnit, __m128i fracMask) {
+	switch (wrapMode) {
+	case TGL_MIRRORED_REPEAT: {
+		const __m128i inside = _mm_and_si128(coord, fracMask);
+		const __m128i even = _mm_cmpeq_epi32(_mm_and_si128(coord, fracUnit), _mm_setzero_si128());
+		return spanSelect(even, inside, _mm_sub_epi32(fracMask, inside));
+	}
+	case TGL_CLAMP_TO_EDGE:
+		coord = _mm_andnot_si128(_mm_srai_epi32(coord, 31), coord);
+		return spanSelect(_mm_cmpgt_epi32(coord, fracMask), fracMask, coord);
+	default:
+		return _mm_and_si128(coord, fracMask);
+	}
+}
+
+// Swap the bytes of each lane
+static FORCEINLINE __m128i spanSwapBytes(__m128i v) {
+	v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+// A channel of 4 bilinear texels, from lanes which hold it for the 4 pixels
+// of each texel, as BilinearTexelBuffer::getARGBAt() interpolates it
+static FORCEINLINE __m128i spanInterpolate(__m128i pixels, __m128i mirrored, __m128i weights) {
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	pixels = spanSelect(mirrored, spanSwapBytes(pixels), pixels);
+	const __m128i p00 = _mm_and_si128(pixels, byteMask);
+	const __m128i p01 = _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask);
+	const __m128i p10 = _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask);
+	const __m128i deltas = _mm_or_si128(_mm_and_si128(_mm_sub_epi32(p01, p00), _mm_set1_epi32(0xFFFF)),
+	                                    _mm_slli_epi32(_mm_sub_epi32(p10, p00), 16));
+	return _mm_add_epi32(p00, _mm_srai_epi32(_mm_madd_epi16(deltas, weights), ZB_POINT_ST_FRAC_BITS));
+}
+
+// A channel of the texels, modulated by the colour
+template <int kColorBits>
+static FORCEINLINE __m128i spanModulate(__m128i texel, __m128i color) {
+	return _mm_srli_epi32(_mm_mullo_epi16(texel, _mm_srli_epi32(color, kColorBits - 8)), kColorBits - 8);
+}
+
+void FrameBuffer::fillTextureSpanSSE2(const TextureSpan &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	const __m128i byteMask = _mm_set1_epi32(0xFF);
+	const __m128i fracBits = _mm_set1_epi32((1 << ZB_POINT_ST_FRAC_BITS) - 1);
+	const __m128i fracUnit = _mm_set1_epi32(span.fracUnit);
+	const __m128i fracMask = _mm_set1_epi32(span.fracMask);
+	const __m128i texWidth = _mm_set1_epi32(span.texWidth);
+	const __m128 widthRatio = _mm_set1_ps(span.widthRatio);
+	const __m128 heightRatio = _mm_set1_ps(span.heightRatio);
+	const __m128i texRShift = _mm_cvtsi32_si128(span.texRShift);
+	const __m128i texGShift = _mm_cvtsi32_si128(span.texGShift);
+	const __m128i texBShift = _mm_cvtsi32_si128(span.texBShift);
+	const __m128i texAShift = _mm_cvtsi32_si128(span.texAShift);
+	const SpanFormat format(span);
+
+	__m128i z = spanSteps(span.z, span.dzdx);
+	__m128i s = spanSteps(span.s, span.dsdx);
+	__m128i t = spanSteps(span.t, span.dtdx);
+	__m128i r = spanSteps(span.r, span.drdx);
+	__m128i g = spanSteps(span.g, span.dgdx);
+	__m128i b = spanSteps(span.b, span.dbdx);
+	__m128i a = spanSteps(span.a, span.dadx);
+	const __m128i dz = _mm_set1_epi32(4 * (uint)span.dzdx);
+	const __m128i ds = _mm_set1_epi32(4 * (uint)span.dsdx);
+	const __m128i dt = _mm_set1_epi32(4 * (uint)span.dtdx);
+	const __m128i dr = _mm_set1_epi32(4 * (uint)span.drdx);
+	const __m128i dg = _mm_set1_epi32(4 * (uint)span.dgdx);
+	const __m128i db = _mm_set1_epi32(4 * (uint)span.dbdx);
+	const __m128i da = _mm_set1_epi32(4 * (uint)span.dadx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		__m128i *pixels = (__m128i *)(span.pixels + i);
+
+		const __m128i mask = spanDepth(span, depthFunc, (__m128i *)(span.zbuf + i), z);
+		if (_mm_movemask_epi8(mask)) {
+			// The coordinates are scaled to the texture through floats, and
+			// its rows are shorter than 32768 texels
+			const __m128i x = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(spanWrap(s, span.wrapS, fracUnit, fracMask)), widthRatio));
+			const __m128i y = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(spanWrap(t, span.wrapT, fracUnit, fracMask)), heightRatio));
+			const __m128i offsets = _mm_add_epi32(_mm_srli_epi32(x, ZB_POINT_ST_FRAC_BITS),
+			                                      _mm_madd_epi16(_mm_srli_epi32(y, ZB_POINT_ST_FRAC_BITS), texWidth));
+			uint32 texels[4];
+			_mm_storeu_si128((__m128i *)texels, offsets);
+
+			__m128i aSrc, rSrc, gSrc, bSrc;
+			if (!span.bilinear) {
+				const __m128i texel = _mm_setr_epi32(span.texels[texels[0]], span.texels[texels[1]], span.texels[texels[2]], span.texels[texels[3]]);
+				aSrc = _mm_and_si128(_mm_srl_epi32(texel, texAShift), byteMask);
+				rSrc = _mm_and_si128(_mm_srl_epi32(texel, texRShift), byteMask);
+				gSrc = _mm_and_si128(_mm_srl_epi32(texel, texGShift), byteMask);
+				bSrc = _mm_and_si128(_mm_srl_epi32(texel, texBShift), byteMask);
+			} else {
+				// Each texel holds a row of the 4 pixels to interpolate for
+				// each channel, which are transposed into a row per channel
+				const __m128i texel0 = _mm_loadu_si128((const __m128i *)(span.texels + 4 * texels[0]));
+				const __m128i texel1 = _mm_loadu_si128((const __m128i *)(span.texels + 4 * texels[1]));
+				const __m128i texel2 = _mm_loadu_si128((const __m128i *)(span.texels + 4 * texels[2]));
+				const __m128i texel3 = _mm_loadu_si128((const __m128i *)(span.texels + 4 * texels[3]));
+				const __m128i ar01 = _mm_unpacklo_epi32(texel0, texel1);
+				const __m128i ar23 = _mm_unpacklo_epi32(texel2, texel3);
+				const __m128i gb01 = _mm_unpackhi_epi32(texel0, texel1);
+				const __m128i gb23 = _mm_unpackhi_epi32(texel2, texel3);
+
+				// Past the diagonal, the pixel on the other side of it is
+				// interpolated from, which swaps the pixels of the rows
+				const __m128i unit = _mm_set1_epi32(1 << ZB_POINT_ST_FRAC_BITS);
+				__m128i xFrac = _mm_and_si128(x, fracBits);
+				__m128i yFrac = _mm_and_si128(y, fracBits);
+				const __m128i mirrored = _mm_cmpgt_epi32(_mm_add_epi32(xFrac, yFrac), unit);
+				xFrac = spanSelect(mirrored, _mm_sub_epi32(unit, xFrac), xFrac);
+				yFrac = spanSelect(mirrored, _mm_sub_epi32(unit, yFrac), yFrac);
+				const __m128i weights = _mm_or_si128(xFrac, _mm_slli_epi32(yFrac, 16));
+
+				aSrc = spanInterpolate(_mm_unpacklo_epi64(ar01, ar23), mirrored, weights);
+				rSrc = spanInterpolate(_mm_unpackhi_epi64(ar01, ar23), mirrored, weights);
+				gSrc = spanInterpolate(_mm_unpacklo_epi64(gb01, gb23), mirrored, weights);
+				bSrc = spanInterpolate(_mm_unpackhi_epi64(gb01, gb23), mirrored, weights);
+			}
+
+			if (span.lighting) {
+				aSrc = spanModulate<ZB_POINT_ALPHA_BITS>(aSrc, a);
+				rSrc = spanModulate<ZB_POINT_RED_BITS>(rSrc, r);
+				gSrc = spanModulate<ZB_POINT_GREEN_BITS>(gSrc, g);
+				bSrc = spanModulate<ZB_POINT_BLUE_BITS>(bSrc, b);
+			}
+
+			const __m128i dst = _mm_loadu_si128(pixels);
+			_mm_storeu_si128(pixels, spanSelect(mask, spanColor(span, format, dst, aSrc, rSrc, gSrc, bSrc), dst));
+		}
+
+		z = _mm_add_epi32(z, dz);
+		s = _mm_add_epi32(s, ds);
+		t = _mm_add_epi32(t, dt);
+		r = _mm_add_epi32(r, dr);
+		g = _mm_add_epi32(g, dg);
+		b = _mm_add_epi32(b, db);
+		a = _mm_add_epi32(a, da);
+	}
+}
+
+void FrameBuffer::fillDepthSpanSSE2(const Span &span) {
+	const int depthFunc = span.depthTest ? span.depthFunc : TGL_ALWAYS;
+	__m128i z = spanSteps(span.z, span.dzdx);
+	const __m128i dz = _mm_set1_epi32(4 * (uint)span.dzdx);
+
+	for (int i = 0; i < span.count; i += 4) {
+		__m128i *zbuf = (__m128i *)(span.zbuf + i);
+		const __m128i zDst = _mm_loadu_si128(zbuf);
+		_mm_storeu_si128(zbuf, spanSelect(spanCompareDepth(z, zDst, depthFunc), z, zDst));
+		z = _mm_add_epi32(z, dz);
+	}
+}
+
+} // end of namespace TinyGL
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -0,0 +1,170 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "graphics/tinygl/ztiles.h"
+#include "graphics/tinygl/zgl.h"
+
+#include "common/taskpool.h"
+
+namespace TinyGL {
+
+TileRenderer::TileRenderer(GLContext *c, Common::TaskPool *pool) : _context(c), _pool(pool) {
+	const int width = c->fb->getPixelBufferWidth();
+	const int height = c->fb->getPixelBufferHeight();
+
+	_tiles.resize((height + kTileHeight - 1) / kTileHeight);
+	for (uint i = 0; i < _tiles.size(); i++) {
+		Tile &tile = _tiles[i];
+		tile.rect = Common::Rect(0, i * kTileHeight, width, MIN<int>((i + 1) * kTileHeight, height));
+
+		// The state which the draw calls don't capture
+		tile.context = new GLContext();
+		tile.context->fb = new FrameBuffer(c->fb);
+		tile.context->render_mode = TGL_RENDER;
+		tile.context->_textureSize = c->_textureSize;
+		tile.context->vertex_max = POLYGON_MAX_VERTEX;
+		tile.context->vertex = (GLVertex *)gl_malloc(POLYGON_MAX_VERTEX * sizeof(GLVertex));
+	}
+}
+
+TileRenderer::~TileRenderer() {
+	for (auto &tile : _tiles) {
+		gl_free(tile.context->vertex);
+		delete tile.context->fb;
+		delete tile.context;
+	}
+}
+
+bool TileRenderer::canExecuteInTiles(const DrawCall *drawCall) {
+	switch (drawCall->getType()) {
+	case DrawCall::DrawCall_Rasterization:
+		return ((const RasterizationDrawCall *)drawCall)->canExecuteOnOtherContext();
+	case DrawCall::DrawCall_Clear:
+		return true;
+	default:
+		// Clipping a transformed blit changes the pixels it draws
+		return false;
+	}
+}
+
+void TileRenderer::execute(const Common::List<DrawCall *> &drawCalls, const Common::Array<Common::Rect> *dirtyRects) {
+	for (auto &tile : _tiles) {
+		tile.context->fb->shareBuffers(_context->fb);
+		tile.context->current_cull_face = _context->current_cull_face;
+	}
+
+	Common::Array<Common::Rect> allRects;
+	if (!dirtyRects)
+		allRects.push_back(_context->renderRect);
+	const Common::Array<Common::Rect> &rects = dirtyRects ? *dirtyRects : allRects;
+
+	Common::List<DrawCall *>::const_iterator it = drawCalls.begin();
+	while (it != drawCalls.end()) {
+		for ( ; it != drawCalls.end() && canExecuteInTiles(*it); ++it)
+			binDrawCall(*it, rects, dirtyRects != nullptr);
+		executeTiles();
+
+		if (it == drawCalls.end())
+			break;
+
+		const DrawCall *drawCall = *it++;
+		if (!dirtyRects) {
+			drawCall->execute(true);
+			continue;
+		}
+		const Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+		for (const auto &rect : rects) {
+			if (rect.intersects(drawCallRegion))
+				drawCall->execute(true, &rect);
+		}
+	}
+}
+
+void TileRenderer::binDrawCall(const DrawCall *drawCall, const Common::Array<Common::Rect> &rects, bool checkRegion) {
+	const int height = _context->fb->getPixelBufferHeight();
+	int top = 0, bottom = height;
+	const RasterizationDrawCall *rasterizationCall = nullptr;
+	if (drawCall->getType() == DrawCall::DrawCall_Rasterization) {
+		rasterizationCall = (const RasterizationDrawCall *)drawCall;
+		rasterizationCall->getRows(height, top, bottom);
+	}
+
+	// A call is executed for every rect which touches its dirty region, and
+	// draws all of its pixels within those rects
+	const Common::Rect drawCallRegion = drawCall->getDirtyRegion();
+	bool executed = false;
+	for (const auto &rect : rects) {
+		if (checkRegion && !rect.intersects(drawCallRegion))
+			continue;
+		executed = true;
+
+		const int first = MAX<int>(rect.top, top);
+		const int last = MIN<int>(rect.bottom, bottom) - 1;
+		if (first > last)
+			continue;
+
+		for (int i = first / kTileHeight; i <= last / kTileHeight; i++) {
+			Job job;
+			job.drawCall = drawCall;
+			job.clippingRectangle = rect.findIntersectingRect(_tiles[i].rect);
+			if (!job.clippingRectangle.isEmpty())
+				_tiles[i].jobs.push_back(job);
+		}
+	}
+
+	if (rasterizationCall && executed)
+		_executedCalls.push_back(rasterizationCall);
+}
+
+void TileRenderer::executeTiles() {
+	_pool->parallelFor(0, _tiles.size(), 1, [this](uint begin, uint end) {
+		for (uint i = begin; i < end; i++)
+			executeTile(_tiles[i]);
+	});
+
+	for (auto &tile : _tiles)
+		tile.jobs.clear();
+
+	// The tiles drew with copies of the vertices
+	for (const auto &drawCall : _executedCalls)
+		drawCall->updateVertices();
+	_executedCalls.clear();
+}
+
+void TileRenderer::executeTile(Tile &tile) {
+	GLContext *c = tile.context;
+	for (const auto &job : tile.jobs) {
+		if (job.drawCall->getType() == DrawCall::DrawCall_Clear) {
+			((const ClearBufferDrawCall *)job.drawCall)->execute(c, &job.clippingRectangle);
+			continue;
+		}
+
+		const RasterizationDrawCall *drawCall = (const RasterizationDrawCall *)job.drawCall;
+		if (drawCall->getVertexCount() > c->vertex_max) {
+			c->vertex_max = drawCall->getVertexCount();
+			c->vertex = (GLVertex *)gl_realloc(c->vertex, sizeof(GLVertex) * c->vertex_max);
+		}
+		drawCall->execute(c, c->vertex, &job.clippingRectangle);
+	}
+}
+
+} // end of namespace TinyGL
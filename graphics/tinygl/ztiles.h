@@ -0,0 +1,91 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef GRAPHICS_TINYGL_ZTILES_H
+#define GRAPHICS_TINYGL_ZTILES_H
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/rect.h"
+
+namespace Common {
+class TaskPool;
+}
+
+namespace TinyGL {
+
+struct GLContext;
+class DrawCall;
+class RasterizationDrawCall;
+
+/**
+ * Executes the draw calls of a frame in tiles on the threads of a task pool.
+ *
+ * The tiles are bands of full rows, as the triangles are clipped to the
+ * scissor rectangle row by row. Each draw call is binned into the tiles
+ * its rows overlap, and each tile executes its calls in order with a
+ * context of its own, clipped to the tile. So the tiles draw into disjoint
+ * parts of the buffers, and the frame is the same as when the calls are
+ * executed one after another. Blits, and the calls which need the current
+ * context, are executed on the calling thread in between.
+ */
+class TileRenderer {
+public:
+	enum {
+		kTileHeight = 32
+	};
+
+	TileRenderer(GLContext *c, Common::TaskPool *pool);
+	~TileRenderer();
+
+	/**
+	 * Execute the draw calls like GLContext::presentBufferSimple(), or like
+	 * GLContext::presentBufferDirtyRects() when @p dirtyRects is given.
+	 */
+	void execute(const Common::List<DrawCall *> &drawCalls, const Common::Array<Common::Rect> *dirtyRects);
+
+private:
+	struct Job {
+		const DrawCall *drawCall;
+		Common::Rect clippingRectangle;
+	};
+
+	struct Tile {
+		Common::Rect rect;
+		GLContext *context;
+		Common::Array<Job> jobs;
+	};
+
+	static bool canExecuteInTiles(const DrawCall *drawCall);
+	void binDrawCall(const DrawCall *drawCall, const Common::Array<Common::Rect> &rects, bool checkRegion);
+	void executeTiles();
+	void executeTile(Tile &tile);
+
+	GLContext *_context;
+	Common::TaskPool *_pool;
+	Common::Array<Tile> _tiles;
+	Common::Array<const RasterizationDrawCall *> _executedCalls;
+};
+
+} // end of namespace TinyGL
+
+#endif
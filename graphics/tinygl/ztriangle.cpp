@@ -29,6 +29,7 @@
 #include "graphics/tinygl/texelbuffer.h"
 #include "graphics/tinygl/zbuffer.h"
 #include "graphics/tinygl/zgl.h"
+#include "graphics/tinygl/colormasks.h"
 
 namespace TinyGL {
 
@@ -182,12 +183,176 @@ end:
 	z += dzdx;
 }
 
+// Draw as much of the start of a span as the span procs can, and step the
+// interpolated values past it. The rest of the span is left to
+// putPixelNoTexture() or putPixelDepth(), which draw the same pixels.
+template <bool kInterpRGB, bool kSmoothMode, bool kDepthWrite, bool kEnableScissor, bool kEnableBlending, bool kDepthTestEnabled>
+void FrameBuffer::fillSpan(int &pp, uint *&pz, int &x, int &n, uint &z, uint &r, uint &g, uint &b, uint &a,
+                           int dzdx, int drdx, int dgdx, int dbdx, uint dadx) {
+	if (!_spanFormat)
+		return;
+	if (kEnableBlending && (_sourceBlendingFactor != TGL_SRC_ALPHA || _destinationBlendingFactor != TGL_ONE_MINUS_SRC_ALPHA))
+		return;
+
+	int skip = 0;
+	int count = n + 1;
+	if (kEnableScissor) {
+		// The row is inside the clipping rectangle, so only the pixels to the
+		// left of it are skipped, and the ones to the right are left over
+		skip = CLIP(_clipRectangle.left - x, 0, count);
+		count = MIN(count, _clipRectangle.right - x) - skip;
+	}
+	count &= ~3;
+	if (count <= 0)
+		return;
+
+	const uint zFirst = z + (uint)skip * dzdx;
+	if (kInterpRGB && kDepthWrite) {
+		// writePixel() writes the depth through a float, which the span procs
+		// only do for depths which fit in an int
+		const int64 zLast = (int64)zFirst + (int64)dzdx * (count - 1);
+		if (zFirst >= 0x80000000u || zLast < 0 || zLast >= 0x80000000LL)
+			return;
+	}
+
+	Span span;
+	span.pixels = (uint32 *)_pbuf + pp + skip;
+	span.zbuf = pz + skip;
+	span.count = count;
+	span.z = zFirst;
+	span.dzdx = dzdx;
+	span.depthFunc = _depthFunc;
+	span.depthTest = kDepthTestEnabled;
+	span.depthWrite = kDepthWrite;
+	if (!kInterpRGB) {
+		_fillDepthSpan(span);
+	} else {
+		if (kSmoothMode) {
+			r += (uint)skip * drdx;
+			g += (uint)skip * dgdx;
+			b += (uint)skip * dbdx;
+			a += (uint)skip * dadx;
+		}
+		span.r = r;
+		span.g = g;
+		span.b = b;
+		span.a = a;
+		span.drdx = kSmoothMode ? drdx : 0;
+		span.dgdx = kSmoothMode ? dgdx : 0;
+		span.dbdx = kSmoothMode ? dbdx : 0;
+		span.dadx = kSmoothMode ? dadx : 0;
+		span.blending = kEnableBlending;
+		span.rShift = _pbufFormat.rShift;
+		span.gShift = _pbufFormat.gShift;
+		span.bShift = _pbufFormat.bShift;
+		span.aShift = _pbufFormat.aShift;
+		span.aLoss = _pbufFormat.aLoss;
+		_fillSpan(span);
+		if (kSmoothMode) {
+			r += (uint)count * drdx;
+			g += (uint)count * dgdx;
+			b += (uint)count * dbdx;
+			a += (uint)count * dadx;
+		}
+	}
+
+	z = zFirst + (uint)count * dzdx;
+	pp += skip + count;
+	pz += skip + count;
+	x += skip + count;
+	n -= skip + count;
+}
+
+// Set up the parts of the textured spans of a triangle which stay the same,
+// or return false if the span procs can't draw them
+template <bool kLightsMode, bool kSmoothMode, bool kDepthWrite, bool kEnableBlending, bool kDepthTestEnabled>
+bool FrameBuffer::initTextureSpan(TextureSpan &span, const TexelBuffer *texture, int dzdx, int drdx, int dgdx, int dbdx, uint dadx) {
+	if (!_spanFormat || texture->_spanLayout == TexelBuffer::kSpanLayoutNone)
+		return false;
+	if (kEnableBlending && (_sourceBlendingFactor != TGL_SRC_ALPHA || _destinationBlendingFactor != TGL_ONE_MINUS_SRC_ALPHA))
+		return false;
+
+	typedef ColorMasks<TGL_RGBA, TGL_UNSIGNED_BYTE> TexelMask;
+
+	span.count = NB_INTERP;
+	span.dzdx = dzdx;
+	span.drdx = kSmoothMode ? drdx : 0;
+	span.dgdx = kSmoothMode ? dgdx : 0;
+	span.dbdx = kSmoothMode ? dbdx : 0;
+	span.dadx = kSmoothMode ? dadx : 0;
+	span.depthFunc = _depthFunc;
+	span.depthTest = kDepthTestEnabled;
+	span.depthWrite = kDepthWrite;
+	span.blending = kEnableBlending;
+	span.rShift = _pbufFormat.rShift;
+	span.gShift = _pbufFormat.gShift;
+	span.bShift = _pbufFormat.bShift;
+	span.aShift = _pbufFormat.aShift;
+	span.aLoss = _pbufFormat.aLoss;
+	span.texels = texture->_spanTexels;
+	span.wrapS = _wrapS;
+	span.wrapT = _wrapT;
+	span.texWidth = texture->_width;
+	span.fracUnit = texture->_fracTextureUnit;
+	span.fracMask = texture->_fracTextureMask;
+	span.widthRatio = texture->_widthRatio;
+	span.heightRatio = texture->_heightRatio;
+	span.bilinear = texture->_spanLayout == TexelBuffer::kSpanLayoutBilinear;
+	span.lighting = kLightsMode;
+	span.texRShift = TexelMask::kRedShift;
+	span.texGShift = TexelMask::kGreenShift;
+	span.texBShift = TexelMask::kBlueShift;
+	span.texAShift = TexelMask::kAlphaShift;
+	return true;
+}
+
+// Draw the NB_INTERP pixels which the texture coordinates are stepped
+// linearly over with the span procs, and step the interpolated values past
+// them. Returns false if they are left to putPixelTexture().
+template <bool kSmoothMode, bool kDepthWrite, bool kEnableScissor>
+bool FrameBuffer::fillTextureSpan(TextureSpan &span, int pp, uint *pz, int x, uint &z, int s, int t, uint &r, uint &g, uint &b, uint &a,
+                                  int dzdx, int dsdx, int dtdx, int drdx, int dgdx, int dbdx, uint dadx) {
+	if (kEnableScissor && (x < _clipRectangle.left || x + NB_INTERP > _clipRectangle.right))
+		return false;
+	if (kDepthWrite) {
+		// writePixel() writes the depth through a float, which the span procs
+		// only do for depths which fit in an int
+		const int64 zLast = (int64)z + (int64)dzdx * (NB_INTERP - 1);
+		if (z >= 0x80000000u || zLast < 0 || zLast >= 0x80000000LL)
+			return false;
+	}
+
+	span.pixels = (uint32 *)_pbuf + pp;
+	span.zbuf = pz;
+	span.z = z;
+	span.r = r;
+	span.g = g;
+	span.b = b;
+	span.a = a;
+	span.s = s;
+	span.t = t;
+	span.dsdx = dsdx;
+	span.dtdx = dtdx;
+	_fillTextureSpan(span);
+
+	z += (uint)NB_INTERP * dzdx;
+	if (kSmoothMode) {
+		r += (uint)NB_INTERP * drdx;
+		g += (uint)NB_INTERP * dgdx;
+		b += (uint)NB_INTERP * dbdx;
+		a += (uint)NB_INTERP * dadx;
+	}
+	return true;
+}
+
 template <bool kInterpRGB, bool kInterpZ, bool kInterpST, bool kInterpSTZ, bool kSmoothMode,
           bool kDepthWrite, bool kFogMode, bool kAlphaTestEnabled, bool kEnableScissor,
           bool kBlendingEnabled, bool kStencilEnabled, bool kStippleEnabled, bool kDepthTestEnabled>
 void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2) {
 	const TexelBuffer *texture;
 	float fdzdx = 0, fndzdx = 0, ndszdx = 0, ndtzdx = 0;
+	TextureSpan textureSpan;
+	bool textureSpans = false;
 
 	ZBufferPoint *tp, *pr1 = 0, *pr2 = 0, *l1 = 0, *l2 = 0;
 	float fdx1, fdx2, fdy1, fdy2, fz0, d1, d2;
@@ -348,6 +513,10 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 		fndzdx = NB_INTERP * fdzdx;
 		ndszdx = NB_INTERP * dszdx;
 		ndtzdx = NB_INTERP * dtzdx;
+		if (kInterpZ && !kFogMode && !kAlphaTestEnabled && !kStencilEnabled && _fillTextureSpan) {
+			textureSpans = initTextureSpan<kInterpRGB, kSmoothMode, kDepthWrite, kBlendingEnabled, kDepthTestEnabled>
+			               (textureSpan, texture, dzdx, drdx, dgdx, dbdx, dadx);
+		}
 	}
 
 	if (fz0 > 0) {
@@ -448,129 +617,173 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 
 		// we draw all the scan line of the part
 		while (nb_lines > 0) {
-			int x = x1;
-			if (!kInterpRGB) {
-				int n;
-				uint *pz;
-				byte *ps = nullptr;
-				uint z;
-				n = (x2 >> 16) - x1;
-				if (kInterpZ) {
-					pz = pz1 + x1;
-					z = z1;
-				}
-				if (kStencilEnabled) {
-					ps = ps1 + x1;
-				}
-				while (n >= 3) {
-					putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 0, x, y, z, dzdx);
-					putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 1, x, y, z, dzdx);
-					putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 2, x, y, z, dzdx);
-					putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 3, x, y, z, dzdx);
+			// Only the edges are stepped for the rows outside of the clipping
+			// rectangle, so that the rows inside are drawn the same as without it
+			if (kEnableScissor && y >= _clipRectangle.bottom)
+				return;
+			if (!kEnableScissor || y >= _clipRectangle.top) {
+				int x = x1;
+				if (!kInterpRGB) {
+					int n;
+					uint *pz;
+					byte *ps = nullptr;
+					uint z;
+					n = (x2 >> 16) - x1;
 					if (kInterpZ) {
-						pz += 4;
+						pz = pz1 + x1;
+						z = z1;
 					}
 					if (kStencilEnabled) {
-						ps += 4;
+						ps = ps1 + x1;
 					}
-					n -= 4;
-					x += 4;
-				}
-				while (n >= 0) {
-					putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 0, x, y, z, dzdx);
-					if (kInterpZ) {
-						pz += 1;
+					if (kDepthWrite && !kStencilEnabled && _fillDepthSpan) {
+						int pp = 0;
+						uint c = 0;
+						fillSpan<false, false, kDepthWrite, kEnableScissor, false, kDepthTestEnabled>(pp, pz, x, n, z, c, c, c, c, dzdx, 0, 0, 0, 0);
 					}
-					if (kStencilEnabled) {
-						ps += 1;
+					while (n >= 3) {
+						putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 0, x, y, z, dzdx);
+						putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 1, x, y, z, dzdx);
+						putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 2, x, y, z, dzdx);
+						putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 3, x, y, z, dzdx);
+						if (kInterpZ) {
+							pz += 4;
+						}
+						if (kStencilEnabled) {
+							ps += 4;
+						}
+						n -= 4;
+						x += 4;
+					}
+					while (n >= 0) {
+						putPixelDepth<kDepthWrite, kEnableScissor, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>(pz, ps, 0, x, y, z, dzdx);
+						if (kInterpZ) {
+							pz += 1;
+						}
+						if (kStencilEnabled) {
+							ps += 1;
+						}
+						n -= 1;
+						x += 1;
+					}
+				} else if (!(kInterpST || kInterpSTZ)) {
+					uint *pz;
+					byte *ps = nullptr;
+					int pp;
+					uint z, r, g, b, a, fog;
+					int n = (x2 >> 16) - x1;
+					pp = pp1 + x1;
+					r = r1;
+					g = g1;
+					b = b1;
+					a = a1;
+					if (kFogMode) {
+						fog = f1;
 					}
-					n -= 1;
-					x += 1;
-				}
-			} else if (!(kInterpST || kInterpSTZ)) {
-				uint *pz;
-				byte *ps = nullptr;
-				int pp;
-				uint z, r, g, b, a, fog;
-				int n = (x2 >> 16) - x1;
-				pp = pp1 + x1;
-				r = r1;
-				g = g1;
-				b = b1;
-				a = a1;
-				if (kFogMode) {
-					fog = f1;
-				}
-				if (kInterpZ) {
-					pz = pz1 + x1;
-					z = z1;
-				}
-				if (kStencilEnabled) {
-					ps = ps1 + x1;
-				}
-				while (n >= 3) {
-					putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
-					                 (pp, pz, ps, 0, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
-					                 (pp, pz, ps, 1, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
-					                 (pp, pz, ps, 2, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
-					                 (pp, pz, ps, 3, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					pp += 4;
 					if (kInterpZ) {
-						pz += 4;
+						pz = pz1 + x1;
+						z = z1;
 					}
 					if (kStencilEnabled) {
-						ps += 4;
+						ps = ps1 + x1;
+					}
+					if (!kFogMode && !kAlphaTestEnabled && !kStencilEnabled && !kStippleEnabled && _fillSpan) {
+						fillSpan<true, kSmoothMode, kDepthWrite, kEnableScissor, kBlendingEnabled, kDepthTestEnabled>(pp, pz, x, n, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx);
+					}
+					while (n >= 3) {
+						putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
+						                 (pp, pz, ps, 0, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
+						                 (pp, pz, ps, 1, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
+						                 (pp, pz, ps, 2, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
+						                 (pp, pz, ps, 3, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						pp += 4;
+						if (kInterpZ) {
+							pz += 4;
+						}
+						if (kStencilEnabled) {
+							ps += 4;
+						}
+						n -= 4;
+						x += 4;
+					}
+					while (n >= 0) {
+						putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
+						                 (pp, pz, ps, 0, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						pp += 1;
+						if (kInterpZ) {
+							pz += 1;
+						}
+						if (kStencilEnabled) {
+							ps += 1;
+						}
+						n -= 1;
+						x += 1;
+					}
+				} else if (kInterpST || kInterpSTZ) {
+					uint *pz;
+					byte *ps = nullptr;
+					int s, t;
+					uint z, r, g, b, a, fog;
+					int n, pp;
+					float sz, tz, fz, zinv;
+					int dsdx, dtdx;
+
+					n = (x2 >> 16) - x1;
+					fz = (float)z1;
+					zinv = (float)(1.0 / fz);
+
+					pp = pp1 + x1;
+					if (kFogMode) {
+						fog = f1;
 					}
-					n -= 4;
-					x += 4;
-				}
-				while (n >= 0) {
-					putPixelNoTexture<kDepthWrite, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kStippleEnabled, kDepthTestEnabled>
-					                 (pp, pz, ps, 0, x, y, z, r, g, b, a, dzdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					pp += 1;
 					if (kInterpZ) {
-						pz += 1;
+						pz = pz1 + x1;
+						z = z1;
 					}
 					if (kStencilEnabled) {
-						ps += 1;
+						ps = ps1 + x1;
 					}
-					n -= 1;
-					x += 1;
-				}
-			} else if (kInterpST || kInterpSTZ) {
-				uint *pz;
-				byte *ps = nullptr;
-				int s, t;
-				uint z, r, g, b, a, fog;
-				int n, pp;
-				float sz, tz, fz, zinv;
-				int dsdx, dtdx;
-
-				n = (x2 >> 16) - x1;
-				fz = (float)z1;
-				zinv = (float)(1.0 / fz);
-
-				pp = pp1 + x1;
-				if (kFogMode) {
-					fog = f1;
-				}
-				if (kInterpZ) {
-					pz = pz1 + x1;
-					z = z1;
-				}
-				if (kStencilEnabled) {
-					ps = ps1 + x1;
-				}
-				sz = sz1;
-				tz = tz1;
-				r = r1;
-				g = g1;
-				b = b1;
-				a = a1;
-				while (n >= (NB_INTERP - 1)) {
+					sz = sz1;
+					tz = tz1;
+					r = r1;
+					g = g1;
+					b = b1;
+					a = a1;
+					while (n >= (NB_INTERP - 1)) {
+						{
+							float ss, tt;
+							ss = sz * zinv;
+							tt = tz * zinv;
+							s = (int)ss;
+							t = (int)tt;
+							dsdx = (int)((dszdx - ss * fdzdx) * zinv);
+							dtdx = (int)((dtzdx - tt * fdzdx) * zinv);
+							fz += fndzdx;
+							zinv = (float)(1.0 / fz);
+						}
+						if (!textureSpans ||
+						    !fillTextureSpan<kSmoothMode, kDepthWrite, kEnableScissor>(textureSpan, pp, pz, x, z, s, t, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx)) {
+							for (int _a = 0; _a < NB_INTERP; _a++) {
+								putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
+								               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+							}
+						}
+						pp += NB_INTERP;
+						if (kInterpZ) {
+							pz += NB_INTERP;
+						}
+						if (kStencilEnabled) {
+							ps += NB_INTERP;
+						}
+						sz += ndszdx;
+						tz += ndtzdx;
+						n -= NB_INTERP;
+						x += NB_INTERP;
+					}
+
 					{
 						float ss, tt;
 						ss = sz * zinv;
@@ -579,48 +792,21 @@ void FrameBuffer::fillTriangle(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint
 						t = (int)tt;
 						dsdx = (int)((dszdx - ss * fdzdx) * zinv);
 						dtdx = (int)((dtzdx - tt * fdzdx) * zinv);
-						fz += fndzdx;
-						zinv = (float)(1.0 / fz);
-					}
-					for (int _a = 0; _a < NB_INTERP; _a++) {
-						putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
-						               (pp, texture, _wrapS, _wrapT, pz, ps, _a, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					}
-					pp += NB_INTERP;
-					if (kInterpZ) {
-						pz += NB_INTERP;
-					}
-					if (kStencilEnabled) {
-						ps += NB_INTERP;
 					}
-					sz += ndszdx;
-					tz += ndtzdx;
-					n -= NB_INTERP;
-					x += NB_INTERP;
-				}
-
-				{
-					float ss, tt;
-					ss = sz * zinv;
-					tt = tz * zinv;
-					s = (int)ss;
-					t = (int)tt;
-					dsdx = (int)((dszdx - ss * fdzdx) * zinv);
-					dtdx = (int)((dtzdx - tt * fdzdx) * zinv);
-				}
 
-				while (n >= 0) {
-					putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
-					               (pp, texture, _wrapS, _wrapT, pz, ps, 0, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
-					pp += 1;
-					if (kInterpZ) {
-						pz += 1;
-					}
-					if (kStencilEnabled) {
-						ps += 1;
+					while (n >= 0) {
+						putPixelTexture<kDepthWrite, kInterpRGB, kSmoothMode, kFogMode, kAlphaTestEnabled, kEnableScissor, kBlendingEnabled, kStencilEnabled, kDepthTestEnabled>
+						               (pp, texture, _wrapS, _wrapT, pz, ps, 0, x, y, z, t, s, r, g, b, a, dzdx, dsdx, dtdx, drdx, dgdx, dbdx, dadx, fog, fog_r, fog_g, fog_b, dfdx);
+						pp += 1;
+						if (kInterpZ) {
+							pz += 1;
+						}
+						if (kStencilEnabled) {
+							ps += 1;
+						}
+						n -= 1;
+						x += 1;
 					}
-					n -= 1;
-					x += 1;
 				}
 			}
 
@@ -0,0 +1,170 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+struct YUVToRGBConstantsAVX2 {
+	__m256i crToR, crToG, cbToG, cbToB, ituScale;
+	__m128i crToRShift, cbToBShift;
+	__m128i rLoss, gLoss, bLoss, aLoss;
+	__m128i rShift, gShift, bShift, aShift;
+	__m256i aMask16, aMask32;
+};
+
+// ((|x| << shift) * factor) >> 16 with the sign of x, which truncates towards zero like the tables
+static FORCEINLINE __m256i mulChroma(__m256i x, __m256i factor, __m128i shift) {
+	const __m256i sign = _mm256_srai_epi16(x, 15);
+	__m256i v = _mm256_abs_epi16(x);
+	v = _mm256_mulhi_epu16(_mm256_sll_epi16(v, shift), factor);
+	return _mm256_sub_epi16(_mm256_xor_si256(v, sign), sign);
+}
+
+template<bool kITU>
+static FORCEINLINE __m256i clampLuminance(__m256i x, const YUVToRGBConstantsAVX2 &c) {
+	if (kITU) {
+		x = _mm256_min_epi16(_mm256_max_epi16(x, _mm256_set1_epi16(16)), _mm256_set1_epi16(235));
+		x = _mm256_sub_epi16(x, _mm256_set1_epi16(16));
+		return _mm256_add_epi16(x, _mm256_mulhi_epu16(x, c.ituScale));
+	}
+
+	return _mm256_min_epi16(_mm256_max_epi16(x, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+}
+
+// The differences which 16 chroma values make to the channels
+static FORCEINLINE void convertChroma(__m256i u, __m256i v, const YUVToRGBConstantsAVX2 &c, __m256i &rDiff, __m256i &gDiff, __m256i &bDiff) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m256i cb = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	const __m256i cr = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+
+	rDiff = mulChroma(cr, c.crToR, c.crToRShift);
+	gDiff = _mm256_add_epi16(mulChroma(cr, c.crToG, zero), mulChroma(cb, c.cbToG, zero));
+	bDiff = mulChroma(cb, c.cbToB, c.cbToBShift);
+}
+
+// Repeat the first 8 values, for chroma which is shared by two pixels
+static FORCEINLINE __m256i repeatChroma(__m256i x) {
+	const __m128i half = _mm256_castsi256_si128(x);
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(half, half)), _mm_unpackhi_epi16(half, half), 1);
+}
+
+static FORCEINLINE __m256i combine32(__m128i r, __m128i g, __m128i b, __m128i a, const YUVToRGBConstantsAVX2 &c) {
+	const __m256i rg = _mm256_or_si256(_mm256_sll_epi32(_mm256_cvtepu16_epi32(r), c.rShift), _mm256_sll_epi32(_mm256_cvtepu16_epi32(g), c.gShift));
+	const __m256i ba = _mm256_or_si256(_mm256_sll_epi32(_mm256_cvtepu16_epi32(b), c.bShift), _mm256_sll_epi32(_mm256_cvtepu16_epi32(a), c.aShift));
+	return _mm256_or_si256(_mm256_or_si256(rg, ba), c.aMask32);
+}
+
+// Convert 16 pixels, with the differences which their chroma values make
+template<typename PixelInt, bool kITU>
+static FORCEINLINE void convertPixels(byte *dst, const byte *ySrc, const byte *aSrc, __m256i rDiff, __m256i gDiff, __m256i bDiff, const YUVToRGBConstantsAVX2 &c) {
+	const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)ySrc));
+	const __m256i a = aSrc ? _mm256_srl_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)aSrc)), c.aLoss) : _mm256_setzero_si256();
+
+	const __m256i r = _mm256_srl_epi16(clampLuminance<kITU>(_mm256_add_epi16(y, rDiff), c), c.rLoss);
+	const __m256i g = _mm256_srl_epi16(clampLuminance<kITU>(_mm256_sub_epi16(y, gDiff), c), c.gLoss);
+	const __m256i b = _mm256_srl_epi16(clampLuminance<kITU>(_mm256_add_epi16(y, bDiff), c), c.bLoss);
+
+	if (sizeof(PixelInt) == 2) {
+		const __m256i rg = _mm256_or_si256(_mm256_sll_epi16(r, c.rShift), _mm256_sll_epi16(g, c.gShift));
+		const __m256i ba = _mm256_or_si256(_mm256_sll_epi16(b, c.bShift), _mm256_sll_epi16(a, c.aShift));
+		_mm256_storeu_si256((__m256i *)dst, _mm256_or_si256(_mm256_or_si256(rg, ba), c.aMask16));
+	} else {
+		_mm256_storeu_si256((__m256i *)dst, combine32(_mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b), _mm256_castsi256_si128(a), c));
+		_mm256_storeu_si256((__m256i *)(dst + 32), combine32(_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1), _mm256_extracti128_si256(a, 1), c));
+	}
+}
+
+template<typename PixelInt, bool kITU>
+static void convertRow(byte *dst, const YUVToRGBConstantsAVX2 &c, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	for (int x = 0; x < width; x += 16) {
+		__m256i rDiff, gDiff, bDiff;
+		if (halfChroma) {
+			const __m256i u = _mm256_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2)));
+			const __m256i v = _mm256_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2)));
+			convertChroma(u, v, c, rDiff, gDiff, bDiff);
+			rDiff = repeatChroma(rDiff);
+			gDiff = repeatChroma(gDiff);
+			bDiff = repeatChroma(bDiff);
+		} else {
+			const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + x)));
+			const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + x)));
+			convertChroma(u, v, c, rDiff, gDiff, bDiff);
+		}
+
+		convertPixels<PixelInt, kITU>(dst, ySrc + x, aSrc ? aSrc + x : nullptr, rDiff, gDiff, bDiff, c);
+		dst += 16 * sizeof(PixelInt);
+	}
+}
+
+void YUVToRGBManager::convertRowAVX2(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	const uint32 aMask = aSrc ? 0 : (0xFF >> format.aLoss) << format.aShift;
+
+	YUVToRGBConstantsAVX2 c;
+	c.crToR = _mm256_set1_epi16((int16)kCrToR);
+	c.crToG = _mm256_set1_epi16((int16)kCrToG);
+	c.cbToG = _mm256_set1_epi16((int16)kCbToG);
+	c.cbToB = _mm256_set1_epi16((int16)kCbToB);
+	c.ituScale = _mm256_set1_epi16((int16)kITUScale);
+	c.crToRShift = _mm_cvtsi32_si128(kCrToRShift);
+	c.cbToBShift = _mm_cvtsi32_si128(kCbToBShift);
+	c.rLoss = _mm_cvtsi32_si128(format.rLoss);
+	c.gLoss = _mm_cvtsi32_si128(format.gLoss);
+	c.bLoss = _mm_cvtsi32_si128(format.bLoss);
+	c.aLoss = _mm_cvtsi32_si128(format.aLoss);
+	c.rShift = _mm_cvtsi32_si128(format.rShift);
+	c.gShift = _mm_cvtsi32_si128(format.gShift);
+	c.bShift = _mm_cvtsi32_si128(format.bShift);
+	c.aShift = _mm_cvtsi32_si128(format.aShift);
+	c.aMask16 = _mm256_set1_epi16((int16)aMask);
+	c.aMask32 = _mm256_set1_epi32(aMask);
+
+	if (format.bytesPerPixel == 2) {
+		if (scale == kScaleITU)
+			convertRow<uint16, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint16, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	} else {
+		if (scale == kScaleITU)
+			convertRow<uint32, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint32, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	}
+}
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/yuv_to_rgb.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+struct YUVToRGBConstantsNEON {
+	uint16x4_t crToR, crToG, cbToG, cbToB, ituScale;
+	int16x8_t crToRShift, cbToBShift;
+	int16x8_t rLoss, gLoss, bLoss, aLoss; // Negative, to shift right
+	int16x8_t rShift16, gShift16, bShift16, aShift16;
+	int32x4_t rShift32, gShift32, bShift32, aShift32;
+	uint16x8_t aMask16;
+	uint32x4_t aMask32;
+};
+
+static FORCEINLINE uint16x8_t mulHigh(uint16x8_t x, uint16x4_t factor) {
+	const uint32x4_t lo = vmull_u16(vget_low_u16(x), factor);
+	const uint32x4_t hi = vmull_u16(vget_high_u16(x), factor);
+	return vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+}
+
+// ((|x| << shift) * factor) >> 16 with the sign of x, which truncates towards zero like the tables
+static FORCEINLINE int16x8_t mulChroma(int16x8_t x, uint16x4_t factor, int16x8_t shift) {
+	const uint16x8_t v = mulHigh(vshlq_u16(vreinterpretq_u16_s16(vabsq_s16(x)), shift), factor);
+	const int16x8_t result = vreinterpretq_s16_u16(v);
+	return vbslq_s16(vcltq_s16(x, vdupq_n_s16(0)), vnegq_s16(result), result);
+}
+
+template<bool kITU>
+static FORCEINLINE uint16x8_t clampLuminance(int16x8_t x, const YUVToRGBConstantsNEON &c) {
+	if (kITU) {
+		x = vminq_s16(vmaxq_s16(x, vdupq_n_s16(16)), vdupq_n_s16(235));
+		const uint16x8_t v = vreinterpretq_u16_s16(vsubq_s16(x, vdupq_n_s16(16)));
+		return vaddq_u16(v, mulHigh(v, c.ituScale));
+	}
+
+	return vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(x, vdupq_n_s16(0)), vdupq_n_s16(255)));
+}
+
+// The differences which 8 chroma values make to the channels
+static FORCEINLINE void convertChroma(uint16x8_t u, uint16x8_t v, const YUVToRGBConstantsNEON &c, int16x8_t &rDiff, int16x8_t &gDiff, int16x8_t &bDiff) {
+	const int16x8_t noShift = vdupq_n_s16(0);
+	const int16x8_t cb = vsubq_s16(vreinterpretq_s16_u16(u), vdupq_n_s16(128));
+	const int16x8_t cr = vsubq_s16(vreinterpretq_s16_u16(v), vdupq_n_s16(128));
+
+	rDiff = mulChroma(cr, c.crToR, c.crToRShift);
+	gDiff = vaddq_s16(mulChroma(cr, c.crToG, noShift), mulChroma(cb, c.cbToG, noShift));
+	bDiff = mulChroma(cb, c.cbToB, c.cbToBShift);
+}
+
+static FORCEINLINE uint32x4_t combine32(uint16x4_t r, uint16x4_t g, uint16x4_t b, uint16x4_t a, const YUVToRGBConstantsNEON &c) {
+	const uint32x4_t rg = vorrq_u32(vshlq_u32(vmovl_u16(r), c.rShift32), vshlq_u32(vmovl_u16(g), c.gShift32));
+	const uint32x4_t ba = vorrq_u32(vshlq_u32(vmovl_u16(b), c.bShift32), vshlq_u32(vmovl_u16(a), c.aShift32));
+	return vorrq_u32(vorrq_u32(rg, ba), c.aMask32);
+}
+
+// Convert 8 pixels, with the differences which their chroma values make
+template<typename PixelInt, bool kITU>
+static FORCEINLINE void convertPixels(byte *dst, const byte *ySrc, const byte *aSrc, int16x8_t rDiff, int16x8_t gDiff, int16x8_t bDiff, const YUVToRGBConstantsNEON &c) {
+	const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc)));
+	const uint16x8_t a = aSrc ? vshlq_u16(vmovl_u8(vld1_u8(aSrc)), c.aLoss) : vdupq_n_u16(0);
+
+	const uint16x8_t r = vshlq_u16(clampLuminance<kITU>(vaddq_s16(y, rDiff), c), c.rLoss);
+	const uint16x8_t g = vshlq_u16(clampLuminance<kITU>(vsubq_s16(y, gDiff), c), c.gLoss);
+	const uint16x8_t b = vshlq_u16(clampLuminance<kITU>(vaddq_s16(y, bDiff), c), c.bLoss);
+
+	if (sizeof(PixelInt) == 2) {
+		const uint16x8_t rg = vorrq_u16(vshlq_u16(r, c.rShift16), vshlq_u16(g, c.gShift16));
+		const uint16x8_t ba = vorrq_u16(vshlq_u16(b, c.bShift16), vshlq_u16(a, c.aShift16));
+		vst1q_u16((uint16 *)dst, vorrq_u16(vorrq_u16(rg, ba), c.aMask16));
+	} else {
+		vst1q_u32((uint32 *)dst, combine32(vget_low_u16(r), vget_low_u16(g), vget_low_u16(b), vget_low_u16(a), c));
+		vst1q_u32((uint32 *)dst + 4, combine32(vget_high_u16(r), vget_high_u16(g), vget_high_u16(b), vget_high_u16(a), c));
+	}
+}
+
+template<typename PixelInt, bool kITU>
+static void convertRow(byte *dst, const YUVToRGBConstantsNEON &c, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	int16x8_t rDiff[2], gDiff[2], bDiff[2];
+
+	for (int x = 0; x < width; x += 16) {
+		if (halfChroma) {
+			// Each chroma value is shared by two pixels
+			int16x8_t r, g, b;
+			convertChroma(vmovl_u8(vld1_u8(uSrc + x / 2)), vmovl_u8(vld1_u8(vSrc + x / 2)), c, r, g, b);
+			const int16x8x2_t rZip = vzipq_s16(r, r);
+			const int16x8x2_t gZip = vzipq_s16(g, g);
+			const int16x8x2_t bZip = vzipq_s16(b, b);
+			rDiff[0] = rZip.val[0];
+			rDiff[1] = rZip.val[1];
+			gDiff[0] = gZip.val[0];
+			gDiff[1] = gZip.val[1];
+			bDiff[0] = bZip.val[0];
+			bDiff[1] = bZip.val[1];
+		} else {
+			const uint8x16_t u = vld1q_u8(uSrc + x);
+			const uint8x16_t v = vld1q_u8(vSrc + x);
+			convertChroma(vmovl_u8(vget_low_u8(u)), vmovl_u8(vget_low_u8(v)), c, rDiff[0], gDiff[0], bDiff[0]);
+			convertChroma(vmovl_u8(vget_high_u8(u)), vmovl_u8(vget_high_u8(v)), c, rDiff[1], gDiff[1], bDiff[1]);
+		}
+
+		convertPixels<PixelInt, kITU>(dst, ySrc + x, aSrc ? aSrc + x : nullptr, rDiff[0], gDiff[0], bDiff[0], c);
+		dst += 8 * sizeof(PixelInt);
+		convertPixels<PixelInt, kITU>(dst, ySrc + x + 8, aSrc ? aSrc + x + 8 : nullptr, rDiff[1], gDiff[1], bDiff[1], c);
+		dst += 8 * sizeof(PixelInt);
+	}
+}
+
+void YUVToRGBManager::convertRowNEON(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	const uint32 aMask = aSrc ? 0 : (0xFF >> format.aLoss) << format.aShift;
+
+	YUVToRGBConstantsNEON c;
+	c.crToR = vdup_n_u16(kCrToR);
+	c.crToG = vdup_n_u16(kCrToG);
+	c.cbToG = vdup_n_u16(kCbToG);
+	c.cbToB = vdup_n_u16(kCbToB);
+	c.ituScale = vdup_n_u16(kITUScale);
+	c.crToRShift = vdupq_n_s16(kCrToRShift);
+	c.cbToBShift = vdupq_n_s16(kCbToBShift);
+	c.rLoss = vdupq_n_s16(-format.rLoss);
+	c.gLoss = vdupq_n_s16(-format.gLoss);
+	c.bLoss = vdupq_n_s16(-format.bLoss);
+	c.aLoss = vdupq_n_s16(-format.aLoss);
+	c.rShift16 = vdupq_n_s16(format.rShift);
+	c.gShift16 = vdupq_n_s16(format.gShift);
+	c.bShift16 = vdupq_n_s16(format.bShift);
+	c.aShift16 = vdupq_n_s16(format.aShift);
+	c.rShift32 = vdupq_n_s32(format.rShift);
+	c.gShift32 = vdupq_n_s32(format.gShift);
+	c.bShift32 = vdupq_n_s32(format.bShift);
+	c.aShift32 = vdupq_n_s32(format.aShift);
+	c.aMask16 = vdupq_n_u16((uint16)aMask);
+	c.aMask32 = vdupq_n_u32(aMask);
+
+	if (format.bytesPerPixel == 2) {
+		if (scale == kScaleITU)
+			convertRow<uint16, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint16, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	} else {
+		if (scale == kScaleITU)
+			convertRow<uint32, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint32, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	}
+}
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -0,0 +1,183 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+struct YUVToRGBConstantsSSE2 {
+	__m128i crToR, crToG, cbToG, cbToB, ituScale;
+	__m128i crToRShift, cbToBShift;
+	__m128i rLoss, gLoss, bLoss, aLoss;
+	__m128i rShift, gShift, bShift, aShift;
+	__m128i aMask16, aMask32;
+};
+
+// ((|x| << shift) * factor) >> 16 with the sign of x, which truncates towards zero like the tables
+static FORCEINLINE __m128i mulChroma(__m128i x, __m128i factor, __m128i shift) {
+	const __m128i sign = _mm_srai_epi16(x, 15);
+	__m128i v = _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+	v = _mm_mulhi_epu16(_mm_sll_epi16(v, shift), factor);
+	return _mm_sub_epi16(_mm_xor_si128(v, sign), sign);
+}
+
+template<bool kITU>
+static FORCEINLINE __m128i clampLuminance(__m128i x, const YUVToRGBConstantsSSE2 &c) {
+	if (kITU) {
+		x = _mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(16)), _mm_set1_epi16(235));
+		x = _mm_sub_epi16(x, _mm_set1_epi16(16));
+		return _mm_add_epi16(x, _mm_mulhi_epu16(x, c.ituScale));
+	}
+
+	return _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(255));
+}
+
+// The differences which 8 chroma values make to the channels
+static FORCEINLINE void convertChroma(__m128i u, __m128i v, const YUVToRGBConstantsSSE2 &c, __m128i &rDiff, __m128i &gDiff, __m128i &bDiff) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i cb = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	const __m128i cr = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	rDiff = mulChroma(cr, c.crToR, c.crToRShift);
+	gDiff = _mm_add_epi16(mulChroma(cr, c.crToG, zero), mulChroma(cb, c.cbToG, zero));
+	bDiff = mulChroma(cb, c.cbToB, c.cbToBShift);
+}
+
+static FORCEINLINE __m128i combine32(__m128i r, __m128i g, __m128i b, __m128i a, const YUVToRGBConstantsSSE2 &c) {
+	const __m128i rg = _mm_or_si128(_mm_sll_epi32(r, c.rShift), _mm_sll_epi32(g, c.gShift));
+	const __m128i ba = _mm_or_si128(_mm_sll_epi32(b, c.bShift), _mm_sll_epi32(a, c.aShift));
+	return _mm_or_si128(_mm_or_si128(rg, ba), c.aMask32);
+}
+
+// Convert 8 pixels, with the differences which their chroma values make
+template<typename PixelInt, bool kITU>
+static FORCEINLINE void convertPixels(byte *dst, const byte *ySrc, const byte *aSrc, __m128i rDiff, __m128i gDiff, __m128i bDiff, const YUVToRGBConstantsSSE2 &c) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)ySrc), zero);
+	const __m128i a = aSrc ? _mm_srl_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)aSrc), zero), c.aLoss) : zero;
+
+	const __m128i r = _mm_srl_epi16(clampLuminance<kITU>(_mm_add_epi16(y, rDiff), c), c.rLoss);
+	const __m128i g = _mm_srl_epi16(clampLuminance<kITU>(_mm_sub_epi16(y, gDiff), c), c.gLoss);
+	const __m128i b = _mm_srl_epi16(clampLuminance<kITU>(_mm_add_epi16(y, bDiff), c), c.bLoss);
+
+	if (sizeof(PixelInt) == 2) {
+		const __m128i rg = _mm_or_si128(_mm_sll_epi16(r, c.rShift), _mm_sll_epi16(g, c.gShift));
+		const __m128i ba = _mm_or_si128(_mm_sll_epi16(b, c.bShift), _mm_sll_epi16(a, c.aShift));
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_or_si128(rg, ba), c.aMask16));
+	} else {
+		_mm_storeu_si128((__m128i *)dst, combine32(_mm_unpacklo_epi16(r, zero), _mm_unpacklo_epi16(g, zero), _mm_unpacklo_epi16(b, zero), _mm_unpacklo_epi16(a, zero), c));
+		_mm_storeu_si128((__m128i *)(dst + 16), combine32(_mm_unpackhi_epi16(r, zero), _mm_unpackhi_epi16(g, zero), _mm_unpackhi_epi16(b, zero), _mm_unpackhi_epi16(a, zero), c));
+	}
+}
+
+template<typename PixelInt, bool kITU>
+static void convertRow(byte *dst, const YUVToRGBConstantsSSE2 &c, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i rDiff[2], gDiff[2], bDiff[2];
+
+	for (int x = 0; x < width; x += 16) {
+		if (halfChroma) {
+			// Each chroma value is shared by two pixels
+			const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2)), zero);
+			const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2)), zero);
+			__m128i r, g, b;
+			convertChroma(u, v, c, r, g, b);
+			rDiff[0] = _mm_unpacklo_epi16(r, r);
+			rDiff[1] = _mm_unpackhi_epi16(r, r);
+			gDiff[0] = _mm_unpacklo_epi16(g, g);
+			gDiff[1] = _mm_unpackhi_epi16(g, g);
+			bDiff[0] = _mm_unpacklo_epi16(b, b);
+			bDiff[1] = _mm_unpackhi_epi16(b, b);
+		} else {
+			const __m128i u = _mm_loadu_si128((const __m128i *)(uSrc + x));
+			const __m128i v = _mm_loadu_si128((const __m128i *)(vSrc + x));
+			convertChroma(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(v, zero), c, rDiff[0], gDiff[0], bDiff[0]);
+			convertChroma(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(v, zero), c, rDiff[1], gDiff[1], bDiff[1]);
+		}
+
+		convertPixels<PixelInt, kITU>(dst, ySrc + x, aSrc ? aSrc + x : nullptr, rDiff[0], gDiff[0], bDiff[0], c);
+		dst += 8 * sizeof(PixelInt);
+		convertPixels<PixelInt, kITU>(dst, ySrc + x + 8, aSrc ? aSrc + x + 8 : nullptr, rDiff[1], gDiff[1], bDiff[1], c);
+		dst += 8 * sizeof(PixelInt);
+	}
+}
+
+void YUVToRGBManager::convertRowSSE2(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma) {
+	const uint32 aMask = aSrc ? 0 : (0xFF >> format.aLoss) << format.aShift;
+
+	YUVToRGBConstantsSSE2 c;
+	c.crToR = _mm_set1_epi16((int16)kCrToR);
+	c.crToG = _mm_set1_epi16((int16)kCrToG);
+	c.cbToG = _mm_set1_epi16((int16)kCbToG);
+	c.cbToB = _mm_set1_epi16((int16)kCbToB);
+	c.ituScale = _mm_set1_epi16((int16)kITUScale);
+	c.crToRShift = _mm_cvtsi32_si128(kCrToRShift);
+	c.cbToBShift = _mm_cvtsi32_si128(kCbToBShift);
+	c.rLoss = _mm_cvtsi32_si128(format.rLoss);
+	c.gLoss = _mm_cvtsi32_si128(format.gLoss);
+	c.bLoss = _mm_cvtsi32_si128(format.bLoss);
+	c.aLoss = _mm_cvtsi32_si128(format.aLoss);
+	c.rShift = _mm_cvtsi32_si128(format.rShift);
+	c.gShift = _mm_cvtsi32_si128(format.gShift);
+	c.bShift = _mm_cvtsi32_si128(format.bShift);
+	c.aShift = _mm_cvtsi32_si128(format.aShift);
+	c.aMask16 = _mm_set1_epi16((int16)aMask);
+	c.aMask32 = _mm_set1_epi32(aMask);
+
+	if (format.bytesPerPixel == 2) {
+		if (scale == kScaleITU)
+			convertRow<uint16, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint16, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	} else {
+		if (scale == kScaleITU)
+			convertRow<uint32, true>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+		else
+			convertRow<uint32, false>(dst, c, ySrc, uSrc, vSrc, aSrc, width, halfChroma);
+	}
+}
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
@@ -38,9 +38,13 @@
 #define GRAPHICS_YUV_TO_RGB_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
+#include "common/mutex.h"
 #include "common/singleton.h"
 #include "graphics/surface.h"
 
+class YUVToRGBTestSuite;
+
 namespace Graphics {
 
 class YUVToRGBLookup;
@@ -53,6 +57,14 @@ public:
 		kScaleITU   /** Luminance values range from [16, 235], the range from ITU-R BT.601 */
 	};
 
+	/**
+	 * Convert the rows with the fastest code which the CPU supports, as
+	 * reported by g_system. This is called once on the main thread at
+	 * startup, since videos may convert their frames on other threads.
+	 * Until then, the rows are converted with the lookup tables.
+	 */
+	void selectConvertRow();
+
 	/**
 	 * Convert a YUV444 image to an RGB surface
 	 *
@@ -137,12 +149,55 @@ public:
 
 private:
 	friend class Common::Singleton<SingletonBaseType>;
+	friend class ::YUVToRGBTestSuite;
 	YUVToRGBManager();
 	~YUVToRGBManager();
 
 	const YUVToRGBLookup *getLookup(Graphics::PixelFormat format, LuminanceScale scale);
 
-	YUVToRGBLookup *_lookup;
+	/**
+	 * Convert a row of pixels with SIMD instructions, with the same results
+	 * as the lookup tables. The width must be a multiple of 16. @p uSrc and
+	 * @p vSrc have a value for each pixel, or for each pair of pixels if
+	 * @p halfChroma is set, and @p aSrc is nullptr if there is no alpha.
+	 */
+	typedef void (*ConvertRowProc)(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma);
+
+	/**
+	 * The factors of the row procs, for which ((x << shift) * factor) >> 16
+	 * is rounded the same as the lookup tables for every chroma value, and
+	 * as (x * 255 / 219) for the ITU scaled luminance.
+	 */
+	enum {
+		kCrToRShift = 1,
+		kCrToR = 45901,
+		kCrToG = 46773,
+		kCbToG = 22567,
+		kCbToBShift = 1,
+		kCbToB = 58110,
+		kITUScale = 10776 // For x * 36 / 219, which is added to x
+	};
+
+#ifdef SCUMMVM_NEON
+	static void convertRowNEON(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma);
+#endif
+#ifdef SCUMMVM_SSE2
+	static void convertRowSSE2(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma);
+#endif
+#ifdef SCUMMVM_AVX2
+	static void convertRowAVX2(byte *dst, const PixelFormat &format, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int width, bool halfChroma);
+#endif
+
+	/**
+	 * Convert as much of the left of an image as the row procs can, and
+	 * return its width. The chroma planes are subsampled by 1 << uvShiftX
+	 * horizontally and by 1 << uvShiftY vertically.
+	 */
+	int convertRows(Graphics::Surface *dst, LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch, int uvShiftX, int uvShiftY);
+
+	Common::Mutex _lookupMutex;
+	Common::Array<YUVToRGBLookup *> _lookups;
+	ConvertRowProc _convertRow;
 };
  /** @} */
 } // End of namespace Graphics
@@ -88,6 +88,7 @@ void EventRecorder::deinit() {
 	if (!_initialized) {
 		return;
 	}
+	_benchmark.finish(_fakeTimer);
 	setFileHeader();
 	_needRedraw = false;
 	_initialized = false;
@@ -161,7 +162,7 @@ void EventRecorder::processTimeAndDate(TimeDate &td, bool skipRecord) {
 			_recordFile->writeEvent(timeDateEvent);
 		}
 
-		_nextEvent = _playbackFile->getNextEvent();
+		readNextEvent();
 	}
 	if (_recordMode == kRecorderPlaybackPause)
 		td = _lastTimeDate;
@@ -218,7 +219,7 @@ void EventRecorder::processMillis(uint32 &millis, bool skipRecord) {
 			_recordFile->writeEvent(timerEvent);
 		}
 		updateSubsystems();
-		_nextEvent = _playbackFile->getNextEvent();
+		readNextEvent();
 		_timerManager->handler();
 		_controlPanel->setReplayedTime(_fakeTimer);
 		_processingMillis = false;
@@ -243,6 +244,7 @@ void EventRecorder::processScreenUpdate() {
 	if (!_initialized) {
 		return;
 	}
+	_benchmark.frame();
 
 	Common::RecorderEvent screenUpdateEvent;
 	switch (_recordMode) {
@@ -260,7 +262,7 @@ void EventRecorder::processScreenUpdate() {
 		if (_nextEvent.recordedtype != Common::kRecorderEventTypeScreenUpdate) {
 			int numSkipped = 0;
 			while (true) {
-				_nextEvent = _playbackFile->getNextEvent();
+				readNextEvent();
 				numSkipped += 1;
 				if (_nextEvent.recordedtype == Common::kRecorderEventTypeScreenUpdate) {
 					warning("Skipped %d events to get to the next screen update at %d", numSkipped, _nextEvent.time);
@@ -271,7 +273,7 @@ void EventRecorder::processScreenUpdate() {
 		_processingMillis = true;
 		_fakeTimer = _nextEvent.time;
 		updateSubsystems();
-		_nextEvent = _playbackFile->getNextEvent();
+		readNextEvent();
 		if (_recordMode == kRecorderUpdate) {
 			// write event to the updated file and update screenshot if necessary
 			screenUpdateEvent.recordedtype = Common::kRecorderEventTypeScreenUpdate;
@@ -308,7 +310,7 @@ bool EventRecorder::pollEvent(Common::Event &ev) {
 	}
 
 	ev = _nextEvent;
-	_nextEvent = _playbackFile->getNextEvent();
+	readNextEvent();
 	switch (ev.type) {
 	case Common::EVENT_MOUSEMOVE:
 	case Common::EVENT_LBUTTONDOWN:
@@ -415,7 +417,7 @@ void EventRecorder::init(const Common::String &recordFileName, RecordMode mode)
 	}
 	if ((_recordMode == kRecorderPlayback) || (_recordMode == kRecorderUpdate)) {
 		applyPlaybackSettings();
-		_nextEvent = _playbackFile->getNextEvent();
+		readNextEvent();
 	}
 	if ((_recordMode == kRecorderRecord) || (_recordMode == kRecorderUpdate)) {
 		getConfig();
@@ -428,6 +430,22 @@ void EventRecorder::init(const Common::String &recordFileName, RecordMode mode)
 }
 
 
+void EventRecorder::startBenchmark(const Common::String &reportFileName) {
+	assert(_recordMode == kRecorderPlayback);
+	_fastPlayback = true;
+	_needRedraw = false;
+	_benchmark.start(reportFileName, _playbackFile->getHeader().fileName);
+}
+
+void EventRecorder::readNextEvent() {
+	// The playback file quits once it runs out of events, the report has to
+	// be written before
+	if (!_playbackFile->hasNextEvent()) {
+		_benchmark.finish(_fakeTimer);
+	}
+	_nextEvent = _playbackFile->getNextEvent();
+}
+
 /**
  * Opens or creates file depend of recording mode.
  *
@@ -699,6 +717,10 @@ Common::SaveFileManager *EventRecorder::getSaveManager(Common::SaveFileManager *
 }
 
 void EventRecorder::preDrawOverlayGui() {
+	if (_benchmark.isRunning()) {
+		// Drawing the control panel is not part of what is measured
+		return;
+	}
 	if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
@@ -716,6 +738,9 @@ void EventRecorder::preDrawOverlayGui() {
 }
 
 void EventRecorder::postDrawOverlayGui() {
+	if (_benchmark.isRunning()) {
+		return;
+	}
 	if ((_initialized) || (_needRedraw)) {
 		RecordMode oldMode = _recordMode;
 		_recordMode = kPassthrough;
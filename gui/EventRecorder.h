@@ -44,6 +44,7 @@
 #include "backends/saves/recorder/recorder-saves.h"
 #include "backends/mixer/null/null-mixer.h"
 #include "backends/saves/default/default-saves.h"
+#include "gui/recorderbenchmark.h"
 
 
 #define g_eventRec (GUI::EventRecorder::instance())
@@ -79,6 +80,13 @@ public:
 
 	void init(const Common::String &recordFileName, RecordMode mode);
 	void deinit();
+
+	/**
+	 * Replay the recording as fast as possible, without the control panel,
+	 * and write the timings to @p reportFileName once it ends. This must be
+	 * called after init() in playback mode.
+	 */
+	void startBenchmark(const Common::String &reportFileName);
 	bool processDelayMillis();
 	uint32 getRandomSeed(const Common::String &name);
 	void processTimeAndDate(TimeDate &td, bool skipRecord);
@@ -243,10 +251,12 @@ private:
 	void saveScreenShot();
 	void checkRecordedMD5();
 	void deleteTemporarySave();
+	void readNextEvent();
 	void updateFakeTimer(uint32 millis);
 	volatile RecordMode _recordMode;
 	Common::String _recordFileName;
 	bool _fastPlayback;
+	RecorderBenchmark _benchmark;
 	bool _needRedraw;
 	bool _processingMillis;
 };
@@ -28,6 +28,7 @@
 #include "common/translation.h"
 
 #include "engines/advancedDetector.h"
+#include "engines/detectionScanner.h"
 
 #include "gui/massadd.h"
 
@@ -58,9 +59,7 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
-	_dirsScanned(0),
 	_oldGamesCount(0),
-	_dirTotal(0),
 	_okButton(nullptr),
 	_dirProgressText(nullptr),
 	_gameProgressText(nullptr) {
@@ -68,7 +67,7 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	Common::U32StringArray l;
 
 	// The dir we start our scan at
-	_scanStack.push(startDir);
+	_scanner.reset(new DetectionScanner(startDir, true, (ADGF_WARNING | ADGF_UNSUPPORTED), true));
 
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
@@ -109,6 +108,9 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	}
 }
 
+MassAddDialog::~MassAddDialog() {
+}
+
 struct GameTargetLess {
 	bool operator()(const DetectedGame &x, const DetectedGame &y) const {
 		return x.preferredTarget.compareToIgnoreCase(y.preferredTarget) < 0;
@@ -130,6 +132,11 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 #endif
 
 	// FIXME: It's a really bad thing that we use two arbitrary constants
+	if (cmd == kOkCmd || cmd == kCancelCmd) {
+		// Stop the scan and its worker threads
+		_scanner.reset();
+	}
+
 	if (cmd == kOkCmd) {
 		// Sort the detected games. This is not strictly necessary, but nice for
 		// people who want to edit their config file by hand after a mass add.
@@ -184,22 +191,23 @@ void MassAddDialog::updateGameList() {
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (!_scanner || _scanner->isDone())
 		return;	// We have finished scanning
 
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+	// Perform a depth-first scan of the filesystem. Do not wait for the
+	// worker threads, so that the dialog stays responsive.
+	while (!_scanner->isDone() && (g_system->getMillis() - t) < kMaxScanTime) {
+		if (!_scanner->scanNextDirectory(false))
+			break;
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
+		if (!_scanner->isDirectoryReadable()) {
 			continue;
 		}
 
-		// Run the detector on the dir
-		DetectionResults detectionResults = EngineMan.detectGames(files, (ADGF_WARNING | ADGF_UNSUPPORTED), true);
+		const Common::FSNode &dir = _scanner->getDirectory();
+		const DetectionResults &detectionResults = _scanner->getResults();
 
 		if (detectionResults.foundUnknownGames()) {
 			Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
@@ -254,29 +262,17 @@ void MassAddDialog::handleTickle() {
 		}
 
 		updateGameList();
-
-		// Recurse into all subdirs
-		for (const auto &file : files) {
-			if (file.isDirectory()) {
-				_scanStack.push(file);
-
-				_dirTotal++;
-			}
-		}
-
-		_dirsScanned++;
+	}
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(_scanner->getScannedCount(), _scanner->getDirectoryCount());
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
-	}
-
 
 	// Update the dialog
 	Common::U32String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanner->isDone()) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -287,7 +283,7 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::U32String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::U32String::format(_("Scanned %d directories ..."), _scanner->getScannedCount());
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::U32String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
@@ -26,9 +26,11 @@
 #include "gui/widgets/list.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
-#include "common/stack.h"
+#include "common/ptr.h"
 #include "common/str.h"
 
+class DetectionScanner;
+
 namespace GUI {
 
 class StaticTextWidget;
@@ -37,6 +39,7 @@ class MassAddListWidget;
 class MassAddDialog : public Dialog {
 public:
 	MassAddDialog(const Common::FSNode &startDir);
+	~MassAddDialog() override;
 
 	//void open();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data) override;
@@ -49,7 +52,7 @@ public:
 	}
 
 private:
-	Common::Stack<Common::FSNode>  _scanStack;
+	Common::ScopedPtr<DetectionScanner> _scanner;
 	DetectedGames _games;
 
 	void updateGameList();
@@ -62,9 +65,7 @@ private:
 	Common::HashMap<Common::Path, Common::StringArray,
 		Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> _pathToTargets;
 
-	int _dirsScanned;
 	int _oldGamesCount;
-	int _dirTotal;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
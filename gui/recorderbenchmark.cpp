@@ -0,0 +1,239 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <new>
+
+#if defined(POSIX)
+#include <sys/resource.h>
+#endif
+
+#include "gui/recorderbenchmark.h"
+
+#include "common/algorithm.h"
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/file.h"
+#include "common/fs.h"
+#include "common/profiler.h"
+#include "common/textconsole.h"
+
+#ifdef ENABLE_ALLOCATION_COUNTING
+
+namespace {
+
+volatile uint32 g_allocationCount = 0;
+
+} // End of anonymous namespace
+
+// Count the allocations, which a benchmark reports per frame. This only
+// covers C++ allocations, as there is no portable way to hook malloc.
+void *operator new(size_t size) {
+#ifdef COMMON_HAS_ATOMICS
+	Common::atomicAdd(&g_allocationCount, (uint32)1);
+#else
+	g_allocationCount++;
+#endif
+
+	// Behave like the default operator on failure
+	for (;;) {
+		void *ptr = malloc(size ? size : 1);
+		if (ptr)
+			return ptr;
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			break;
+		handler();
+	}
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+	throw std::bad_alloc();
+#else
+	error("Out of memory allocating %u bytes", (uint)size);
+#endif
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+#endif
+
+namespace GUI {
+
+RecorderBenchmark::RecorderBenchmark() :
+	_running(false), _startTime(0), _lastFrameTime(0),
+	_startAllocations(0), _lastFrameAllocations(0) {
+}
+
+bool RecorderBenchmark::countsAllocations() {
+#ifdef ENABLE_ALLOCATION_COUNTING
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint32 RecorderBenchmark::getAllocationCount() {
+#if !defined(ENABLE_ALLOCATION_COUNTING)
+	return 0;
+#elif defined(COMMON_HAS_ATOMICS)
+	return Common::atomicLoadRelaxed(&g_allocationCount);
+#else
+	return g_allocationCount;
+#endif
+}
+
+void RecorderBenchmark::start(const Common::String &reportFileName, const Common::String &recordFileName) {
+	_running = true;
+	_reportFileName = reportFileName;
+	_recordFileName = recordFileName;
+	_frameTimes.clear();
+	_frameAllocations.clear();
+
+	// The time of the recording is not related to the real time, which is
+	// the one being measured
+	_startTime = _lastFrameTime = Common::Profiler::getMicros();
+	_startAllocations = _lastFrameAllocations = getAllocationCount();
+}
+
+void RecorderBenchmark::frame() {
+	if (!_running)
+		return;
+
+	const uint64 now = Common::Profiler::getMicros();
+	const uint32 allocations = getAllocationCount();
+
+	_frameTimes.push_back((uint32)MIN<uint64>(now - _lastFrameTime, 0xFFFFFFFF));
+	_frameAllocations.push_back(allocations - _lastFrameAllocations);
+
+	// The arrays allocate as well, leave them out of the next frame
+	_lastFrameTime = now;
+	_lastFrameAllocations = getAllocationCount();
+}
+
+RecorderBenchmark::Summary RecorderBenchmark::summarize(Common::Array<uint32> values) {
+	Summary summary = { 0, 0, 0, 0, 0, 0 };
+	if (values.empty())
+		return summary;
+
+	Common::sort(values.begin(), values.end());
+	for (uint i = 0; i < values.size(); i++)
+		summary.total += values[i];
+
+	// Nearest rank percentiles
+	const uint count = values.size();
+	summary.max = values[count - 1];
+	summary.p50 = values[(count * 50 + 99) / 100 - 1];
+	summary.p90 = values[(count * 90 + 99) / 100 - 1];
+	summary.p95 = values[(count * 95 + 99) / 100 - 1];
+	summary.p99 = values[(count * 99 + 99) / 100 - 1];
+	return summary;
+}
+
+Common::String RecorderBenchmark::formatSummary(const Summary &summary, uint32 count) {
+	return Common::String::format("{\"mean\":%.1f,\"p50\":%u,\"p90\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}",
+	                              count ? (double)summary.total / count : 0.0,
+	                              summary.p50, summary.p90, summary.p95, summary.p99, summary.max);
+}
+
+Common::String RecorderBenchmark::escapeString(const Common::String &str) {
+	Common::String result;
+	for (uint i = 0; i < str.size(); i++) {
+		if (str[i] == '"' || str[i] == '\\')
+			result += '\\';
+		result += str[i];
+	}
+	return result;
+}
+
+int64 RecorderBenchmark::getPeakResidentKB() {
+#if defined(POSIX)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+#if defined(MACOSX) || defined(IPHONE)
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	return -1;
+#endif
+}
+
+void RecorderBenchmark::finish(uint32 replayedMillis) {
+	if (!_running)
+		return;
+
+	_running = false;
+
+	const uint64 wallTime = Common::Profiler::getMicros() - _startTime;
+	const uint32 allocations = getAllocationCount() - _startAllocations;
+	const uint32 frames = _frameTimes.size();
+	const int64 peakResident = getPeakResidentKB();
+
+	Common::String json = "{\n";
+	json += Common::String::format("\"recording\":\"%s\",\n", escapeString(_recordFileName).c_str());
+	json += Common::String::format("\"target\":\"%s\",\n", escapeString(ConfMan.getActiveDomainName()).c_str());
+	json += Common::String::format("\"engine\":\"%s\",\n", escapeString(ConfMan.get("engineid")).c_str());
+	json += Common::String::format("\"frames\":%u,\n", frames);
+	json += Common::String::format("\"replayed_time_ms\":%u,\n", replayedMillis);
+	json += Common::String::format("\"wall_time_ms\":%.3f,\n", wallTime / 1000.0);
+	json += Common::String::format("\"frame_time_us\":%s,\n", formatSummary(summarize(_frameTimes), frames).c_str());
+	if (countsAllocations()) {
+		json += Common::String::format("\"allocations\":%u,\n", allocations);
+		json += Common::String::format("\"allocations_per_frame\":%s,\n", formatSummary(summarize(_frameAllocations), frames).c_str());
+	} else {
+		json += "\"allocations\":null,\n";
+		json += "\"allocations_per_frame\":null,\n";
+	}
+	if (peakResident >= 0)
+		json += Common::String::format("\"peak_rss_kb\":%lld\n", (long long)peakResident);
+	else
+		json += "\"peak_rss_kb\":null\n";
+	json += "}\n";
+
+	Common::DumpFile file;
+	if (!file.open(Common::FSNode(Common::Path(_reportFileName, Common::Path::kNativeSeparator)))) {
+		warning("Could not write the benchmark report to '%s'", _reportFileName.c_str());
+		return;
+	}
+
+	file.writeString(json);
+	if (!file.flush() || file.err()) {
+		warning("Could not write the benchmark report to '%s'", _reportFileName.c_str());
+		return;
+	}
+
+	debug("benchmark:frames=%u wall_time_ms=%.3f report=%s", frames, wallTime / 1000.0, _reportFileName.c_str());
+}
+
+} // End of namespace GUI
@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GUI_RECORDERBENCHMARK_H
+#define GUI_RECORDERBENCHMARK_H
+
+#include "common/array.h"
+#include "common/str.h"
+
+namespace GUI {
+
+/**
+ * Measures the replay of a recording by the event recorder, and writes the
+ * results as JSON, for performance regression tests.
+ *
+ * The time of each frame is the real time between two screen updates, while
+ * the engine itself runs on the time of the recording.
+ */
+class RecorderBenchmark {
+public:
+	RecorderBenchmark();
+
+	void start(const Common::String &reportFileName, const Common::String &recordFileName);
+	bool isRunning() const { return _running; }
+
+	/** Called on every screen update of the replayed game. */
+	void frame();
+
+	/**
+	 * Write the report, and stop measuring.
+	 *
+	 * @param replayedMillis The time of the recording which was replayed.
+	 */
+	void finish(uint32 replayedMillis);
+
+	/**
+	 * Return whether the allocations are counted, which needs a build
+	 * configured with --enable-allocation-counting. Otherwise, they are
+	 * reported as null.
+	 */
+	static bool countsAllocations();
+
+	/** Return the number of C++ allocations since the start of ScummVM, or 0 if they are not counted. */
+	static uint32 getAllocationCount();
+
+	struct Summary {
+		uint64 total;
+		uint32 max;
+		uint32 p50;
+		uint32 p90;
+		uint32 p95;
+		uint32 p99;
+	};
+
+	/** Return the total and the nearest rank percentiles of @p values. */
+	static Summary summarize(Common::Array<uint32> values);
+
+	/** Format @p summary of @p count values as a JSON object. */
+	static Common::String formatSummary(const Summary &summary, uint32 count);
+
+	/** Escape @p str for a JSON string. */
+	static Common::String escapeString(const Common::String &str);
+
+private:
+	static int64 getPeakResidentKB();
+
+	bool _running;
+	Common::String _reportFileName;
+	Common::String _recordFileName;
+	uint64 _startTime;
+	uint64 _lastFrameTime;
+	uint32 _startAllocations;
+	uint32 _lastFrameAllocations;
+	Common::Array<uint32> _frameTimes;
+	Common::Array<uint32> _frameAllocations;
+};
+
+} // End of namespace GUI
+
+#endif
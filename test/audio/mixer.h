@@ -0,0 +1,181 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "audio/rate_intern.h"
+#include "audio/decoders/raw.h"
+
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/endian.h"
+
+#include "../null_osystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kRate = 22050,
+		kFrames = 1024
+	};
+
+	// A mono stream of two seconds of a constant level
+	static Audio::AudioStream *createStream(int rate = kRate) {
+		const uint32 samples = rate * 2;
+		byte *data = (byte *)malloc(samples * 2);
+		for (uint32 i = 0; i < samples; i++)
+			WRITE_LE_INT16(data + i * 2, 1000);
+		return Audio::makeRawStream(data, samples * 2, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+	}
+
+	// The null OSystem cannot tell which SIMD kernels the CPU supports
+	static void initSystem() {
+		Common::install_null_g_system();
+		Audio::MixKernels generic;
+		Audio::getMixKernelsGeneric(generic);
+		Audio::setMixKernels(generic);
+	}
+
+	// Mixes one buffer, and returns whether it is audible
+	static bool mix(Audio::MixerImpl &mixer) {
+		int16 buffer[kFrames * 2];
+		mixer.mixCallback((byte *)buffer, sizeof(buffer));
+		for (uint i = 0; i < ARRAYSIZE(buffer); i++) {
+			if (buffer[i])
+				return true;
+		}
+		return false;
+	}
+
+	public:
+	void test_lock_free_commands() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(COMMON_HAS_ATOMICS)
+		initSystem();
+
+		Audio::MixerImpl mixer(kRate, true, kFrames, true);
+		TS_ASSERT(mixer.isLockFree());
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		static_cast<Audio::Mixer &>(mixer).playStream(Audio::Mixer::kPlainSoundType, &handle, createStream());
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(mixer.getSoundElapsedTime(handle), 0u);
+
+		// The commands are applied at the start of the next buffer. The
+		// elapsed time counts the samples mixed before the last buffer.
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT_LESS_THAN_EQUALS((uint32)(kFrames * 1000 / kRate), mixer.getSoundElapsedTime(handle));
+
+		mixer.pauseHandle(handle, true);
+		TS_ASSERT(!mix(mixer));
+		const uint32 elapsed = mixer.getSoundElapsedTime(handle);
+		TS_ASSERT(!mix(mixer));
+		TS_ASSERT_EQUALS(mixer.getSoundElapsedTime(handle), elapsed);
+		mixer.pauseHandle(handle, false);
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT_LESS_THAN(elapsed, mixer.getSoundElapsedTime(handle));
+
+		mixer.stopHandle(handle);
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(mixer.getSoundElapsedTime(handle), 0u);
+		TS_ASSERT(!mix(mixer));
+		Audio::resetMixKernels();
+#endif
+	}
+
+	void test_lock_free_overflow() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(COMMON_HAS_ATOMICS)
+		initSystem();
+
+		Audio::MixerImpl mixer(kRate, true, kFrames, true);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		static_cast<Audio::Mixer &>(mixer).playStream(Audio::Mixer::kPlainSoundType, &handle, createStream());
+
+		// Without the audio callback running, the engine thread applies the
+		// commands itself once the queue is full
+		for (int i = 0; i < 1000; i++)
+			mixer.setChannelVolume(handle, i & 0xFF);
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 0);
+		TS_ASSERT(!mix(mixer));
+
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		TS_ASSERT(mix(mixer));
+		TS_ASSERT_LESS_THAN_EQUALS((uint32)(kFrames * 1000 / kRate), mixer.getSoundElapsedTime(handle));
+		Audio::resetMixKernels();
+#endif
+	}
+
+	void test_lock_free_ready() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(COMMON_HAS_ATOMICS)
+		initSystem();
+
+		// Like in the locked mode, the first callback makes the mixer ready
+		Audio::MixerImpl mixer(kRate, true, kFrames, true);
+		TS_ASSERT(!mixer.isReady());
+		TS_ASSERT(!mix(mixer));
+		TS_ASSERT(mixer.isReady());
+		Audio::resetMixKernels();
+#endif
+	}
+
+	void test_large_callback() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		initSystem();
+
+		Audio::MixerImpl mixer(kRate);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		static_cast<Audio::Mixer &>(mixer).playStream(Audio::Mixer::kPlainSoundType, &handle, createStream());
+
+		// Callbacks larger than the mix bus are mixed in several passes
+		const uint samples = 10000 * 2;
+		int16 *buffer = new int16[samples];
+		mixer.mixCallback((byte *)buffer, samples * 2);
+		for (uint i = 0; i < samples; i++) {
+			if (buffer[i] != buffer[0]) {
+				TS_FAIL("Sample mismatch");
+				break;
+			}
+		}
+		TS_ASSERT_DIFFERS(buffer[0], 0);
+		delete[] buffer;
+
+		Audio::resetMixKernels();
+#endif
+	}
+
+	void test_lock_free_rate() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(COMMON_HAS_ATOMICS)
+		initSystem();
+		ConfMan.set("resampler", "sinc", Common::ConfigManager::kTransientDomain);
+
+		Audio::MixerImpl mixer(kRate, true, kFrames, true);
+		mixer.setReady(true);
+
+		// The filter for the new rate is prepared by the engine thread, and
+		// handed to the audio callback along with the rate change
+		Audio::SoundHandle handle;
+		static_cast<Audio::Mixer &>(mixer).playStream(Audio::Mixer::kPlainSoundType, &handle, createStream(kRate / 2));
+		mixer.setChannelRate(handle, kRate / 4);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), (uint32)kRate / 4);
+		TS_ASSERT(mix(mixer));
+
+		mixer.resetChannelRate(handle);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), (uint32)kRate / 2);
+		TS_ASSERT(mix(mixer));
+
+		// Rate changes for a channel which is gone are dropped
+		mixer.setChannelRate(handle, kRate);
+		mixer.stopHandle(handle);
+		TS_ASSERT(!mix(mixer));
+
+		ConfMan.removeKey("resampler", Common::ConfigManager::kTransientDomain);
+		Audio::resetMixKernels();
+#endif
+	}
+};
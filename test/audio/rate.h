@@ -0,0 +1,352 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/rate_intern.h"
+
+#include "common/debug.h"
+#include "common/memstream.h"
+
+#include "helper.h"
+
+#include "../null_osystem.h"
+#include "../instrset_detect.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+
+class RateConverterTestSuite : public CxxTest::TestSuite {
+public:
+	static void fillRandom(Audio::st_sample_t *buf, uint numSamples, uint32 &seed) {
+		for (uint i = 0; i < numSamples; ++i) {
+			seed = seed * 1103515245 + 12345;
+			buf[i] = (Audio::st_sample_t)(seed >> 16);
+		}
+	}
+
+	// Compare a set of kernels against the generic ones, using frame counts
+	// which do not fill a whole vector and volumes covering the whole range.
+	static void compareKernels(const Audio::MixKernels &kernels) {
+		Audio::MixKernels generic;
+		Audio::getMixKernelsGeneric(generic);
+
+		const uint maxFrames = 67;
+		Audio::st_sample_t in[maxFrames * 2];
+		Audio::st_mix_t outGeneric[maxFrames * 2], outTest[maxFrames * 2];
+		Audio::st_sample_t clampGeneric[maxFrames * 2], clampTest[maxFrames * 2];
+		uint32 seed = 1;
+
+		const int volumes[][2] = { { 0, 0 }, { 256, 256 }, { 255, 1 }, { 17, 200 }, { 128, 0 } };
+
+		for (int mode = 0; mode < Audio::kMixModeCount; ++mode) {
+			for (uint v = 0; v < ARRAYSIZE(volumes); ++v) {
+				for (uint frames = 0; frames <= maxFrames; frames += 13) {
+					fillRandom(in, maxFrames * 2, seed);
+					for (uint i = 0; i < maxFrames * 2; ++i)
+						outGeneric[i] = outTest[i] = (int32)(seed * (i + 1)) >> 14;
+
+					generic.mix[mode](outGeneric, in, frames, volumes[v][0], volumes[v][1]);
+					kernels.mix[mode](outTest, in, frames, volumes[v][0], volumes[v][1]);
+					TS_ASSERT_SAME_DATA(outGeneric, outTest, sizeof(outGeneric));
+				}
+			}
+		}
+
+		for (uint numSamples = 0; numSamples <= maxFrames * 2; numSamples += 19) {
+			memset(clampGeneric, 0, sizeof(clampGeneric));
+			memset(clampTest, 0, sizeof(clampTest));
+
+			generic.clamp(clampGeneric, outGeneric, numSamples);
+			kernels.clamp(clampTest, outGeneric, numSamples);
+			TS_ASSERT_SAME_DATA(clampGeneric, clampTest, sizeof(clampGeneric));
+		}
+	}
+
+	// Collect the kernels which can be used on this CPU
+	static uint getKernelSets(Audio::MixKernels *sets) {
+		uint count = 0;
+		Audio::getMixKernelsGeneric(sets[count++]);
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			Audio::getMixKernelsSSE2(sets[count++]);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			Audio::getMixKernelsAVX2(sets[count++]);
+#endif
+		return count;
+	}
+
+	void test_simd_kernels() {
+		Audio::MixKernels sets[3];
+		const uint count = getKernelSets(sets);
+		for (uint i = 1; i < count; ++i)
+			compareKernels(sets[i]);
+	}
+
+	// Mixing a single stream into the 32-bit bus and clipping it must give
+	// the same result as mixing into a 16-bit buffer.
+	void checkMixBus(int inRate, int outRate, bool inStereo, bool outStereo, bool reverseStereo, Audio::RateConverterType type = Audio::kRateConverterDefault) {
+		Common::install_null_g_system();
+
+		Audio::MixKernels sets[3];
+		const uint count = getKernelSets(sets);
+		for (uint i = 0; i < count; ++i) {
+			Audio::setMixKernels(sets[i]);
+			checkMixBus(inRate, outRate, inStereo, outStereo, reverseStereo, type, 200, 100);
+			checkMixBus(inRate, outRate, inStereo, outStereo, reverseStereo, type, 256, 256);
+		}
+		Audio::resetMixKernels();
+	}
+
+	void checkMixBus(int inRate, int outRate, bool inStereo, bool outStereo, bool reverseStereo, Audio::RateConverterType type, int volL, int volR) {
+		const uint numFrames = 1000;
+		const uint numSamples = numFrames * (outStereo ? 2 : 1);
+
+		Audio::SeekableAudioStream *stream16 = createSineStream<int16>(inRate, 1, nullptr, false, inStereo);
+		Audio::SeekableAudioStream *stream32 = createSineStream<int16>(inRate, 1, nullptr, false, inStereo);
+		Audio::RateConverter *conv16 = Audio::makeRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, type);
+		Audio::RateConverter *conv32 = Audio::makeRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, type);
+
+		Audio::st_sample_t *out16 = new Audio::st_sample_t[numSamples]();
+		Audio::st_sample_t *out32 = new Audio::st_sample_t[numSamples]();
+		Audio::st_mix_t *bus = new Audio::st_mix_t[numSamples]();
+
+		// Convert in several chunks, so the state carried between calls is
+		// used as well
+		for (uint pos = 0; pos < numFrames; pos += 250) {
+			const int res16 = conv16->convert(*stream16, out16 + pos * (outStereo ? 2 : 1), 250, volL, volR);
+			const int res32 = conv32->convert(*stream32, bus + pos * (outStereo ? 2 : 1), 250, volL, volR);
+			TS_ASSERT_EQUALS(res16, res32);
+		}
+		Audio::clampMixBuffer(out32, bus, numSamples);
+
+		TS_ASSERT_SAME_DATA(out16, out32, numSamples * sizeof(Audio::st_sample_t));
+
+		delete[] bus;
+		delete[] out32;
+		delete[] out16;
+		delete conv32;
+		delete conv16;
+		delete stream32;
+		delete stream16;
+	}
+
+	void test_mix_bus_copy() {
+		checkMixBus(22050, 22050, false, true, false);
+		checkMixBus(22050, 22050, true, true, true);
+		checkMixBus(22050, 22050, true, false, false);
+	}
+
+	void test_mix_bus_simple() {
+		checkMixBus(44100, 22050, false, false, false);
+		checkMixBus(44100, 22050, true, true, false);
+		checkMixBus(44100, 22050, true, true, true);
+	}
+
+	void test_mix_bus_interpolate() {
+		checkMixBus(22050, 44100, false, true, false);
+		checkMixBus(11025, 44100, true, true, false);
+		checkMixBus(22050, 48000, true, false, false);
+	}
+
+	void test_mix_bus_sinc() {
+		checkMixBus(22050, 48000, false, true, false, Audio::kRateConverterSinc);
+		checkMixBus(11025, 44100, true, true, true, Audio::kRateConverterSinc);
+		checkMixBus(44100, 22050, true, false, false, Audio::kRateConverterSinc);
+	}
+	static Audio::SeekableAudioStream *createConstantStream(int rate, uint frames, int16 left, int16 right, bool isStereo) {
+		const uint numSamples = frames * (isStereo ? 2 : 1);
+		byte *data = (byte *)malloc(numSamples * 2);
+		for (uint i = 0; i < numSamples; ++i)
+			WRITE_LE_INT16(data + i * 2, (isStereo && (i & 1)) ? right : left);
+
+		return Audio::makeRawStream(data, numSamples * 2, rate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN | (isStereo ? Audio::FLAG_STEREO : 0), DisposeAfterUse::YES);
+	}
+
+	// Convert a whole stream with full volume, and return the number of frames
+	static uint convertAll(Audio::RateConverter *conv, Audio::AudioStream *stream, Audio::st_sample_t *out, uint maxFrames, bool outStereo) {
+		uint frames = 0;
+		while (frames < maxFrames && (!stream->endOfData() || conv->needsDraining())) {
+			const int res = conv->convert(*stream, out + frames * (outStereo ? 2 : 1), MIN<uint>(300, maxFrames - frames), Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+			if (res == 0)
+				break;
+			frames += res;
+		}
+		return frames;
+	}
+
+	void test_sinc_constant() {
+		Common::install_null_g_system();
+		Audio::MixKernels generic;
+		Audio::getMixKernelsGeneric(generic);
+		Audio::setMixKernels(generic);
+
+		const uint inFrames = 2000;
+		const uint maxFrames = 5000;
+		Audio::st_sample_t *out = new Audio::st_sample_t[maxFrames * 2]();
+
+		// A constant signal must stay exactly the same, away from its edges
+		Audio::SeekableAudioStream *stream = createConstantStream(22050, inFrames, 10000, -5000, true);
+		Audio::RateConverter *conv = Audio::makeRateConverter(22050, 48000, true, true, true, Audio::kRateConverterSinc);
+		uint frames = convertAll(conv, stream, out, maxFrames, true);
+		for (uint i = 100; i < frames - 100; ++i) {
+			TS_ASSERT_EQUALS(out[i * 2], -5000);
+			TS_ASSERT_EQUALS(out[i * 2 + 1], 10000);
+		}
+		delete conv;
+		delete stream;
+
+		// When the stream ends, the converter is drained up to the last input frame
+		memset(out, 0, maxFrames * 2 * sizeof(Audio::st_sample_t));
+		stream = createConstantStream(44100, inFrames, 10000, 0, false);
+		conv = Audio::makeRateConverter(44100, 22050, false, false, false, Audio::kRateConverterSinc);
+		frames = convertAll(conv, stream, out, maxFrames, false);
+		TS_ASSERT_EQUALS(frames, inFrames / 2);
+		TS_ASSERT(!conv->needsDraining());
+		for (uint i = 100; i < frames - 100; ++i)
+			TS_ASSERT_EQUALS(out[i], 10000);
+		delete conv;
+		delete stream;
+
+		delete[] out;
+		Audio::resetMixKernels();
+	}
+
+	// Compare the output for a sine wave against the exact sine wave
+	static int sincSineError(int inRate, int outRate, double freq) {
+		const uint inFrames = inRate / 4;
+		const uint maxFrames = outRate;
+		const double amplitude = 16000.0;
+
+		int16 *data = (int16 *)malloc(inFrames * 2);
+		for (uint i = 0; i < inFrames; ++i)
+			WRITE_LE_INT16(data + i, (int16)floor(amplitude * sin(2 * M_PI * freq * i / inRate) + 0.5));
+		Audio::SeekableAudioStream *stream = Audio::makeRawStream((byte *)data, inFrames * 2, inRate, Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN, DisposeAfterUse::YES);
+
+		Audio::st_sample_t *out = new Audio::st_sample_t[maxFrames]();
+		Audio::RateConverter *conv = Audio::makeRateConverter(inRate, outRate, false, false, false, Audio::kRateConverterSinc);
+		const uint frames = convertAll(conv, stream, out, maxFrames, false);
+
+		int maxError = 0;
+		for (uint i = 200; i < frames - 200; ++i) {
+			const int expected = (int)floor(amplitude * sin(2 * M_PI * freq * i / outRate) + 0.5);
+			maxError = MAX(maxError, ABS(out[i] - expected));
+		}
+
+		delete conv;
+		delete stream;
+		delete[] out;
+		return maxError;
+	}
+
+	void test_sinc_sine() {
+		Common::install_null_g_system();
+		Audio::MixKernels generic;
+		Audio::getMixKernelsGeneric(generic);
+		Audio::setMixKernels(generic);
+
+		TS_ASSERT_LESS_THAN(sincSineError(22050, 48000, 1000.0), 16);
+		TS_ASSERT_LESS_THAN(sincSineError(11025, 44100, 3000.0), 16);
+		TS_ASSERT_LESS_THAN(sincSineError(22050, 22222, 5000.0), 16);
+		TS_ASSERT_LESS_THAN(sincSineError(48000, 22050, 2000.0), 16);
+		Audio::resetMixKernels();
+	}
+
+	// A rate prepared on another thread must give the same result as a
+	// rate set directly
+	void test_sinc_prepared_rate() {
+		Common::install_null_g_system();
+		Audio::MixKernels generic;
+		Audio::getMixKernelsGeneric(generic);
+		Audio::setMixKernels(generic);
+
+		const uint maxFrames = 20000;
+		Audio::st_sample_t *outDirect = new Audio::st_sample_t[maxFrames]();
+		Audio::st_sample_t *outPrepared = new Audio::st_sample_t[maxFrames]();
+
+		Audio::SeekableAudioStream *streamDirect = createSineStream<int16>(22050, 1, nullptr, false, false);
+		Audio::SeekableAudioStream *streamPrepared = createSineStream<int16>(22050, 1, nullptr, false, false);
+		Audio::RateConverter *convDirect = Audio::makeRateConverter(22050, 44100, false, false, false, Audio::kRateConverterSinc);
+		Audio::RateConverter *convPrepared = Audio::makeRateConverter(22050, 44100, false, false, false, Audio::kRateConverterSinc);
+
+		TS_ASSERT_EQUALS(convDirect->convert(*streamDirect, outDirect, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+		TS_ASSERT_EQUALS(convPrepared->convert(*streamPrepared, outPrepared, 1000, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), 1000);
+
+		convDirect->setInputRate(11025);
+		Audio::RateConverterData *data = convPrepared->prepareInputRate(11025);
+		TS_ASSERT(data);
+		convPrepared->setPreparedInputRate(11025, data);
+		TS_ASSERT_EQUALS(convPrepared->getInputRate(), 11025u);
+
+		const uint framesDirect = 1000 + convertAll(convDirect, streamDirect, outDirect + 1000, maxFrames - 1000, false);
+		const uint framesPrepared = 1000 + convertAll(convPrepared, streamPrepared, outPrepared + 1000, maxFrames - 1000, false);
+		TS_ASSERT_EQUALS(framesDirect, framesPrepared);
+		TS_ASSERT_SAME_DATA(outDirect, outPrepared, framesDirect * sizeof(Audio::st_sample_t));
+
+		// Prepared data which is not used anyway is given back
+		convPrepared->prepareInputRate(8000)->release();
+
+		delete convDirect;
+		delete convPrepared;
+		delete streamDirect;
+		delete streamPrepared;
+		delete[] outDirect;
+		delete[] outPrepared;
+		Audio::resetMixKernels();
+	}
+
+	void test_converter_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+		Audio::MixKernels sets[3];
+		Audio::setMixKernels(sets[getKernelSets(sets) - 1]);
+
+		static const struct {
+			int inRate, outRate;
+			Audio::RateConverterType type;
+			const char *name;
+		} converters[] = {
+			{ 44100, 44100, Audio::kRateConverterDefault, "copy" },
+			{ 44100, 22050, Audio::kRateConverterDefault, "simple" },
+			{ 22050, 48000, Audio::kRateConverterDefault, "linear" },
+			{ 22050, 48000, Audio::kRateConverterSinc, "sinc" },
+			{ 11025, 48000, Audio::kRateConverterSinc, "sinc" },
+			{ 48000, 22050, Audio::kRateConverterSinc, "sinc" }
+		};
+
+		const uint blockFrames = 1024;
+		Audio::st_mix_t *bus = new Audio::st_mix_t[blockFrames * 2];
+
+		for (uint i = 0; i < ARRAYSIZE(converters); ++i) {
+			Audio::SeekableAudioStream *stream = createSineStream<int16>(converters[i].inRate, 4, nullptr, false, true);
+			Audio::RateConverter *conv = Audio::makeRateConverter(converters[i].inRate, converters[i].outRate, true, true, false, converters[i].type);
+
+			uint frames = 0;
+			const uint32 start = g_system->getMillis();
+			for (;;) {
+				const int res = conv->convert(*stream, bus, blockFrames, 200, 200);
+				frames += res;
+				if (res < (int)blockFrames)
+					break;
+			}
+			const uint32 time = g_system->getMillis() - start;
+
+			debug("%s %d -> %d Hz stereo: %f ns per output frame", converters[i].name, converters[i].inRate, converters[i].outRate, time * 1000000.0 / frames);
+
+			delete conv;
+			delete stream;
+		}
+
+		delete[] bus;
+		Audio::resetMixKernels();
+#endif
+	}
+};
+
+#endif
@@ -0,0 +1,280 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/atomic.h"
+#include "common/memstream.h"
+#include "common/taskpool.h"
+
+#include "../null_osystem.h"
+
+class ArchiveTestSuite : public CxxTest::TestSuite
+{
+	// An archive whose members contain the name of the archive, and which
+	// counts how often it is asked for them
+	class TestArchive : public Common::Archive {
+	public:
+		TestArchive(const char *name) : _name(name), _lookups(0) {}
+
+		void addMember(const char *path) { _members.push_back(Common::Path(path)); }
+
+		bool hasFile(const Common::Path &path) const override {
+			return findMember(path) >= 0;
+		}
+
+		int listMembers(Common::ArchiveMemberList &list) const override {
+			for (uint i = 0; i < _members.size(); i++)
+				list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_members[i], *this)));
+			return _members.size();
+		}
+
+		const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+			if (findMember(path) < 0)
+				return Common::ArchiveMemberPtr();
+			return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path, *this));
+		}
+
+		Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override {
+			if (findMember(path) < 0)
+				return nullptr;
+			return new Common::MemoryReadStream((const byte *)_name, strlen(_name));
+		}
+
+		const char *_name;
+		Common::Array<Common::Path> _members;
+		mutable int _lookups;
+
+	private:
+		int findMember(const Common::Path &path) const {
+			_lookups++;
+			for (uint i = 0; i < _members.size(); i++) {
+				if (_members[i].equalsIgnoreCase(path))
+					return i;
+			}
+			return -1;
+		}
+	};
+
+	// An archive of members of the given sizes, which counts how often it
+	// reads them
+	class TestMemcachingArchive : public Common::MemcachingCaseInsensitiveArchive {
+	public:
+		TestMemcachingArchive(uint32 maxStronglyCachedSize) : Common::MemcachingCaseInsensitiveArchive(maxStronglyCachedSize), _reads(0) {}
+
+		bool hasFile(const Common::Path &path) const override {
+			return getSize(path) > 0;
+		}
+
+		int listMembers(Common::ArchiveMemberList &list) const override {
+			return 0;
+		}
+
+		const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+			return Common::ArchiveMemberPtr();
+		}
+
+		Common::SharedArchiveContents readContentsForPath(const Common::Path &translatedPath) const override {
+			const uint32 size = getSize(translatedPath);
+			if (!size)
+				return Common::SharedArchiveContents();
+
+			Common::atomicAdd(&_reads, 1);
+			byte *contents = new byte[size];
+			memset(contents, size & 0xFF, size);
+			return Common::SharedArchiveContents(contents, size);
+		}
+
+		mutable int32 _reads;
+
+	private:
+		// The members are named after their sizes
+		static uint32 getSize(const Common::Path &path) {
+			return atoi(path.toString().c_str());
+		}
+	};
+
+	static uint32 openMember(const Common::Archive &archive, const char *path) {
+		Common::SeekableReadStream *stream = archive.createReadStreamForMember(Common::Path(path));
+		if (!stream)
+			return 0;
+
+		const uint32 size = stream->size();
+		delete stream;
+		return size;
+	}
+
+	static Common::String readMember(const Common::SearchSet &searchSet, const char *path) {
+		Common::SeekableReadStream *stream = searchSet.createReadStreamForMember(Common::Path(path));
+		if (!stream)
+			return Common::String();
+
+		Common::String contents = stream->readString(0, stream->size());
+		delete stream;
+		return contents;
+	}
+
+	static void checkLookups(const Common::SearchSet &searchSet) {
+		TS_ASSERT_EQUALS(readMember(searchSet, "shared.dat"), "high");
+		TS_ASSERT_EQUALS(readMember(searchSet, "LOW.DAT"), "low");
+		TS_ASSERT_EQUALS(readMember(searchSet, "dir/high.dat"), "high");
+		TS_ASSERT_EQUALS(readMember(searchSet, "missing.dat"), "");
+
+		TS_ASSERT(searchSet.hasFile(Common::Path("low.dat")));
+		TS_ASSERT(!searchSet.hasFile(Common::Path("dir/low.dat")));
+
+		Common::Archive *container = nullptr;
+		Common::ArchiveMemberPtr member = searchSet.getMember(Common::Path("Shared.dat"), &container);
+		TS_ASSERT(member);
+		TS_ASSERT(container == searchSet.getArchive("high"));
+		TS_ASSERT(!searchSet.getMember(Common::Path("missing.dat"), &container));
+	}
+
+	public:
+	void test_search_set() {
+		for (int enabled = 0; enabled < 2; enabled++) {
+			Common::SearchSet searchSet;
+			searchSet.setPathIndexEnabled(enabled);
+
+			TestArchive *low = new TestArchive("low");
+			low->addMember("shared.dat");
+			low->addMember("low.dat");
+			TestArchive *high = new TestArchive("high");
+			high->addMember("shared.dat");
+			high->addMember("dir/high.dat");
+
+			searchSet.add("low", low, 0);
+			searchSet.add("high", high, 1);
+			checkLookups(searchSet);
+
+			// The index is rebuilt when the priorities change
+			searchSet.setPriority("low", 2);
+			TS_ASSERT_EQUALS(readMember(searchSet, "shared.dat"), "low");
+
+			searchSet.remove("low");
+			TS_ASSERT_EQUALS(readMember(searchSet, "shared.dat"), "high");
+			TS_ASSERT(!searchSet.hasFile(Common::Path("low.dat")));
+		}
+	}
+
+	void test_path_index() {
+		Common::SearchSet searchSet;
+		searchSet.setPathIndexEnabled(true);
+
+		TestArchive *low = new TestArchive("low");
+		low->addMember("low.dat");
+		TestArchive *high = new TestArchive("high");
+		high->addMember("high.dat");
+		searchSet.add("low", low, 0);
+		searchSet.add("high", high, 1);
+
+		// Only the archive which has the member is asked for it
+		TS_ASSERT_EQUALS(readMember(searchSet, "low.dat"), "low");
+		TS_ASSERT(!searchSet.hasFile(Common::Path("missing.dat")));
+		TS_ASSERT_EQUALS(high->_lookups, 0);
+		TS_ASSERT_EQUALS(low->_lookups, 1);
+		TS_ASSERT_EQUALS(searchSet.getPathIndexHits(), 1u);
+		TS_ASSERT_EQUALS(searchSet.getPathIndexNegativeLookups(), 1u);
+
+		// Members added behind the back of the search set are only found
+		// once the index is invalidated
+		high->addMember("new.dat");
+		TS_ASSERT(!searchSet.hasFile(Common::Path("new.dat")));
+		searchSet.invalidatePathIndex();
+		TS_ASSERT(searchSet.hasFile(Common::Path("NEW.DAT")));
+		TS_ASSERT_EQUALS(searchSet.getPathIndexHits(), 2u);
+	}
+
+	void test_memcaching_budget() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		typedef Common::MemcachingCaseInsensitiveArchive MemcachingArchive;
+		TS_ASSERT_EQUALS(MemcachingArchive::getCacheBudget(), MemcachingArchive::kDefaultCacheBudget);
+		const uint32 budget = MemcachingArchive::getCacheBudget();
+		const MemcachingArchive::CacheStats stats = MemcachingArchive::getCacheStats();
+		MemcachingArchive::setCacheBudget(stats.bytesResident + 1000);
+
+		TestMemcachingArchive *first = new TestMemcachingArchive(500);
+		TestMemcachingArchive second(500);
+		TS_ASSERT_EQUALS(openMember(*first, "400"), 400u);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(openMember(*first, "400"), 400u);
+		TS_ASSERT_EQUALS(first->_reads, 1);
+		TS_ASSERT_EQUALS(MemcachingArchive::getCacheStats().bytesResident, stats.bytesResident + 700);
+
+		// The least recently used member of all archives is evicted first
+		TS_ASSERT_EQUALS(openMember(*first, "200"), 200u);
+		TS_ASSERT_EQUALS(openMember(second, "350"), 350u);
+		TS_ASSERT_EQUALS(openMember(*first, "400"), 400u);
+		TS_ASSERT_EQUALS(first->_reads, 2);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(second._reads, 3);
+
+		// With a budget, members above the size limit of the archive are kept
+		// as well
+		TS_ASSERT_EQUALS(openMember(second, "600"), 600u);
+		TS_ASSERT_EQUALS(openMember(second, "600"), 600u);
+		TS_ASSERT_EQUALS(second._reads, 4);
+		TS_ASSERT_EQUALS(openMember(second, "missing"), 0u);
+
+		const MemcachingArchive::CacheStats newStats = MemcachingArchive::getCacheStats();
+		TS_ASSERT_EQUALS(newStats.hits - stats.hits, 3u);
+		TS_ASSERT_EQUALS(newStats.misses - stats.misses, 6u);
+		TS_ASSERT_EQUALS(newStats.evictions - stats.evictions, 4u);
+		TS_ASSERT_EQUALS(newStats.bytesResident, stats.bytesResident + 900);
+
+		// Deleted archives and smaller budgets free the memory
+		TS_ASSERT_EQUALS(openMember(*first, "100"), 100u);
+		TS_ASSERT_EQUALS(MemcachingArchive::getCacheStats().bytesResident, stats.bytesResident + 1000);
+		delete first;
+		TS_ASSERT_EQUALS(MemcachingArchive::getCacheStats().bytesResident, stats.bytesResident + 900);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(second._reads, 4);
+		MemcachingArchive::setCacheBudget(stats.bytesResident);
+		TS_ASSERT_EQUALS(MemcachingArchive::getCacheStats().bytesResident, stats.bytesResident);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(second._reads, 5);
+
+		// Without a budget, only the members up to the size limit are kept
+		MemcachingArchive::setCacheBudget(MemcachingArchive::kDefaultCacheBudget);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(openMember(second, "300"), 300u);
+		TS_ASSERT_EQUALS(openMember(second, "600"), 600u);
+		TS_ASSERT_EQUALS(openMember(second, "600"), 600u);
+		TS_ASSERT_EQUALS(second._reads, 8);
+
+		MemcachingArchive::setCacheBudget(budget);
+#endif
+	}
+
+	void test_memcaching_threads() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		typedef Common::MemcachingCaseInsensitiveArchive MemcachingArchive;
+		const uint32 budget = MemcachingArchive::getCacheBudget();
+		const MemcachingArchive::CacheStats stats = MemcachingArchive::getCacheStats();
+		MemcachingArchive::setCacheBudget(stats.bytesResident + 2000);
+
+		// The archives share the cache, so the threads evict the members of
+		// each other
+		TestMemcachingArchive first(500), second(500);
+		const uint numOpens = 4000;
+		uint32 sizes[numOpens];
+		Common::TaskPool pool(3);
+		pool.parallelFor(0, numOpens, 50, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				const Common::String name = Common::String::format("%u", 100 + i % 37 * 10);
+				sizes[i] = openMember((i & 1) ? first : second, name.c_str());
+			}
+		});
+
+		for (uint i = 0; i < numOpens; i++)
+			TS_ASSERT_EQUALS(sizes[i], 100 + i % 37 * 10);
+		const MemcachingArchive::CacheStats newStats = MemcachingArchive::getCacheStats();
+		TS_ASSERT_EQUALS(newStats.hits + newStats.misses - stats.hits - stats.misses, numOpens);
+		TS_ASSERT_LESS_THAN_EQUALS(newStats.bytesResident, stats.bytesResident + 2000);
+
+		MemcachingArchive::setCacheBudget(budget);
+#endif
+	}
+};
@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/compression/deflate.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+
+class DeflateTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kDataSize = 3 * 1024 * 1024 + 12345,
+		kInterval = 256 * 1024
+	};
+
+	// Words of varying length, so that the deflate blocks refer back into
+	// the data before them
+	static byte *createData() {
+		byte *data = new byte[kDataSize];
+		uint32 seed = 12345;
+		for (uint32 i = 0; i < kDataSize; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (seed >> 27) ? 'a' + (seed >> 16) % 16 : ' ';
+		}
+		return data;
+	}
+
+	static byte *compress(const byte *data, uint32 &size) {
+		Common::MemoryWriteStreamDynamic *compressed = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *stream = Common::wrapCompressedWriteStream(compressed);
+		stream->write(data, kDataSize);
+		stream->finalize();
+
+		byte *result = compressed->getData();
+		size = compressed->size();
+		delete stream;
+		return result;
+	}
+
+	static bool readMatches(Common::SeekableReadStream &stream, const byte *data, uint32 pos, uint32 size) {
+		byte *buffer = new byte[size];
+		stream.seek(pos);
+		const bool matches = stream.read(buffer, size) == size && !memcmp(buffer, data + pos, size);
+		delete[] buffer;
+		return matches;
+	}
+
+	public:
+	void test_seek_index() {
+		byte *data = createData();
+		uint32 compressedSize;
+		byte *compressed = compress(data, compressedSize);
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::wrapCompressedReadStream(
+			new Common::MemoryReadStream(compressed, compressedSize), DisposeAfterUse::YES, kDataSize));
+		TS_ASSERT(stream);
+
+		// Without compression support, the data is written as it is
+		Common::DeflateSeekIndex *index = Common::getDeflateSeekIndex(stream.get());
+		if (index) {
+			index->setCheckpointInterval(kInterval);
+			TS_ASSERT(readMatches(*stream, data, 0, kDataSize));
+			// They are taken at the first block after each interval
+			TS_ASSERT_LESS_THAN((uint)(kDataSize / kInterval / 2), index->getCheckpointCount());
+
+			// Seeking back resumes from the checkpoints
+			const uint32 positions[] = { 3000000, 1000, 2 * kInterval + 7, kInterval - 1, 0, kDataSize - 100 };
+			for (uint i = 0; i < ARRAYSIZE(positions); i++)
+				TS_ASSERT(readMatches(*stream, data, positions[i], 100));
+			TS_ASSERT(!stream->err());
+
+			Common::MemoryWriteStreamDynamic saved(DisposeAfterUse::YES);
+			TS_ASSERT(index->saveSeekIndex(saved));
+
+			// A new stream with the saved checkpoints can seek straight to
+			// the end, and keeps recording more of them
+			Common::ScopedPtr<Common::SeekableReadStream> restored(Common::wrapCompressedReadStream(
+				new Common::MemoryReadStream(compressed, compressedSize), DisposeAfterUse::YES, kDataSize));
+			Common::DeflateSeekIndex *restoredIndex = Common::getDeflateSeekIndex(restored.get());
+			Common::MemoryReadStream savedIndex(saved.getData(), saved.size());
+			TS_ASSERT(restoredIndex->loadSeekIndex(savedIndex));
+			TS_ASSERT_EQUALS(restoredIndex->getCheckpointCount(), index->getCheckpointCount());
+			TS_ASSERT(readMatches(*restored, data, kDataSize - 5000, 5000));
+			TS_ASSERT(readMatches(*restored, data, kInterval + 3, 5000));
+			TS_ASSERT(!restored->err());
+
+			// The index of different data is rejected
+			Common::ScopedPtr<Common::SeekableReadStream> other(Common::wrapCompressedReadStream(
+				new Common::MemoryReadStream(compressed, compressedSize - 1), DisposeAfterUse::YES, kDataSize));
+			savedIndex.seek(0);
+			TS_ASSERT(!Common::getDeflateSeekIndex(other.get())->loadSeekIndex(savedIndex));
+		}
+
+		free(compressed);
+		delete[] data;
+	}
+};
@@ -0,0 +1,219 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/crc.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/compression/deflate.h"
+#include "common/compression/unzip.h"
+
+#include "../../null_osystem.h"
+
+class UnzipTestSuite : public CxxTest::TestSuite
+{
+	enum {
+		kLargeSize = 1024 * 1024 + 4321
+	};
+
+	struct Member {
+		const char *name;
+		const byte *data;
+		uint32 size;
+		uint16 method;
+		const byte *compressed;
+		uint32 compressedSize;
+		uint32 offset;
+	};
+
+	static byte *createData() {
+		byte *data = new byte[kLargeSize];
+		uint32 seed = 54321;
+		for (uint32 i = 0; i < kLargeSize; i++) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = (seed >> 27) ? 'a' + (seed >> 16) % 16 : ' ';
+		}
+		return data;
+	}
+
+	// Raw deflate data, taken out of the gzip stream, or nullptr if the
+	// data cannot be compressed
+	static byte *deflate(const byte *data, uint32 size, uint32 &deflatedSize) {
+		Common::MemoryWriteStreamDynamic *compressed = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *stream = Common::wrapCompressedWriteStream(compressed);
+		stream->write(data, size);
+		stream->finalize();
+		byte *gzip = compressed->getData();
+		const uint32 gzipSize = compressed->size();
+		delete stream;
+
+		// The header has no optional fields, and is followed by the data,
+		// the CRC and the size
+		byte *result = nullptr;
+		if (gzipSize > 18 && gzip[0] == 0x1F && gzip[1] == 0x8B && gzip[3] == 0) {
+			deflatedSize = gzipSize - 18;
+			result = new byte[deflatedSize];
+			memcpy(result, gzip + 10, deflatedSize);
+		}
+		free(gzip);
+		return result;
+	}
+
+	static void writeZip(Common::WriteStream &zip, Member *members, uint count) {
+		Common::CRC32 crc;
+
+		for (uint i = 0; i < count; i++) {
+			Member &member = members[i];
+			member.offset = zip.pos();
+			zip.writeUint32LE(0x04034B50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(member.method);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(crc.crcFast(member.data, member.size));
+			zip.writeUint32LE(member.compressedSize);
+			zip.writeUint32LE(member.size);
+			zip.writeUint16LE(strlen(member.name));
+			zip.writeUint16LE(0);
+			zip.writeString(member.name);
+			zip.write(member.compressed, member.compressedSize);
+		}
+
+		const uint32 centralDirOffset = zip.pos();
+		for (uint i = 0; i < count; i++) {
+			const Member &member = members[i];
+			zip.writeUint32LE(0x02014B50);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(20);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(member.method);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(crc.crcFast(member.data, member.size));
+			zip.writeUint32LE(member.compressedSize);
+			zip.writeUint32LE(member.size);
+			zip.writeUint16LE(strlen(member.name));
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint16LE(0);
+			zip.writeUint32LE(0);
+			zip.writeUint32LE(member.offset);
+			zip.writeString(member.name);
+		}
+		const uint32 centralDirSize = zip.pos() - centralDirOffset;
+
+		zip.writeUint32LE(0x06054B50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(count);
+		zip.writeUint16LE(count);
+		zip.writeUint32LE(centralDirSize);
+		zip.writeUint32LE(centralDirOffset);
+		zip.writeUint16LE(0);
+	}
+
+	static bool readMatches(Common::SeekableReadStream &stream, const byte *data, uint32 pos, uint32 size) {
+		byte *buffer = new byte[size];
+		stream.seek(pos);
+		const bool matches = stream.read(buffer, size) == size && !memcmp(buffer, data + pos, size);
+		delete[] buffer;
+		return matches;
+	}
+
+	public:
+	void test_streamed_members() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		byte *data = createData();
+		uint32 deflatedSize = 0;
+		byte *deflated = deflate(data, kLargeSize, deflatedSize);
+		const byte small[] = "small";
+
+		Member members[] = {
+			{ "small.txt", small, 5, 0, small, 5, 0 },
+			{ "stored.bin", data, kLargeSize, 0, data, kLargeSize, 0 },
+			{ "deflated.bin", data, kLargeSize, 8, deflated, deflatedSize, 0 }
+		};
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		writeZip(zip, members, deflated ? 3 : 2);
+
+		Common::Archive *archive = Common::makeZipArchive(new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES));
+		TS_ASSERT(archive);
+
+		// Small members are cached in memory
+		Common::ScopedPtr<Common::SeekableReadStream> smallStream(archive->createReadStreamForMember(Common::Path("small.txt")));
+		TS_ASSERT(dynamic_cast<Common::MemoryReadStream *>(smallStream.get()));
+		TS_ASSERT_EQUALS(smallStream->readString(), "small");
+
+		// Large ones are read from the ZIP file as needed
+		Common::ScopedPtr<Common::SeekableReadStream> stored(archive->createReadStreamForMember(Common::Path("stored.bin")));
+		TS_ASSERT(!dynamic_cast<Common::MemoryReadStream *>(stored.get()));
+		TS_ASSERT_EQUALS(stored->size(), kLargeSize);
+		Common::ScopedPtr<Common::SeekableReadStream> inflated;
+		if (deflated) {
+			inflated.reset(archive->createReadStreamForMember(Common::Path("deflated.bin")));
+			TS_ASSERT(Common::getDeflateSeekIndex(inflated.get()));
+			TS_ASSERT_EQUALS(inflated->size(), kLargeSize);
+		}
+
+		const uint32 positions[] = { 1000, kLargeSize - 3000, 500000, 0, 777777 };
+		for (uint i = 0; i < ARRAYSIZE(positions); i++) {
+			TS_ASSERT(readMatches(*stored, data, positions[i], 3000));
+			if (inflated)
+				TS_ASSERT(readMatches(*inflated, data, positions[i], 3000));
+		}
+
+		// The streams keep the ZIP file open
+		delete archive;
+		TS_ASSERT(readMatches(*stored, data, 0, kLargeSize));
+		TS_ASSERT(!stored->err());
+		if (inflated) {
+			TS_ASSERT(readMatches(*inflated, data, 0, kLargeSize));
+			TS_ASSERT(!inflated->err());
+		}
+
+		delete[] deflated;
+		delete[] data;
+#endif
+	}
+
+	void test_streamed_crc() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		// The members hold other data than their CRC was computed from
+		byte *data = createData();
+		byte *corrupt = createData();
+		corrupt[kLargeSize - 100] ^= 0x40;
+		uint32 deflatedSize = 0;
+		byte *deflated = deflate(corrupt, kLargeSize, deflatedSize);
+
+		Member members[] = {
+			{ "stored.bin", data, kLargeSize, 0, corrupt, kLargeSize, 0 },
+			{ "deflated.bin", data, kLargeSize, 8, deflated, deflatedSize, 0 }
+		};
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		writeZip(zip, members, deflated ? 2 : 1);
+
+		Common::ScopedPtr<Common::Archive> archive(Common::makeZipArchive(new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES)));
+		TS_ASSERT(archive);
+
+		for (uint i = 0; i < (deflated ? 2U : 1U); i++) {
+			Common::ScopedPtr<Common::SeekableReadStream> stream(archive->createReadStreamForMember(Common::Path(members[i].name)));
+			TS_ASSERT(stream);
+
+			// Nothing is known before all of the data has been read
+			TS_ASSERT(readMatches(*stream, corrupt, 0, 5000));
+			TS_ASSERT(readMatches(*stream, corrupt, 500000, 5000));
+			TS_ASSERT(!stream->err());
+
+			TS_ASSERT(readMatches(*stream, corrupt, 4000, kLargeSize - 4000));
+			TS_ASSERT(stream->err());
+		}
+
+		delete[] deflated;
+		delete[] corrupt;
+		delete[] data;
+#endif
+	}
+};
@@ -0,0 +1,272 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hash-str.h"
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::FlatHashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FlatStringMap;
+
+	static uint32 nextRandom(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	}
+
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+
+		FlatStringMap container2;
+		TS_ASSERT(container2.empty());
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(!container2.empty());
+		container2.clear(true);
+		TS_ASSERT(container2.empty());
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+
+		FlatStringMap container2;
+		container2["foo"] = "bar";
+		container2["quux"] = "blub";
+		TS_ASSERT(container2.contains("foo"));
+		TS_ASSERT(container2.contains("QUUX"));
+		TS_ASSERT(!container2.contains("bar"));
+		TS_ASSERT(!container2.contains("asdf"));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		container.erase(2);
+		TS_ASSERT(container.empty());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container.setVal(2, 45);
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef[1], -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(2), 45);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0, -10), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+
+		int val = 0;
+		TS_ASSERT(containerRef.tryGetVal(2, val));
+		TS_ASSERT_EQUALS(val, 45);
+		TS_ASSERT(!containerRef.tryGetVal(3, val));
+		TS_ASSERT_EQUALS(containerRef.find(3), containerRef.end());
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		container.erase(1);
+		container[1] = 42;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		Common::FlatHashMap<int, int>::iterator i;
+		for (i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		found = 0;
+		Common::FlatHashMap<int, int>::const_iterator j;
+		for (j = container.begin(); j != container.end(); ++j) {
+			int key = j->_key;
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		// Erasing while iterating does not move the other elements
+		for (i = container.begin(); i != container.end(); ++i) {
+			if (i->_key != 3)
+				container.erase(i);
+		}
+		TS_ASSERT_EQUALS(container.size(), 1u);
+		TS_ASSERT_EQUALS(container.begin()->_value, 12);
+	}
+
+	void test_copy() {
+		FlatStringMap map1, map2;
+		for (int i = 0; i < 100; i++)
+			map1[Common::String::format("key%d", i)] = Common::String::format("val%d", i);
+		map1.erase("key50");
+
+		map2 = map1;
+		FlatStringMap map3(map1);
+		map1.clear();
+
+		TS_ASSERT_EQUALS(map2.size(), 99u);
+		TS_ASSERT_EQUALS(map3.size(), 99u);
+		TS_ASSERT_EQUALS(map2["KEY99"], "val99");
+		TS_ASSERT_EQUALS(map3["key0"], "val0");
+		TS_ASSERT(!map3.contains("key50"));
+	}
+
+	void test_collision() {
+		// Keys which only differ in their high bits, and so share the bits
+		// used to tag the slots
+		Common::FlatHashMap<int, int> h;
+		for (int i = 0; i < 64; i++)
+			h[i << 24] = i;
+		for (int i = 0; i < 64; i += 2)
+			h.erase(i << 24);
+		for (int i = 0; i < 64; i++)
+			TS_ASSERT_EQUALS(h.contains(i << 24), (i & 1) != 0);
+		TS_ASSERT_EQUALS(h.size(), 32u);
+	}
+
+	void test_against_hashmap() {
+		// Random insertions and deletions, also filling the map with deleted
+		// slots, must give the same results as the existing hash map
+		Common::FlatHashMap<uint32, uint32> flat;
+		Common::HashMap<uint32, uint32> reference;
+		uint32 seed = 1;
+
+		for (int i = 0; i < 50000; i++) {
+			const uint32 key = nextRandom(seed) % 3000;
+			const uint32 op = nextRandom(seed) % 3;
+			if (op == 0) {
+				flat.erase(key);
+				reference.erase(key);
+			} else {
+				flat[key] = i;
+				reference[key] = i;
+			}
+			TS_ASSERT_EQUALS(flat.size(), reference.size());
+		}
+
+		for (uint32 key = 0; key < 3000; key++) {
+			TS_ASSERT_EQUALS(flat.contains(key), reference.contains(key));
+			TS_ASSERT_EQUALS(flat.getValOrDefault(key, 0xFFFFFFFF), reference.getValOrDefault(key, 0xFFFFFFFF));
+		}
+
+		uint count = 0;
+		for (Common::FlatHashMap<uint32, uint32>::const_iterator i = flat.begin(); i != flat.end(); ++i) {
+			TS_ASSERT_EQUALS(i->_value, reference[i->_key]);
+			count++;
+		}
+		TS_ASSERT_EQUALS(count, reference.size());
+	}
+
+	template<class Map, class Key>
+	static uint32 timeLookups(const Key *keys, uint numKeys, uint rounds, uint &hits) {
+		Map map;
+		for (uint i = 0; i < numKeys; i += 2)
+			map[keys[i]] = i;
+
+		const uint32 start = g_system->getMillis();
+		for (uint r = 0; r < rounds; r++) {
+			for (uint i = 0; i < numKeys; i++)
+				hits += map.contains(keys[i]);
+		}
+		return g_system->getMillis() - start;
+	}
+
+	template<class Map, class Key>
+	static uint32 timeInsertions(const Key *keys, uint numKeys, uint rounds) {
+		const uint32 start = g_system->getMillis();
+		for (uint r = 0; r < rounds; r++) {
+			Map map;
+			for (uint i = 0; i < numKeys; i++)
+				map[keys[i]] = i;
+		}
+		return g_system->getMillis() - start;
+	}
+
+	void test_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		const uint numKeys = 20000;
+		const uint rounds = 50;
+		uint32 *intKeys = new uint32[numKeys];
+		Common::String *stringKeys = new Common::String[numKeys];
+		for (uint i = 0; i < numKeys; i++) {
+			// Distinct keys, spread over the whole range
+			uint32 key = i * 0x6C8E9CF5;
+			key ^= key >> 15;
+			intKeys[i] = key * 0x2C1B3C6D;
+			stringKeys[i] = Common::String::format("data/room%u/object%u.bin", i % 97, intKeys[i]);
+		}
+
+		// Half of the keys are in the maps, so half of the lookups fail
+		uint hits = 0;
+		uint32 oldTime = timeLookups<Common::HashMap<uint32, uint32> >(intKeys, numKeys, rounds, hits);
+		uint32 newTime = timeLookups<Common::FlatHashMap<uint32, uint32> >(intKeys, numKeys, rounds, hits);
+		debug("uint32 lookups: HashMap %d ms, FlatHashMap %d ms", oldTime, newTime);
+
+		oldTime = timeLookups<Common::StringMap>(stringKeys, numKeys, rounds, hits);
+		newTime = timeLookups<FlatStringMap>(stringKeys, numKeys, rounds, hits);
+		debug("String lookups: HashMap %d ms, FlatHashMap %d ms", oldTime, newTime);
+		TS_ASSERT_EQUALS(hits, numKeys * rounds * 2);
+
+		oldTime = timeInsertions<Common::HashMap<uint32, uint32> >(intKeys, numKeys, rounds / 5);
+		newTime = timeInsertions<Common::FlatHashMap<uint32, uint32> >(intKeys, numKeys, rounds / 5);
+		debug("uint32 insertions: HashMap %d ms, FlatHashMap %d ms", oldTime, newTime);
+
+		oldTime = timeInsertions<Common::StringMap>(stringKeys, numKeys, rounds / 5);
+		newTime = timeInsertions<FlatStringMap>(stringKeys, numKeys, rounds / 5);
+		debug("String insertions: HashMap %d ms, FlatHashMap %d ms", oldTime, newTime);
+
+		delete[] intKeys;
+		delete[] stringKeys;
+#endif
+	}
+};
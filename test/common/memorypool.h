@@ -0,0 +1,124 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_memory_pool() {
+		Common::MemoryPool pool(12);
+		TS_ASSERT_EQUALS(pool.getChunkSize() % sizeof(void *), 0u);
+
+		void *chunks[100];
+		for (int i = 0; i < 100; i++) {
+			chunks[i] = pool.allocChunk();
+			memset(chunks[i], i, 12);
+		}
+		for (int i = 0; i < 100; i++) {
+			TS_ASSERT_EQUALS(*(byte *)chunks[i], i);
+			pool.freeChunk(chunks[i]);
+		}
+		pool.freeUnusedPages();
+	}
+
+	void test_size_class_pool() {
+		// Every size from 1 to beyond the largest class, with the blocks
+		// of each size overlapping in time with the others
+		void *chunks[Common::SizeClassPool::kMaxChunkSize + 16];
+		for (uint size = 1; size < ARRAYSIZE(chunks); size++) {
+			chunks[size] = Common::SizeClassPool::allocChunk(size);
+			TS_ASSERT(chunks[size] != nullptr);
+			TS_ASSERT_EQUALS((size_t)chunks[size] % sizeof(void *), 0u);
+			memset(chunks[size], size & 0xFF, size);
+		}
+
+		for (uint size = 1; size < ARRAYSIZE(chunks); size++) {
+			const byte *data = (const byte *)chunks[size];
+			TS_ASSERT_EQUALS(data[0], size & 0xFF);
+			TS_ASSERT_EQUALS(data[size - 1], size & 0xFF);
+			Common::SizeClassPool::freeChunk(chunks[size], size);
+		}
+
+		Common::SizeClassPool::freeChunk(nullptr, 4);
+	}
+
+	void test_size_class_pool_reuse() {
+		// Churn through many more blocks than a thread keeps for itself
+		void *chunks[1000];
+		for (int round = 0; round < 3; round++) {
+			for (int i = 0; i < 1000; i++)
+				chunks[i] = Common::SizeClassPool::allocChunk(24);
+			for (int i = 0; i < 1000; i++)
+				Common::SizeClassPool::freeChunk(chunks[i], 24);
+		}
+
+		Common::SizeClassPool::Stats before;
+		Common::SizeClassPool::getStats(before);
+
+		// All the blocks needed are already in the pool
+		for (int i = 0; i < 1000; i++)
+			chunks[i] = Common::SizeClassPool::allocChunk(24);
+
+		Common::SizeClassPool::Stats during;
+		Common::SizeClassPool::getStats(during);
+		TS_ASSERT_EQUALS(during.pages, before.pages);
+		TS_ASSERT_EQUALS(during.bytesHeld, before.bytesHeld);
+		TS_ASSERT_LESS_THAN_EQUALS(before.bytesInUse + 1000 * 32, during.bytesInUse);
+
+		for (int i = 0; i < 1000; i++)
+			Common::SizeClassPool::freeChunk(chunks[i], 24);
+
+		Common::SizeClassPool::flushThreadCache();
+
+		Common::SizeClassPool::Stats after;
+		Common::SizeClassPool::getStats(after);
+		TS_ASSERT_EQUALS(after.bytesInUse, before.bytesInUse);
+		TS_ASSERT_EQUALS(after.bytesCached, 0u);
+		TS_ASSERT_LESS_THAN_EQUALS(after.bytesInUse, after.bytesHeld);
+		TS_ASSERT(after.getFragmentation() >= 0.0 && after.getFragmentation() <= 1.0);
+	}
+
+	void test_size_class_pool_release() {
+		// Blocks of a size which the other tests do not use
+		const size_t size = 200;
+		void *chunks[1000];
+
+		Common::SizeClassPool::Stats before;
+		Common::SizeClassPool::getStats(before);
+
+		for (int i = 0; i < 1000; i++)
+			chunks[i] = Common::SizeClassPool::allocChunk(size);
+		memset(chunks[0], 0x5A, size);
+
+		Common::SizeClassPool::Stats during;
+		Common::SizeClassPool::getStats(during);
+		TS_ASSERT_LESS_THAN_EQUALS(before.bytesHeld + 1000 * size, during.bytesHeld);
+
+		// A page is kept as long as one of its blocks is in use
+		for (int i = 1; i < 1000; i++)
+			Common::SizeClassPool::freeChunk(chunks[i], size);
+		Common::SizeClassPool::flushThreadCache();
+		Common::SizeClassPool::freeUnusedPages();
+
+		Common::SizeClassPool::Stats partial;
+		Common::SizeClassPool::getStats(partial);
+		TS_ASSERT_LESS_THAN(partial.pages, during.pages);
+		TS_ASSERT_LESS_THAN(partial.bytesHeld, during.bytesHeld);
+		TS_ASSERT_LESS_THAN_EQUALS(before.bytesInUse + size, partial.bytesInUse);
+		TS_ASSERT_EQUALS(((byte *)chunks[0])[size - 1], 0x5A);
+
+		// The pages released are allocated again as needed
+		for (int i = 1; i < 1000; i++)
+			chunks[i] = Common::SizeClassPool::allocChunk(size);
+		for (int i = 0; i < 1000; i++)
+			Common::SizeClassPool::freeChunk(chunks[i], size);
+		Common::SizeClassPool::flushThreadCache();
+		Common::SizeClassPool::freeUnusedPages();
+
+		Common::SizeClassPool::Stats after;
+		Common::SizeClassPool::getStats(after);
+		TS_ASSERT_LESS_THAN_EQUALS(after.pages, before.pages);
+		TS_ASSERT_LESS_THAN_EQUALS(after.bytesHeld, before.bytesHeld);
+		TS_ASSERT_EQUALS(after.bytesInUse, before.bytesInUse);
+	}
+};
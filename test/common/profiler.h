@@ -0,0 +1,82 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/profiler.h"
+#include "common/stream.h"
+#include "common/str.h"
+
+class ProfilerTestSuite : public CxxTest::TestSuite
+{
+	class StringWriteStream : public Common::WriteStream {
+	public:
+		StringWriteStream(Common::String &output) : _output(output) {}
+
+		uint32 write(const void *dataPtr, uint32 dataSize) override {
+			_output += Common::String((const char *)dataPtr, dataSize);
+			return dataSize;
+		}
+
+		int64 pos() const override { return _output.size(); }
+
+	private:
+		Common::String &_output;
+	};
+
+	static void zone() {
+		PROFILE_ZONE("test_zone");
+	}
+
+	static void nestedZones() {
+		PROFILE_ZONE("outer_zone");
+		PROFILE_ZONE("inner_zone");
+	}
+
+	public:
+	void test_not_running() {
+		TS_ASSERT(!Common::Profiler::isRunning());
+
+		// Nothing is recorded, and nothing breaks
+		zone();
+		PROFILE_COUNTER("test_counter", 1);
+		Common::Profiler::endFrame();
+		Common::Profiler::stop();
+	}
+
+	void test_trace() {
+		Common::String output;
+		if (!Common::Profiler::start(new StringWriteStream(output)))
+			return; // Not supported on this platform
+
+		TS_ASSERT(Common::Profiler::isRunning());
+
+		zone();
+		nestedZones();
+		PROFILE_COUNTER("test_counter", 42);
+		Common::Profiler::endFrame();
+		zone();
+		Common::Profiler::stop();
+
+		TS_ASSERT(!Common::Profiler::isRunning());
+
+		TS_ASSERT(output.hasPrefix("{\"traceEvents\":["));
+		TS_ASSERT(output.hasSuffix("]"
+		                           ",\"displayTimeUnit\":\"ms\"}\n"));
+		TS_ASSERT(output.contains("\"name\":\"thread_name\",\"ph\":\"M\""));
+		TS_ASSERT(output.contains("\"name\":\"Frame\",\"ph\":\"X\""));
+		TS_ASSERT(output.contains("\"args\":{\"value\":42}"));
+		TS_ASSERT(output.contains("\"name\":\"outer_zone\",\"ph\":\"X\""));
+		TS_ASSERT(output.contains("\"name\":\"inner_zone\",\"ph\":\"X\""));
+
+		// Both zones are written, the second one by stop()
+		const char *first = strstr(output.c_str(), "\"name\":\"test_zone\",\"ph\":\"X\"");
+		TS_ASSERT(first != nullptr);
+		if (first)
+			TS_ASSERT(strstr(first + 1, "\"name\":\"test_zone\",\"ph\":\"X\"") != nullptr);
+
+		// Events recorded after stop() are not written to the next trace
+		zone();
+		Common::String output2;
+		Common::Profiler::start(new StringWriteStream(output2));
+		Common::Profiler::stop();
+		TS_ASSERT(!output2.contains("test_zone"));
+	}
+};
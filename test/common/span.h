@@ -2,8 +2,14 @@
 
 class SpanTestSuite;
 
+#include "common/fs.h"
 #include "common/span.h"
 #include "common/str.h"
+#include "common/substream.h"
+
+#include "backends/fs/posix/posix-mmapstream.h"
+
+#include "../null_osystem.h"
 
 class SpanTestSuite : public CxxTest::TestSuite {
 	struct Foo {
@@ -627,6 +633,52 @@ public:
 		}
 	}
 
+	void test_mapped_span() {
+		const byte data[] = { 0, 1, 2, 3 };
+		Common::MemoryReadStream stream(data, sizeof(data));
+		Common::Span<const byte> span = Common::getMappedSpan(stream);
+		TS_ASSERT_EQUALS(span.data(), data);
+		TS_ASSERT_EQUALS(span.size(), sizeof(data));
+
+		// The span holds all of the data, wherever the stream is
+		TS_ASSERT_EQUALS(stream.readByte(), 0);
+		stream.seek(2);
+		span = Common::getMappedSpan(stream);
+		TS_ASSERT_EQUALS(span.data(), data);
+		TS_ASSERT_EQUALS(span.size(), sizeof(data));
+
+		// Streams which are not in memory have to be read
+		Common::SeekableSubReadStream subStream(&stream, 1, 3);
+		TS_ASSERT_EQUALS(Common::getMappedSpan(subStream).size(), 0U);
+
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(HAS_MMAP)
+		Common::install_null_g_system();
+		const Common::FSNode node(Common::Path("test/engine-data/encoding.dat"));
+
+		Common::SeekableReadStream *file = node.createReadStream();
+		TS_ASSERT(file);
+		TS_ASSERT_EQUALS(Common::getMappedSpan(*file).size(), 0U);
+		const uint32 size = file->size();
+		byte *contents = new byte[size];
+		TS_ASSERT_EQUALS(file->read(contents, size), size);
+		delete file;
+
+		// Files are only mapped into memory when it is enabled
+		PosixMmapStream::setEnabled(true);
+		file = node.createReadStream();
+		PosixMmapStream::setEnabled(false);
+		TS_ASSERT(file);
+		TS_ASSERT_EQUALS(file->readUint32LE(), READ_LE_UINT32(contents));
+		file->seek(size / 2);
+		Common::Span<const byte> mapped = Common::getMappedSpan(*file);
+		TS_ASSERT_EQUALS(mapped.size(), size);
+		TS_ASSERT_EQUALS(memcmp(mapped.data(), contents, size), 0);
+		delete file;
+
+		delete[] contents;
+#endif
+	}
+
 	void test_span_copying() {
 		const byte data[] = { 0, 1, 2, 3, 4, 5 };
 		Common::Span<const byte> span(data, sizeof(data));
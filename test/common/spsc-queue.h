@@ -0,0 +1,60 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/spsc-queue.h"
+
+class SPSCQueueTestSuite : public CxxTest::TestSuite {
+public:
+	void test_empty_full() {
+		Common::SPSCQueue<int, 4> queue;
+		TS_ASSERT(queue.empty());
+		TS_ASSERT(!queue.full());
+		TS_ASSERT_EQUALS(queue.capacity(), 4U);
+
+		for (int i = 0; i < 4; ++i)
+			TS_ASSERT(queue.push(i));
+
+		TS_ASSERT(queue.full());
+		TS_ASSERT(!queue.push(4));
+		TS_ASSERT_EQUALS(queue.size(), 4U);
+	}
+
+	void test_fifo_order() {
+		Common::SPSCQueue<int, 8> queue;
+		int val = -1;
+
+		TS_ASSERT(!queue.pop(val));
+		TS_ASSERT_EQUALS(val, -1);
+
+		queue.push(42);
+		queue.push(-23);
+		queue.push(7);
+
+		TS_ASSERT(queue.pop(val));
+		TS_ASSERT_EQUALS(val, 42);
+		TS_ASSERT(queue.pop(val));
+		TS_ASSERT_EQUALS(val, -23);
+		TS_ASSERT(queue.pop(val));
+		TS_ASSERT_EQUALS(val, 7);
+		TS_ASSERT(queue.empty());
+	}
+
+	void test_wrap_around() {
+		Common::SPSCQueue<int, 4> queue;
+		int val;
+
+		// Push and pop more elements than the capacity, so the indices wrap
+		// around the ring several times.
+		for (int i = 0; i < 50; ++i) {
+			TS_ASSERT(queue.push(i));
+			TS_ASSERT(queue.push(i + 1000));
+			TS_ASSERT_EQUALS(queue.size(), 2U);
+
+			TS_ASSERT(queue.pop(val));
+			TS_ASSERT_EQUALS(val, i);
+			TS_ASSERT(queue.pop(val));
+			TS_ASSERT_EQUALS(val, i + 1000);
+		}
+
+		TS_ASSERT(queue.empty());
+	}
+};
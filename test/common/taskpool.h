@@ -0,0 +1,162 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/taskpool.h"
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class TaskPoolTestSuite : public CxxTest::TestSuite
+{
+	struct Slot {
+		Common::TaskPool::Future future;
+		uint value;
+	};
+
+	static void incrementTask(void *data) {
+		((Slot *)data)->value++;
+	}
+
+	static void markRange(uint begin, uint end, void *data) {
+		uint *marks = (uint *)data;
+		for (uint i = begin; i < end; i++)
+			marks[i]++;
+	}
+
+	struct NestedTask {
+		Common::TaskPool *pool;
+		uint marks[100];
+	};
+
+	static void nestedTask(void *data) {
+		NestedTask *task = (NestedTask *)data;
+		task->pool->parallelFor(0, 100, 1, markRange, task->marks);
+	}
+
+	static void testPool(Common::TaskPool &pool) {
+		// More tasks than the queue holds, some of them run on this thread
+		const uint numSlots = Common::TaskPool::kMaxQueuedTasks * 2 + 10;
+		Slot *slots = new Slot[numSlots];
+		for (uint i = 0; i < numSlots; i++) {
+			slots[i].value = i;
+			pool.submit(slots[i].future, incrementTask, &slots[i]);
+		}
+		for (uint i = 0; i < numSlots; i++) {
+			slots[i].future.wait();
+			TS_ASSERT(slots[i].future.isDone());
+			TS_ASSERT_EQUALS(slots[i].value, i + 1);
+		}
+
+		// A future can be reused once its task is done
+		pool.submit(slots[0].future, incrementTask, &slots[0]);
+		slots[0].future.wait();
+		TS_ASSERT_EQUALS(slots[0].value, 2u);
+		delete[] slots;
+
+		const uint numMarks = 1000;
+		uint marks[numMarks] = { 0 };
+		pool.parallelFor(0, numMarks, 7, markRange, marks);
+		pool.parallelFor(10, 20, 100, markRange, marks);
+		pool.parallelFor(5, 5, 1, markRange, marks);
+		for (uint i = 0; i < numMarks; i++)
+			TS_ASSERT_EQUALS(marks[i], (i >= 10 && i < 20) ? 2u : 1u);
+
+		uint sums[numMarks] = { 0 };
+		pool.parallelFor(0, numMarks, 1, [&sums](uint begin, uint end) {
+			for (uint i = begin; i < end; i++)
+				sums[i] += i;
+		});
+		for (uint i = 0; i < numMarks; i++)
+			TS_ASSERT_EQUALS(sums[i], i);
+
+		// Tasks may use the pool themselves
+		NestedTask nested[4];
+		Common::TaskPool::Future futures[4];
+		for (uint i = 0; i < 4; i++) {
+			nested[i].pool = &pool;
+			for (uint j = 0; j < 100; j++)
+				nested[i].marks[j] = 0;
+			pool.submit(futures[i], nestedTask, &nested[i]);
+		}
+		for (uint i = 0; i < 4; i++) {
+			futures[i].wait();
+			for (uint j = 0; j < 100; j++)
+				TS_ASSERT_EQUALS(nested[i].marks[j], 1u);
+		}
+	}
+
+	public:
+	void test_synchronous() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		Common::TaskPool pool(0);
+		TS_ASSERT_EQUALS(pool.getWorkerCount(), 0u);
+
+		// Without workers, tasks are run before submit() returns
+		Slot slot;
+		slot.value = 0;
+		TS_ASSERT(slot.future.isDone());
+		pool.submit(slot.future, incrementTask, &slot);
+		TS_ASSERT(slot.future.isDone());
+		TS_ASSERT_EQUALS(slot.value, 1u);
+
+		testPool(pool);
+#endif
+	}
+
+	void test_workers() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		// On systems without threads, this is the same as above
+		Common::TaskPool pool(3);
+		testPool(pool);
+#endif
+	}
+
+	void test_dispatch_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		Common::TaskPool pool(3);
+		const uint rounds = 20000;
+		const uint batch = 64;
+
+		Slot *slots = new Slot[batch];
+		for (uint i = 0; i < batch; i++)
+			slots[i].value = 0;
+
+		uint32 start = g_system->getMillis();
+		for (uint r = 0; r < rounds / batch; r++) {
+			for (uint i = 0; i < batch; i++)
+				pool.submit(slots[i].future, incrementTask, &slots[i]);
+			for (uint i = 0; i < batch; i++)
+				slots[i].future.wait();
+		}
+		const uint32 submitTime = g_system->getMillis() - start;
+
+		uint total = 0;
+		for (uint i = 0; i < batch; i++)
+			total += slots[i].value;
+		TS_ASSERT_EQUALS(total, rounds / batch * batch);
+		delete[] slots;
+
+		uint marks[64] = { 0 };
+		start = g_system->getMillis();
+		for (uint r = 0; r < rounds; r++)
+			pool.parallelFor(0, 64, 1, markRange, marks);
+		const uint32 parallelForTime = g_system->getMillis() - start;
+		TS_ASSERT_EQUALS(marks[63], rounds);
+
+		debug("TaskPool with %u workers: %u tasks in %d ms, %u parallelFor calls in %d ms",
+		      pool.getWorkerCount(), rounds / batch * batch, submitTime, rounds, parallelForTime);
+#endif
+	}
+};
@@ -0,0 +1,128 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/advancedDetector.h"
+
+#include "common/fs.h"
+#include "common/stream.h"
+
+#include "../null_osystem.h"
+
+class AdvancedDetectorCacheTestSuite : public CxxTest::TestSuite
+{
+	static Common::Path getCacheFile() {
+		return Common::Path("test/detection.cache");
+	}
+
+	static void writeCacheFile(const Common::String &contents) {
+		Common::ScopedPtr<Common::SeekableWriteStream> stream(Common::FSNode(getCacheFile()).createWriteStream());
+		TS_ASSERT(stream);
+		stream->writeString(contents);
+		stream->finalize();
+	}
+
+	static Common::String readCacheFile() {
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::FSNode(getCacheFile()).createReadStream());
+		TS_ASSERT(stream);
+		Common::String contents;
+		while (!stream->eos())
+			contents += stream->readLine() + "\n";
+		return contents;
+	}
+
+	// Start over with the given contents of the cache file
+	static void resetCache(const Common::String &contents) {
+		writeCacheFile(contents);
+		ADCacheMan.setPersistentCacheFile(getCacheFile());
+	}
+
+	static FileProperties makeProperties(const char *md5, int64 size) {
+		FileProperties props;
+		props.md5 = md5;
+		props.size = size;
+		props.md5prop = kMD5Tail;
+		return props;
+	}
+
+	public:
+	void test_round_trip() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		resetCache("version 1\nstats 0 0 0 0\n");
+
+		ADCacheMan.setPersistentProperties("d:5000:game.dat", "1234:5678", makeProperties("0123456789abcdef0123456789abcdef", 1234));
+		ADCacheMan.savePersistentCache();
+
+		ADCacheMan.setPersistentCacheFile(getCacheFile());
+		FileProperties props;
+		TS_ASSERT(ADCacheMan.getPersistentProperties("d:5000:game.dat", "1234:5678", props));
+		TS_ASSERT_EQUALS(props.md5, "0123456789abcdef0123456789abcdef");
+		TS_ASSERT_EQUALS(props.size, 1234);
+		TS_ASSERT_EQUALS(props.md5prop, kMD5Tail);
+		TS_ASSERT(!ADCacheMan.getPersistentProperties("d:5000:other.dat", "1234:5678", props));
+
+		// Lookups alone do not rewrite the file
+		const Common::String contents = readCacheFile();
+		ADCacheMan.savePersistentCache();
+		TS_ASSERT_EQUALS(readCacheFile(), contents);
+
+		ADCacheMan.setPersistentCacheFile(Common::Path());
+#endif
+	}
+
+	void test_invalidation() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		resetCache("version 1\nstats 0 0 0 0\n");
+
+		ADCacheMan.setPersistentProperties("d:5000:size.dat", "1234:5678", makeProperties("0123456789abcdef0123456789abcdef", 1234));
+		ADCacheMan.setPersistentProperties("d:5000:time.dat", "1234:5678", makeProperties("fedcba9876543210fedcba9876543210", 1234));
+		ADCacheMan.savePersistentCache();
+		ADCacheMan.setPersistentCacheFile(getCacheFile());
+
+		// The signature holds the size and the modification time of the file
+		FileProperties props;
+		TS_ASSERT(!ADCacheMan.getPersistentProperties("d:5000:size.dat", "1235:5678", props));
+		TS_ASSERT(!ADCacheMan.getPersistentProperties("d:5000:time.dat", "1234:5679", props));
+		TS_ASSERT(!ADCacheMan.hasPersistentProperties("d:5000:size.dat", "1234:5678"));
+
+		const Common::String contents = readCacheFile();
+		ADCacheMan.savePersistentCache();
+		TS_ASSERT_DIFFERS(readCacheFile(), contents);
+
+		ADCacheMan.setPersistentCacheFile(getCacheFile());
+		TS_ASSERT(!ADCacheMan.hasPersistentProperties("d:5000:size.dat", "1234:5678"));
+		TS_ASSERT(!ADCacheMan.hasPersistentProperties("d:5000:time.dat", "1234:5678"));
+
+		ADCacheMan.setPersistentCacheFile(Common::Path());
+#endif
+	}
+
+	void test_expiry() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		resetCache("version 1\nstats 0 0 0 0\n");
+
+		// Find out the current day, as stored in the file
+		ADCacheMan.setPersistentProperties("d:5000:today.dat", "1:1", makeProperties("0123456789abcdef0123456789abcdef", 1));
+		ADCacheMan.savePersistentCache();
+		const Common::String contents = readCacheFile();
+		const uint32 today = strtoul(contents.c_str() + contents.find("\n", contents.find("stats")) + 1, nullptr, 10);
+		TS_ASSERT_LESS_THAN(90u, today);
+
+		// Entries are kept for 90 days after they were last used
+		resetCache(Common::String::format("version 1\nstats 0 0 0 0\n"
+			"%u\t1\t0\t0123456789abcdef0123456789abcdef\t1:1\td:5000:kept.dat\n"
+			"%u\t1\t0\t0123456789abcdef0123456789abcdef\t1:1\td:5000:expired.dat\n",
+			today - 90, today - 91));
+		TS_ASSERT(ADCacheMan.hasPersistentProperties("d:5000:kept.dat", "1:1"));
+		TS_ASSERT(ADCacheMan.hasPersistentProperties("d:5000:expired.dat", "1:1"));
+		ADCacheMan.savePersistentCache();
+
+		ADCacheMan.setPersistentCacheFile(getCacheFile());
+		TS_ASSERT(ADCacheMan.hasPersistentProperties("d:5000:kept.dat", "1:1"));
+		TS_ASSERT(!ADCacheMan.hasPersistentProperties("d:5000:expired.dat", "1:1"));
+
+		ADCacheMan.setPersistentCacheFile(Common::Path());
+#endif
+	}
+};
@@ -0,0 +1,116 @@
+#include <cxxtest/TestSuite.h>
+
+#include "engines/detectionScanner.h"
+
+#include "common/atomic.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/stream.h"
+
+#include "../null_osystem.h"
+
+class DetectionScannerTestSuite : public CxxTest::TestSuite
+{
+	// Records the files it was asked to detect games in
+	class TestDetector : public DetectionScanner::Detector {
+	public:
+		TestDetector(Common::StringArray &detected, uint32 &prefetched) : _detected(detected), _prefetched(prefetched) {}
+
+		void prefetch(const Common::FSList &files) override {
+			Common::atomicAdd(&_prefetched, 1);
+		}
+
+		DetectionResults detect(const Common::FSList &files) override {
+			Common::StringArray names;
+			for (const auto &file : files)
+				names.push_back(file.getName());
+			Common::sort(names.begin(), names.end());
+
+			Common::String line;
+			for (const auto &name : names)
+				line += name + " ";
+			_detected.push_back(line);
+
+			return DetectionResults(DetectedGames());
+		}
+
+	private:
+		Common::StringArray &_detected;
+		uint32 &_prefetched;
+	};
+
+	static Common::FSNode getRoot() {
+		return Common::FSNode(Common::Path("test/scanner"));
+	}
+
+	static void createTree() {
+		static const char *const dirs[] = { "", "a", "a/a1", "a/a2", "a/a2/deep", "b", "b/b1", "c" };
+		for (uint i = 0; i < ARRAYSIZE(dirs); i++) {
+			Common::FSNode dir(getRoot().getPath().join(dirs[i]));
+			if (!dir.exists())
+				dir.createDirectory();
+
+			Common::ScopedPtr<Common::SeekableWriteStream> stream(dir.getChild(Common::String::format("file%u.dat", i)).createWriteStream());
+			TS_ASSERT(stream);
+			stream->writeString(dirs[i]);
+			stream->finalize();
+		}
+	}
+
+	// Scan the tree, and return the directories and their files in the
+	// order they were reported
+	static Common::StringArray scan(int threads, uint32 &prefetched) {
+		ConfMan.setInt("detection_threads", threads, Common::ConfigManager::kTransientDomain);
+
+		Common::StringArray detected, result;
+		prefetched = 0;
+		DetectionScanner scanner(getRoot(), true, new TestDetector(detected, prefetched));
+		while (scanner.scanNextDirectory())
+			result.push_back(scanner.getDirectory().getPath().toString() + ": " + detected.back());
+
+		TS_ASSERT(scanner.isDone());
+		TS_ASSERT_EQUALS(scanner.getScannedCount(), scanner.getDirectoryCount());
+
+		ConfMan.removeKey("detection_threads", Common::ConfigManager::kTransientDomain);
+		return result;
+	}
+
+	public:
+	void test_parallel_scan() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		createTree();
+
+		uint32 prefetched;
+		const Common::StringArray serial = scan(0, prefetched);
+		TS_ASSERT_EQUALS(serial.size(), 8u);
+		TS_ASSERT_EQUALS(prefetched, 0u);
+
+		// The workers read the directories ahead, but the results come in
+		// the same order
+		for (int threads = 1; threads <= 4; threads++) {
+			const Common::StringArray parallel = scan(threads, prefetched);
+			TS_ASSERT_EQUALS(parallel.size(), serial.size());
+			for (uint i = 0; i < serial.size() && i < parallel.size(); i++)
+				TS_ASSERT_EQUALS(parallel[i], serial[i]);
+			TS_ASSERT_LESS_THAN(0u, prefetched);
+		}
+#endif
+	}
+
+	void test_debug_level() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		createTree();
+
+		// The debug output of the detection must not come from the workers
+		const int debugLevel = gDebugLevel;
+		gDebugLevel = 7;
+		uint32 prefetched;
+		TS_ASSERT_EQUALS(scan(4, prefetched).size(), 8u);
+		TS_ASSERT_EQUALS(prefetched, 0u);
+		gDebugLevel = debugLevel;
+#endif
+	}
+};
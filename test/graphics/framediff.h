@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/system.h"
+
+#include "graphics/framediff.h"
+
+#include "../null_osystem.h"
+
+class FrameDiffTestSuite : public CxxTest::TestSuite
+{
+	typedef Common::Array<Common::Rect> RectList;
+
+	static void setPixel(Graphics::Surface &surface, int x, int y, uint32 color) {
+		if (surface.format.bytesPerPixel == 1)
+			*(byte *)surface.getBasePtr(x, y) = color;
+		else if (surface.format.bytesPerPixel == 2)
+			*(uint16 *)surface.getBasePtr(x, y) = color;
+		else
+			*(uint32 *)surface.getBasePtr(x, y) = color;
+	}
+
+	static void testFormat(Graphics::FrameDiff::DiffRowProc diffRow, const Graphics::PixelFormat &format) {
+		// Not a multiple of the tile size, so the last tiles are smaller
+		Graphics::Surface frame;
+		frame.create(100, 70, format);
+
+		Graphics::FrameDiff diff;
+		diff._diffRow = diffRow;
+		diff.reset(frame.w, frame.h, format);
+		const Common::Rect all(frame.w, frame.h);
+
+		// Without a previous frame, all of it has changed
+		RectList rects;
+		diff.compare(frame, all, rects);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT(rects[0] == all);
+
+		rects.clear();
+		diff.compare(frame, all, rects);
+		TS_ASSERT(rects.empty());
+		TS_ASSERT_EQUALS(diff.getComparedTiles(), 7u * 5u);
+		TS_ASSERT_EQUALS(diff.getSkippedTiles(), 7u * 5u);
+
+		// A single pixel marks its tile, clipped to the frame
+		setPixel(frame, 99, 69, 1);
+		diff.compare(frame, all, rects);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT(rects[0] == Common::Rect(96, 64, 100, 70));
+
+		// Changes outside of the area are found later
+		rects.clear();
+		setPixel(frame, 0, 0, 1);
+		diff.compare(frame, Common::Rect(50, 50, 60, 60), rects);
+		TS_ASSERT(rects.empty());
+		diff.compare(frame, Common::Rect(1, 1), rects);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT(rects[0] == Common::Rect(16, 16));
+
+		// Runs of tiles are merged across rows when their columns match
+		rects.clear();
+		for (int y = 20; y < 60; y++) {
+			for (int x = 20; x < 40; x++)
+				setPixel(frame, x, y, 2);
+		}
+		setPixel(frame, 90, 40, 2);
+		diff.compare(frame, all, rects);
+		TS_ASSERT_EQUALS(rects.size(), 2u);
+		TS_ASSERT(rects[0] == Common::Rect(16, 16, 48, 64));
+		TS_ASSERT(rects[1] == Common::Rect(80, 32, 96, 48));
+
+		rects.clear();
+		diff.compare(frame, all, rects);
+		TS_ASSERT(rects.empty());
+
+		frame.free();
+	}
+
+	static void testDiffRow(Graphics::FrameDiff::DiffRowProc diffRow) {
+		testFormat(diffRow, Graphics::PixelFormat::createFormatCLUT8());
+		testFormat(diffRow, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
+		testFormat(diffRow, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+	}
+
+	public:
+	void test_compare() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		testDiffRow(Graphics::FrameDiff::diffRowGeneric);
+#ifdef SCUMMVM_NEON
+		testDiffRow(Graphics::FrameDiff::diffRowNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testDiffRow(Graphics::FrameDiff::diffRowSSE2);
+#endif
+#endif
+	}
+};
@@ -0,0 +1,266 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "graphics/blit.h"
+#include "graphics/managed_surface.h"
+#include "graphics/palette.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class KeyMaskBlitTestSuite : public CxxTest::TestSuite
+{
+	typedef Graphics::KeyMaskBlit::RowFuncs RowFuncs;
+
+	enum Mode {
+		kModeKey,
+		kModeMask,
+		kModeKeyMap,
+		kModeMaskMap
+	};
+
+	// Noise with runs of transparent and opaque pixels, so that all of
+	// the cases of the vectorized rows are taken
+	struct Images {
+		Images(uint w, uint h) : width(w), height(h), pitch(w * 4 + 12) {
+			src = new byte[pitch * h];
+			dst = new byte[pitch * h];
+			mask = new byte[pitch * h];
+			uint32 seed = 12345;
+			for (uint i = 0; i < pitch * h; i++) {
+				seed = seed * 1103515245 + 12345;
+				const uint run = (i / 37) % 3;
+				src[i] = run == 0 ? (byte)kKey : (byte)(seed >> 24);
+				dst[i] = seed >> 16;
+				mask[i] = run == 1 ? 0xFF : (run == 2 ? 0 : (seed >> 8) & 1);
+			}
+			for (uint i = 0; i < 256; i++)
+				map[i] = i * 0x01020305 + 0x11223344;
+		}
+
+		~Images() {
+			delete[] src;
+			delete[] dst;
+			delete[] mask;
+		}
+
+		enum {
+			kKey = 0x5A
+		};
+
+		uint width, height, pitch;
+		byte *src, *dst, *mask;
+		uint32 map[256];
+	};
+
+	static void setRowFuncs(const RowFuncs *rowFuncs) {
+		Graphics::KeyMaskBlit::rowFuncs = rowFuncs;
+		Graphics::KeyMaskBlit::rowFuncsSelected = true;
+	}
+
+	static uint32 getKey(uint bytesPerPixel) {
+		// Keys which repeat the byte, so that the runs of it are transparent
+		return bytesPerPixel == 1 ? 0x5A : bytesPerPixel == 2 ? 0x5A5A : 0x5A5A5A5A;
+	}
+
+	static void blit(Mode mode, byte *dst, const Images &images, uint w, uint h, uint bytesPerPixel) {
+		switch (mode) {
+		case kModeKey:
+			Graphics::keyBlit(dst, images.src, images.pitch, images.pitch, w, h, bytesPerPixel, getKey(bytesPerPixel));
+			break;
+		case kModeMask:
+			Graphics::maskBlit(dst, images.src, images.mask, images.pitch, images.pitch, images.pitch, w, h, bytesPerPixel);
+			break;
+		case kModeKeyMap:
+			Graphics::crossKeyBlitMap(dst, images.src, images.pitch, images.pitch, w, h, bytesPerPixel, images.map, Images::kKey);
+			break;
+		case kModeMaskMap:
+			Graphics::crossMaskBlitMap(dst, images.src, images.mask, images.pitch, images.pitch, images.pitch, w, h, bytesPerPixel, images.map);
+			break;
+		}
+	}
+
+	static void testRowFuncs(const RowFuncs *rowFuncs) {
+		const Mode modes[] = { kModeKey, kModeMask, kModeKeyMap, kModeMaskMap };
+		const uint bytesPerPixels[] = { 1, 2, 4 };
+
+		// Not a multiple of any vector size, so that the tails are blitted
+		Images images(83, 7);
+		const uint size = images.pitch * images.height;
+		byte *expected = new byte[size];
+		byte *actual = new byte[size];
+
+		for (uint m = 0; m < ARRAYSIZE(modes); m++) {
+			for (uint b = 0; b < ARRAYSIZE(bytesPerPixels); b++) {
+				memcpy(expected, images.dst, size);
+				memcpy(actual, images.dst, size);
+
+				setRowFuncs(nullptr);
+				blit(modes[m], expected, images, images.width, images.height, bytesPerPixels[b]);
+				setRowFuncs(rowFuncs);
+				blit(modes[m], actual, images, images.width, images.height, bytesPerPixels[b]);
+
+				TS_ASSERT_EQUALS(memcmp(expected, actual, size), 0);
+			}
+		}
+
+		// Converting a CLUT8 image in place
+		for (uint b = 0; b < ARRAYSIZE(bytesPerPixels); b++) {
+			memcpy(expected, images.src, size);
+			memcpy(actual, images.src, size);
+
+			setRowFuncs(nullptr);
+			Graphics::crossKeyBlitMap(expected, expected, images.pitch, images.pitch / bytesPerPixels[b], images.width, images.height,
+			                          bytesPerPixels[b], images.map, Images::kKey);
+			setRowFuncs(rowFuncs);
+			Graphics::crossKeyBlitMap(actual, actual, images.pitch, images.pitch / bytesPerPixels[b], images.width, images.height,
+			                          bytesPerPixels[b], images.map, Images::kKey);
+
+			TS_ASSERT_EQUALS(memcmp(expected, actual, size), 0);
+		}
+
+		delete[] expected;
+		delete[] actual;
+		setRowFuncs(nullptr);
+		Graphics::KeyMaskBlit::rowFuncsSelected = false;
+	}
+
+	static void testTransBlitFrom(const RowFuncs *rowFuncs) {
+		// The flipped blit of a mirrored sprite is drawn pixel by pixel,
+		// and has to match the unflipped one, which uses the key blitters
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat::createFormatCLUT8(),
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0)
+		};
+		const uint32 transColors[] = { 3, 0xF81F, 0xFFFFFF };
+
+		setRowFuncs(rowFuncs);
+
+		Graphics::Palette palette(256);
+		for (uint i = 0; i < 256; i++)
+			palette.set(i, i, 255 - i, i * 7);
+
+		for (uint s = 0; s < ARRAYSIZE(formats); s++) {
+			Graphics::ManagedSurface sprite(37, 9, formats[s]), mirrored(37, 9, formats[s]);
+			for (int y = 0; y < sprite.h; y++) {
+				for (int x = 0; x < sprite.w; x++) {
+					const uint32 color = (x + y) % 5 == 0 ? transColors[s] : (x * 13 + y * 31) & 0xFF;
+					sprite.setPixel(x, y, color);
+					mirrored.setPixel(sprite.w - x - 1, y, color);
+				}
+			}
+
+			for (uint d = 0; d < ARRAYSIZE(formats); d++) {
+				// True color sprites are only drawn on screens of their format
+				if (s != 0 && d != s)
+					continue;
+
+				Graphics::ManagedSurface expected(50, 20, formats[d]), actual(50, 20, formats[d]);
+				expected.clear(1);
+				actual.clear(1);
+
+				// Partly off the screen, to check the clipping
+				const Common::Point pos(-5, 14);
+				expected.transBlitFrom(*mirrored.surfacePtr(), Common::Rect(mirrored.w, mirrored.h), pos,
+				                       transColors[s], true, 0xff, &palette);
+				actual.transBlitFrom(*sprite.surfacePtr(), Common::Rect(sprite.w, sprite.h), pos,
+				                     transColors[s], false, 0xff, &palette);
+
+				for (int y = 0; y < expected.h; y++)
+					TS_ASSERT_EQUALS(memcmp(expected.getBasePtr(0, y), actual.getBasePtr(0, y),
+					                        expected.w * expected.format.bytesPerPixel), 0);
+			}
+		}
+
+		setRowFuncs(nullptr);
+		Graphics::KeyMaskBlit::rowFuncsSelected = false;
+	}
+
+	static void testSpeed(const RowFuncs *rowFuncs, const char *name) {
+		Images images(640, 480);
+		byte *dst = new byte[images.pitch * images.height];
+		memcpy(dst, images.dst, images.pitch * images.height);
+
+		setRowFuncs(rowFuncs);
+		const uint frames = 100;
+		const uint32 start = g_system->getMillis();
+		for (uint frame = 0; frame < frames; frame++) {
+			blit(kModeKey, dst, images, images.width, images.height, 2);
+			blit(kModeKeyMap, dst, images, images.width, images.height, 4);
+		}
+		const uint32 time = g_system->getMillis() - start;
+
+		debug("Color keyed sprites of %dx%d with %s: %u frames in %d ms",
+		      images.width, images.height, name, frames, time);
+
+		delete[] dst;
+		setRowFuncs(nullptr);
+		Graphics::KeyMaskBlit::rowFuncsSelected = false;
+	}
+
+	public:
+	void test_row_funcs() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+#ifdef SCUMMVM_NEON
+		testRowFuncs(&Graphics::KeyMaskBlit::rowFuncsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testRowFuncs(&Graphics::KeyMaskBlit::rowFuncsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testRowFuncs(&Graphics::KeyMaskBlit::rowFuncsAVX2);
+#endif
+#endif
+	}
+
+	void test_trans_blit_from() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		testTransBlitFrom(nullptr);
+#ifdef SCUMMVM_NEON
+		testTransBlitFrom(&Graphics::KeyMaskBlit::rowFuncsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testTransBlitFrom(&Graphics::KeyMaskBlit::rowFuncsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testTransBlitFrom(&Graphics::KeyMaskBlit::rowFuncsAVX2);
+#endif
+#endif
+	}
+
+	void test_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		testSpeed(nullptr, "scalar");
+#ifdef SCUMMVM_NEON
+		testSpeed(&Graphics::KeyMaskBlit::rowFuncsNEON, "NEON");
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testSpeed(&Graphics::KeyMaskBlit::rowFuncsSSE2, "SSE2");
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testSpeed(&Graphics::KeyMaskBlit::rowFuncsAVX2, "AVX2");
+#endif
+#endif
+	}
+};
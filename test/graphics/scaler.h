@@ -0,0 +1,290 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/debug.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/taskpool.h"
+
+#include "graphics/scalerplugin.h"
+#include "graphics/scaler/normal.h"
+#ifdef USE_SCALERS
+#include "graphics/scaler/dotmatrix.h"
+#include "graphics/scaler/pm.h"
+#include "graphics/scaler/sai.h"
+#include "graphics/scaler/scalebit.h"
+#include "graphics/scaler/tv.h"
+#ifdef USE_HQ_SCALERS
+#include "graphics/scaler/hq.h"
+#endif
+#endif
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+	// More than any scaler reads outside of the scaled rect
+	static const int kPadding = 4;
+
+	struct TestImage {
+		TestImage(const Graphics::PixelFormat &format, int w, int h) :
+			width(w), height(h), bpp(format.bytesPerPixel),
+			pitch((w + kPadding * 2) * bpp), pixels(new byte[pitch * (h + kPadding * 2)]) {
+			// Runs of the same color, so that the scalers find edges to blend
+			uint32 seed = 12345;
+			for (uint i = 0; i < pitch * (h + kPadding * 2); i++) {
+				if (i % 3 == 0)
+					seed = seed * 1103515245 + 12345;
+				pixels[i] = (byte)(seed >> 24);
+			}
+		}
+		~TestImage() { delete[] pixels; }
+
+		const byte *getBasePtr(int x, int y) const {
+			return pixels + (y + kPadding) * pitch + (x + kPadding) * bpp;
+		}
+
+		int width, height;
+		uint bpp, pitch;
+		byte *pixels;
+	};
+
+	static void compareBands(Scaler &scaler, const Graphics::PixelFormat &format, uint extraPixels) {
+		const uint factor = scaler.getFactor();
+		Common::TaskPool pool(3);
+		TestImage src(format, 320, 200);
+		const uint dstPitch = src.width * factor * src.bpp;
+		const uint dstSize = dstPitch * src.height * factor;
+		byte *expected = new byte[dstSize]();
+		byte *actual = new byte[dstSize]();
+
+		// The whole image, and a rect at an odd position
+		scaler.scale(src.getBasePtr(0, 0), src.pitch, expected, dstPitch, src.width, src.height, 0, 0);
+		scaler.scaleInBands(pool, extraPixels, src.getBasePtr(0, 0), src.pitch, actual, dstPitch, src.width, src.height, 0, 0);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, dstSize), 0);
+
+		const uint offset = 33 * factor * dstPitch + 17 * factor * src.bpp;
+		scaler.scale(src.getBasePtr(17, 33), src.pitch, expected + offset, dstPitch, 200, 150, 17, 33);
+		scaler.scaleInBands(pool, extraPixels, src.getBasePtr(17, 33), src.pitch, actual + offset, dstPitch, 200, 150, 17, 33);
+		TS_ASSERT_EQUALS(memcmp(expected, actual, dstSize), 0);
+
+		delete[] expected;
+		delete[] actual;
+	}
+
+	// Compare the bands for all factors of the scaler
+	static void compareAllFactors(Scaler *scaler, const Graphics::PixelFormat &format, uint extraPixels) {
+		uint factor = scaler->getFactor();
+		while (scaler->decreaseFactor() != factor)
+			factor = scaler->getFactor();
+
+		do {
+			factor = scaler->getFactor();
+			compareBands(*scaler, format, extraPixels);
+		} while (scaler->increaseFactor() != factor);
+		delete scaler;
+	}
+
+#ifdef USE_HQ_SCALERS
+	// An image with smooth gradients, noise and flat areas, so that all
+	// kinds of neighbour patterns are found
+	static void fillHQTestImage(const Graphics::PixelFormat &format, byte *pixels, uint pitch, int w, int h) {
+		uint32 seed = 1;
+		for (int y = -kPadding; y < h + kPadding; y++) {
+			for (int x = -kPadding; x < w + kPadding; x++) {
+				seed = seed * 1103515245 + 12345;
+				const uint noise = seed >> 24;
+				byte r, g, b;
+				if (((x + 64) / 8 + (y + 64) / 8) % 3 == 0) {
+					r = noise;
+					g = noise * 3;
+					b = noise * 7;
+				} else {
+					r = (x + kPadding) * 4 + (noise & 7);
+					g = (y + kPadding) * 4 + (noise >> 5);
+					b = ((x ^ y) & 0x3f) * 4;
+				}
+
+				byte *ptr = pixels + (y + kPadding) * pitch + (x + kPadding) * format.bytesPerPixel;
+				if (format.bytesPerPixel == 2)
+					*(uint16 *)ptr = format.RGBToColor(r, g, b);
+				else
+					*(uint32 *)ptr = format.RGBToColor(r, g, b);
+			}
+		}
+	}
+
+	static void testHQGolden(HQScaler::PatternProc patternProc) {
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0)
+		};
+		// The output of HQ2x and HQ3x before the neighbour patterns were
+		// computed in rows
+		const char *const md5s[][2] = {
+			{ "7d146413e5aa53ce2e7e0d51596aa5c2", "1f7d2c464104d66470d828e93846ac3b" },
+			{ "ddb5b216552779a047403c1f49a1714e", "7739fc8f980f0b9e24a20d0dfa5db210" },
+			{ "7c546ae722a257f3d4b4f286868fcb1c", "5ea1a03da9e7c5f3edfbff62c4d1ba0c" },
+			{ "353e430da6d46d5e59bb3abbbd7121c2", "2bdae087f1cf010127889f3eca36d01c" }
+		};
+
+		const int w = 64, h = 48;
+		for (uint i = 0; i < ARRAYSIZE(formats); i++) {
+			const Graphics::PixelFormat &format = formats[i];
+			const uint bpp = format.bytesPerPixel;
+			const uint pitch = (w + kPadding * 2) * bpp;
+			byte *pixels = new byte[pitch * (h + kPadding * 2)];
+			fillHQTestImage(format, pixels, pitch, w, h);
+
+			HQScaler scaler(format);
+			scaler._patternProc = patternProc;
+			for (uint factor = 2; factor <= 3; factor++) {
+				scaler.setFactor(factor);
+				const uint dstPitch = w * factor * bpp;
+				const uint dstSize = dstPitch * h * factor;
+				byte *dst = new byte[dstSize];
+				scaler.scale(pixels + kPadding * pitch + kPadding * bpp, pitch, dst, dstPitch, w, h, 0, 0);
+
+				Common::MemoryReadStream stream(dst, dstSize);
+				TS_ASSERT_EQUALS(Common::computeStreamMD5AsString(stream), md5s[i][factor - 2]);
+				delete[] dst;
+			}
+
+			delete[] pixels;
+		}
+	}
+
+	static void testHQSpeed(HQScaler::PatternProc patternProc, const char *name) {
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		TestImage src(format, 640, 480);
+		byte *dst = new byte[src.width * 3 * src.bpp * src.height * 3];
+
+		HQScaler scaler(format);
+		scaler._patternProc = patternProc;
+		const uint frames = 10;
+		for (uint factor = 2; factor <= 3; factor++) {
+			scaler.setFactor(factor);
+			const uint dstPitch = src.width * factor * src.bpp;
+
+			const uint32 start = g_system->getMillis();
+			for (uint frame = 0; frame < frames; frame++)
+				scaler.scale(src.getBasePtr(0, 0), src.pitch, dst, dstPitch, src.width, src.height, 0, 0);
+			const uint32 time = g_system->getMillis() - start;
+
+			debug("HQ%ux of %dx%d with %s patterns: %u frames in %d ms",
+			      factor, src.width, src.height, name, frames, time);
+		}
+
+		delete[] dst;
+	}
+#endif
+
+	public:
+	void test_bands_match() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+		};
+
+		for (uint i = 0; i < ARRAYSIZE(formats); i++) {
+			const Graphics::PixelFormat &format = formats[i];
+			compareAllFactors(new NormalScaler(format), format, 0);
+#ifdef USE_SCALERS
+			compareAllFactors(new AdvMameScaler(format), format, 4);
+			compareAllFactors(new SAIScaler(format), format, 2);
+			compareAllFactors(new SuperSAIScaler(format), format, 2);
+			compareAllFactors(new SuperEagleScaler(format), format, 2);
+			compareAllFactors(new PMScaler(format), format, 1);
+			compareAllFactors(new TVScaler(format), format, 0);
+			compareAllFactors(new DotMatrixScaler(format), format, 0);
+#ifdef USE_HQ_SCALERS
+			HQScaler *hq = new HQScaler(format);
+			hq->_patternProc = HQScaler::patternsGeneric;
+			compareAllFactors(hq, format, 1);
+#endif
+#endif
+		}
+#endif
+	}
+
+	void test_bands_speed() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(USE_HQ_SCALERS)
+		Common::install_null_g_system();
+
+		const Graphics::PixelFormat format(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		HQScaler scaler(format);
+		scaler._patternProc = HQScaler::patternsGeneric;
+		scaler.setFactor(3);
+
+		TestImage src(format, 640, 480);
+		const uint dstPitch = src.width * 3 * src.bpp;
+		byte *dst = new byte[dstPitch * src.height * 3];
+
+		const uint threads[] = { 1, 2, 4, MAX<uint>(g_system->getCPUCount(), 1) };
+		const uint frames = 10;
+		for (uint i = 0; i < ARRAYSIZE(threads); i++) {
+			Common::TaskPool pool(threads[i] - 1);
+
+			const uint32 start = g_system->getMillis();
+			for (uint frame = 0; frame < frames; frame++)
+				scaler.scaleInBands(pool, 1, src.getBasePtr(0, 0), src.pitch, dst, dstPitch, src.width, src.height, 0, 0);
+			const uint32 time = g_system->getMillis() - start;
+
+			debug("HQ3x of %dx%d with %u threads: %u frames in %d ms",
+			      src.width, src.height, pool.getWorkerCount() + 1, frames, time);
+		}
+
+		delete[] dst;
+#endif
+	}
+
+	void test_hq_golden() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(USE_HQ_SCALERS)
+		Common::install_null_g_system();
+
+		testHQGolden(HQScaler::patternsGeneric);
+#ifdef SCUMMVM_NEON
+		testHQGolden(HQScaler::patternsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testHQGolden(HQScaler::patternsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testHQGolden(HQScaler::patternsAVX2);
+#endif
+#endif
+	}
+
+	void test_hq_speed() {
+#if BENCHMARK_TIME && defined(USE_HQ_SCALERS)
+		Common::install_null_g_system();
+
+		testHQSpeed(HQScaler::patternsGeneric, "generic");
+#ifdef SCUMMVM_NEON
+		testHQSpeed(HQScaler::patternsNEON, "NEON");
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testHQSpeed(HQScaler::patternsSSE2, "SSE2");
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testHQSpeed(HQScaler::patternsAVX2, "AVX2");
+#endif
+#endif
+	}
+};
@@ -0,0 +1,370 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/debug.h"
+#include "common/system.h"
+#include "common/taskpool.h"
+
+#ifdef USE_TINYGL
+#include "graphics/tinygl/tinygl.h"
+#include "graphics/tinygl/zgl.h"
+#endif
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class TinyGLTestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_TINYGL
+	struct Scene {
+		uint32 seed;
+		TGLuint texture, bilinearTexture, rgbTexture;
+		TinyGL::BlitImage *image;
+
+		float nextFloat() {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 8) / 16777216.0f;
+		}
+
+		void vertex(float size) {
+			tglColor4f(nextFloat(), nextFloat(), nextFloat(), 0.5f + nextFloat() / 2);
+			tglTexCoord2f(nextFloat() * 3 - 1, nextFloat() * 3 - 1);
+			tglVertex3f((nextFloat() - 0.5f) * size, (nextFloat() - 0.5f) * size, (nextFloat() - 0.5f) * size);
+		}
+
+		void create() {
+			byte texels[64 * 64 * 4];
+			for (uint i = 0; i < sizeof(texels); i++)
+				texels[i] = (byte)(i * 7 + i / 256);
+			tglGenTextures(1, &texture);
+			tglBindTexture(TGL_TEXTURE_2D, texture);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MIN_FILTER, TGL_NEAREST);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MAG_FILTER, TGL_NEAREST);
+			tglTexImage2D(TGL_TEXTURE_2D, 0, TGL_RGBA, 64, 64, 0, TGL_RGBA, TGL_UNSIGNED_BYTE, texels);
+
+			// A filtered texture which isn't square, and a texture which the
+			// span procs leave to putPixelTexture()
+			tglGenTextures(1, &bilinearTexture);
+			tglBindTexture(TGL_TEXTURE_2D, bilinearTexture);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MIN_FILTER, TGL_LINEAR);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MAG_FILTER, TGL_LINEAR);
+			tglTexImage2D(TGL_TEXTURE_2D, 0, TGL_RGBA, 40, 24, 0, TGL_RGBA, TGL_UNSIGNED_BYTE, texels);
+			tglGenTextures(1, &rgbTexture);
+			tglBindTexture(TGL_TEXTURE_2D, rgbTexture);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MIN_FILTER, TGL_NEAREST);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_MAG_FILTER, TGL_NEAREST);
+			tglTexImage2D(TGL_TEXTURE_2D, 0, TGL_RGB, 32, 32, 0, TGL_RGB, TGL_UNSIGNED_BYTE, texels);
+
+			Graphics::Surface surface;
+			surface.create(48, 48, TinyGL::gl_get_context()->fb->getPixelFormat());
+			for (int y = 0; y < surface.h; y++)
+				for (int x = 0; x < surface.w; x++)
+					surface.setPixel(x, y, surface.format.RGBToColor(x * 5, y * 5, (x ^ y) * 5));
+			image = tglGenBlitImage();
+			tglUploadBlitImage(image, surface, 0, false);
+			surface.free();
+		}
+
+		void destroy() {
+			tglDeleteBlitImage(image);
+			tglDeleteTextures(1, &texture);
+			tglDeleteTextures(1, &bilinearTexture);
+			tglDeleteTextures(1, &rgbTexture);
+		}
+
+		// Exercises the fill modes, clipping at the screen edges and the near
+		// plane, the texture filters and wrap modes, blending, the scissor
+		// test, lines, points and blits
+		void draw(int frame, int triangles) {
+			seed = 1;
+			tglClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+			tglClear(TGL_COLOR_BUFFER_BIT | TGL_DEPTH_BUFFER_BIT);
+
+			tglMatrixMode(TGL_PROJECTION);
+			tglLoadIdentity();
+			tglFrustum(-1, 1, -0.75, 0.75, 1, 100);
+			tglMatrixMode(TGL_MODELVIEW);
+			tglLoadIdentity();
+			tglTranslatef(0, 0, -4);
+			tglRotatef(frame * 7.0f, 0.3f, 1, 0.2f);
+
+			tglEnable(TGL_DEPTH_TEST);
+			tglShadeModel(TGL_SMOOTH);
+			tglBegin(TGL_TRIANGLES);
+			for (int i = 0; i < triangles * 3; i++)
+				vertex(8);
+			tglEnd();
+
+			tglDepthFunc(TGL_GEQUAL);
+			tglColorMask(TGL_FALSE, TGL_FALSE, TGL_FALSE, TGL_FALSE);
+			tglBegin(TGL_TRIANGLES);
+			for (int i = 0; i < 8 * 3; i++)
+				vertex(6);
+			tglEnd();
+			tglColorMask(TGL_TRUE, TGL_TRUE, TGL_TRUE, TGL_TRUE);
+			tglBegin(TGL_TRIANGLES);
+			for (int i = 0; i < 8 * 3; i++)
+				vertex(6);
+			tglEnd();
+			tglDepthFunc(TGL_LESS);
+
+			tglEnable(TGL_TEXTURE_2D);
+			tglBindTexture(TGL_TEXTURE_2D, texture);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 16 * 4; i++)
+				vertex(6);
+			tglEnd();
+			tglBindTexture(TGL_TEXTURE_2D, bilinearTexture);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 8 * 4; i++)
+				vertex(6);
+			tglEnd();
+			tglBindTexture(TGL_TEXTURE_2D, rgbTexture);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 4 * 4; i++)
+				vertex(6);
+			tglEnd();
+
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_S, TGL_CLAMP_TO_EDGE);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_T, TGL_MIRRORED_REPEAT);
+			tglBindTexture(TGL_TEXTURE_2D, texture);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 8 * 4; i++)
+				vertex(6);
+			tglEnd();
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_S, TGL_MIRRORED_REPEAT);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_T, TGL_CLAMP_TO_EDGE);
+			tglBindTexture(TGL_TEXTURE_2D, bilinearTexture);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 8 * 4; i++)
+				vertex(6);
+			tglEnd();
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_S, TGL_REPEAT);
+			tglTexParameteri(TGL_TEXTURE_2D, TGL_TEXTURE_WRAP_T, TGL_REPEAT);
+			tglDisable(TGL_TEXTURE_2D);
+
+			tglBlit(image, TinyGL::BlitTransform(40 + frame * 3, 30));
+
+			tglEnable(TGL_BLEND);
+			tglBlendFunc(TGL_SRC_ALPHA, TGL_ONE_MINUS_SRC_ALPHA);
+			tglShadeModel(TGL_FLAT);
+			tglBegin(TGL_TRIANGLE_FAN);
+			for (int i = 0; i < 12; i++)
+				vertex(4);
+			tglEnd();
+			tglEnable(TGL_TEXTURE_2D);
+			tglBegin(TGL_TRIANGLE_FAN);
+			for (int i = 0; i < 12; i++)
+				vertex(4);
+			tglEnd();
+			tglShadeModel(TGL_SMOOTH);
+			tglBindTexture(TGL_TEXTURE_2D, texture);
+			tglBegin(TGL_TRIANGLE_FAN);
+			for (int i = 0; i < 12; i++)
+				vertex(4);
+			tglEnd();
+			tglDisable(TGL_TEXTURE_2D);
+			tglDisable(TGL_BLEND);
+
+			tglEnable(TGL_SCISSOR_TEST);
+			tglScissor(50, 40, 200, 100);
+			tglBegin(TGL_TRIANGLE_STRIP);
+			for (int i = 0; i < 12; i++)
+				vertex(4);
+			tglEnd();
+			tglEnable(TGL_TEXTURE_2D);
+			tglBindTexture(TGL_TEXTURE_2D, bilinearTexture);
+			tglBegin(TGL_TRIANGLE_STRIP);
+			for (int i = 0; i < 12; i++)
+				vertex(4);
+			tglEnd();
+			tglDisable(TGL_TEXTURE_2D);
+			tglDisable(TGL_SCISSOR_TEST);
+
+			tglPolygonMode(TGL_FRONT_AND_BACK, TGL_LINE);
+			tglBegin(TGL_QUADS);
+			for (int i = 0; i < 8 * 4; i++)
+				vertex(6);
+			tglEnd();
+			tglPolygonMode(TGL_FRONT_AND_BACK, TGL_FILL);
+
+			tglBegin(TGL_LINES);
+			for (int i = 0; i < 32; i++)
+				vertex(8);
+			tglEnd();
+			tglBegin(TGL_POINTS);
+			for (int i = 0; i < 32; i++)
+				vertex(4);
+			tglEnd();
+		}
+	};
+
+	static void setSpanProcs(TinyGL::FrameBuffer::SpanProc fillSpan, TinyGL::FrameBuffer::SpanProc fillDepthSpan,
+	                         TinyGL::FrameBuffer::TextureSpanProc fillTextureSpan) {
+		TinyGL::FrameBuffer::_fillSpan = fillSpan;
+		TinyGL::FrameBuffer::_fillDepthSpan = fillDepthSpan;
+		TinyGL::FrameBuffer::_fillTextureSpan = fillTextureSpan;
+		TinyGL::FrameBuffer::_spanProcsSelected = true;
+	}
+
+	// The test OSystem can't tell the CPU features, so this replaces
+	// FrameBuffer::selectSpanProcs()
+	static void selectSpanProcs() {
+		setSpanProcs(nullptr, nullptr, nullptr);
+#ifdef SCUMMVM_NEON
+		setSpanProcs(TinyGL::FrameBuffer::fillSpanNEON, TinyGL::FrameBuffer::fillDepthSpanNEON, TinyGL::FrameBuffer::fillTextureSpanNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			setSpanProcs(TinyGL::FrameBuffer::fillSpanSSE2, TinyGL::FrameBuffer::fillDepthSpanSSE2, TinyGL::FrameBuffer::fillTextureSpanSSE2);
+#endif
+	}
+
+	static void testSpanProcs(TinyGL::FrameBuffer::SpanProc fillSpan, TinyGL::FrameBuffer::SpanProc fillDepthSpan,
+	                          TinyGL::FrameBuffer::TextureSpanProc fillTextureSpan) {
+		const int kFrames = 3;
+
+		for (int dirtyRects = 0; dirtyRects < 2; dirtyRects++) {
+			// The depth buffers are compared as well, since the depth only
+			// triangles aren't all visible in the frames
+			Graphics::Surface expected[kFrames * 2], actual[kFrames * 2];
+			setSpanProcs(nullptr, nullptr, nullptr);
+			drawFrames(nullptr, dirtyRects, expected, kFrames, expected + kFrames);
+			setSpanProcs(fillSpan, fillDepthSpan, fillTextureSpan);
+			drawFrames(nullptr, dirtyRects, actual, kFrames, actual + kFrames);
+
+			for (int frame = 0; frame < kFrames * 2; frame++) {
+				for (int y = 0; y < expected[frame].h; y++)
+					TS_ASSERT_SAME_DATA(expected[frame].getBasePtr(0, y), actual[frame].getBasePtr(0, y), expected[frame].w * 4);
+				expected[frame].free();
+				actual[frame].free();
+			}
+		}
+	}
+
+	// Draw a few frames of the scene, and return a copy of each
+	static void drawFrames(Common::TaskPool *pool, bool dirtyRects, Graphics::Surface *frames, int numFrames, Graphics::Surface *depths = nullptr) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		TinyGL::ContextHandle *context = TinyGL::createContext(320, 240, format, 256, true, dirtyRects);
+		TinyGL::GLContext *c = TinyGL::gl_get_context();
+		delete c->_tileRenderer;
+		c->_tileRenderer = pool ? new TinyGL::TileRenderer(c, pool) : nullptr;
+
+		Scene scene;
+		scene.create();
+		for (int frame = 0; frame < numFrames; frame++) {
+			scene.draw(frame, 200);
+			TinyGL::presentBuffer();
+
+			Graphics::Surface surface;
+			TinyGL::getSurfaceRef(surface);
+			frames[frame].copyFrom(surface);
+			if (depths) {
+				depths[frame].create(surface.w, surface.h, format);
+				memcpy(depths[frame].getPixels(), c->fb->getZBuffer(), surface.w * surface.h * 4);
+			}
+		}
+		scene.destroy();
+		TinyGL::destroyContext(context);
+	}
+#endif
+
+public:
+	void test_tiles_match() {
+#ifdef USE_TINYGL
+		const int kFrames = 3;
+		Common::TaskPool pool(3);
+		selectSpanProcs();
+
+		for (int dirtyRects = 0; dirtyRects < 2; dirtyRects++) {
+			Graphics::Surface expected[kFrames], actual[kFrames];
+			drawFrames(nullptr, dirtyRects, expected, kFrames);
+			drawFrames(&pool, dirtyRects, actual, kFrames);
+
+			for (int frame = 0; frame < kFrames; frame++) {
+				for (int y = 0; y < expected[frame].h; y++)
+					TS_ASSERT_SAME_DATA(expected[frame].getBasePtr(0, y), actual[frame].getBasePtr(0, y), expected[frame].w * 4);
+				expected[frame].free();
+				actual[frame].free();
+			}
+		}
+#endif
+	}
+
+	void test_tiles_speed() {
+#if defined(USE_TINYGL) && BENCHMARK_TIME
+		// Many large overlapping triangles, as in a fill-rate bound game
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		const int frames = 20;
+		const uint threads[] = { 1, 2, 4, MAX<uint>(g_system->getCPUCount(), 1) };
+		selectSpanProcs();
+
+		for (uint i = 0; i < ARRAYSIZE(threads); i++) {
+			Common::TaskPool pool(threads[i] - 1);
+			TinyGL::ContextHandle *context = TinyGL::createContext(640, 480, format, 256, true, false);
+			TinyGL::GLContext *c = TinyGL::gl_get_context();
+			delete c->_tileRenderer;
+			c->_tileRenderer = threads[i] > 1 ? new TinyGL::TileRenderer(c, &pool) : nullptr;
+
+			Scene scene;
+			scene.create();
+			const uint32 start = g_system->getMillis();
+			for (int frame = 0; frame < frames; frame++) {
+				scene.draw(frame, 1000);
+				TinyGL::presentBuffer();
+			}
+			const uint32 time = g_system->getMillis() - start;
+			scene.destroy();
+			TinyGL::destroyContext(context);
+
+			debug("TinyGL 640x480, %u threads: %u ms for %d frames", threads[i], time, frames);
+		}
+#endif
+	}
+
+	void test_spans_match() {
+#ifdef USE_TINYGL
+#ifdef SCUMMVM_NEON
+		testSpanProcs(TinyGL::FrameBuffer::fillSpanNEON, TinyGL::FrameBuffer::fillDepthSpanNEON, TinyGL::FrameBuffer::fillTextureSpanNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testSpanProcs(TinyGL::FrameBuffer::fillSpanSSE2, TinyGL::FrameBuffer::fillDepthSpanSSE2, TinyGL::FrameBuffer::fillTextureSpanSSE2);
+#endif
+#endif
+	}
+
+	void test_spans_speed() {
+#if defined(USE_TINYGL) && BENCHMARK_TIME
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		const int frames = 20;
+		const int triangles = 1000;
+
+		for (int simd = 0; simd < 2; simd++) {
+			if (simd)
+				selectSpanProcs();
+			else
+				setSpanProcs(nullptr, nullptr, nullptr);
+
+			TinyGL::ContextHandle *context = TinyGL::createContext(640, 480, format, 256, true, false);
+			Scene scene;
+			scene.create();
+			const uint32 start = g_system->getMillis();
+			for (int frame = 0; frame < frames; frame++) {
+				scene.draw(frame, triangles);
+				TinyGL::presentBuffer();
+			}
+			const uint32 time = MAX<uint32>(g_system->getMillis() - start, 1);
+			scene.destroy();
+			TinyGL::destroyContext(context);
+
+			debug("TinyGL 640x480, %s spans: %u ms for %d frames, %u triangles/s", simd ? "SIMD" : "scalar", time, frames, frames * triangles * 1000 / time);
+		}
+#endif
+	}
+};
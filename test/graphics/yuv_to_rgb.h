@@ -0,0 +1,225 @@
+#include <cxxtest/TestSuite.h>
+#include "test/instrset_detect.h"
+
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "graphics/yuv_to_rgb.h"
+
+#include "../null_osystem.h"
+
+#if NULL_OSYSTEM_IS_AVAILABLE
+#define BENCHMARK_TIME 1
+#else
+#define BENCHMARK_TIME 0
+#endif
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+	typedef Graphics::YUVToRGBManager::ConvertRowProc ConvertRowProc;
+
+	enum Layout {
+		kLayout444,
+		kLayout422,
+		kLayout420,
+		kLayout420Alpha
+	};
+
+	struct Planes {
+		Planes(int w, int h) : width(w), height(h), yPitch(w + 3), uvPitch(w + 5) {
+			// Noise, so that the chroma values clip the channels as well
+			y = new byte[yPitch * h];
+			u = new byte[uvPitch * h];
+			v = new byte[uvPitch * h];
+			a = new byte[yPitch * h];
+			uint32 seed = 12345;
+			for (int i = 0; i < yPitch * h; i++) {
+				seed = seed * 1103515245 + 12345;
+				y[i] = seed >> 24;
+				a[i] = seed >> 16;
+			}
+			for (int i = 0; i < uvPitch * h; i++) {
+				seed = seed * 1103515245 + 12345;
+				u[i] = seed >> 24;
+				v[i] = seed >> 16;
+			}
+		}
+
+		~Planes() {
+			delete[] y;
+			delete[] u;
+			delete[] v;
+			delete[] a;
+		}
+
+		int width, height, yPitch, uvPitch;
+		byte *y, *u, *v, *a;
+	};
+
+	static void setConvertRow(ConvertRowProc convertRow) {
+		YUVToRGBMan._convertRow = convertRow;
+	}
+
+	// The null OSystem does not report the CPU features, so the rows are
+	// converted with the tables outside of these tests
+	static void restoreConvertRow() {
+		YUVToRGBMan._convertRow = nullptr;
+	}
+
+	static void convert(Graphics::Surface &dst, Graphics::YUVToRGBManager::LuminanceScale scale, Layout layout, const Planes &planes) {
+		switch (layout) {
+		case kLayout444:
+			YUVToRGBMan.convert444(&dst, scale, planes.y, planes.u, planes.v, planes.width, planes.height, planes.yPitch, planes.uvPitch);
+			break;
+		case kLayout422:
+			YUVToRGBMan.convert422(&dst, scale, planes.y, planes.u, planes.v, planes.width, planes.height, planes.yPitch, planes.uvPitch);
+			break;
+		case kLayout420:
+			YUVToRGBMan.convert420(&dst, scale, planes.y, planes.u, planes.v, planes.width, planes.height, planes.yPitch, planes.uvPitch);
+			break;
+		case kLayout420Alpha:
+			YUVToRGBMan.convert420Alpha(&dst, scale, planes.y, planes.u, planes.v, planes.a, planes.width, planes.height, planes.yPitch, planes.uvPitch);
+			break;
+		}
+	}
+
+	static uint32 getPixel(const Graphics::Surface &surface, int x, int y) {
+		if (surface.format.bytesPerPixel == 2)
+			return *(const uint16 *)surface.getBasePtr(x, y);
+		return *(const uint32 *)surface.getBasePtr(x, y);
+	}
+
+	static bool channelsMatch(uint32 a, uint32 b, byte shift, byte loss) {
+		const int mask = 0xFF >> loss;
+		const int diff = (int)((a >> shift) & mask) - (int)((b >> shift) & mask);
+		return diff >= -1 && diff <= 1;
+	}
+
+	static void testConvertRow(ConvertRowProc convertRow) {
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24)
+		};
+		const Graphics::YUVToRGBManager::LuminanceScale scales[] = {
+			Graphics::YUVToRGBManager::kScaleFull,
+			Graphics::YUVToRGBManager::kScaleITU
+		};
+		const Layout layouts[] = { kLayout444, kLayout422, kLayout420, kLayout420Alpha };
+
+		// Not a multiple of 16, so that the tables convert the right of the image
+		Planes planes(70, 10);
+
+		for (uint f = 0; f < ARRAYSIZE(formats); f++) {
+			const Graphics::PixelFormat &format = formats[f];
+			for (uint s = 0; s < ARRAYSIZE(scales); s++) {
+				for (uint l = 0; l < ARRAYSIZE(layouts); l++) {
+					Graphics::Surface expected, actual;
+					expected.create(planes.width, planes.height, format);
+					actual.create(planes.width, planes.height, format);
+
+					setConvertRow(nullptr);
+					convert(expected, scales[s], layouts[l], planes);
+					setConvertRow(convertRow);
+					convert(actual, scales[s], layouts[l], planes);
+
+					uint32 mismatches = 0;
+					for (int y = 0; y < planes.height; y++) {
+						for (int x = 0; x < planes.width; x++) {
+							const uint32 a = getPixel(expected, x, y);
+							const uint32 b = getPixel(actual, x, y);
+							if (!channelsMatch(a, b, format.rShift, format.rLoss) ||
+							    !channelsMatch(a, b, format.gShift, format.gLoss) ||
+							    !channelsMatch(a, b, format.bShift, format.bLoss) ||
+							    !channelsMatch(a, b, format.aShift, format.aLoss))
+								mismatches++;
+						}
+					}
+					TS_ASSERT_EQUALS(mismatches, 0u);
+
+					expected.free();
+					actual.free();
+				}
+			}
+		}
+
+		restoreConvertRow();
+	}
+
+	static void testSpeed(ConvertRowProc convertRow, const char *name) {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		Planes planes(1280, 720);
+		Graphics::Surface dst;
+		dst.create(planes.width, planes.height, format);
+
+		setConvertRow(convertRow);
+		const uint frames = 100;
+		const uint32 start = g_system->getMillis();
+		for (uint frame = 0; frame < frames; frame++)
+			convert(dst, Graphics::YUVToRGBManager::kScaleITU, kLayout420, planes);
+		const uint32 time = g_system->getMillis() - start;
+
+		debug("YUV 4:2:0 to RGB of %dx%d with %s: %u frames in %d ms",
+		      planes.width, planes.height, name, frames, time);
+
+		dst.free();
+		restoreConvertRow();
+	}
+
+	public:
+	void test_convert_rows() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+#ifdef SCUMMVM_NEON
+		testConvertRow(Graphics::YUVToRGBManager::convertRowNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testConvertRow(Graphics::YUVToRGBManager::convertRowSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testConvertRow(Graphics::YUVToRGBManager::convertRowAVX2);
+#endif
+#endif
+	}
+
+	void test_lookups() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		// Switching formats does not free the lookups, which other threads
+		// may still use
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		const Graphics::YUVToRGBLookup *first = YUVToRGBMan.getLookup(rgb565, Graphics::YUVToRGBManager::kScaleFull);
+		const Graphics::YUVToRGBLookup *second = YUVToRGBMan.getLookup(rgba8888, Graphics::YUVToRGBManager::kScaleFull);
+		const Graphics::YUVToRGBLookup *third = YUVToRGBMan.getLookup(rgb565, Graphics::YUVToRGBManager::kScaleITU);
+		TS_ASSERT_DIFFERS(first, second);
+		TS_ASSERT_DIFFERS(first, third);
+		TS_ASSERT_EQUALS(YUVToRGBMan.getLookup(rgb565, Graphics::YUVToRGBManager::kScaleFull), first);
+		TS_ASSERT_EQUALS(YUVToRGBMan.getLookup(rgba8888, Graphics::YUVToRGBManager::kScaleFull), second);
+#endif
+	}
+
+	void test_convert_speed() {
+#if BENCHMARK_TIME
+		Common::install_null_g_system();
+
+		testSpeed(nullptr, "tables");
+#ifdef SCUMMVM_NEON
+		testSpeed(Graphics::YUVToRGBManager::convertRowNEON, "NEON");
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			testSpeed(Graphics::YUVToRGBManager::convertRowSSE2, "SSE2");
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			testSpeed(Graphics::YUVToRGBManager::convertRowAVX2, "AVX2");
+#endif
+#endif
+	}
+};
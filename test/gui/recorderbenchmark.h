@@ -0,0 +1,94 @@
+#include <cxxtest/TestSuite.h>
+
+#include "gui/recorderbenchmark.h"
+
+#include "common/fs.h"
+#include "common/stream.h"
+
+#include "../null_osystem.h"
+
+class RecorderBenchmarkTestSuite : public CxxTest::TestSuite
+{
+	static Common::String readReport(const char *fileName) {
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::FSNode(Common::Path(fileName)).createReadStream());
+		TS_ASSERT(stream);
+		if (!stream)
+			return Common::String();
+
+		const uint32 size = stream->size();
+		char *buffer = new char[size];
+		const uint32 read = stream->read(buffer, size);
+		const Common::String contents(buffer, read);
+		delete[] buffer;
+		return contents;
+	}
+
+	public:
+	void test_summary() {
+		Common::Array<uint32> values;
+		for (uint32 i = 100; i >= 1; i--)
+			values.push_back(i);
+
+		const GUI::RecorderBenchmark::Summary summary = GUI::RecorderBenchmark::summarize(values);
+		TS_ASSERT_EQUALS(summary.total, 5050u);
+		TS_ASSERT_EQUALS(summary.max, 100u);
+		TS_ASSERT_EQUALS(summary.p50, 50u);
+		TS_ASSERT_EQUALS(summary.p90, 90u);
+		TS_ASSERT_EQUALS(summary.p95, 95u);
+		TS_ASSERT_EQUALS(summary.p99, 99u);
+		TS_ASSERT_EQUALS(GUI::RecorderBenchmark::formatSummary(summary, values.size()),
+		                 "{\"mean\":50.5,\"p50\":50,\"p90\":90,\"p95\":95,\"p99\":99,\"max\":100}");
+
+		// Nearest rank: with few values, the high percentiles are the maximum
+		values.resize(3);
+		const GUI::RecorderBenchmark::Summary small = GUI::RecorderBenchmark::summarize(values);
+		TS_ASSERT_EQUALS(small.p50, 99u);
+		TS_ASSERT_EQUALS(small.p90, 100u);
+		TS_ASSERT_EQUALS(small.p99, 100u);
+
+		const GUI::RecorderBenchmark::Summary empty = GUI::RecorderBenchmark::summarize(Common::Array<uint32>());
+		TS_ASSERT_EQUALS(GUI::RecorderBenchmark::formatSummary(empty, 0),
+		                 "{\"mean\":0.0,\"p50\":0,\"p90\":0,\"p95\":0,\"p99\":0,\"max\":0}");
+	}
+
+	void test_escape() {
+		TS_ASSERT_EQUALS(GUI::RecorderBenchmark::escapeString("a \"b\" c:\\d"), "a \\\"b\\\" c:\\\\d");
+	}
+
+	void test_report() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		GUI::RecorderBenchmark benchmark;
+		TS_ASSERT(!benchmark.isRunning());
+		benchmark.frame();
+
+		benchmark.start("test/benchmark.json", "my \"game\".r");
+		TS_ASSERT(benchmark.isRunning());
+		for (int i = 0; i < 3; i++)
+			benchmark.frame();
+		benchmark.finish(1234);
+		TS_ASSERT(!benchmark.isRunning());
+
+		const Common::String report = readReport("test/benchmark.json");
+		TS_ASSERT(report.hasPrefix("{\n"));
+		TS_ASSERT(report.hasSuffix("}\n"));
+		TS_ASSERT(report.contains("\"recording\":\"my \\\"game\\\".r\",\n"));
+		TS_ASSERT(report.contains("\"frames\":3,\n"));
+		TS_ASSERT(report.contains("\"replayed_time_ms\":1234,\n"));
+		TS_ASSERT(report.contains("\"frame_time_us\":{\"mean\":"));
+		TS_ASSERT(report.contains("\"peak_rss_kb\":"));
+		if (GUI::RecorderBenchmark::countsAllocations()) {
+			TS_ASSERT(report.contains("\"allocations_per_frame\":{\"mean\":"));
+		} else {
+			TS_ASSERT(report.contains("\"allocations\":null,\n"));
+			TS_ASSERT(report.contains("\"allocations_per_frame\":null,\n"));
+		}
+
+		// Nothing is written once finished
+		benchmark.frame();
+		benchmark.finish(0);
+		TS_ASSERT_EQUALS(readReport("test/benchmark.json"), report);
+#endif
+	}
+};
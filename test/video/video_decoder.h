@@ -0,0 +1,249 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/mutex.h"
+#include "common/system.h"
+
+#include "graphics/surface.h"
+#include "video/video_decoder.h"
+
+#include "../null_osystem.h"
+
+class VideoDecoderTestSuite : public CxxTest::TestSuite
+{
+	// A video whose frames are filled with their number, and which changes
+	// the first color of the palette every few frames
+	class TestDecoder : public Video::VideoDecoder {
+	public:
+		enum {
+			kFrameCount = 40,
+			kPaletteInterval = 8
+		};
+
+		TestDecoder() : _track(nullptr), _decodedFrames(0) {}
+		~TestDecoder() { close(); }
+
+		bool loadStream(Common::SeekableReadStream *stream) override {
+			close();
+			_track = new TestTrack(this);
+			addTrack(_track);
+			return true;
+		}
+
+		void close() override {
+			VideoDecoder::close();
+			_track = nullptr;
+		}
+
+		int getDecodedFrames() const {
+			Common::StackLock lock(_mutex);
+			return _decodedFrames;
+		}
+
+	private:
+		class TestTrack : public FixedRateVideoTrack {
+		public:
+			TestTrack(TestDecoder *decoder) : _decoder(decoder), _curFrame(-1), _reversed(false), _dirtyPalette(false) {
+				_surface.create(8, 4, Graphics::PixelFormat::createFormatCLUT8());
+				memset(_palette, 0, sizeof(_palette));
+			}
+
+			~TestTrack() { _surface.free(); }
+
+			bool isSeekable() const override { return true; }
+			bool seek(const Audio::Timestamp &time) override {
+				_curFrame = getFrameAtTime(time) - 1;
+				return true;
+			}
+
+			uint16 getWidth() const override { return _surface.w; }
+			uint16 getHeight() const override { return _surface.h; }
+			Graphics::PixelFormat getPixelFormat() const override { return _surface.format; }
+			int getCurFrame() const override { return _curFrame; }
+			int getFrameCount() const override { return kFrameCount; }
+
+			bool setReverse(bool reverse) override {
+				_reversed = reverse;
+				return true;
+			}
+
+			bool isReversed() const override { return _reversed; }
+
+			bool endOfTrack() const override {
+				return _reversed ? _curFrame <= 0 : FixedRateVideoTrack::endOfTrack();
+			}
+
+			const Graphics::Surface *decodeNextFrame() override {
+				_curFrame += _reversed ? -1 : 1;
+				_surface.fillRect(Common::Rect(_surface.w, _surface.h), _curFrame);
+				if (_curFrame % kPaletteInterval == 0) {
+					_palette[0] = _curFrame;
+					_dirtyPalette = true;
+				}
+
+				Common::StackLock lock(_decoder->_mutex);
+				_decoder->_decodedFrames++;
+				return &_surface;
+			}
+
+			const byte *getPalette() const override {
+				_dirtyPalette = false;
+				return _palette;
+			}
+
+			bool hasDirtyPalette() const override { return _dirtyPalette; }
+
+		protected:
+			Common::Rational getFrameRate() const override { return 25; }
+
+		private:
+			TestDecoder *_decoder;
+			Graphics::Surface _surface;
+			int _curFrame;
+			bool _reversed;
+			byte _palette[256 * 3];
+			mutable bool _dirtyPalette;
+		};
+
+		TestTrack *_track;
+		mutable Common::Mutex _mutex;
+		int _decodedFrames;
+	};
+
+	static void checkFrame(TestDecoder &decoder, int frameNum) {
+		TS_ASSERT(!decoder.endOfVideo());
+
+		const Graphics::Surface *frame = decoder.decodeNextFrame();
+		TS_ASSERT(frame);
+		if (frame)
+			TS_ASSERT_EQUALS(*(const byte *)frame->getBasePtr(7, 3), frameNum);
+
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), frameNum);
+		if (frameNum % TestDecoder::kPaletteInterval == 0) {
+			TS_ASSERT(decoder.hasDirtyPalette());
+			TS_ASSERT_EQUALS(decoder.getPalette()[0], frameNum);
+		} else {
+			TS_ASSERT(!decoder.hasDirtyPalette());
+		}
+	}
+
+	static void waitForDecodedFrames(TestDecoder &decoder, int count) {
+		for (int i = 0; i < 1000 && decoder.getDecodedFrames() < count; i++)
+			g_system->delayMillis(1);
+		TS_ASSERT_EQUALS(decoder.getDecodedFrames(), count);
+	}
+
+	static void testFrames(uint decodeAhead) {
+		TestDecoder decoder;
+		decoder.setDecodeAhead(decodeAhead);
+		decoder.loadStream(nullptr);
+		decoder.start();
+
+		for (int i = 0; i < TestDecoder::kFrameCount; i++)
+			checkFrame(decoder, i);
+
+		TS_ASSERT(decoder.endOfVideo());
+		TS_ASSERT(!decoder.decodeNextFrame());
+		TS_ASSERT_EQUALS(decoder.getDecodedFrames(), (int)TestDecoder::kFrameCount);
+	}
+
+	public:
+	void test_frames() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		testFrames(0);
+		testFrames(1);
+		testFrames(3);
+#endif
+	}
+
+	void test_queue_is_bounded() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		TestDecoder decoder;
+		decoder.setDecodeAhead(3);
+		decoder.loadStream(nullptr);
+		decoder.start();
+		checkFrame(decoder, 0);
+
+		// The first frame and the three after it
+		for (int i = 0; i < 1000 && decoder.getDecodedFrames() < 4; i++)
+			g_system->delayMillis(1);
+		g_system->delayMillis(20);
+		TS_ASSERT_EQUALS(decoder.getDecodedFrames(), 4);
+
+		// Pausing does not change which frames are next
+		decoder.pauseVideo(true);
+		checkFrame(decoder, 1);
+		decoder.pauseVideo(false);
+		TS_ASSERT(!decoder.isPaused());
+		checkFrame(decoder, 2);
+#endif
+	}
+
+	void test_seek() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		TestDecoder decoder;
+		decoder.setDecodeAhead(3);
+		decoder.loadStream(nullptr);
+		decoder.start();
+
+		for (int i = 0; i < 5; i++)
+			checkFrame(decoder, i);
+
+		// The frames which were decoded ahead are dropped
+		TS_ASSERT(decoder.seekToFrame(20));
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 19);
+		for (int i = 20; i < 30; i++)
+			checkFrame(decoder, i);
+
+		TS_ASSERT(decoder.rewind());
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), -1);
+		checkFrame(decoder, 0);
+		checkFrame(decoder, 1);
+
+		// Turning it off drops the queued frames as well
+		decoder.setDecodeAhead(0);
+		TS_ASSERT(decoder.seekToFrame(30));
+		checkFrame(decoder, 30);
+#endif
+	}
+
+	void test_changes_with_queued_frames() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		TestDecoder decoder;
+		decoder.setDecodeAhead(3);
+		decoder.loadStream(nullptr);
+		decoder.start();
+
+		for (int i = 0; i < 5; i++)
+			checkFrame(decoder, i);
+		waitForDecodedFrames(decoder, 8);
+
+		// The frames which were decoded ahead are not skipped
+		decoder.setVideoCodecAccuracy(Image::CodecAccuracy::Accurate);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 4);
+		for (int i = 5; i < 10; i++)
+			checkFrame(decoder, i);
+		waitForDecodedFrames(decoder, 13);
+
+		// Reversing goes on from the frame which was returned last
+		TS_ASSERT(decoder.setReverse(true));
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 9);
+		for (int i = 8; i >= 3; i--)
+			checkFrame(decoder, i);
+		waitForDecodedFrames(decoder, 22);
+
+		TS_ASSERT(decoder.setReverse(false));
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 3);
+		for (int i = 4; i < TestDecoder::kFrameCount; i++)
+			checkFrame(decoder, i);
+		TS_ASSERT(decoder.endOfVideo());
+#endif
+	}
+};
@@ -30,12 +30,14 @@
 #include "common/textconsole.h"
 #include "common/intrinsics.h"
 #include "common/stream.h"
+#include "common/memstream.h"
 #include "common/substream.h"
 #include "common/file.h"
 #include "common/str.h"
 #include "common/bitstream.h"
 #include "common/compression/huffman.h"
 #include "common/system.h"
+#include "common/taskpool.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
@@ -200,13 +202,16 @@ void BinkDecoder::readNextPacket() {
 		}
 	}
 
-	uint32 videoPacketStart = _bink->pos();
-	uint32 videoPacketEnd   = _bink->pos() + frameSize;
+	// Read the video packet into memory, where its planes can be decoded
+	// at the same time
+	_videoPacket.resize(frameSize);
+	uint32 videoPacketSize = frameSize ? _bink->read(_videoPacket.data(), frameSize) : 0;
+	if (videoPacketSize < frameSize)
+		memset(_videoPacket.data() + videoPacketSize, 0, frameSize - videoPacketSize);
 
-	frame.bits = new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-			videoPacketStart, videoPacketEnd), DisposeAfterUse::YES);
+	frame.bits = new Common::BitStream32LELSB(new Common::MemoryReadStream(_videoPacket.data(), frameSize), DisposeAfterUse::YES);
 
-	videoTrack->decodePacket(frame);
+	videoTrack->decodePacket(frame, _videoPacket.data(), frameSize);
 
 	delete frame.bits;
 	frame.bits = 0;
@@ -249,25 +254,6 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32
 	for (int i = 0; i < 16; i++)
 		_huffman[i] = 0;
 
-	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = 0;
-
-		_bundles[i].huffman.index = 0;
-		for (int j = 0; j < 16; j++)
-			_bundles[i].huffman.symbols[j] = j;
-
-		_bundles[i].data     = 0;
-		_bundles[i].dataEnd  = 0;
-		_bundles[i].curDec   = 0;
-		_bundles[i].curPtr   = 0;
-	}
-
-	for (int i = 0; i < 16; i++) {
-		_colHighHuffman[i].index = 0;
-		for (int j = 0; j < 16; j++)
-			_colHighHuffman[i].symbols[j] = j;
-	}
-
 	// Make the surface even-sized:
 	_surfaceHeight = _height = height;
 	_surfaceWidth = _width = width;
@@ -305,8 +291,25 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32
 	memset(_curPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 	memset(_oldPlanes[3], 255, _yBlockWidth  * 8 * _yBlockHeight  * 8);
 
-	initBundles();
 	initHuffman();
+
+	_planeDecoders[0] = new PlaneDecoder(*this);
+	_planeDecoders[1] = nullptr;
+	_planeDecoders[2] = nullptr;
+
+	// Only BIKi frames tell where their planes start
+	_taskPool = nullptr;
+	if (_id == kBIKiID && g_system->getTaskPool()->getWorkerCount())
+		_taskPool = g_system->getTaskPool();
+
+	for (int i = 0; i < kPlaneOffsetMAX; i++) {
+		for (int j = 0; j < kPlaneOffsetBaseMAX; j++) {
+			_planeOffsetDeltas[i][j] = 0;
+			_planeOffsetValid[i][j] = true;
+		}
+	}
+	_planeOffsetChecks = 0;
+	_concurrentPlanes = false;
 }
 
 BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
@@ -315,7 +318,8 @@ BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
 	}
 
-	deinitBundles();
+	for (int i = 0; i < 3; i++)
+		delete _planeDecoders[i];
 
 	for (int i = 0; i < 16; i++) {
 		delete _huffman[i];
@@ -446,7 +450,7 @@ bool BinkDecoder::BinkVideoTrack::rewind() {
 	return true;
 }
 
-void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
+void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame, const byte *packet, uint32 packetSize) {
 	assert(frame.bits);
 
 	if (!_surface) {
@@ -459,24 +463,8 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 		_surface->w = _width;
 	}
 
-	if (_hasAlpha) {
-		if (_id == kBIKiID)
-			frame.bits->skip(32);
-
-		decodePlane(frame, 3, false);
-	}
-
-	if (_id == kBIKiID)
-		frame.bits->skip(32);
-
-	for (int i = 0; i < 3; i++) {
-		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
-
-		decodePlane(frame, planeIdx, i != 0);
-
-		if (frame.bits->pos() >= frame.bits->size())
-			break;
-	}
+	if (!_concurrentPlanes || !decodePlanesConcurrently(packet, packetSize))
+		decodePlanesSerially(frame);
 
 	// Convert the YUV data we have to our format
 	// The width used here is the surface-width, and not the video-width
@@ -498,9 +486,214 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	_curFrame++;
 }
 
-void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
-	uint32 blockWidth  = isChroma ? _uvBlockWidth  : _yBlockWidth;
-	uint32 blockHeight = isChroma ? _uvBlockHeight : _yBlockHeight;
+void BinkDecoder::BinkVideoTrack::decodePlanesSerially(VideoFrame &frame) {
+	PlaneDecoder &decoder = *_planeDecoders[0];
+
+	if (_hasAlpha) {
+		uint32 alphaOffset = 0;
+		if (_id == kBIKiID)
+			alphaOffset = frame.bits->getBits<32>();
+
+		decoder.decodePlane(frame, 3, false);
+
+		if (_id == kBIKiID)
+			checkPlaneOffset(kPlaneOffsetAlpha, alphaOffset, 32, frame.bits->pos());
+	}
+
+	uint32 colorOffset = 0;
+	uint32 colorOffsetEnd = 0;
+	if (_id == kBIKiID) {
+		colorOffset = frame.bits->getBits<32>();
+		colorOffsetEnd = frame.bits->pos();
+	}
+
+	for (int i = 0; i < 3; i++) {
+		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
+
+		decoder.decodePlane(frame, planeIdx, i != 0);
+
+		if (i == 0 && _id == kBIKiID)
+			checkPlaneOffset(kPlaneOffsetColor, colorOffset, colorOffsetEnd, frame.bits->pos());
+
+		if (frame.bits->pos() >= frame.bits->size())
+			break;
+	}
+
+	if (_id != kBIKiID || !_taskPool || _planeOffsetChecks == kPlaneOffsetFrames)
+		return;
+
+	if (++_planeOffsetChecks < kPlaneOffsetFrames)
+		return;
+
+	// Only decode the planes concurrently if the offsets located them in all
+	// the frames checked
+	_concurrentPlanes = _planeOffsetValid[kPlaneOffsetColor][kPlaneOffsetFromPacket] ||
+	                    _planeOffsetValid[kPlaneOffsetColor][kPlaneOffsetFromValue];
+	if (_hasAlpha)
+		_concurrentPlanes = _concurrentPlanes &&
+		                    (_planeOffsetValid[kPlaneOffsetAlpha][kPlaneOffsetFromPacket] ||
+		                     _planeOffsetValid[kPlaneOffsetAlpha][kPlaneOffsetFromValue]);
+
+	if (_concurrentPlanes) {
+		for (int i = 1; i < 3; i++)
+			if (!_planeDecoders[i])
+				_planeDecoders[i] = new PlaneDecoder(*this);
+	}
+}
+
+bool BinkDecoder::BinkVideoTrack::decodePlanesConcurrently(const byte *packet, uint32 packetSize) {
+	const uint32 size = (packetSize & ~3) * 8;
+
+	// The Y plane follows the offset in front of it
+	uint32 colorOffsetPos = 0;
+	if (_hasAlpha && !findPlanes(kPlaneOffsetAlpha, packet, packetSize, 0, colorOffsetPos))
+		return false;
+
+	uint32 chromaStart;
+	if (!findPlanes(kPlaneOffsetColor, packet, packetSize, colorOffsetPos, chromaStart))
+		return false;
+
+	PlaneTask tasks[3];
+	for (int i = 0; i < 3; i++) {
+		tasks[i].decoder = _planeDecoders[i];
+		tasks[i].packet = packet;
+		tasks[i].packetSize = packetSize;
+		tasks[i].planeCount = 0;
+	}
+
+	if (_hasAlpha) {
+		tasks[0].start = 32;
+		tasks[0].planes[0] = 3;
+		tasks[0].planeCount = 1;
+	}
+
+	tasks[1].start = colorOffsetPos + 32;
+	tasks[1].planes[0] = 0;
+	tasks[1].planeCount = 1;
+
+	// Like decodePlanesSerially(), the U and V planes stop at the end of the packet
+	if (chromaStart < size) {
+		tasks[2].start = chromaStart;
+		tasks[2].planes[0] = _swapPlanes ? 2 : 1;
+		tasks[2].planes[1] = _swapPlanes ? 1 : 2;
+		tasks[2].planeCount = 2;
+	}
+
+	Common::TaskPool::Future futures[3];
+	for (int i = 0; i < 3; i += 2)
+		if (tasks[i].planeCount)
+			_taskPool->submit(futures[i], &decodePlanesProc, &tasks[i]);
+
+	decodePlanesProc(&tasks[1]);
+
+	for (int i = 0; i < 3; i += 2)
+		if (tasks[i].planeCount)
+			futures[i].wait();
+
+	bool valid = tasks[1].end == chromaStart || (tasks[1].end >= size && chromaStart >= size);
+	if (_hasAlpha)
+		valid = valid && tasks[0].end == colorOffsetPos;
+
+	if (!valid) {
+		// The offsets did not locate the planes after all, so the frame is
+		// decoded again, and so are all the frames after it
+		warning("Bink plane offsets do not match the planes in frame %d", _curFrame + 1);
+		_concurrentPlanes = false;
+	}
+
+	return valid;
+}
+
+void BinkDecoder::BinkVideoTrack::checkPlaneOffset(PlaneOffset offset, uint32 value, uint32 valueEnd, uint32 planesStart) {
+	if (!_taskPool || _planeOffsetChecks == kPlaneOffsetFrames)
+		return;
+
+	const int64 deltas[kPlaneOffsetBaseMAX] = {
+		(int64)planesStart - (int64)value * 8,
+		(int64)planesStart - valueEnd - (int64)value * 8
+	};
+
+	for (int i = 0; i < kPlaneOffsetBaseMAX; i++) {
+		if (_planeOffsetChecks == 0)
+			_planeOffsetDeltas[offset][i] = deltas[i];
+		else if (_planeOffsetDeltas[offset][i] != deltas[i])
+			_planeOffsetValid[offset][i] = false;
+	}
+}
+
+bool BinkDecoder::BinkVideoTrack::findPlanes(PlaneOffset offset, const byte *packet, uint32 packetSize, uint32 valuePos, uint32 &planesStart) const {
+	const uint32 size = (packetSize & ~3) * 8;
+	if (valuePos + 32 > size)
+		return false;
+
+	const uint32 value = READ_LE_UINT32(packet + valuePos / 8);
+
+	int64 start = (int64)value * 8;
+	if (_planeOffsetValid[offset][kPlaneOffsetFromPacket])
+		start += _planeOffsetDeltas[offset][kPlaneOffsetFromPacket];
+	else
+		start += _planeOffsetDeltas[offset][kPlaneOffsetFromValue] + valuePos + 32;
+
+	// Planes start at 32-bit boundaries, after the offset
+	if (start < valuePos + 32 || start > size || (start & 0x1F))
+		return false;
+
+	planesStart = (uint32)start;
+	return true;
+}
+
+void BinkDecoder::BinkVideoTrack::decodePlanesProc(void *data) {
+	PlaneTask &task = *(PlaneTask *)data;
+
+	task.end = task.decoder->decodePlanes(task.packet, task.packetSize, task.start, task.planes, task.planeCount);
+}
+
+BinkDecoder::BinkVideoTrack::PlaneDecoder::PlaneDecoder(BinkVideoTrack &track) : _track(track), _colLastVal(0) {
+	for (int i = 0; i < kSourceMAX; i++) {
+		_bundles[i].countLength = 0;
+
+		_bundles[i].huffman.index = 0;
+		for (int j = 0; j < 16; j++)
+			_bundles[i].huffman.symbols[j] = j;
+
+		_bundles[i].data     = 0;
+		_bundles[i].dataEnd  = 0;
+		_bundles[i].curDec   = 0;
+		_bundles[i].curPtr   = 0;
+	}
+
+	for (int i = 0; i < 16; i++) {
+		_colHighHuffman[i].index = 0;
+		for (int j = 0; j < 16; j++)
+			_colHighHuffman[i].symbols[j] = j;
+	}
+
+	initBundles();
+}
+
+BinkDecoder::BinkVideoTrack::PlaneDecoder::~PlaneDecoder() {
+	deinitBundles();
+}
+
+uint32 BinkDecoder::BinkVideoTrack::PlaneDecoder::decodePlanes(const byte *packet, uint32 packetSize, uint32 start, const int *planes, uint planeCount) {
+	// Planes start at 32-bit boundaries, so a stream starting at the first
+	// one reads the same bits as the one of the whole packet
+	VideoFrame video;
+	video.bits = new Common::BitStream32LELSB(new Common::MemoryReadStream(packet + start / 8, packetSize - start / 8), DisposeAfterUse::YES);
+
+	for (uint i = 0; i < planeCount; i++) {
+		decodePlane(video, planes[i], planes[i] == 1 || planes[i] == 2);
+
+		if (video.bits->pos() >= video.bits->size())
+			break;
+	}
+
+	return start + video.bits->pos();
+}
+
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+	uint32 blockWidth  = isChroma ? _track._uvBlockWidth  : _track._yBlockWidth;
+	uint32 blockHeight = isChroma ? _track._uvBlockHeight : _track._yBlockHeight;
 	uint32 width       = blockWidth  * 8;
 	uint32 height      = blockHeight * 8;
 
@@ -508,10 +701,10 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 	ctx.video     = &video;
 	ctx.planeIdx  = planeIdx;
-	ctx.destStart = _curPlanes[planeIdx];
-	ctx.destEnd   = _curPlanes[planeIdx] + width * height;
-	ctx.prevStart = _oldPlanes[planeIdx];
-	ctx.prevEnd   = _oldPlanes[planeIdx] + width * height;
+	ctx.destStart = _track._curPlanes[planeIdx];
+	ctx.destEnd   = _track._curPlanes[planeIdx] + width * height;
+	ctx.prevStart = _track._oldPlanes[planeIdx];
+	ctx.prevEnd   = _track._oldPlanes[planeIdx] + width * height;
 	ctx.pitch     = width;
 
 	for (int i = 0; i < 64; i++) {
@@ -598,7 +791,7 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 }
 
-void BinkDecoder::BinkVideoTrack::readBundle(VideoFrame &video, Source source) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readBundle(VideoFrame &video, Source source) {
 	if (source == kSourceColors) {
 		for (int i = 0; i < 16; i++)
 			readHuffman(video, _colHighHuffman[i]);
@@ -613,7 +806,7 @@ void BinkDecoder::BinkVideoTrack::readBundle(VideoFrame &video, Source source) {
 	_bundles[source].curPtr = _bundles[source].data;
 }
 
-void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readHuffman(VideoFrame &video, Huffman &huffman) {
 	huffman.index = video.bits->getBits<4>();
 
 	if (huffman.index == 0) {
@@ -665,7 +858,7 @@ void BinkDecoder::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffma
 	memcpy(huffman.symbols, in, 16);
 }
 
-void BinkDecoder::BinkVideoTrack::mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size) {
 	const byte *src2  = src + size;
 	int size2 = size;
 
@@ -687,9 +880,9 @@ void BinkDecoder::BinkVideoTrack::mergeHuffmanSymbols(VideoFrame &video, byte *d
 		*dst++ = *src2++;
 }
 
-void BinkDecoder::BinkVideoTrack::initBundles() {
-	uint32 bw     = (_width + 7) >> 3;
-	uint32 bh     = (_height + 7) >> 3;
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::initBundles() {
+	uint32 bw     = (_track._width + 7) >> 3;
+	uint32 bh     = (_track._height + 7) >> 3;
 	uint32 blocks = bw * bh;
 
 	for (int i = 0; i < kSourceMAX; i++) {
@@ -697,8 +890,8 @@ void BinkDecoder::BinkVideoTrack::initBundles() {
 		_bundles[i].dataEnd = _bundles[i].data + blocks * 64;
 	}
 
-	uint32 cbw[2] = { (uint32)((_width + 7) >> 3), (uint32)((_width  + 15) >> 4) };
-	uint32 cw [2] = { (uint32)( _width          ), (uint32)( _width        >> 1) };
+	uint32 cbw[2] = { (uint32)((_track._width + 7) >> 3), (uint32)((_track._width  + 15) >> 4) };
+	uint32 cw [2] = { (uint32)( _track._width          ), (uint32)( _track._width        >> 1) };
 
 	// Calculate the lengths of an element count in bits
 	for (int i = 0; i < 2; i++) {
@@ -716,7 +909,7 @@ void BinkDecoder::BinkVideoTrack::initBundles() {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::deinitBundles() {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::deinitBundles() {
 	for (int i = 0; i < kSourceMAX; i++)
 		delete[] _bundles[i].data;
 }
@@ -726,11 +919,11 @@ void BinkDecoder::BinkVideoTrack::initHuffman() {
 		_huffman[i] = new Common::Huffman<Common::BitStream32LELSB>(binkHuffmanLengths[i][15], 16, binkHuffmanCodes[i], binkHuffmanLengths[i]);
 }
 
-byte BinkDecoder::BinkVideoTrack::getHuffmanSymbol(VideoFrame &video, Huffman &huffman) {
-	return huffman.symbols[_huffman[huffman.index]->getSymbol(*video.bits)];
+byte BinkDecoder::BinkVideoTrack::PlaneDecoder::getHuffmanSymbol(VideoFrame &video, Huffman &huffman) {
+	return huffman.symbols[_track._huffman[huffman.index]->getSymbol(*video.bits)];
 }
 
-int32 BinkDecoder::BinkVideoTrack::getBundleValue(Source source) {
+int32 BinkDecoder::BinkVideoTrack::PlaneDecoder::getBundleValue(Source source) {
 	if ((source < kSourceXOff) || (source == kSourceRun))
 		return *_bundles[source].curPtr++;
 
@@ -744,7 +937,7 @@ int32 BinkDecoder::BinkVideoTrack::getBundleValue(Source source) {
 	return ret;
 }
 
-uint32 BinkDecoder::BinkVideoTrack::readBundleCount(VideoFrame &video, Bundle &bundle) {
+uint32 BinkDecoder::BinkVideoTrack::PlaneDecoder::readBundleCount(VideoFrame &video, Bundle &bundle) {
 	if (!bundle.curDec || (bundle.curDec > bundle.curPtr))
 		return 0;
 
@@ -755,7 +948,7 @@ uint32 BinkDecoder::BinkVideoTrack::readBundleCount(VideoFrame &video, Bundle &b
 	return n;
 }
 
-void BinkDecoder::BinkVideoTrack::blockSkip(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockSkip(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev;
 
@@ -763,7 +956,7 @@ void BinkDecoder::BinkVideoTrack::blockSkip(DecodeContext &ctx) {
 		memcpy(dest, prev, 8);
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledSkip(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledSkip(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev;
 
@@ -771,7 +964,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledSkip(DecodeContext &ctx) {
 		memcpy(dest, prev, 16);
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledRun(DecodeContext &ctx) {
 	const uint8 *scan = binkPatterns[ctx.video->bits->getBits<4>()];
 
 	int i = 0;
@@ -807,7 +1000,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledIntra(DecodeContext &ctx) {
 	int32 block[64];
 	memset(block, 0, 64 * sizeof(int32));
 
@@ -828,7 +1021,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledFill(DecodeContext &ctx) {
 	byte v = getBundleValue(kSourceColors);
 
 	byte *dest = ctx.dest;
@@ -836,7 +1029,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
 		memset(dest, v, 16);
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledPattern(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
@@ -852,7 +1045,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledPattern(DecodeContext &ctx) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaledRaw(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaledRaw(DecodeContext &ctx) {
 	byte row[8];
 
 	byte *dest1 = ctx.dest;
@@ -867,7 +1060,7 @@ void BinkDecoder::BinkVideoTrack::blockScaledRaw(DecodeContext &ctx) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockScaled(DecodeContext &ctx) {
 	BlockType blockType = (BlockType) getBundleValue(kSourceSubBlockTypes);
 
 	switch (blockType) {
@@ -895,7 +1088,7 @@ void BinkDecoder::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
 	ctx.prev   += 8;
 }
 
-void BinkDecoder::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockMotion(DecodeContext &ctx) {
 	int8 xOff = getBundleValue(kSourceXOff);
 	int8 yOff = getBundleValue(kSourceYOff);
 
@@ -908,7 +1101,7 @@ void BinkDecoder::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
 		memcpy(dest, prev, 8);
 }
 
-void BinkDecoder::BinkVideoTrack::blockRun(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockRun(DecodeContext &ctx) {
 	const uint8 *scan = binkPatterns[ctx.video->bits->getBits<4>()];
 
 	int i = 0;
@@ -935,7 +1128,7 @@ void BinkDecoder::BinkVideoTrack::blockRun(DecodeContext &ctx) {
 		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
 }
 
-void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockResidue(DecodeContext &ctx) {
 	blockMotion(ctx);
 
 	byte v = ctx.video->bits->getBits<7>();
@@ -952,7 +1145,7 @@ void BinkDecoder::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 			dst[j] += src[j];
 }
 
-void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockIntra(DecodeContext &ctx) {
 	int32 block[64];
 	memset(block, 0, 64 * sizeof(int32));
 
@@ -963,7 +1156,7 @@ void BinkDecoder::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
 	IDCTPut(ctx, block);
 }
 
-void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockFill(DecodeContext &ctx) {
 	byte v = getBundleValue(kSourceColors);
 
 	byte *dest = ctx.dest;
@@ -971,7 +1164,7 @@ void BinkDecoder::BinkVideoTrack::blockFill(DecodeContext &ctx) {
 		memset(dest, v, 8);
 }
 
-void BinkDecoder::BinkVideoTrack::blockInter(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockInter(DecodeContext &ctx) {
 	blockMotion(ctx);
 
 	int32 block[64];
@@ -984,7 +1177,7 @@ void BinkDecoder::BinkVideoTrack::blockInter(DecodeContext &ctx) {
 	IDCTAdd(ctx, block);
 }
 
-void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
@@ -999,7 +1192,7 @@ void BinkDecoder::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::blockRaw(DecodeContext &ctx) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::blockRaw(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
 	byte *data = _bundles[kSourceColors].curPtr;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch, data += 8)
@@ -1008,7 +1201,7 @@ void BinkDecoder::BinkVideoTrack::blockRaw(DecodeContext &ctx) {
 	_bundles[kSourceColors].curPtr += 64;
 }
 
-void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readRuns(VideoFrame &video, Bundle &bundle) {
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
@@ -1028,7 +1221,7 @@ void BinkDecoder::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
 			*bundle.curDec++ = getHuffmanSymbol(video, bundle.huffman);
 }
 
-void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readMotionValues(VideoFrame &video, Bundle &bundle) {
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
@@ -1065,7 +1258,7 @@ void BinkDecoder::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bu
 }
 
 const uint8 rleLens[4] = { 4, 8, 12, 32 };
-void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readBlockTypes(VideoFrame &video, Bundle &bundle) {
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
@@ -1102,7 +1295,7 @@ void BinkDecoder::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bund
 	} while (bundle.curDec < decEnd);
 }
 
-void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readPatterns(VideoFrame &video, Bundle &bundle) {
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
@@ -1120,7 +1313,7 @@ void BinkDecoder::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle
 }
 
 
-void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readColors(VideoFrame &video, Bundle &bundle) {
 	uint32 n = readBundleCount(video, bundle);
 	if (n == 0)
 		return;
@@ -1136,7 +1329,7 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 		v = getHuffmanSymbol(video, bundle.huffman);
 		v = (_colLastVal << 4) | v;
 
-		if (_id != kBIKiID) {
+		if (_track._id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
 			v = ((v & 0x7F) ^ sign) - sign;
 			v += 0x80;
@@ -1155,7 +1348,7 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 		v = getHuffmanSymbol(video, bundle.huffman);
 		v = (_colLastVal << 4) | v;
 
-		if (_id != kBIKiID) {
+		if (_track._id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
 			v = ((v & 0x7F) ^ sign) - sign;
 			v += 0x80;
@@ -1165,7 +1358,7 @@ void BinkDecoder::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle)
 }
 
 template<int startBits, bool hasSign>
-void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readDCS(VideoFrame &video, Bundle &bundle) {
 	uint32 length = readBundleCount(video, bundle);
 	if (length == 0)
 		return;
@@ -1211,7 +1404,7 @@ void BinkDecoder::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle) {
 }
 
 /** Reads 8x8 block of DCT coefficients. */
-void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int32 *block, bool isIntra) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readDCTCoeffs(VideoFrame &video, int32 *block, bool isIntra) {
 	int coefCount = 0;
 	int coefIdx[64];
 
@@ -1313,7 +1506,7 @@ void BinkDecoder::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int32 *block,
 }
 
 /** Reads 8x8 block with residue after motion compensation. */
-void BinkDecoder::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int masksCount) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::readResidue(VideoFrame &video, int16 *block, int masksCount) {
 	int nzCoeff[64];
 	int nzCoeffCount = 0;
 
@@ -1461,7 +1654,7 @@ static inline void IDCTCol(int32 *dest, const int32 *src) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::IDCT(int32 *block) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::IDCT(int32 *block) {
 	int i;
 	int32 temp[64];
 
@@ -1472,7 +1665,7 @@ void BinkDecoder::BinkVideoTrack::IDCT(int32 *block) {
 	}
 }
 
-void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int32 *block) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::IDCTAdd(DecodeContext &ctx, int32 *block) {
 	int i, j;
 
 	IDCT(block);
@@ -1482,7 +1675,7 @@ void BinkDecoder::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int32 *block) {
 			 dest[j] += block[j];
 }
 
-void BinkDecoder::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int32 *block) {
+void BinkDecoder::BinkVideoTrack::PlaneDecoder::IDCTPut(DecodeContext &ctx, int32 *block) {
 	int i;
 	int32 temp[64];
 	for (i = 0; i < 8; i++)
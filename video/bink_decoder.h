@@ -45,6 +45,7 @@ class QueuingAudioStream;
 
 namespace Common {
 class SeekableReadStream;
+class TaskPool;
 template <class BITSTREAM>
 class Huffman;
 }
@@ -168,8 +169,11 @@ private:
 		bool rewind() override;
 		void setCurFrame(uint32 frame) { _curFrame = frame; }
 
-		/** Decode a video packet. */
-		void decodePacket(VideoFrame &frame);
+		/**
+		 * Decode a video packet, which is read into memory. Its bitstream
+		 * is in the frame.
+		 */
+		void decodePacket(VideoFrame &frame, const byte *packet, uint32 packetSize);
 
 		Common::Rational getFrameRate() const override { return _frameRate; }
 
@@ -247,6 +251,135 @@ private:
 			byte *curPtr; ///< Pointer to the data that wasn't yet read.
 		};
 
+		/**
+		 * Decodes planes out of a bitstream into the planes of the track.
+		 *
+		 * Each decoder has bundles of its own, so that several of them may
+		 * decode different planes of a frame at the same time.
+		 */
+		class PlaneDecoder {
+		public:
+			PlaneDecoder(BinkVideoTrack &track);
+			~PlaneDecoder();
+
+			/** Decode a plane. */
+			void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+
+			/**
+			 * Decode planes out of a packet in memory, starting at the given
+			 * bit position, and stopping at the end of the packet like
+			 * decodePacket() does.
+			 *
+			 * @return The bit position after the last decoded plane.
+			 */
+			uint32 decodePlanes(const byte *packet, uint32 packetSize, uint32 start, const int *planes, uint planeCount);
+
+		private:
+			BinkVideoTrack &_track;
+
+			Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+
+			/** Huffman codebooks to use for decoding high nibbles in color data types. */
+			Huffman _colHighHuffman[16];
+			/** Value of the last decoded high nibble in color data types. */
+			int _colLastVal;
+
+			/** Initialize the bundles. */
+			void initBundles();
+			/** Deinitialize the bundles. */
+			void deinitBundles();
+
+			/** Read/Initialize a bundle for decoding a plane. */
+			void readBundle(VideoFrame &video, Source source);
+
+			/** Read the symbols for a Huffman code. */
+			void readHuffman(VideoFrame &video, Huffman &huffman);
+			/** Merge two Huffman symbol lists. */
+			void mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size);
+
+			/** Read and translate a symbol out of a Huffman code. */
+			byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
+
+			/** Get a direct value out of a bundle. */
+			int32 getBundleValue(Source source);
+			/** Read a count value out of a bundle. */
+			uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
+
+			// Handle the block types
+			void blockSkip         (DecodeContext &ctx);
+			void blockScaledSkip   (DecodeContext &ctx);
+			void blockScaledRun    (DecodeContext &ctx);
+			void blockScaledIntra  (DecodeContext &ctx);
+			void blockScaledFill   (DecodeContext &ctx);
+			void blockScaledPattern(DecodeContext &ctx);
+			void blockScaledRaw    (DecodeContext &ctx);
+			void blockScaled       (DecodeContext &ctx);
+			void blockMotion       (DecodeContext &ctx);
+			void blockRun          (DecodeContext &ctx);
+			void blockResidue      (DecodeContext &ctx);
+			void blockIntra        (DecodeContext &ctx);
+			void blockFill         (DecodeContext &ctx);
+			void blockInter        (DecodeContext &ctx);
+			void blockPattern      (DecodeContext &ctx);
+			void blockRaw          (DecodeContext &ctx);
+
+			// Read the bundles
+			void readRuns        (VideoFrame &video, Bundle &bundle);
+			void readMotionValues(VideoFrame &video, Bundle &bundle);
+			void readBlockTypes  (VideoFrame &video, Bundle &bundle);
+			void readPatterns    (VideoFrame &video, Bundle &bundle);
+			void readColors      (VideoFrame &video, Bundle &bundle);
+			template<int startBits, bool hasSign>
+			void readDCS         (VideoFrame &video, Bundle &bundle);
+			void readDCTCoeffs   (VideoFrame &video, int32 *block, bool isIntra);
+			void readResidue     (VideoFrame &video, int16 *block, int masksCount);
+
+			// Bink video IDCT
+			void IDCT(int32 *block);
+			void IDCTPut(DecodeContext &ctx, int32 *block);
+			void IDCTAdd(DecodeContext &ctx, int32 *block);
+		};
+
+		/**
+		 * The 32-bit values of BIKi frames in front of the alpha plane, and
+		 * in front of the Y plane, which give the position of the planes
+		 * following the next one.
+		 */
+		enum PlaneOffset {
+			kPlaneOffsetAlpha = 0, ///< Locates the value in front of the Y plane.
+			kPlaneOffsetColor    , ///< Locates the U and V planes.
+
+			kPlaneOffsetMAX
+		};
+
+		/** What a plane offset is counted from. */
+		enum PlaneOffsetBase {
+			kPlaneOffsetFromPacket = 0, ///< The start of the video packet.
+			kPlaneOffsetFromValue     , ///< The end of the value itself.
+
+			kPlaneOffsetBaseMAX
+		};
+
+		/** Planes decoded on a task pool worker. */
+		struct PlaneTask {
+			PlaneDecoder *decoder;
+
+			const byte *packet;
+			uint32 packetSize;
+
+			uint32 start; ///< Bit position of the first plane.
+			uint32 end;   ///< Bit position after the last decoded plane.
+
+			int planes[2];
+			uint planeCount;
+		};
+
+		/**
+		 * The number of frames which are decoded one plane after the other,
+		 * to check how the plane offsets relate to the planes.
+		 */
+		static const uint kPlaneOffsetFrames = 4;
+
 		int _curFrame;
 		int _frameCount;
 
@@ -264,15 +397,8 @@ private:
 
 		Common::Rational _frameRate;
 
-		Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
-
 		Common::Huffman<Common::BitStream32LELSB> *_huffman[16]; ///< The 16 Huffman codebooks used in Bink decoding.
 
-		/** Huffman codebooks to use for decoding high nibbles in color data types. */
-		Huffman _colHighHuffman[16];
-		/** Value of the last decoded high nibble in color data types. */
-		int _colLastVal;
-
 		uint32 _yBlockWidth;   ///< Width of the Y plane in blocks
 		uint32 _yBlockHeight;  ///< Height of the Y plane in blocks
 		uint32 _uvBlockWidth;  ///< Width of the U and V planes in blocks
@@ -281,66 +407,50 @@ private:
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
-		/** Initialize the bundles. */
-		void initBundles();
-		/** Deinitialize the bundles. */
-		void deinitBundles();
+		/**
+		 * The decoders of the alpha, the Y, and the U and V planes. The first
+		 * one decodes all of them when the planes are decoded serially.
+		 */
+		PlaneDecoder *_planeDecoders[3];
+
+		/** The pool decoding the planes of BIKi frames, if it has workers. */
+		Common::TaskPool *_taskPool;
+
+		/**
+		 * The differences between the plane positions and the offsets, in
+		 * bits, as seen in the frames which were decoded so far.
+		 */
+		int64 _planeOffsetDeltas[kPlaneOffsetMAX][kPlaneOffsetBaseMAX];
+		/** Whether the differences above were the same in all these frames. */
+		bool _planeOffsetValid[kPlaneOffsetMAX][kPlaneOffsetBaseMAX];
+		/** Number of frames checked against the plane offsets so far. */
+		uint _planeOffsetChecks;
+		/** Are the planes decoded concurrently? */
+		bool _concurrentPlanes;
 
 		/** Initialize the Huffman decoders. */
 		void initHuffman();
 
-		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
-
-		/** Read/Initialize a bundle for decoding a plane. */
-		void readBundle(VideoFrame &video, Source source);
-
-		/** Read the symbols for a Huffman code. */
-		void readHuffman(VideoFrame &video, Huffman &huffman);
-		/** Merge two Huffman symbol lists. */
-		void mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size);
-
-		/** Read and translate a symbol out of a Huffman code. */
-		byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
-
-		/** Get a direct value out of a bundle. */
-		int32 getBundleValue(Source source);
-		/** Read a count value out of a bundle. */
-		uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
-
-		// Handle the block types
-		void blockSkip         (DecodeContext &ctx);
-		void blockScaledSkip   (DecodeContext &ctx);
-		void blockScaledRun    (DecodeContext &ctx);
-		void blockScaledIntra  (DecodeContext &ctx);
-		void blockScaledFill   (DecodeContext &ctx);
-		void blockScaledPattern(DecodeContext &ctx);
-		void blockScaledRaw    (DecodeContext &ctx);
-		void blockScaled       (DecodeContext &ctx);
-		void blockMotion       (DecodeContext &ctx);
-		void blockRun          (DecodeContext &ctx);
-		void blockResidue      (DecodeContext &ctx);
-		void blockIntra        (DecodeContext &ctx);
-		void blockFill         (DecodeContext &ctx);
-		void blockInter        (DecodeContext &ctx);
-		void blockPattern      (DecodeContext &ctx);
-		void blockRaw          (DecodeContext &ctx);
-
-		// Read the bundles
-		void readRuns        (VideoFrame &video, Bundle &bundle);
-		void readMotionValues(VideoFrame &video, Bundle &bundle);
-		void readBlockTypes  (VideoFrame &video, Bundle &bundle);
-		void readPatterns    (VideoFrame &video, Bundle &bundle);
-		void readColors      (VideoFrame &video, Bundle &bundle);
-		template<int startBits, bool hasSign>
-		void readDCS         (VideoFrame &video, Bundle &bundle);
-		void readDCTCoeffs   (VideoFrame &video, int32 *block, bool isIntra);
-		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int32 *block);
-		void IDCTPut(DecodeContext &ctx, int32 *block);
-		void IDCTAdd(DecodeContext &ctx, int32 *block);
+		/** Decode the planes of a frame one after the other. */
+		void decodePlanesSerially(VideoFrame &frame);
+		/**
+		 * Decode the alpha, the Y, and the U and V planes of a BIKi frame
+		 * concurrently.
+		 *
+		 * @return False if the planes were not all decoded from the
+		 *         positions they actually start at.
+		 */
+		bool decodePlanesConcurrently(const byte *packet, uint32 packetSize);
+
+		/** Check how a plane offset relates to the position of the planes. */
+		void checkPlaneOffset(PlaneOffset offset, uint32 value, uint32 valueEnd, uint32 planesStart);
+		/**
+		 * Find where the planes located by the offset at the given bit
+		 * position of a packet start.
+		 */
+		bool findPlanes(PlaneOffset offset, const byte *packet, uint32 packetSize, uint32 valuePos, uint32 &planesStart) const;
+
+		static void decodePlanesProc(void *data);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
@@ -378,6 +488,7 @@ private:
 	};
 
 	Common::SeekableReadStream *_bink;
+	Common::Array<byte> _videoPacket; ///< The video packet being decoded.
 
 	Common::Array<AudioInfo> _audioTracks; ///< All audio tracks.
 	Common::Array<VideoFrame> _frames;      ///< All video frames.
@@ -26,10 +26,333 @@
 
 #include "common/rational.h"
 #include "common/file.h"
+#include "common/mutex.h"
+#include "common/profiler.h"
 #include "common/system.h"
+#include "common/thread.h"
+
+#include "graphics/surface.h"
 
 namespace Video {
 
+/**
+ * A queue of frames of a video track, which a worker thread decodes ahead
+ * of the caller.
+ *
+ * The worker holds the track mutex while it decodes a frame, and the caller
+ * only uses the track when the queue is empty and it holds the track mutex,
+ * so that the state of the track is the state of the caller as well.
+ */
+class VideoDecoder::DecodeAhead {
+public:
+	DecodeAhead(VideoDecoder *decoder, VideoTrack *track, uint numFrames);
+	~DecodeAhead();
+
+	VideoTrack *getTrack() const { return _track; }
+
+	/** Return false if the backend does not support threads. */
+	bool isAvailable() const { return _available; }
+
+	/**
+	 * Take the next frame of the queue, and wait for the worker if it is
+	 * still decoding it. @p palette is set if the frame changed the palette.
+	 *
+	 * @return false if the worker is not running and the queue is empty, so
+	 *         that the caller must decode the frame and pass it to keepFrame()
+	 */
+	bool takeFrame(const Graphics::Surface *&surface, const byte *&palette);
+
+	/**
+	 * Keep a copy of a frame decoded by the caller, and start the worker on
+	 * the frames after it. @p palette is replaced with a copy.
+	 */
+	const Graphics::Surface *keepFrame(const Graphics::Surface *surface, const byte *&palette);
+
+	/**
+	 * Stop the worker, so that the track can be changed. The frames in the
+	 * queue are still returned, and the worker starts again after them.
+	 */
+	void stop();
+
+	/** Stop the worker and drop the queue, so that the track can be moved. */
+	void reset();
+
+	/** Return whether the track decoded past the frame returned last. */
+	bool hasQueuedFrames() const;
+
+	int getCurFrame() const;
+	uint32 getNextFrameStartTime() const;
+	bool endOfTrack() const;
+	void pause(bool pause);
+
+private:
+	struct Frame {
+		Graphics::Surface surface;
+		bool hasSurface;
+		int curFrame;         // The current frame of the track after this one
+		uint32 startTime;     // The start time of this frame
+		bool dirtyPalette;
+		byte palette[256 * 3];
+	};
+
+	struct State {
+		int curFrame;
+		uint32 nextFrameStartTime;
+		bool endOfTrack;
+	};
+
+	static void threadProc(void *data);
+	void run();
+	void joinThread();
+	State getState() const;
+	static void storeSurface(Frame &frame, const Graphics::Surface *surface);
+
+	VideoDecoder *_decoder;
+	VideoTrack *_track;
+
+	// The frames which are ready start at _first, and the one before
+	// it is the frame which was returned last
+	Frame *_frames;
+	uint _numSlots;
+	uint _first;
+	uint _count;
+	int _curFrame;
+	byte _palette[256 * 3];
+
+	Common::ThreadInternal *_thread;
+	Common::SemaphoreInternal *_frameReady;
+	Common::SemaphoreInternal *_spaceFree;
+	mutable Common::Mutex _mutex;      // Protects the queue
+	mutable Common::Mutex _trackMutex; // Held while the track is used
+	bool _stopping;
+	bool _workerDone;
+	bool _available;
+};
+
+VideoDecoder::DecodeAhead::DecodeAhead(VideoDecoder *decoder, VideoTrack *track, uint numFrames) :
+	_decoder(decoder), _track(track), _numSlots(numFrames + 1), _first(0), _count(0), _curFrame(-1),
+	_thread(nullptr), _stopping(false), _workerDone(false) {
+
+	_frames = new Frame[_numSlots];
+	_frameReady = g_system->createSemaphore();
+	_spaceFree = g_system->createSemaphore();
+	_available = _frameReady && _spaceFree;
+}
+
+VideoDecoder::DecodeAhead::~DecodeAhead() {
+	reset();
+
+	for (uint i = 0; i < _numSlots; i++)
+		_frames[i].surface.free();
+	delete[] _frames;
+
+	delete _frameReady;
+	delete _spaceFree;
+}
+
+bool VideoDecoder::DecodeAhead::takeFrame(const Graphics::Surface *&surface, const byte *&palette) {
+	Frame *frame = nullptr;
+	while (!frame) {
+		bool workerDone;
+		{
+			Common::StackLock lock(_mutex);
+			if (_count) {
+				frame = &_frames[_first];
+				_first = (_first + 1) % _numSlots;
+				_count--;
+				_curFrame = frame->curFrame;
+			}
+			workerDone = _workerDone || !_thread;
+		}
+
+		if (frame)
+			break;
+
+		if (workerDone) {
+			// The end of the track was reached, or the worker was stopped
+			if (_thread)
+				joinThread();
+			return false;
+		}
+
+		PROFILE_ZONE("waitForFrame");
+		_frameReady->wait();
+	}
+
+	if (_thread)
+		_spaceFree->signal();
+
+	surface = frame->hasSurface ? &frame->surface : nullptr;
+	palette = nullptr;
+	if (frame->dirtyPalette) {
+		memcpy(_palette, frame->palette, sizeof(_palette));
+		palette = _palette;
+	}
+	return true;
+}
+
+const Graphics::Surface *VideoDecoder::DecodeAhead::keepFrame(const Graphics::Surface *surface, const byte *&palette) {
+	assert(!_thread && !_count);
+
+	Frame &frame = _frames[(_first + _numSlots - 1) % _numSlots];
+	storeSurface(frame, surface);
+	if (palette) {
+		memcpy(_palette, palette, sizeof(_palette));
+		palette = _palette;
+	}
+	_curFrame = _track->getCurFrame();
+
+	if (!_track->endOfTrack()) {
+		_stopping = false;
+		_workerDone = false;
+		_thread = g_system->createThread(threadProc, this);
+		if (!_thread)
+			_available = false;
+	}
+
+	return frame.hasSurface ? &frame.surface : nullptr;
+}
+
+void VideoDecoder::DecodeAhead::stop() {
+	if (_thread) {
+		{
+			Common::StackLock lock(_mutex);
+			_stopping = true;
+		}
+
+		_spaceFree->signal();
+		joinThread();
+	}
+}
+
+void VideoDecoder::DecodeAhead::reset() {
+	stop();
+
+	_first = 0;
+	_count = 0;
+}
+
+bool VideoDecoder::DecodeAhead::hasQueuedFrames() const {
+	Common::StackLock lock(_mutex);
+	return _count != 0;
+}
+
+void VideoDecoder::DecodeAhead::joinThread() {
+	_thread->join();
+	delete _thread;
+	_thread = nullptr;
+}
+
+VideoDecoder::DecodeAhead::State VideoDecoder::DecodeAhead::getState() const {
+	State state;
+
+	// With frames in the queue, the track is ahead of the caller
+	{
+		Common::StackLock lock(_mutex);
+		if (_count) {
+			state.curFrame = _curFrame;
+			state.nextFrameStartTime = _frames[_first].startTime;
+			state.endOfTrack = false;
+			return state;
+		}
+	}
+
+	// Otherwise it is where the caller is, once the worker finished the
+	// frame which it may be decoding
+	Common::StackLock trackLock(_trackMutex);
+	{
+		Common::StackLock lock(_mutex);
+		if (_count) {
+			state.curFrame = _curFrame;
+			state.nextFrameStartTime = _frames[_first].startTime;
+			state.endOfTrack = false;
+			return state;
+		}
+	}
+
+	state.curFrame = _track->getCurFrame();
+	state.nextFrameStartTime = _track->getNextFrameStartTime();
+	state.endOfTrack = _track->endOfTrack();
+	return state;
+}
+
+int VideoDecoder::DecodeAhead::getCurFrame() const {
+	return getState().curFrame;
+}
+
+uint32 VideoDecoder::DecodeAhead::getNextFrameStartTime() const {
+	return getState().nextFrameStartTime;
+}
+
+bool VideoDecoder::DecodeAhead::endOfTrack() const {
+	return getState().endOfTrack;
+}
+
+void VideoDecoder::DecodeAhead::pause(bool pause) {
+	Common::StackLock trackLock(_trackMutex);
+	_track->pause(pause);
+}
+
+void VideoDecoder::DecodeAhead::storeSurface(Frame &frame, const Graphics::Surface *surface) {
+	frame.hasSurface = (surface != nullptr);
+	if (!surface)
+		return;
+
+	if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+		frame.surface.free();
+		frame.surface.create(surface->w, surface->h, surface->format);
+	}
+
+	frame.surface.copyRectToSurface(*surface, 0, 0, Common::Rect(surface->w, surface->h));
+}
+
+void VideoDecoder::DecodeAhead::threadProc(void *data) {
+	((DecodeAhead *)data)->run();
+}
+
+void VideoDecoder::DecodeAhead::run() {
+	for (;;) {
+		Frame *frame = nullptr;
+		{
+			Common::StackLock lock(_mutex);
+			if (_stopping)
+				break;
+
+			if (_count < _numSlots - 1)
+				frame = &_frames[(_first + _count) % _numSlots];
+		}
+
+		if (!frame) {
+			// The queue is full, wait until the caller takes a frame
+			_spaceFree->wait();
+			continue;
+		}
+
+		Common::StackLock trackLock(_trackMutex);
+		if (_track->endOfTrack())
+			break;
+
+		// The same steps as VideoDecoder::decodeNextFrame(), which the
+		// subclass must keep free of diagnostics and other OSystem calls,
+		// see setDecodeAhead()
+		frame->startTime = _track->getNextFrameStartTime();
+		_decoder->readNextPacket();
+		storeSurface(*frame, _track->decodeNextFrame());
+		frame->curFrame = _track->getCurFrame();
+		frame->dirtyPalette = _track->hasDirtyPalette();
+		if (frame->dirtyPalette)
+			memcpy(frame->palette, _track->getPalette(), sizeof(frame->palette));
+
+		Common::StackLock lock(_mutex);
+		_count++;
+		_frameReady->signal();
+	}
+
+	Common::StackLock lock(_mutex);
+	_workerDone = true;
+	_frameReady->signal();
+}
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -48,12 +371,20 @@ VideoDecoder::VideoDecoder() {
 	_canSetDither = true;
 	_canSetDefaultFormat = true;
 	_videoCodecAccuracy = Image::CodecAccuracy::Default;
+	_decodeAhead = nullptr;
+	_decodeAheadFrames = 0;
+}
+
+VideoDecoder::~VideoDecoder() {
+	stopDecodeAhead();
 }
 
 void VideoDecoder::close() {
 	if (isPlaying())
 		stop();
 
+	stopDecodeAhead();
+
 	for (auto *track : _tracks)
 		delete track;
 
@@ -137,10 +468,10 @@ void VideoDecoder::pauseVideo(bool pause) {
 		_pauseStartTime = g_system->getMillis(); // Store the starting time from pausing to keep it for later
 
 		for (auto &track : _tracks)
-			track->pause(true);
+			pauseTrack(track, true);
 	} else if (_pauseLevel == 0) {
 		for (auto &track : _tracks)
-			track->pause(false);
+			pauseTrack(track, false);
 
 		_startTime += (g_system->getMillis() - _pauseStartTime);
 	}
@@ -208,10 +539,28 @@ Graphics::PixelFormat VideoDecoder::getPixelFormat() const {
 }
 
 const Graphics::Surface *VideoDecoder::decodeNextFrame() {
+	PROFILE_ZONE("decodeNextFrame");
+
 	_needsUpdate = false;
 	_canSetDither = false;
 	_canSetDefaultFormat = false;
 
+	if (_decodeAheadFrames && !_decodeAhead)
+		startDecodeAhead();
+
+	const bool decodeAhead = _decodeAhead && _decodeAhead->isAvailable();
+	const Graphics::Surface *frame;
+	const byte *palette;
+	if (decodeAhead && _decodeAhead->takeFrame(frame, palette)) {
+		if (palette) {
+			_palette = palette;
+			_dirtyPalette = true;
+		}
+
+		findNextVideoTrack();
+		return frame;
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -219,10 +568,19 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	if (!_nextVideoTrack)
 		return 0;
 
-	const Graphics::Surface *frame = _nextVideoTrack->decodeNextFrame();
+	frame = _nextVideoTrack->decodeNextFrame();
+
+	palette = nullptr;
+	if (_nextVideoTrack->hasDirtyPalette())
+		palette = _nextVideoTrack->getPalette();
 
-	if (_nextVideoTrack->hasDirtyPalette()) {
-		_palette = _nextVideoTrack->getPalette();
+	// The first frame after loading or seeking is decoded here, and the
+	// worker decodes the ones after it
+	if (decodeAhead)
+		frame = _decodeAhead->keepFrame(frame, palette);
+
+	if (palette) {
+		_palette = palette;
 		_dirtyPalette = true;
 	}
 
@@ -240,6 +598,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	// Attempt to make sure all the tracks are in the requested direction
 	for (auto &track : _tracks) {
 		if (track->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)track)->isReversed() != reverse) {
+			// The frames decoded ahead go the other way
+			if (!rewindDecodeAhead())
+				return false;
+
 			if (!((VideoTrack *)track)->setReverse(reverse))
 				return false;
 
@@ -261,7 +623,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (const auto &track : _tracks)
 		if (track->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)track)->getCurFrame() + 1;
+			frame += getTrackCurFrame((const VideoTrack *)track) + 1;
 
 	return frame;
 }
@@ -302,7 +664,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getTrackNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -321,8 +683,8 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (const auto &track : _tracks) {
-		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && ((const VideoTrack *)track)->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = track->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool videoEndTimeReached = _endTimeSet && track->getTrackType() == Track::kTrackTypeVideo && getTrackNextFrameStartTime((const VideoTrack *)track) >= (uint)_endTime.msecs();
+		bool endReached = endOfTrack(track) || (isPlaying() && videoEndTimeReached);
 		if (!endReached)
 			return false;
 	}
@@ -349,6 +711,8 @@ bool VideoDecoder::rewind() {
 	if (isPlaying())
 		stopAudio();
 
+	resetDecodeAhead();
+
 	for (auto &track : _tracks)
 		if (!track->rewind())
 			return false;
@@ -383,6 +747,8 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (isPlaying())
 		stopAudio();
 
+	resetDecodeAhead();
+
 	// Do the actual seeking
 	if (!seekIntern(time))
 		return false;
@@ -465,7 +831,7 @@ void VideoDecoder::stop() {
 
 	// Reset the pause state of the tracks too
 	for (auto &track : _tracks)
-		track->pause(false);
+		pauseTrack(track, false);
 }
 
 void VideoDecoder::setRate(const Common::Rational &rate) {
@@ -577,12 +943,97 @@ bool VideoDecoder::setOutputPixelFormats(const Common::List<Graphics::PixelForma
 void VideoDecoder::setVideoCodecAccuracy(Image::CodecAccuracy accuracy) {
 	_videoCodecAccuracy = accuracy;
 
+	// The frames which were decoded ahead are still shown, so that none
+	// are skipped, and the following ones use the new accuracy
+	if (_decodeAhead)
+		_decodeAhead->stop();
+
 	for (Track *track : _tracks) {
 		if (track->getTrackType() == Track::kTrackTypeVideo)
 			static_cast<VideoTrack *>(track)->setCodecAccuracy(accuracy);
 	}
 }
 
+void VideoDecoder::setDecodeAhead(uint numFrames) {
+	if (numFrames == _decodeAheadFrames)
+		return;
+
+	stopDecodeAhead();
+	_decodeAheadFrames = numFrames;
+}
+
+void VideoDecoder::startDecodeAhead() {
+	// The worker could not pick the track of each frame like
+	// findNextVideoTrack() does, so only single video tracks are supported
+	VideoTrack *videoTrack = nullptr;
+	for (auto &track : _tracks) {
+		if (track->getTrackType() == Track::kTrackTypeVideo) {
+			if (videoTrack)
+				return;
+
+			videoTrack = (VideoTrack *)track;
+		}
+	}
+
+	if (videoTrack)
+		_decodeAhead = new DecodeAhead(this, videoTrack, _decodeAheadFrames);
+}
+
+void VideoDecoder::stopDecodeAhead() {
+	delete _decodeAhead;
+	_decodeAhead = nullptr;
+}
+
+void VideoDecoder::resetDecodeAhead() {
+	if (_decodeAhead)
+		_decodeAhead->reset();
+}
+
+bool VideoDecoder::rewindDecodeAhead() {
+	if (!_decodeAhead)
+		return true;
+
+	_decodeAhead->stop();
+	if (!_decodeAhead->hasQueuedFrames())
+		return true;
+
+	// Drop the queue, and move the track back to the frame returned last
+	if (!isSeekable())
+		return false;
+
+	const Audio::Timestamp time = _decodeAhead->getTrack()->getFrameTime(_decodeAhead->getCurFrame() + 1);
+	_decodeAhead->reset();
+	return seekIntern(time);
+}
+
+int VideoDecoder::getTrackCurFrame(const VideoTrack *track) const {
+	if (_decodeAhead && _decodeAhead->getTrack() == track)
+		return _decodeAhead->getCurFrame();
+
+	return track->getCurFrame();
+}
+
+uint32 VideoDecoder::getTrackNextFrameStartTime(const VideoTrack *track) const {
+	if (_decodeAhead && _decodeAhead->getTrack() == track)
+		return _decodeAhead->getNextFrameStartTime();
+
+	return track->getNextFrameStartTime();
+}
+
+bool VideoDecoder::endOfTrack(const Track *track) const {
+	if (_decodeAhead && _decodeAhead->getTrack() == track)
+		return _decodeAhead->endOfTrack();
+
+	return track->endOfTrack();
+}
+
+void VideoDecoder::pauseTrack(Track *track, bool pause) {
+	if (_decodeAhead && _decodeAhead->getTrack() == track)
+		_decodeAhead->pause(pause);
+	else
+		track->pause(pause);
+}
+
 VideoDecoder::Track::Track() {
 	_paused = false;
 }
@@ -829,6 +1280,9 @@ void VideoDecoder::addTrack(Track *track, bool isExternal) {
 			}
 		}
 	} else if (track->getTrackType() == Track::kTrackTypeVideo) {
+		// Only the frames of a single video track are decoded ahead
+		stopDecodeAhead();
+
 		// If this track has a better time, update _nextVideoTrack
 		if (!_nextVideoTrack || ((VideoTrack *)track)->getNextFrameStartTime() < _nextVideoTrack->getNextFrameStartTime())
 			_nextVideoTrack = (VideoTrack *)track;
@@ -948,7 +1402,7 @@ void VideoDecoder::setEndFrame(uint frame) {
 
 void VideoDecoder::resetStartTime() {
 	if (_nextVideoTrack) {
-		Audio::Timestamp curTime = _nextVideoTrack->getFrameTime(_nextVideoTrack->getCurFrame());
+		Audio::Timestamp curTime = _nextVideoTrack->getFrameTime(getTrackCurFrame(_nextVideoTrack));
 		if (isPlaying()) {
 			_startTime = g_system->getMillis() - (curTime.msecs() / _playbackRate).toInt();
 		}
@@ -971,7 +1425,7 @@ const VideoDecoder::Track *VideoDecoder::getTrack(uint track) const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (const auto &track : _tracks)
-		if (track->getTrackType() == Track::kTrackTypeVideo && !track->endOfTrack())
+		if (track->getTrackType() == Track::kTrackTypeVideo && !endOfTrack(track))
 			return false;
 
 	return true;
@@ -982,9 +1436,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	uint32 bestTime = 0xFFFFFFFF;
 
 	for (auto &track : _tracks) {
-		if (track->getTrackType() == Track::kTrackTypeVideo && !track->endOfTrack()) {
+		if (track->getTrackType() == Track::kTrackTypeVideo && !endOfTrack(track)) {
 			VideoTrack *videoTrack = (VideoTrack *)track;
-			uint32 time = videoTrack->getNextFrameStartTime();
+			uint32 time = getTrackNextFrameStartTime(videoTrack);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -1038,8 +1492,8 @@ bool VideoDecoder::hasFramesLeft() const {
 
 		const VideoTrack *videoTrack = (const VideoTrack *)track;
 
-		bool videoEndTimeReached = _endTimeSet && videoTrack->getNextFrameStartTime() >= (uint)_endTime.msecs();
-		bool endReached = videoTrack->endOfTrack() || (isPlaying() && videoEndTimeReached);
+		bool videoEndTimeReached = _endTimeSet && getTrackNextFrameStartTime(videoTrack) >= (uint)_endTime.msecs();
+		bool endReached = endOfTrack(videoTrack) || (isPlaying() && videoEndTimeReached);
 		if (!endReached)
 			return true;
 	}
@@ -1056,6 +1510,9 @@ bool VideoDecoder::hasAudio() const {
 }
 
 void VideoDecoder::eraseTrack(Track *track) {
+	if (_decodeAhead && _decodeAhead->getTrack() == track)
+		stopDecodeAhead();
+
 	for (uint idx = 0; idx < _externalTracks.size(); ++idx) {
 		if (_externalTracks[idx] == track)
 			_externalTracks.remove_at(idx);
@@ -53,7 +53,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -424,6 +424,50 @@ public:
 	 */
 	virtual void setVideoCodecAccuracy(Image::CodecAccuracy accuracy);
 
+	/**
+	 * Decode frames ahead of time on a worker thread.
+	 *
+	 * Up to @p numFrames decoded frames are kept ready for the video track,
+	 * so that a frame which is slow to decode does not hold up the caller.
+	 * decodeNextFrame() then returns the next frame of the queue, and the
+	 * state of the video, such as getCurFrame() and getTimeToNextFrame(),
+	 * follows the frames which were returned. Seeking and rewinding empty
+	 * the queue. Reversing the video seeks it back to the frame which was
+	 * returned last, which requires a seekable video, and a new codec
+	 * accuracy applies to the frames after those already in the queue.
+	 *
+	 * Frames are only decoded ahead for videos with a single video track,
+	 * on backends with thread support, and otherwise when they are
+	 * requested. The subclass must follow the rules of OSystem::createThread()
+	 * in readNextPacket() and in the decodeNextFrame() of its tracks, and its
+	 * destructor must call close().
+	 *
+	 * In particular, only the first frame after loading or seeking is decoded
+	 * on the calling thread, so these functions must not, for any later frame:
+	 * - call warning(), error(), debug() or the other functions of
+	 *   common/debug.h and common/textconsole.h, which write to the OSystem;
+	 * - ask the OSystem for anything else, such as the time, the features
+	 *   or the mixer, or read ConfMan;
+	 * - create singletons, or change state shared with the caller's thread
+	 *   or with other videos without a lock.
+	 * Codecs may set themselves up lazily while decoding the first frame, and
+	 * may convert with YUVToRGBMan, which is safe to use from several threads.
+	 * A subclass which cannot meet this should not enable decoding ahead.
+	 *
+	 * This setting remains until it is changed, and may be set before or
+	 * after loadStream(). Changing it drops the frames which were decoded
+	 * ahead, so it should be followed by a seek if a video is playing.
+	 *
+	 * @param numFrames The number of frames to decode ahead, or 0 to decode
+	 *                  each frame when it is requested
+	 */
+	void setDecodeAhead(uint numFrames);
+
+	/**
+	 * Get the number of frames which are decoded ahead, see setDecodeAhead().
+	 */
+	uint getDecodeAhead() const { return _decodeAheadFrames; }
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -1038,6 +1082,26 @@ private:
 	Audio::Mixer::SoundType _soundType;
 
 	AudioTrack *_mainAudioTrack;
+
+	// The queue of frames decoded ahead by a worker thread, see setDecodeAhead()
+	class DecodeAhead;
+	DecodeAhead *_decodeAhead;
+	uint _decodeAheadFrames;
+
+	void startDecodeAhead();
+	void stopDecodeAhead();
+	void resetDecodeAhead();
+
+	// Drop the frames decoded ahead, and seek the track back to where the
+	// caller is. Returns false if the track cannot seek.
+	bool rewindDecodeAhead();
+
+	// The state of a track as seen by the caller, which is behind the track
+	// itself while frames are decoded ahead
+	int getTrackCurFrame(const VideoTrack *track) const;
+	uint32 getTrackNextFrameStartTime(const VideoTrack *track) const;
+	bool endOfTrack(const Track *track) const;
+	void pauseTrack(Track *track, bool pause);
 };
 
 } // End of namespace Video